@@ -5,7 +5,7 @@
  * Version:      0.3a3
  * Date:         July 21, 2014
  * License:      Free Software (see comments in main.c for limitations)
- * Dependencies: common.h, board.h
+ * Dependencies: common.h, pool.h, board.h, board_private.h
  * --------------------------------------------------------------
  *
  * Private implementation of the Board "class". The accompanying header
@@ -15,9 +15,9 @@
  * in this source-module. They are usually inlined, without performing
  * any sanity check on their arguments.
  *
- * A board consists of the grid (a re-sizable 1D array of tiles that
- * actually describes a square grid) and a bunch of meta-data. For
- * details see the definition of struct _board, further below.
+ * A board consists of a bunch of meta-data followed by the grid (an
+ * inline 1D array of tiles that actually describes a square grid). For
+ * details see the definition of struct _board, in "board_private.h".
  *
  * Currently, the single-dimension (dim) of the square grid is also
  * used for determining the values of other meta-data, such as the
@@ -27,16 +27,22 @@
  * The grid dimension is actually used for determining the desired
  * variant of the game (currently supported variants include 4x4,
  * 5x5, 6x6 and 8x8 boards).
+ *
+ * Boards are allocated from the pool allocator (see the file: "pool.c")
+ * as single blocks. Their inline grid has capacity for the largest
+ * supported dimension, so resizing a board never reallocates it.
  ****************************************************************
  */
 
 #define BOARD_C
 
-#include <stdlib.h>        /* rand(), malloc(), calloc(), realloc() */
+#include <stdlib.h>        /* rand() */
 #include <string.h>        /* memset(), memcpy() */
 
 #include "common.h"
+#include "pool.h"
 #include "board.h"
+#include "board_private.h"
 
 /* Macro for indexing the grid of the board (it's an 1D buffer). */
 #define _IDX(i,j,ncols)    ( (i) * (ncols) + (j) )
@@ -69,25 +75,6 @@ enum {
 	_NRANDOM_6 = 2
 };
 
-/* Structure of a single tile.
- * Since it contains just one field, it could be omitted.
- * However, this design gives me flexibility to add more
- * fields if needed in future versions.
- */
-struct _tile {
-	int val;             /* the value of the tile */
-};
-
-/* The board consists of a square grid of tiles and meta-data */
-struct _board {
-	int  dim;            /* single dimension (grid is a square) */
-	int  sentinel;       /* sentinel value (e.g. for 4x4 it is 2048) */
-	int  nrandom;        /* # of random generated tiles after a move */
-	int  nempty;         /* # of currently empty slots */
-	int  hasadjacent;    /* are there 2 adjacent tiles with equal val? */
-	struct _tile *grid;
-};
-
 /* --------------------------------------------------------------
  * int _dim_to_sentinel():
  *
@@ -157,15 +144,107 @@ static inline int _dim_to_nrandom( int dim )
 	return _NRANDOM_4;
 }
 
+/* --------------------------------------------------------------
+ * void _add_event():
+ *
+ * Append to the specified move-events (events) an event of the
+ * specified kind, about a tile moved from the specified source index
+ * (isrc) to the specified destination index (idst) of the grid of
+ * the specified board, which then has the specified value (val).
+ * --------------------------------------------------------------
+ */
+static inline void _add_event(
+	BoardEvents  *events,
+	const Board  *board,
+	int          kind,
+	int          isrc,
+	int          idst,
+	int          val
+	)
+{
+	BoardEvent *ev = NULL;
+
+	if ( events->n >= BOARD_MAXEVENTS ) {
+		return;
+	}
+	ev = &events->ev[ events->n++ ];
+	ev->kind = (unsigned char) kind;
+	ev->i0   = (unsigned char) (isrc / board->dim);
+	ev->j0   = (unsigned char) (isrc % board->dim);
+	ev->i    = (unsigned char) (idst / board->dim);
+	ev->j    = (unsigned char) (idst % board->dim);
+	ev->val  = val;
+}
+
+/* --------------------------------------------------------------
+ * void _line_record_events():
+ *
+ * Append to the specified move-events (events) the slides & merges
+ * that a move will cause to a line (row or column) of the specified
+ * board. The line is specified by the grid index of its cell that
+ * lies at the edge the move is heading to (beg) and the distance of
+ * the indices of its successive cells, moving away from that edge
+ * (step).
+ *
+ * NOTES: It MUST be called before the line gets actually moved,
+ *        and it follows the same rules as the functions:
+ *        _merge_adjacent_from_beg() & _merge_adjacent_from_end()
+ *        (a merged tile does not merge again in the same move).
+ *
+ *        It is used only when the caller of a board_move_XXX()
+ *        function asks for the events, so it costs nothing to
+ *        the moves otherwise.
+ * --------------------------------------------------------------
+ */
+static inline void _line_record_events(
+	BoardEvents  *events,
+	const Board  *board,
+	int          beg,
+	int          step
+	)
+{
+	int k, idx, val;
+	int dst = -1;          /* (in the line) where the last tile ended */
+	int dstval = 0;        /* value of the last tile */
+	int canmerge = 0;      /* can the last tile still get merged? */
+	const int DIM = board->dim;
+
+	for (k=0, idx=beg; k < DIM; k++, idx += step)
+	{
+		val = board->grid[idx].val;
+		if ( 0 == val ) {
+			continue;
+		}
+		if ( canmerge && val == dstval ) {
+			dstval += val;
+			canmerge = 0;  /* false */
+			_add_event(
+				events, board, BOARD_EVENT_MERGE,
+				idx, beg + dst * step, dstval
+				);
+			continue;
+		}
+		dst++;
+		dstval   = val;
+		canmerge = 1;  /* true */
+		if ( dst != k ) {
+			_add_event(
+				events, board, BOARD_EVENT_SLIDE,
+				idx, beg + dst * step, val
+				);
+		}
+	}
+}
+
 /* --------------------------------------------------------------
  * int board_generate_tile():
  *
  * Generate a random value between 2 and 4 and put it at a random
- * empty tile of the specified board. Return 0 (false) on error,
- * 1 (true) otherwise.
+ * empty tile of the specified board, appending the corresponding
+ * event to the specified move-events (events) unless it is NULL.
  * --------------------------------------------------------------
  */
-static inline void _generate_tile( Board *board )
+static inline void _generate_tile( Board *board, BoardEvents *events )
 {
 	int i,j,idx;
 	const int DIM = board->dim;
@@ -179,6 +258,12 @@ static inline void _generate_tile( Board *board )
 	board->grid[idx].val = (rand() % 2 == 0) ? 2 : 4;
 
 	board->nempty--;
+	if ( events ) {
+		_add_event(
+			events, board, BOARD_EVENT_SPAWN,
+			idx, idx, board->grid[idx].val
+			);
+	}
 
 }
 
@@ -713,23 +798,6 @@ static inline int _has_adjacent( const Board *board )
 	return 0;
 }
 
-/* --------------------------------------------------------------
- * struct _tile *_grid_resize():
- *
- * Resize the specified grid to the specified dimensions and
- * and return a pointer to it, or NULL on error.
- * --------------------------------------------------------------
- */
-static inline struct _tile *_grid_resize( struct _tile *grid, int dim )
-{
-	struct _tile *test = realloc( grid, dim * dim * sizeof(*test) );
-	if ( NULL == test ) {
-		DBGF( "%s", "realloc failed (grid)!" );
-		return NULL;
-	}
-	return test;
-}
-
 /* --------------------------------------------------------------
  * int _init():
  *
@@ -768,18 +836,12 @@ Board *make_board( int dim )
 		return NULL;
 	}
 
-	board = calloc( 1, sizeof(*board) );
+	board = pool_alloc( sizeof(*board) );
 	if ( NULL == board ) {
-		DBGF( "%s", "calloc failed (board)!" );
-		return NULL;
-	}
-
-	board->grid = calloc( dim * dim, sizeof(struct _tile) );
-	if ( NULL == board->grid ) {
-		DBGF( "%s", "calloc failed (board->grid)!" );
-		free( board );
+		DBGF( "%s", "pool_alloc failed (board)!" );
 		return NULL;
 	}
+	board->dim = dim;
 
 	return board;
 }
@@ -818,8 +880,7 @@ Board *new_board( void )
 Board *board_free( Board *board )
 {
 	if ( board ) {
-		free( board->grid );
-		free( board );
+		pool_free( board, sizeof(*board) );
 	}
 	return NULL;
 }
@@ -844,15 +905,9 @@ int board_reset( Board *board )
 		DBGF( "%s", "NULL pointer argument!" );
 		return 0;
 	}
-	if ( NULL == board->grid ) {
-		DBGF( "%s", "Board grid is not created (NULL)!" );
-		return 0;
-	}
 
 	len = board->dim * board->dim;
-	if ( board->grid ) {
-		memset( board->grid, 0, len * sizeof(struct _tile) );
-	}
+	memset( board->grid, 0, len * sizeof(struct _tile) );
 	board->nempty      = len;
 	board->hasadjacent = 0;  /* false */
 
@@ -864,6 +919,10 @@ int board_reset( Board *board )
  *
  * Resize the grid of the specified board according to the specified
  * single-dimension (dim). Return 0 on error, 1 otherwise.
+ *
+ * NOTE: The grid is inline, with capacity for the largest supported
+ *       dimension, so the board is never reallocated (that is, any
+ *       pointer to it remains valid).
  * --------------------------------------------------------------
  */
 int board_resize_and_reset( Board *board, int dim )
@@ -877,20 +936,6 @@ int board_resize_and_reset( Board *board, int dim )
 		return 0;
 	}
 
-	/* realloc board->grid ONLY if needed */
-	if ( dim != board->dim )
-	{
-		struct _tile *test = realloc(
-					board->grid,
-					dim * dim * sizeof(*test)
-					);
-		if ( NULL == test ) {
-			DBGF( "%s", "realloc failed (board->grid)!" );
-			return 0;
-		}
-		board->grid = test;
-	}
-
 	/* reset the board */
 
 	memset( board->grid, 0, dim * dim * sizeof( *(board->grid) ) );
@@ -914,6 +959,9 @@ int board_resize_and_reset( Board *board, int dim )
  * NOTES: If the grid dimensions of the boards differ, then
  *        the grid of the destination board gets resized to
  *        the dimensions of the source board.
+ *
+ *        Only the meta-data and the used part of the source grid
+ *        are copied, with a single memcpy() (see BOARD_SZUSED()).
  * --------------------------------------------------------------
  */
 int board_copy( Board *dst, const Board *src )
@@ -923,27 +971,7 @@ int board_copy( Board *dst, const Board *src )
 		return 0;  /* false */
 	}
 
-	if ( NULL == src->grid ) {
-		free( dst->grid );
-		dst->grid = NULL;
-	}
-	else {
-		int len = src->dim * src->dim;
-		if ( src->dim != dst->dim ) {
-			dst->grid = _grid_resize( dst->grid, src->dim );
-			if ( NULL == dst->grid ) {
-				DBGF( "%s", "_grid_resize() failed!" );
-				return 0;  /* false */
-			}
-		}
-		memcpy( dst->grid, src->grid, len * sizeof(struct _tile) );
-	}
-
-	dst->dim         = src->dim;
-	dst->sentinel    = src->sentinel;
-	dst->nrandom     = src->nrandom;
-	dst->nempty      = src->nempty;
-	dst->hasadjacent = src->hasadjacent;
+	memcpy( dst, src, BOARD_SZUSED(src->dim) );
 
 	return 1;  /* true */
 }
@@ -954,13 +982,17 @@ int board_copy( Board *dst, const Board *src )
  * Generate (n) random values, each one being either 2 or 4,
  * and put them at (n) random empty tiles, in the specified
  * board. Return 0 (false) on error, 1 (true) otherwise.
-
+ *
+ * Unless the specified move-events (events) is NULL, a spawn
+ * event is appended to it for every generated tile (so after
+ * a move, they follow the events of the move).
+ *
  * NOTE: This function is a publicly exported wrapper of
  *       the function: _generate_tile(). It accepts one
  *       extra argument (n) and it performs sanity checks.
  * --------------------------------------------------------------
  */
-int board_generate_ntiles( Board *board, int n )
+int board_generate_ntiles( Board *board, int n, BoardEvents *events )
 {
 	if ( NULL == board ) {
 		DBGF( "%s", "NULL pointer argument!" );
@@ -979,7 +1011,7 @@ int board_generate_ntiles( Board *board, int n )
 		n = board->nempty;
 	}
 	while ( n-- > 0 ) {
-		_generate_tile( board );
+		_generate_tile( board, events );
 	}
 
 	return 1;
@@ -1052,9 +1084,23 @@ int board_has_adjacent( const Board *board )
  *
  * c. Starting from left to right, copy all non-0 elements of the
  *    temp buffer back into the board column (top to bottom).
+ *
+ * MOVE-EVENTS:
+ *
+ * Unless the specified move-events (events) is NULL, it gets reset
+ * and then filled with the slides & merges caused by the move (see
+ * the type BoardEvents in the file "board.h"), so the caller knows
+ * which tiles changed (e.g. for repainting just those). The same
+ * goes for the functions: board_move_down(), board_move_left() and
+ * board_move_right().
  * --------------------------------------------------------------
  */
-int board_move_up( Board *board, long int *score, int *won )
+int board_move_up(
+	Board       *board,
+	long int    *score,
+	int         *won,
+	BoardEvents *events
+	)
 {
 	int j;
 	int *temp = NULL;
@@ -1067,6 +1113,9 @@ int board_move_up( Board *board, long int *score, int *won )
 		DBGF( "%s", "temp malloc failed!" );
 		return 0;
 	}
+	if ( events ) {
+		events->n = 0;
+	}
 
 	/* for every column (j) */
 	for ( j=0; j < DIM; j++)
@@ -1074,6 +1123,9 @@ int board_move_up( Board *board, long int *score, int *won )
 		if ( _col_has_gaps_begend(board, j) ) {
 			moved = 1;
 		}
+		if ( events ) {
+			_line_record_events( events, board, _IDX(0,j,DIM), DIM );
+		}
 
 		/* backup column (j) to temp buffer */
 		_col_backup_nogaps_and_clear( board,j, temp );
@@ -1109,7 +1161,12 @@ int board_move_up( Board *board, long int *score, int *won )
  *            from bottom to top in the columns of the board.
  * --------------------------------------------------------------
  */
-int board_move_down( Board *board, long int *score, int *won )
+int board_move_down(
+	Board       *board,
+	long int    *score,
+	int         *won,
+	BoardEvents *events
+	)
 {
 	int j;
 	int *temp = NULL;
@@ -1122,6 +1179,9 @@ int board_move_down( Board *board, long int *score, int *won )
 		DBGF( "%s", "temp malloc failed!" );
 		return 0;
 	}
+	if ( events ) {
+		events->n = 0;
+	}
 
 	/* for every column (j) */
 	for ( j=0; j < DIM; j++)
@@ -1129,6 +1189,11 @@ int board_move_down( Board *board, long int *score, int *won )
 		if ( _col_has_gaps_endbeg(board, j) ) {
 			moved = 1;
 		}
+		if ( events ) {
+			_line_record_events(
+				events, board, _IDX(DIM-1,j,DIM), -DIM
+				);
+		}
 
 		/* backup column (j) to temp */
 		_col_backup_nogaps_and_clear( board,j, temp );
@@ -1164,7 +1229,12 @@ int board_move_down( Board *board, long int *score, int *won )
  *            done from left to right.
  * --------------------------------------------------------------
  */
-int board_move_left( Board *board, long int *score, int *won  )
+int board_move_left(
+	Board       *board,
+	long int    *score,
+	int         *won,
+	BoardEvents *events
+	)
 {
 	int i;
 	int *temp = NULL;
@@ -1177,6 +1247,9 @@ int board_move_left( Board *board, long int *score, int *won  )
 		DBGF( "%s", "temp malloc failed!" );
 		return 0;
 	}
+	if ( events ) {
+		events->n = 0;
+	}
 
 	/* for every row (i) */
 	for (i=0; i < DIM; i++)
@@ -1184,6 +1257,9 @@ int board_move_left( Board *board, long int *score, int *won  )
 		if ( _row_has_gaps_begend(board,i) ) {
 			moved = 1;
 		}
+		if ( events ) {
+			_line_record_events( events, board, _IDX(i,0,DIM), 1 );
+		}
 
 		/* backup row (i) to temp buffer */
 		_row_backup_nogaps_and_clear( board,i, temp );
@@ -1216,7 +1292,12 @@ int board_move_left( Board *board, long int *score, int *won  )
  *            and merging is always done from right to left.
  * --------------------------------------------------------------
  */
-int board_move_right( Board *board, long int *score, int *won )
+int board_move_right(
+	Board       *board,
+	long int    *score,
+	int         *won,
+	BoardEvents *events
+	)
 {
 	int i;
 	int *temp = NULL;
@@ -1229,6 +1310,9 @@ int board_move_right( Board *board, long int *score, int *won )
 		DBGF( "%s", "temp malloc failed!" );
 		return 0;
 	}
+	if ( events ) {
+		events->n = 0;
+	}
 
 	/* for every row */
 	for ( i=0; i < DIM; i++)
@@ -1236,6 +1320,11 @@ int board_move_right( Board *board, long int *score, int *won )
 		if ( _row_has_gaps_endbeg(board,i) ) {
 			moved = 1;
 		}
+		if ( events ) {
+			_line_record_events(
+				events, board, _IDX(i,DIM-1,DIM), -1
+				);
+		}
 
 		/* backup row (i) to temp buffer */
 		_row_backup_nogaps_and_clear( board,i, temp );
@@ -1307,6 +1396,44 @@ int board_get_tile_value( const Board *board, int i, int j )
 	return board->grid[ _IDX(i,j,board->dim) ].val;
 }
 
+/* --------------------------------------------------------------
+ * int board_set_tile_value():
+ *
+ * Set the value of the tile at row (i) and column (j) of the specified
+ * board, to the specified value (val), keeping the count of empty tiles
+ * in sync. Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTE: Used for re-constructing boards from recorded deltas (see the
+ *       branches of a moves-history object, in the file: "mvhist.c").
+ *       Contrary to board_move_XXX() functions, it does NOT update the
+ *       hasadjacent field of the board.
+ * --------------------------------------------------------------
+ */
+int board_set_tile_value( Board *board, int i, int j, int val )
+{
+	struct _tile *tile = NULL;
+
+	if ( NULL == board ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+	if ( i < 0 || j < 0 || i >= board->dim || j >= board->dim ) {
+		DBGF( "Invalid tile position (%d,%d)!", i, j );
+		return 0;  /* false */
+	}
+
+	tile = &board->grid[ _IDX(i,j,board->dim) ];
+	if ( 0 == tile->val && 0 != val ) {
+		board->nempty--;
+	}
+	else if ( 0 != tile->val && 0 == val ) {
+		board->nempty++;
+	}
+	tile->val = val;
+
+	return 1;  /* true */
+}
+
 
 /* --------------------------------------------------------------
  * int _grid_append_to_fp():
@@ -1421,84 +1548,54 @@ int board_append_to_fp( const Board *board, FILE *fp )
 }
 
 /* --------------------------------------------------------------
- * Board *new_board_from_text():
+ * const char *board_parse_text():
  *
- * De-serialize the specified text and load it in a newly created
- * board object. Return a pointer to the new object, or NULL on
- * error.
+ * De-serialize the text found at the start of the specified c-string
+ * (text) into the specified board. Return a pointer to the character
+ * right after the last tile-value (normally the eol), or NULL on error,
+ * in which case the board is left in an unspecified state.
  *
  * NOTES: Text is expected to be already serialized as following:
  *        "dim sentinel nrandom nempty hasadjacent#tile-values\r\n"
+ *
+ *        The text is parsed in place, without any allocations, and
+ *        the board gets resized to the parsed dim.
  * --------------------------------------------------------------
  */
-Board *new_board_from_text( char *text )
+const char *board_parse_text( Board *board, const char *text )
 {
-	Board *board = NULL;
-	char  *tokens[2] = { NULL };
-	int   ntokens = 0;
-	int   n=0, len=0;
+	int i, len, dim;
 
-	if ( NULL == text ) {
+	if ( NULL == board || NULL == text ) {
 		DBGF( "%s", "NULL pointer argument!" );
 		return NULL;
 	}
 
-	ntokens = s_tokenize( text, tokens, 2, "#" );
-	if ( ntokens < 2 ) {
-		DBGF( "%s", "s_tokenize(text) failed to produce 2 tokens" );
+	/* the meta-data */
+	if ( NULL == (text = s_parse_int(text, &dim))
+	|| NULL == (text = s_parse_int(text, &board->sentinel))
+	|| NULL == (text = s_parse_int(text, &board->nrandom))
+	|| NULL == (text = s_parse_int(text, &board->nempty))
+	|| NULL == (text = s_parse_int(text, &board->hasadjacent))
+	|| '#' != *text++
+	){
 		return NULL;
 	}
-
-	board = new_board();
-	if ( NULL == board ) {
-		DBGF( "%s", "new_board() failed!" );
+	if ( !_VALID_DIM(dim) ) {
 		return NULL;
 	}
+	board->dim = dim;
 
-	/* from the 1st token, get the meta-data */
-	n = sscanf(
-		tokens[0],
-		"%d %d %d %d %d",
-		&board->dim,
-		&board->sentinel,
-		&board->nrandom,
-		&board->nempty,
-		&board->hasadjacent
-		);
-	if ( n < 5 ) {
-		DBGF( "%s", "sscanf(tokens[0]) failed!" );
-		goto ret_failure;
-	}
-
-	/* resize the grid according to board->dim */
-	if ( !_VALID_DIM(board->dim) ) {
-		DBGF( "Invalid grid-dimension (%d)!", board->dim );
-		goto ret_failure;
-	}
-	board->grid = _grid_resize( board->grid, board->dim );
-	if ( NULL == board->grid ) {
-		DBGF( "%s", "_grid_resize() failed!" );
-		goto ret_failure;
-	}
-
-	/* from the 2nd token, get the tile-values into the grid */
-	len = board->dim * board->dim;
-	char *tokval = strtok(tokens[1], " ");
-	for (n=0; n < len && tokval; n++)
-	{
-		int m = sscanf( tokval, "%d", &board->grid[n].val );
-		if ( m < 1 ) {
-			DBGF( "%s", "sscanf(tokval) failed!" );
-			goto ret_failure;
+	/* the tile-values */
+	len = dim * dim;
+	for (i=0; i < len; i++) {
+		text = s_parse_int( text, &board->grid[i].val );
+		if ( NULL == text ) {
+			return NULL;
 		}
-		tokval = strtok(NULL, " ");
 	}
 
-	return board;
-
-ret_failure:
-	board_free( board );
-	return NULL;
+	return text;
 }
 
 /* --------------------------------------------------------------
@@ -25,6 +25,35 @@ enum {
 	BOARD_DIM_8 = 8     /* 8x8 board */
 };
 
+/* Kinds of move-events (see board_move_up()) */
+enum {
+	BOARD_EVENT_SLIDE = 0,  /* a tile slid to an empty cell */
+	BOARD_EVENT_MERGE,      /* a tile got merged into another one */
+	BOARD_EVENT_SPAWN       /* a tile got generated at an empty cell */
+};
+
+/* Max count of events of a move, along with its generated tiles: every
+ * tile may slide or merge at most once, and a board never spawns more
+ * tiles than it has cells.
+ */
+#define BOARD_MAXEVENTS    (2 * BOARD_DIM_8 * BOARD_DIM_8)
+
+/* A single move-event: a tile from the cell (i0,j0) ended up at the cell
+ * (i,j), which now has the value (val). Spawned tiles have i0,j0 == i,j.
+ */
+typedef struct _boardevent {
+	unsigned char kind;     /* BOARD_EVENT_XXX */
+	unsigned char i0,j0;    /* source cell */
+	unsigned char i,j;      /* destination cell */
+	int           val;      /* value of the destination cell afterwards */
+} BoardEvent;
+
+/* The events of a move, in the order they happened */
+typedef struct _boardevents {
+	int        n;           /* # of events */
+	BoardEvent ev[ BOARD_MAXEVENTS ];
+} BoardEvents;
+
 #ifndef BOARD_C
 extern Board *make_board( int dim );
 extern Board *new_board( void );
@@ -33,24 +62,45 @@ extern Board *board_free( Board *board );
 extern int   board_reset( Board *board );
 extern int   board_resize_and_reset( Board *board, int dim );
 extern int   board_copy( Board *dst, const Board *src );
-extern int   board_generate_ntiles( Board *board, int n );
+extern int   board_generate_ntiles( Board *board, int n, BoardEvents *events );
 
 extern int   board_has_room( const Board *board );
 extern int   board_has_adjacent( const Board *board );
 
-extern int   board_move_up( Board *board, long int *score, int *won );
-extern int   board_move_down( Board *board, long int *score, int *won );
-extern int   board_move_left( Board *board, long int *score, int *won );
-extern int   board_move_right( Board *board, long int *score, int *won );
+extern int   board_move_up(
+                     Board       *board,
+                     long int    *score,
+                     int         *won,
+                     BoardEvents *events
+                     );
+extern int   board_move_down(
+                     Board       *board,
+                     long int    *score,
+                     int         *won,
+                     BoardEvents *events
+                     );
+extern int   board_move_left(
+                     Board       *board,
+                     long int    *score,
+                     int         *won,
+                     BoardEvents *events
+                     );
+extern int   board_move_right(
+                     Board       *board,
+                     long int    *score,
+                     int         *won,
+                     BoardEvents *events
+                     );
 
 extern int   board_get_dim( const Board *board );
 extern int   board_get_sentinel( const Board *board );
 extern int   board_get_nrandom( const Board *board );
 extern int   board_get_tile_value( const Board *board, int i, int j );
 extern int   board_get_nempty( const Board *board );
+extern int   board_set_tile_value( Board *board, int i, int j, int val );
 
 extern int    board_append_to_fp( const Board *board, FILE *fp );
-extern Board *new_board_from_text( char *text );
+extern const char *board_parse_text( Board *board, const char *text );
 
 extern int   dbg_board_dump( const Board *board );
 extern int   dbg_board_generate_tile( Board *board, int i, int j );
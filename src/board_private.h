@@ -0,0 +1,69 @@
+/****************************************************************
+ * This file is part of the "2048cc" game.
+ *
+ * Author:       migf1 <mig_f1@hotmail.com>
+ * Version:      0.3a3
+ * Date:         July 21, 2014
+ * License:      Free Software (see comments in main.c for limitations)
+ * Dependencies: board.h
+ * --------------------------------------------------------------
+ *
+ * The private definition of the Board "class".
+ *
+ * It is NOT part of the public interface. It is shared ONLY between
+ * "board.c" and the modules that embed boards by value into their own
+ * private structures (currently just "gs.c"). Everybody else should
+ * treat boards as opaque, via the public interface in "board.h".
+ ****************************************************************
+ */
+
+#ifndef BOARD_PRIVATE_H
+#define BOARD_PRIVATE_H
+
+#include <stddef.h>        /* offsetof() */
+
+#include "board.h"
+
+/* Largest supported single-dimension. It determines the capacity of
+ * the inline grid of every board, whatever its current dimension.
+ */
+#define BOARD_DIM_MAX      BOARD_DIM_8
+
+/* Structure of a single tile.
+ * Since it contains just one field, it could be omitted.
+ * However, this design gives me flexibility to add more
+ * fields if needed in future versions.
+ */
+struct _tile {
+	int val;             /* the value of the tile */
+};
+
+/* The board consists of meta-data followed by a square grid of tiles.
+ *
+ * The grid is stored inline, with enough capacity for the largest
+ * supported dimension, so a board is a single contiguous block that
+ * never moves when it gets resized. Only its first dim * dim tiles
+ * are meaningful.
+ *
+ * NOTE: The grid MUST remain the last field (see BOARD_SZUSED()).
+ */
+struct _board {
+	int  dim;            /* single dimension (grid is a square) */
+	int  sentinel;       /* sentinel value (e.g. for 4x4 it is 2048) */
+	int  nrandom;        /* # of random generated tiles after a move */
+	int  nempty;         /* # of currently empty slots */
+	int  hasadjacent;    /* are there 2 adjacent tiles with equal val? */
+	struct _tile grid[ BOARD_DIM_MAX * BOARD_DIM_MAX ];
+};
+
+/* Macro for the count of leading bytes of a board with single-dimension
+ * (dim) that are meaningful, that is its meta-data plus the used part of
+ * its grid. Copying that many bytes is enough for duplicating a board.
+ */
+#define BOARD_SZUSED(dim)                                        \
+(                                                                \
+	offsetof(struct _board, grid)                            \
+	+ (size_t)(dim) * (dim) * sizeof(struct _tile)           \
+)
+
+#endif
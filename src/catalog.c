@@ -0,0 +1,598 @@
+/****************************************************************
+ * This file is part of the "2048cc" game.
+ *
+ * Author:       migf1 <mig_f1@hotmail.com>
+ * Version:      0.3a3
+ * Date:         July 21, 2014
+ * License:      Free Software (see comments in main.c for limitations)
+ * Dependencies: common.h, board.h, gs.h, mvhist.h, catalog.h
+ * --------------------------------------------------------------
+ *
+ * Private implementation of the ReplayCatalog "class". The accompanying
+ * header file "catalog.h" exposes publicly the "class" as an opaque
+ * data-type.
+ *
+ * Functions with a "_" prefix in their names are meant to be private
+ * in this source-module. They are usually inlined, without performing
+ * any sanity check on their arguments.
+ *
+ * A ReplayCatalog object lists the replay-files (both .sav2 & .sav) of
+ * a folder, along with some metadata of each one of them (variant,
+ * score, moves, largest tile and time of last modification) for the
+ * load screen of the game (see tui_prompt_replay_fname_to_load() in
+ * the file: "tui.c"). The folder is read in-process, instead of via
+ * a shell command.
+ *
+ * Getting the metadata of a replay-file means loading the whole file,
+ * so they are cached in the index file _IDX_FNAME, inside the folder.
+ * When the catalog gets refreshed (see catalog_refresh()), only files
+ * whose time of last modification or size differ from the ones cached
+ * get loaded again, and the index file gets re-written only if any
+ * of its items changed. Files that cannot be loaded are cached too
+ * (with a 0 variant) so they are not re-tried until they change.
+ *
+ * The index file is just a cache: if it is missing, unreadable or
+ * cannot be written, everything still works (just slower).
+ ****************************************************************
+ */
+
+#define CATALOG_C
+
+#include <stdlib.h>        /* calloc(), realloc(), free(), qsort() */
+#include <string.h>
+
+#include "common.h"
+#include "board.h"
+#include "gs.h"
+#include "mvhist.h"
+#include "catalog.h"
+
+/* Name & signature of the index file, kept inside the folder */
+#define _IDX_FNAME     "catalog.idx"
+#define _IDX_MAGIC     "2048idx1"
+
+/* Initial capacity of the array of items */
+#define _NMIN_ITEMS    64
+
+/* Private definition of the ReplayCatalog "class" */
+struct _ReplayCatalog {
+	char       *folder;
+	char       *idxname;     /* the index file */
+	int        isloaded;     /* has the index file been loaded? */
+	int        sortby;       /* CATALOG_SORT_XXX (see catalog_sort()) */
+	ReplayInfo *items;
+	long int   nitems;       /* # of items */
+	long int   capacity;     /* # of items reserved */
+};
+
+/* State of a refresh in progress (see catalog_refresh()) */
+struct _scan {
+	ReplayCatalog *catalog;
+	ReplayInfo    *old;      /* the items before refreshing, by name */
+	long int      nold;      /* # of old items */
+	long int      nreused;   /* # of old items still up-to-date */
+	int           failed;    /* did any reservation of memory fail? */
+};
+
+/* --------------------------------------------------------------
+ * int _cmp_xxx():
+ *
+ * Comparison callbacks of qsort(), one per sorting key. They all
+ * sort in ascending order, falling back to the filenames on ties.
+ * --------------------------------------------------------------
+ */
+static int _cmp_name( const void *a, const void *b )
+{
+	return strcmp( ((const ReplayInfo *)a)->fname, ((const ReplayInfo *)b)->fname );
+}
+
+#define _CMP_BY( field )                                             \
+	const ReplayInfo *ia = a, *ib = b;                           \
+	if ( ia->field != ib->field ) {                              \
+		return ia->field < ib->field ? -1 : 1;               \
+	}                                                            \
+	return _cmp_name( a, b )
+
+static int _cmp_time( const void *a, const void *b )    { _CMP_BY( mtime ); }
+static int _cmp_score( const void *a, const void *b )   { _CMP_BY( score ); }
+static int _cmp_nmoves( const void *a, const void *b )  { _CMP_BY( nmoves ); }
+static int _cmp_maxtile( const void *a, const void *b ) { _CMP_BY( maxtile ); }
+
+/* --------------------------------------------------------------
+ * int _cmp_name_key():
+ *
+ * Comparison callback of bsearch(), for looking up a filename (key)
+ * in an array of items sorted by name.
+ * --------------------------------------------------------------
+ */
+static int _cmp_name_key( const void *key, const void *item )
+{
+	return strcmp( (const char *)key, ((const ReplayInfo *)item)->fname );
+}
+
+/* --------------------------------------------------------------
+ * void _items_free():
+ *
+ * Release the specified array of (n) items (items), along with their
+ * filenames.
+ * --------------------------------------------------------------
+ */
+static void _items_free( ReplayInfo *items, long int n )
+{
+	long int i;
+
+	for (i=0; i < n; i++) {
+		free( items[i].fname );
+	}
+	free( items );
+}
+
+/* --------------------------------------------------------------
+ * int _items_append():
+ *
+ * Append a copy of the specified item (info) to the items of the
+ * specified catalog, which takes over its filename. Return 0 (false)
+ * if memory cannot be reserved, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _items_append( ReplayCatalog *catalog, const ReplayInfo *info )
+{
+	ReplayInfo *try = NULL;
+	long int capacity;
+
+	if ( catalog->nitems == catalog->capacity ) {
+		capacity = catalog->capacity ? 2 * catalog->capacity : _NMIN_ITEMS;
+		try = realloc( catalog->items, capacity * sizeof(*try) );
+		if ( NULL == try ) {
+			return 0;  /* false */
+		}
+		catalog->items    = try;
+		catalog->capacity = capacity;
+	}
+	catalog->items[ catalog->nitems++ ] = *info;
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * void _items_sort():
+ *
+ * Sort the items of the specified catalog by its current key.
+ * --------------------------------------------------------------
+ */
+static inline void _items_sort( ReplayCatalog *catalog )
+{
+	int (*cmp)( const void *, const void * ) = _cmp_time;
+
+	switch ( catalog->sortby )
+	{
+		case CATALOG_SORT_NAME:    cmp = _cmp_name;    break;
+		case CATALOG_SORT_SCORE:   cmp = _cmp_score;   break;
+		case CATALOG_SORT_NMOVES:  cmp = _cmp_nmoves;  break;
+		case CATALOG_SORT_MAXTILE: cmp = _cmp_maxtile; break;
+		default:                                       break;
+	}
+	if ( catalog->nitems > 1 ) {
+		qsort( catalog->items, catalog->nitems, sizeof(ReplayInfo), cmp );
+	}
+}
+
+/* --------------------------------------------------------------
+ * int _is_replay_fname():
+ *
+ * Return 1 (true) if the specified filename (name) has the extension
+ * of replay-files (binary or text), 0 (false) otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _is_replay_fname( const char *name )
+{
+	const char *ext = strrchr( name, '.' );
+
+	return NULL != ext && ext != name
+		&& ( 0 == strcmp(ext, REPLAY_FNAME_EXT)
+		  || 0 == strcmp(ext, REPLAY_FNAME_EXT_TEXT) );
+}
+
+/* --------------------------------------------------------------
+ * void _info_read():
+ *
+ * Load the specified replay-file (path) and fill in the metadata of
+ * the specified item (info) from its last game-state. The variant
+ * is left 0 if the file cannot be loaded.
+ *
+ * NOTE: The game-state the replay ends to is the top of the undo
+ *       gsstack (see mvhist_init_replay(), in the file: "mvhist.c").
+ * --------------------------------------------------------------
+ */
+static void _info_read( ReplayInfo *info, const char *path )
+{
+	int i, j, dim;
+	const Board     *board = NULL;
+	const GameState *state = NULL;
+	MovesHistory    *mvhist = new_mvhist_from_file( path );
+
+	info->dim = info->maxtile = info->iswin = 0;
+	info->score = info->nmoves = 0;
+	if ( NULL == mvhist ) {
+		return;
+	}
+
+	state = mvhist_peek_undo_stack_state( mvhist );
+	if ( NULL != state ) {
+		board = gamestate_get_board( state );
+		dim   = board_get_dim( board );
+		for (i=0; i < dim; i++) {
+			for (j=0; j < dim; j++) {
+				if ( info->maxtile < board_get_tile_value(board, i,j) ) {
+					info->maxtile = board_get_tile_value( board, i,j );
+				}
+			}
+		}
+		info->dim    = dim;
+		info->score  = gamestate_get_score( state );
+		info->iswin  = gamestate_get_iswin( state );
+		info->nmoves = mvhist_peek_undo_stack_count( mvhist ) - 1;
+	}
+
+	mvhist_free( mvhist );
+}
+
+/* --------------------------------------------------------------
+ * int _idx_load():
+ *
+ * Load into the specified, empty, catalog the items cached in its
+ * index file. Return 0 (false) if memory cannot be reserved, 1 (true)
+ * otherwise.
+ *
+ * NOTES:
+ *
+ *    The index file starts with a line containing the _IDX_MAGIC
+ *    signature, followed by a line per item, of the form:
+ *    "mtime size dim score nmoves maxtile iswin fname\n"
+ *
+ *    A missing index file is treated as empty, and an invalid line
+ *    just drops the rest of the file (those items get loaded from
+ *    their replay-files, and the index file gets re-written).
+ * --------------------------------------------------------------
+ */
+static int _idx_load( ReplayCatalog *catalog )
+{
+	size_t     size = 0;
+	char       *buf = f_read_all( catalog->idxname, &size );
+	const char *cp  = buf;
+	const char *eol = NULL;
+	ReplayInfo info;
+
+	if ( NULL == buf ) {
+		return 1;  /* true */
+	}
+	if ( 0 != strncmp(cp, _IDX_MAGIC "\n", sizeof(_IDX_MAGIC)) ) {
+		free( buf );
+		return 1;  /* true */
+	}
+
+	for (cp += sizeof(_IDX_MAGIC); *cp; cp = eol + 1)
+	{
+		memset( &info, 0, sizeof(info) );
+		if ( NULL == (eol = strchr(cp, '\n'))
+		|| NULL == (cp = s_parse_long(cp, &info.mtime))
+		|| NULL == (cp = s_parse_long(cp, &info.size))
+		|| NULL == (cp = s_parse_int(cp, &info.dim))
+		|| NULL == (cp = s_parse_long(cp, &info.score))
+		|| NULL == (cp = s_parse_long(cp, &info.nmoves))
+		|| NULL == (cp = s_parse_int(cp, &info.maxtile))
+		|| NULL == (cp = s_parse_int(cp, &info.iswin))
+		|| ' ' != *cp++ || cp >= eol
+		){
+			break;
+		}
+		info.fname = printf_to_text( "%.*s", (int)(eol - cp), cp );
+		if ( NULL == info.fname || !_items_append(catalog, &info) ) {
+			free( info.fname );
+			free( buf );
+			return 0;  /* false */
+		}
+	}
+
+	free( buf );
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _idx_save():
+ *
+ * Write the items of the specified catalog to its index file (see
+ * _idx_load() for the format). Return 0 (false) on error, 1 (true)
+ * otherwise.
+ *
+ * NOTE: The file is written via a temporary one, which then replaces
+ *       it, so a half-written index file is never left behind.
+ * --------------------------------------------------------------
+ */
+static int _idx_save( const ReplayCatalog *catalog )
+{
+	int      ok;
+	long int i;
+	FILE     *fp = NULL;
+	char     *tmpname = printf_to_text( "%s.tmp", catalog->idxname );
+
+	if ( NULL == tmpname ) {
+		return 0;  /* false */
+	}
+	fp = fopen( tmpname, "wb" );
+	if ( NULL == fp ) {
+		free( tmpname );
+		return 0;  /* false */
+	}
+
+	ok = EOF != fputs( _IDX_MAGIC "\n", fp );
+	for (i=0; ok && i < catalog->nitems; i++) {
+		const ReplayInfo *info = &catalog->items[i];
+		ok = fprintf(
+			fp,
+			"%ld %ld %d %ld %ld %d %d %s\n",
+			info->mtime, info->size, info->dim, info->score,
+			info->nmoves, info->maxtile, info->iswin, info->fname
+			) > 0;
+	}
+	if ( 0 != fclose(fp) ) {
+		ok = 0;  /* false */
+	}
+
+	/* replace the file (rename() does not overwrite on Windows) */
+	if ( ok
+	&& 0 != rename(tmpname, catalog->idxname)
+	&& (0 != remove(catalog->idxname) || 0 != rename(tmpname, catalog->idxname))
+	){
+		ok = 0;  /* false */
+	}
+	if ( !ok ) {
+		remove( tmpname );
+	}
+
+	free( tmpname );
+	return ok;
+}
+
+/* --------------------------------------------------------------
+ * int _scan_entry():
+ *
+ * Callback of f_scan_folder() (defined in the file: "common.c") for
+ * refreshing a catalog, as described by the specified state (arg) of
+ * the refresh. Append to the catalog the specified file (name) if it
+ * is a replay-file, re-using its old item if it is still up-to-date.
+ * Return 0 (false) if memory cannot be reserved, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _scan_entry( const char *name, void *arg )
+{
+	struct _scan *scan = arg;
+	ReplayInfo   info, *old = NULL;
+	char         *path = NULL;
+
+	if ( !_is_replay_fname(name) ) {
+		return 1;  /* true */
+	}
+
+	path = printf_to_text( "%s/%s", scan->catalog->folder, name );
+	if ( NULL == path ) {
+		scan->failed = 1;  /* true */
+		return 0;  /* false */
+	}
+	memset( &info, 0, sizeof(info) );
+	if ( !f_get_info(path, &info.mtime, &info.size) ) {
+		free( path );
+		return 1;  /* true (it is gone) */
+	}
+
+	if ( scan->nold > 0 ) {
+		old = bsearch(
+			name,
+			scan->old,
+			scan->nold,
+			sizeof(*scan->old),
+			_cmp_name_key
+			);
+	}
+	if ( old && old->mtime == info.mtime && old->size == info.size ) {
+		info = *old;
+		scan->nreused++;
+		info.fname = printf_to_text( "%s", name );
+	}
+	else {
+		info.fname = printf_to_text( "%s", name );
+		if ( NULL != info.fname ) {
+			_info_read( &info, path );
+		}
+	}
+	free( path );
+
+	if ( NULL == info.fname || !_items_append(scan->catalog, &info) ) {
+		free( info.fname );
+		scan->failed = 1;  /* true */
+		return 0;  /* false */
+	}
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * (Destructor) ReplayCatalog *catalog_free():
+ *
+ * The catalog destructor releases all resources occupied by the
+ * specified object, and returns NULL (so the caller may assign it
+ * back to the object pointer).
+ * --------------------------------------------------------------
+ */
+ReplayCatalog *catalog_free( ReplayCatalog *catalog )
+{
+	if ( catalog ) {
+		_items_free( catalog->items, catalog->nitems );
+		free( catalog->idxname );
+		free( catalog->folder );
+		free( catalog );
+	}
+	return NULL;
+}
+
+/* --------------------------------------------------------------
+ * (Constructor) ReplayCatalog *new_catalog():
+ *
+ * The catalog constructor instantiates a new, empty, catalog of the
+ * replay-files in the specified folder, and returns a pointer to it,
+ * or NULL on error. The catalog gets filled by catalog_refresh().
+ * --------------------------------------------------------------
+ */
+ReplayCatalog *new_catalog( const char *folder )
+{
+	ReplayCatalog *catalog = NULL;
+
+	if ( NULL == folder ) {
+		DBGF( "%s", "NULL pointer argument (folder)!" );
+		return NULL;
+	}
+
+	catalog = calloc( 1, sizeof(*catalog) );
+	if ( NULL == catalog ) {
+		DBGF( "%s", "calloc() failed!" );
+		return NULL;
+	}
+	catalog->folder  = printf_to_text( "%s", folder );
+	catalog->idxname = printf_to_text( "%s/%s", folder, _IDX_FNAME );
+	if ( NULL == catalog->folder || NULL == catalog->idxname ) {
+		DBGF( "%s", "printf_to_text() failed!" );
+		return catalog_free( catalog );
+	}
+	catalog->sortby = CATALOG_SORT_TIME;
+
+	return catalog;
+}
+
+/* --------------------------------------------------------------
+ * int catalog_refresh():
+ *
+ * Bring the specified catalog up-to-date with the replay-files in
+ * its folder, and sort it by its current key. Return 0 (false) on
+ * error, 1 (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    The 1st time, the items cached in the index file get loaded.
+ *    Then, every replay-file whose item is missing or out-of-date
+ *    gets loaded (see _info_read()), and the index file gets updated
+ *    if anything changed.
+ *
+ *    A missing folder is treated as an empty one.
+ * --------------------------------------------------------------
+ */
+int catalog_refresh( ReplayCatalog *catalog )
+{
+	struct _scan scan;
+
+	if ( NULL == catalog ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+
+	if ( !catalog->isloaded ) {
+		if ( !_idx_load(catalog) ) {
+			DBGF( "%s", "_idx_load() failed!" );
+			return 0;  /* false */
+		}
+		catalog->isloaded = 1;  /* true */
+	}
+
+	/* the old items get looked up by name */
+	memset( &scan, 0, sizeof(scan) );
+	scan.catalog = catalog;
+	scan.old     = catalog->items;
+	scan.nold    = catalog->nitems;
+	if ( scan.nold > 1 ) {
+		qsort( scan.old, scan.nold, sizeof(*scan.old), _cmp_name );
+	}
+	catalog->items    = NULL;
+	catalog->nitems   = 0;
+	catalog->capacity = 0;
+
+	f_scan_folder( catalog->folder, _scan_entry, &scan );
+	if ( scan.failed ) {
+		DBGF( "%s", "Out of memory!" );
+		_items_free( catalog->items, catalog->nitems );
+		catalog->items    = scan.old;
+		catalog->nitems   = scan.nold;
+		catalog->capacity = scan.nold;
+		_items_sort( catalog );
+		return 0;  /* false */
+	}
+
+	if ( scan.nreused != scan.nold || scan.nreused != catalog->nitems ) {
+		_idx_save( catalog );
+	}
+	_items_free( scan.old, scan.nold );
+	_items_sort( catalog );
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int catalog_sort():
+ *
+ * Sort the items of the specified catalog by the specified key (by),
+ * which should be one of the CATALOG_SORT_XXX constants (defined in
+ * the file: "catalog.h"), in ascending order. The key is kept for
+ * subsequent refreshes. Return 0 (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+int catalog_sort( ReplayCatalog *catalog, int by )
+{
+	if ( NULL == catalog ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+	if ( by < CATALOG_SORT_TIME || by > CATALOG_SORT_MAXTILE ) {
+		DBGF( "Invalid sorting key (%d)!", by );
+		return 0;  /* false */
+	}
+
+	catalog->sortby = by;
+	_items_sort( catalog );
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * long int catalog_get_count():
+ *
+ * Return the count of items in the specified catalog, or 0 on error.
+ * --------------------------------------------------------------
+ */
+long int catalog_get_count( const ReplayCatalog *catalog )
+{
+	if ( NULL == catalog ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;
+	}
+
+	return catalog->nitems;
+}
+
+/* --------------------------------------------------------------
+ * const ReplayInfo *catalog_get_info():
+ *
+ * Return a read-only pointer to the i'th item (0 based) of the
+ * specified catalog, in its current sorting order, or NULL on error.
+ * --------------------------------------------------------------
+ */
+const ReplayInfo *catalog_get_info( const ReplayCatalog *catalog, long int i )
+{
+	if ( NULL == catalog ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return NULL;
+	}
+	if ( i < 0 || i >= catalog->nitems ) {
+		DBGF( "Invalid item index (%ld)!", i );
+		return NULL;
+	}
+
+	return &catalog->items[i];
+}
@@ -0,0 +1,55 @@
+/****************************************************************
+ * This file is part of the "2048cc" game.
+ *
+ * Author:       migf1 <mig_f1@hotmail.com>
+ * Version:      0.3a3
+ * Date:         July 21, 2014
+ * License:      Free Software (see comments in main.c for limitations)
+ * --------------------------------------------------------------
+ *
+ * The public interface of the ReplayCatalog "class".
+ * For details, see the file: "catalog.c"
+ ****************************************************************
+ */
+
+#ifndef CATALOG_H
+#define CATALOG_H
+
+/* The "class" is forward-declared as an opaque data-type */
+typedef struct _ReplayCatalog ReplayCatalog;
+
+/* Metadata of a replay-file in a catalog (see catalog_get_info()) */
+typedef struct _replayinfo {
+	char     *fname;    /* pure filename (without the folder) */
+	long int mtime;     /* time of last modification (since the Epoch) */
+	long int size;      /* size of the file, in bytes */
+	int      dim;       /* board variant (0 if the file is unreadable) */
+	long int score;     /* score of the last game-state */
+	long int nmoves;    /* # of moves up to the last game-state */
+	int      maxtile;   /* the largest tile of the last game-state */
+	int      iswin;     /* did the game reach the winning tile? */
+} ReplayInfo;
+
+enum {  /* Sorting keys (see catalog_sort()) */
+	CATALOG_SORT_TIME = 0,/* time of last modification (default) */
+	CATALOG_SORT_NAME,    /* filename */
+	CATALOG_SORT_SCORE,   /* score */
+	CATALOG_SORT_NMOVES,  /* # of moves */
+	CATALOG_SORT_MAXTILE  /* largest tile */
+};
+
+#ifndef CATALOG_C
+extern ReplayCatalog    *new_catalog( const char *folder );
+extern ReplayCatalog    *catalog_free( ReplayCatalog *catalog );
+
+extern int              catalog_refresh( ReplayCatalog *catalog );
+extern int              catalog_sort( ReplayCatalog *catalog, int by );
+
+extern long int         catalog_get_count( const ReplayCatalog *catalog );
+extern const ReplayInfo *catalog_get_info(
+                                const ReplayCatalog *catalog,
+                                long int            i
+                                );
+#endif
+
+#endif
@@ -9,7 +9,8 @@
  * --------------------------------------------------------------
  *
  * A collection of miscellaneous, utility functions dealing mostly
- * with c-strings handling (including filenames).
+ * with c-strings handling (including filenames), plus a few thin
+ * wrappers of OS facilities (files & threads).
  *
  * The accompanying header file ("common.h") is also defining some
  * additional constants & macros related to c-strings and debugging
@@ -24,9 +25,58 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdarg.h>
+#include <limits.h>       /* INT_MIN, INT_MAX, LONG_MAX */
+#include <time.h>         /* time(), clock_gettime() */
 
 #include "common.h"
 
+#if defined( CC2048_OS_UNIX ) || defined( CC2048_OS_LINUX ) \
+|| defined( CC2048_OS_OSX )
+	#include <fcntl.h>         /* open() */
+	#include <unistd.h>        /* close(), sysconf() */
+	#include <sys/mman.h>      /* mmap(), munmap() */
+	#include <sys/stat.h>      /* fstat(), stat() */
+	#include <dirent.h>        /* opendir(), readdir(), closedir() */
+	#include <pthread.h>       /* pthread_create(), pthread_join() */
+	#define _HAS_POSIX_IO
+	#define _HAS_PTHREADS
+
+#elif defined( CC2048_OS_WINDOWS )
+	#include <io.h>            /* _commit(), _fileno(), _findfirst() */
+	#include <sys/stat.h>      /* stat() */
+	#include <stdint.h>        /* intptr_t */
+	#include <windows.h>       /* CreateThread(), WaitForSingleObject() */
+#endif
+
+/* A thread started by th_start() (it is opaque to the callers) */
+struct _thread {
+#if defined( _HAS_PTHREADS )
+	pthread_t       id;
+	pthread_mutex_t mutex;    /* guards done */
+#elif defined( CC2048_OS_WINDOWS )
+	HANDLE          handle;
+#endif
+	int             (*fn)( void *arg );
+	void            *arg;
+	int             ret;      /* the return value of fn */
+	int             done;     /* has fn returned? */
+};
+
+/* Is the calling thread one started by th_start()? (see th_isworker()) */
+static TH_LOCAL int _th_isworker = 0;  /* false */
+
+/* --------------------------------------------------------------
+ * int th_isworker():
+ *
+ * Return 1 (true) if the calling thread has been started by the
+ * function th_start(), 0 (false) otherwise (e.g. the main thread).
+ * --------------------------------------------------------------
+ */
+int th_isworker( void )
+{
+	return _th_isworker;
+}
+
 /* --------------------------------------------------------------
  * char *vprintf_to_text():
  *
@@ -124,6 +174,469 @@ int f_exists( const char *fname )
 	return 1;  /* true */
 }
 
+/* --------------------------------------------------------------
+ * char *f_read_all():
+ *
+ * Read the whole contents of the specified file (fname) into a newly
+ * allocated buffer, terminated by an extra NUL byte, and pass their
+ * size (without the NUL byte) back to the caller via the argument
+ * (size). Return a pointer to the buffer, which should be freed by
+ * the caller, or NULL on error.
+ * --------------------------------------------------------------
+ */
+char *f_read_all( const char *fname, size_t *size )
+{
+	long int n;
+	char *buf = NULL;
+	FILE *fp  = NULL;
+
+	if ( NULL == fname || NULL == size ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return NULL;
+	}
+
+	fp = fopen( fname, "rb" );
+	if ( NULL == fp ) {
+		return NULL;
+	}
+	if ( 0 != fseek(fp, 0, SEEK_END)
+	|| (n = ftell(fp)) < 0
+	|| 0 != fseek(fp, 0, SEEK_SET)
+	){
+		fclose( fp );
+		return NULL;
+	}
+
+	buf = malloc( n + 1 );
+	if ( NULL == buf ) {
+		DBGF( "%s", "malloc() failed!" );
+		fclose( fp );
+		return NULL;
+	}
+	*size = fread( buf, 1, n, fp );
+	buf[ *size ] = '\0';
+	fclose( fp );
+
+	return buf;
+}
+
+/* --------------------------------------------------------------
+ * int f_sync():
+ *
+ * Flush the buffers of the specified file (fp) and ask the system to
+ * commit its contents to the storage device. Return 0 (false) on error,
+ * 1 (true) otherwise.
+ *
+ * NOTE: On platforms without a known way to commit files, the buffers
+ *       are just flushed.
+ * --------------------------------------------------------------
+ */
+int f_sync( FILE *fp )
+{
+	if ( NULL == fp ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+
+	if ( 0 != fflush(fp) ) {
+		return 0;  /* false */
+	}
+#if defined( _HAS_POSIX_IO )
+	return 0 == fsync( fileno(fp) );
+#elif defined( CC2048_OS_WINDOWS )
+	return 0 == _commit( _fileno(fp) );
+#else
+	return 1;  /* true */
+#endif
+}
+
+/* --------------------------------------------------------------
+ * char *f_map_all():
+ *
+ * Map the whole contents of the specified file (fname) read-only into
+ * memory, and pass their size back to the caller via the argument
+ * (size). Return a pointer to the mapped contents, which should be
+ * unmapped by the caller via f_unmap_all(), or NULL on error.
+ *
+ * NOTES:
+ *
+ *    Like the buffer of f_read_all(), the mapped contents are followed
+ *    by a NUL byte (the zero-filled tail of their last memory page).
+ *    So, files whose size is a multiple of the page size are NOT mapped,
+ *    and neither are empty files.
+ *
+ *    NULL is also returned on platforms without mmap(), so callers are
+ *    expected to fall back to f_read_all() in all those cases.
+ * --------------------------------------------------------------
+ */
+char *f_map_all( const char *fname, size_t *size )
+{
+#if defined( _HAS_POSIX_IO )
+	int  fd;
+	long int pgsize = sysconf( _SC_PAGESIZE );
+	void *map = NULL;
+	struct stat st;
+
+	if ( NULL == fname || NULL == size ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return NULL;
+	}
+
+	fd = open( fname, O_RDONLY );
+	if ( -1 == fd ) {
+		return NULL;
+	}
+	if ( 0 != fstat(fd, &st)
+	|| st.st_size < 1
+	|| pgsize < 1
+	|| 0 == st.st_size % pgsize
+	){
+		close( fd );
+		return NULL;
+	}
+
+	map = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );       /* the mapping stays valid */
+	if ( MAP_FAILED == map ) {
+		return NULL;
+	}
+	*size = st.st_size;
+
+	return map;
+#else
+	(void)fname;
+	(void)size;
+	return NULL;
+#endif
+}
+
+/* --------------------------------------------------------------
+ * char *f_unmap_all():
+ *
+ * Unmap the specified contents (buf) of a file, as mapped by the
+ * function f_map_all(), along with their size (size). Return NULL
+ * (so the caller may assign it back to the contents pointer).
+ * --------------------------------------------------------------
+ */
+char *f_unmap_all( char *buf, size_t size )
+{
+#if defined( _HAS_POSIX_IO )
+	if ( buf ) {
+		munmap( buf, size );
+	}
+#else
+	(void)buf;
+	(void)size;
+#endif
+	return NULL;
+}
+
+/* --------------------------------------------------------------
+ * int f_get_info():
+ *
+ * Pass back to the caller the time of the last modification (mtime)
+ * of the specified file (fname), in seconds since the Epoch, and its
+ * size in bytes (size). Return 0 (false) if the file is not available
+ * (or on platforms without a known way to tell), 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+int f_get_info( const char *fname, long int *mtime, long int *size )
+{
+#if defined( _HAS_POSIX_IO ) || defined( CC2048_OS_WINDOWS )
+	struct stat st;
+
+	if ( NULL == fname || NULL == mtime || NULL == size ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+
+	if ( 0 != stat(fname, &st) ) {
+		return 0;  /* false */
+	}
+	*mtime = (long int) st.st_mtime;
+	*size  = (long int) st.st_size;
+
+	return 1;  /* true */
+#else
+	(void)fname;
+	(void)mtime;
+	(void)size;
+	return 0;  /* false */
+#endif
+}
+
+/* --------------------------------------------------------------
+ * int f_scan_folder():
+ *
+ * Call the specified function (fn) for the name of every entry of the
+ * specified folder (without the folder prefixed, and skipping "." and
+ * ".."), passing it along the specified argument (arg). Stop as soon
+ * as fn returns 0. Return 0 (false) if the folder cannot be read, or
+ * fn returned 0, 1 (true) otherwise.
+ *
+ * NOTE: On platforms without a known way to read folders, 0 (false)
+ *       is always returned.
+ * --------------------------------------------------------------
+ */
+int f_scan_folder(
+	const char *folder,
+	int        (*fn)( const char *name, void *arg ),
+	void       *arg
+	)
+{
+#if defined( _HAS_POSIX_IO )
+	int ret = 1;  /* true */
+	DIR *dir = NULL;
+	struct dirent *ent = NULL;
+
+	if ( NULL == folder || NULL == fn ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+
+	dir = opendir( folder );
+	if ( NULL == dir ) {
+		return 0;  /* false */
+	}
+	while ( ret && NULL != (ent = readdir(dir)) ) {
+		if ( 0 != strcmp(ent->d_name, ".") && 0 != strcmp(ent->d_name, "..") ) {
+			ret = fn( ent->d_name, arg );
+		}
+	}
+	closedir( dir );
+
+	return ret;
+
+#elif defined( CC2048_OS_WINDOWS )
+	int ret = 1;  /* true */
+	intptr_t h;
+	char *pattern = NULL;
+	struct _finddata_t fd;
+
+	if ( NULL == folder || NULL == fn ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+
+	pattern = printf_to_text( "%s\\*", folder );
+	if ( NULL == pattern ) {
+		DBGF( "%s", "printf_to_text() failed!" );
+		return 0;  /* false */
+	}
+	h = _findfirst( pattern, &fd );
+	free( pattern );
+	if ( -1 == h ) {
+		return 0;  /* false */
+	}
+	do {
+		if ( 0 != strcmp(fd.name, ".") && 0 != strcmp(fd.name, "..") ) {
+			ret = fn( fd.name, arg );
+		}
+	} while ( ret && 0 == _findnext(h, &fd) );
+	_findclose( h );
+
+	return ret;
+
+#else
+	(void)folder;
+	(void)fn;
+	(void)arg;
+	return 0;  /* false */
+#endif
+}
+
+/* --------------------------------------------------------------
+ * (thread entry-point) _th_main():
+ *
+ * Run the function of the specified thread (th), keep its return
+ * value and mark the thread as done.
+ * --------------------------------------------------------------
+ */
+#if defined( _HAS_PTHREADS )
+static void *_th_main( void *th )
+{
+	struct _thread *t = th;
+
+	_th_isworker = 1;  /* true */
+	t->ret = t->fn( t->arg );
+	pthread_mutex_lock( &t->mutex );
+	t->done = 1;  /* true */
+	pthread_mutex_unlock( &t->mutex );
+
+	return NULL;
+}
+#elif defined( CC2048_OS_WINDOWS )
+static DWORD WINAPI _th_main( LPVOID th )
+{
+	struct _thread *t = th;
+
+	_th_isworker = 1;  /* true */
+	t->ret = t->fn( t->arg );
+	return 0;
+}
+#endif
+
+/* --------------------------------------------------------------
+ * void *th_start():
+ *
+ * Start a new thread running the specified function (fn) with the
+ * specified argument (arg). Return an opaque handle of the thread,
+ * which MUST be passed to th_join() eventually, or NULL on error.
+ *
+ * NOTE: On platforms without a known threads facility, fn is run
+ *       to completion before the function returns.
+ * --------------------------------------------------------------
+ */
+void *th_start( int (*fn)(void *arg), void *arg )
+{
+	struct _thread *t = NULL;
+
+	if ( NULL == fn ) {
+		DBGF( "%s", "NULL pointer argument (fn)!" );
+		return NULL;
+	}
+	if ( NULL == (t = calloc(1, sizeof(*t))) ) {
+		DBGF( "%s", "calloc() failed!" );
+		return NULL;
+	}
+	t->fn  = fn;
+	t->arg = arg;
+
+#if defined( _HAS_PTHREADS )
+	if ( 0 != pthread_mutex_init(&t->mutex, NULL) ) {
+		free( t );
+		return NULL;
+	}
+	if ( 0 != pthread_create(&t->id, NULL, _th_main, t) ) {
+		pthread_mutex_destroy( &t->mutex );
+		free( t );
+		return NULL;
+	}
+#elif defined( CC2048_OS_WINDOWS )
+	t->handle = CreateThread( NULL, 0, _th_main, t, 0, NULL );
+	if ( NULL == t->handle ) {
+		free( t );
+		return NULL;
+	}
+#else
+	t->ret  = fn( arg );
+	t->done = 1;  /* true */
+#endif
+
+	return t;
+}
+
+/* --------------------------------------------------------------
+ * int th_isdone():
+ *
+ * Return 1 (true) if the function of the specified thread (th)
+ * has returned (so th_join() will not block), 0 (false) otherwise.
+ * --------------------------------------------------------------
+ */
+int th_isdone( void *th )
+{
+	int done;
+	struct _thread *t = th;
+
+	if ( NULL == t ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+
+#if defined( _HAS_PTHREADS )
+	pthread_mutex_lock( &t->mutex );
+	done = t->done;
+	pthread_mutex_unlock( &t->mutex );
+#elif defined( CC2048_OS_WINDOWS )
+	done = (WAIT_OBJECT_0 == WaitForSingleObject(t->handle, 0));
+#else
+	done = t->done;
+#endif
+
+	return done;
+}
+
+/* --------------------------------------------------------------
+ * int th_join():
+ *
+ * Wait for the function of the specified thread (th) to return,
+ * release the thread, and return the value returned by the function.
+ * --------------------------------------------------------------
+ */
+int th_join( void *th )
+{
+	int ret;
+	struct _thread *t = th;
+
+	if ( NULL == t ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;
+	}
+
+#if defined( _HAS_PTHREADS )
+	pthread_join( t->id, NULL );
+	pthread_mutex_destroy( &t->mutex );
+#elif defined( CC2048_OS_WINDOWS )
+	WaitForSingleObject( t->handle, INFINITE );
+	CloseHandle( t->handle );
+#endif
+	ret = t->ret;
+	free( t );
+
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int th_count_cpus():
+ *
+ * Return the count of the processors that are currently online
+ * (that is, how many threads may run in parallel), or 1 if it
+ * cannot be found.
+ * --------------------------------------------------------------
+ */
+int th_count_cpus( void )
+{
+#if defined( _HAS_POSIX_IO )
+	long int n = sysconf( _SC_NPROCESSORS_ONLN );
+	return n > 0 && n <= INT_MAX ? (int)n : 1;
+#elif defined( CC2048_OS_WINDOWS )
+	SYSTEM_INFO si;
+	GetSystemInfo( &si );
+	return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+#else
+	return 1;
+#endif
+}
+
+/* --------------------------------------------------------------
+ * double th_wall_secs():
+ *
+ * Return the current time of a monotonic wall-clock, in seconds.
+ * Only the difference of 2 such times is meaningful (that is, the
+ * elapsed time between them, regardless of how many threads ran).
+ *
+ * NOTE: On platforms without a known monotonic clock, the function
+ *       falls back to ISO C's time() (that is, whole seconds).
+ * --------------------------------------------------------------
+ */
+double th_wall_secs( void )
+{
+#if defined( _HAS_POSIX_IO )
+	struct timespec ts;
+	if ( 0 == clock_gettime(CLOCK_MONOTONIC, &ts) ) {
+		return ts.tv_sec + ts.tv_nsec / 1e9;
+	}
+#elif defined( CC2048_OS_WINDOWS )
+	LARGE_INTEGER freq, now;
+	if ( QueryPerformanceFrequency(&freq)
+	&& QueryPerformanceCounter(&now)
+	){
+		return (double)now.QuadPart / (double)freq.QuadPart;
+	}
+#endif
+	return (double) time( NULL );
+}
+
 /* --------------------------------------------------------------
  * Read a c-string from stdin, flushing any extra characters.
  *
@@ -197,6 +710,69 @@ int s_tokenize( char *s, char *tokens[], int ntoks, const char *delims )
 	return i;
 }
 
+/* --------------------------------------------------------------
+ * const char *s_parse_long():
+ *
+ * Parse the decimal integer found at the start of the c-string (s),
+ * after any leading blanks (spaces or tabs), and pass it back to the
+ * caller via the argument (val). Return a pointer to the character
+ * right after the integer, or NULL if there is no integer or it does
+ * not fit in a long int.
+ *
+ * NOTE: It is a minimal, allocation-free alternative to sscanf(),
+ *       meant for parsing large files in place.
+ * --------------------------------------------------------------
+ */
+const char *s_parse_long( const char *s, long int *val )
+{
+	int neg = 0;
+	unsigned long int u = 0;
+	const char *digits = NULL;
+
+	if ( NULL == s || NULL == val ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return NULL;
+	}
+
+	while ( ' ' == *s || '\t' == *s ) {
+		s++;
+	}
+	if ( '-' == *s || '+' == *s ) {
+		neg = ('-' == *s++);
+	}
+	for (digits = s; *s >= '0' && *s <= '9'; s++) {
+		if ( u > (LONG_MAX - (unsigned long)(*s - '0')) / 10 ) {
+			return NULL;
+		}
+		u = 10 * u + (*s - '0');
+	}
+	if ( s == digits ) {
+		return NULL;
+	}
+
+	*val = neg ? -(long int)u : (long int)u;
+	return s;
+}
+
+/* --------------------------------------------------------------
+ * const char *s_parse_int():
+ *
+ * Same as s_parse_long(), but for an int (val).
+ * --------------------------------------------------------------
+ */
+const char *s_parse_int( const char *s, int *val )
+{
+	long int lval;
+
+	s = s_parse_long( s, &lval );
+	if ( NULL == s || NULL == val || lval < INT_MIN || lval > INT_MAX ) {
+		return NULL;
+	}
+
+	*val = (int) lval;
+	return s;
+}
+
 /* --------------------------------------------------------------
  * char *s_char_replace():
  *
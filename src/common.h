@@ -22,37 +22,48 @@
  */
 #define REPLAYS_FOLDER          "replays"
 #define SZMAX_FNAME             BUFSIZ
-#define REPLAY_FNAME_EXT        ".sav"
+#define REPLAY_FNAME_EXT        ".sav2"  /* binary format */
+#define REPLAY_FNAME_EXT_TEXT   ".sav"   /* text format (earlier versions) */
+#define JOURNAL_FNAME           REPLAYS_FOLDER "/journal.jnl"
 
-/* Determine the compilation OS & define accordingly some
- * more constants related to replay files.
+/* Determine the compilation OS.
  */
 #if defined(_WIN32) || defined(_WIN64) || defined(__WINDOWS__) \
 || defined(__TOS_WIN__)
 	#define CC2048_OS_WINDOWS
-	#define LS_REPLAYS      "dir/D " REPLAYS_FOLDER "\\*" REPLAY_FNAME_EXT
 
 #elif ( defined(__APPLE__) && defined(__MACH__) )              \
 || ( defined(__APPLE__) && defined(__MACH) )
 	#define CC2048_OS_OSX
-	#define LS_REPLAYS      "ls -Gp " REPLAYS_FOLDER "/*" REPLAY_FNAME_EXT
 
 #elif defined(__linux__) || defined(__linux) || defined(linux) \
 || defined(__gnu_linux__)
 	#define CC2048_OS_LINUX
-	#define LS_REPLAYS      "ls --color -p " REPLAYS_FOLDER "/*" REPLAY_FNAME_EXT
 
 #elif defined(__unix__) || defined(__unix) || defined(unix)    \
 || defined(__CYGWIN__)
 	#define CC2048_OS_UNIX
-	#define LS_REPLAYS      "ls -Gp " REPLAYS_FOLDER "/*" REPLAY_FNAME_EXT
 
 #else
 	#define CC2048_OS_UNKNOWN
-	#define LS_REPLAYS      /* void */
 
 #endif
 
+/* Thread-local storage specifier, depending on the compiler
+ * (it is left empty when none is available, which is fine as
+ * long as the game stays single-threaded).
+ */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L \
+&& !defined(__STDC_NO_THREADS__)
+	#define TH_LOCAL    _Thread_local
+#elif defined(__GNUC__) || defined(__clang__)
+	#define TH_LOCAL    __thread
+#elif defined(_MSC_VER)
+	#define TH_LOCAL    __declspec(thread)
+#else
+	#define TH_LOCAL    /* void */
+#endif
+
 /* Cross-platform alternative to Windows' system( "pause" ).
  */
 #define pressENTER()                                              \
@@ -65,10 +76,26 @@ do {                                                              \
 
 /* Print the specified msg a-la printf(),
  * along with debugging information.
+ *
+ * When the macro CC2048_QUIET is defined at compile-time (e.g. by
+ * the headless tools of the folder "tools/", which report errors on
+ * their own) nothing is printed. Nothing is printed by the threads
+ * started with th_start() either (e.g. a save in the background),
+ * since they must not wait for the player.
  */
+#if defined( CC2048_QUIET )
+#define DBGF( format, ... )                                       \
+do {                                                              \
+	if ( 0 )  /* just type-check the arguments */             \
+	fprintf(stderr, (const char *)(format), __VA_ARGS__);     \
+} while(0)
+
+#else
 #define DBGF( format, ... )                                       \
 do {                                                              \
 	int c_;                                                   \
+	if ( th_isworker() )                                      \
+		break;                                            \
 	puts("*** RUNTIME ERROR CAUGHT ****");                    \
 	fprintf(stderr, "*** File: %s | Line: %d | Func: %s()\n", \
 		__FILE__, __LINE__, __func__);                    \
@@ -79,6 +106,7 @@ do {                                                              \
 	fflush(stdout);                                           \
 	while ( '\n' != (c_=getchar()) && EOF != c_ );            \
 } while(0)
+#endif
 
 
 /*
@@ -90,6 +118,23 @@ extern char *vprintf_to_text( const char *fmt, va_list vargs );
 extern char *printf_to_text( const char *fmt, ... );
 
 extern int  f_exists( const char *fname );
+extern char *f_read_all( const char *fname, size_t *size );
+extern char *f_map_all( const char *fname, size_t *size );
+extern char *f_unmap_all( char *buf, size_t size );
+extern int  f_sync( FILE *fp );
+extern int  f_get_info( const char *fname, long int *mtime, long int *size );
+extern int  f_scan_folder(
+                    const char *folder,
+                    int        (*fn)( const char *name, void *arg ),
+                    void       *arg
+                    );
+
+extern void *th_start( int (*fn)(void *arg), void *arg );
+extern int  th_isdone( void *th );
+extern int  th_isworker( void );
+extern int  th_join( void *th );
+extern int  th_count_cpus( void );
+extern double th_wall_secs( void );
 
 extern char *s_getflushed( char *s, size_t ssize );
 extern int  s_tokenize(
@@ -102,6 +147,8 @@ extern char *s_char_replace( char *s, int cin, int cout );
 extern char *s_trim( char *s );
 extern char *s_strip( char *s, const char *del );
 extern char *s_fixeol( char *s  );
+extern const char *s_parse_long( const char *s, long int *val );
+extern const char *s_parse_int( const char *s, int *val );
 #endif
 
 #endif
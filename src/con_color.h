@@ -1090,6 +1090,41 @@ typedef struct ConColors {
 #define CONOUT_PAINT_NTIMES(bg, n) \
 	CONOUT_LL_PAINT_NTIMES( (bg), (n) )
 
+/*********************************************************************//**
+ * @par    CONOUT_BEGIN_FRAME()
+ * @brief 	Start composing a frame.
+ * @details	Until the matching CONOUT_END_FRAME(), the output of all
+ *		the macros is only buffered (normally, every macro flushes
+ *		its output) so a whole frame reaches the console at once,
+ *		with as few system calls as possible. Frames may be nested,
+ *		in which case only the outermost one counts.
+ * @remarks	Only the ANSI color-mode buffers anything. In the other
+ *		color-modes the macro does nothing.
+ *		\n
+ *		In the ANSI color-mode, the console colors are also not
+ *		reset after every macro, but once at the end of the frame.
+ *		Since a color is emitted only if the console is not set
+ *		to it already, consecutive output in the same colors does
+ *		not repeat any escape sequence.
+ * @note   	Output written by other means (e.g. printf()) while
+ *		composing a frame gets buffered too, but it should NOT
+ *		be flushed explicitly. It also gets the colors of the
+ *		preceding output of the frame.
+ * @sa		CONOUT_END_FRAME()
+ */
+#define CONOUT_BEGIN_FRAME() \
+	CONOUT_LL_BEGIN_FRAME()
+
+/*********************************************************************//**
+ * @par    CONOUT_END_FRAME()
+ * @brief 	End composing a frame.
+ * @details	If it is the outermost frame, the console colors are reset
+ *		and its whole output is flushed.
+ * @sa		CONOUT_BEGIN_FRAME()
+ */
+#define CONOUT_END_FRAME() \
+	CONOUT_LL_END_FRAME()
+
 /** @}*/ /* end of RC104_MACROS doxygen sub-group */
 
 
@@ -391,6 +391,9 @@ do {                                                              \
 	#define CONSYS_LL_GET_FG_LABEL()  (const char *)CONOUT_MSG_NOCOLOR
 	#define CONSYS_LL_GET_BG_LABEL()  (const char *)CONOUT_MSG_NOCOLOR
 
+	#define CONOUT_LL_BEGIN_FRAME()   do { ; } while(0)
+	#define CONOUT_LL_END_FRAME()     fflush( stdout )
+
 	#define CONOUT_LL_PAINT(bg)                             \
 		do {                                            \
 			putchar( '-' );                         \
@@ -603,7 +606,7 @@ do {                                                                    \
 	CONOUT_LL_SET_COLOR(fg);                                        \
 	CONOUT_LL_ADD_COLOR(bg);                                        \
 	putchar( (int)(c) );                                            \
-	fflush(stdout);                                                 \
+	CONOUT_LL_FLUSH();                                              \
 	CONOUT_LL_RESET();                                              \
 } while(0)
 
@@ -619,13 +622,16 @@ do {                                                                    \
 		errPUTS( "*** CONOUT_PUTCHAR_NTIMES(): The interface is NOT inited! ***"); \
 		break;                                                  \
 	}                                                               \
+	if ( (int)(ntimes) < 1 ) {                                      \
+		break;                                                  \
+	}                                                               \
+	CONOUT_LL_SET_COLOR(fg);                                        \
+	CONOUT_LL_ADD_COLOR(bg);                                        \
 	for (ii=0; ii < (int)(ntimes); ii++) {                          \
-		CONOUT_LL_SET_COLOR(fg);                                \
-		CONOUT_LL_ADD_COLOR(bg);                                \
 		putchar( (int)(c) );                                    \
-		fflush(stdout);                                         \
-		CONOUT_LL_RESET();                                      \
 	}                                                               \
+	CONOUT_LL_FLUSH();                                              \
+	CONOUT_LL_RESET();                                              \
 }while(0)
 
 /*******************************//**
@@ -643,10 +649,10 @@ do {                                                                    \
 	CONOUT_LL_SET_COLOR( (fg) );                                    \
 	CONOUT_LL_ADD_COLOR( (bg) );                                    \
 	printf( "%s", (char *)(str) );                                  \
-	fflush(stdout);                                                 \
+	CONOUT_LL_FLUSH();                                              \
 	CONOUT_LL_RESET();                                              \
 	putchar('\n');                                                  \
-	fflush(stdout);                                                 \
+	CONOUT_LL_FLUSH();                                              \
 } while(0)
 
 /*******************************//**
@@ -664,7 +670,7 @@ do {                                                                    \
 	CONOUT_LL_SET_COLOR( (fg) );                                    \
 	CONOUT_LL_ADD_COLOR( (bg) );                                    \
 	printf( __VA_ARGS__ );                                          \
-	fflush(stdout);                                                 \
+	CONOUT_LL_FLUSH();                                              \
 	CONOUT_LL_RESET();                                              \
 } while(0)
 
@@ -684,7 +690,7 @@ do {                                                                    \
 	CONOUT_LL_SET_COLOR( (fg) );                                    \
 	CONOUT_LL_ADD_COLOR( (bg) );                                    \
 	(n) = printf( __VA_ARGS__ );                                    \
-	fflush(stdout);                                                 \
+	CONOUT_LL_FLUSH();                                              \
 	CONOUT_LL_RESET();                                              \
 } while(0)
 
@@ -702,7 +708,7 @@ do {                                                                    \
 	CONOUT_LL_SET_COLOR(fg);                                        \
 	CONOUT_LL_ADD_COLOR(bg);                                        \
 	putwchar( (wchar_t)(wc) );                                      \
-	fflush(stdout);                                                 \
+	CONOUT_LL_FLUSH();                                              \
 	CONOUT_LL_RESET();                                              \
 } while(0)
 
@@ -718,13 +724,16 @@ do {                                                                    \
 		errPUTS( "*** CONOUT_PUTWCHAR_NTIMES(): The interface is NOT inited! ***"); \
 		break;                                                  \
 	}                                                               \
+	if ( (ntimes) < 1 ) {                                           \
+		break;                                                  \
+	}                                                               \
+	CONOUT_LL_SET_COLOR(fg);                                        \
+	CONOUT_LL_ADD_COLOR(bg);                                        \
 	for (i=0; i < (ntimes); i++) {                                  \
-		CONOUT_LL_SET_COLOR(fg);                                \
-		CONOUT_LL_ADD_COLOR(bg);                                \
 		putwchar( (wchar_t)(wc) );                              \
-		fflush(stdout);                                         \
-		CONOUT_LL_RESET();                                      \
 	}                                                               \
+	CONOUT_LL_FLUSH();                                              \
+	CONOUT_LL_RESET();                                              \
 }while(0)
 
 /********************************************************************//**
@@ -741,10 +750,10 @@ do {                                                                    \
 	CONOUT_LL_SET_COLOR( (fg) );                                    \
 	CONOUT_LL_ADD_COLOR( (bg) );                                    \
 	wprintf( L"%ls", (wchar_t *)(wstr) );                           \
-	fflush(stdout);                                                 \
+	CONOUT_LL_FLUSH();                                              \
 	CONOUT_LL_RESET();                                              \
 	putchar('\n');                                                  \
-	fflush(stdout);                                                 \
+	CONOUT_LL_FLUSH();                                              \
 } while(0)
 
 /********************************************************************//**
@@ -761,7 +770,7 @@ do {                                                                    \
 	CONOUT_LL_SET_COLOR( (fg) );                                    \
 	CONOUT_LL_ADD_COLOR( (bg) );                                    \
 	wprintf( __VA_ARGS__ );                                         \
-	fflush(stdout);                                                 \
+	CONOUT_LL_FLUSH();                                              \
 	CONOUT_LL_RESET();                                              \
 } while(0)
 
@@ -779,7 +788,7 @@ do {                                                                    \
 	CONOUT_LL_SET_COLOR( (fg) );                                    \
 	CONOUT_LL_ADD_COLOR( (bg) );                                    \
 	(n) = wprintf( __VA_ARGS__ );                                   \
-	fflush(stdout);                                                 \
+	CONOUT_LL_FLUSH();                                              \
 	CONOUT_LL_RESET();                                              \
 } while(0)
 
@@ -803,6 +812,14 @@ do {                                                                    \
 	}ConOut;
 	typedef WORD ConColor_T;       /* Win32 colors are 16bit WORDs */
 
+	/* Colors are attributes of the console, applied when the output
+	 * gets written, so it can neither be buffered nor composed into
+	 * frames (they are accepted, but they do nothing).
+	 */
+	#define CONOUT_LL_BEGIN_FRAME()   do { ; } while(0)
+	#define CONOUT_LL_END_FRAME()     fflush( stdout )
+	#define CONOUT_LL_FLUSH()         fflush( stdout )
+
 	/* ================================
 	 * the Win32 API defines console colors
 	 * as 16bit WORDs in <wincon.h>
@@ -1542,8 +1559,11 @@ do {                                                                    \
 
 	typedef struct ConOut {
 		int  isInited;
+		int  nframes;  /* depth of frames (see CONOUT_LL_BEGIN_FRAME()) */
 		char curFg[ CONOUT_LL_CLRSZ ];
 		char curBg[ CONOUT_LL_CLRSZ ];
+		char termFg[ CONOUT_LL_CLRSZ ];  /* as set on the terminal */
+		char termBg[ CONOUT_LL_CLRSZ ];  /* (see CONOUT_LL_RESET()) */
 		char fg_label[ CONOUT_LL_MAXLEN_ColorLABEL ];
 		char bg_label[ CONOUT_LL_MAXLEN_ColorLABEL ];
 	}ConOut;
@@ -1670,11 +1690,13 @@ do {                                                                    \
 		memset( &g_conout, 0, sizeof(ConOut) );	                \
 		                                                        \
 		printf( "%s", "\033[0m" );                              \
-		fflush( stdout );                                       \
+		CONOUT_LL_FLUSH();                                      \
 		                                                        \
 		g_conout.isInited = 1;                                  \
 		CONOUT_LL_CPYCLR(g_conout.curFg, FGLL_DEFAULT);         \
 		CONOUT_LL_CPYCLR(g_conout.curBg, BGLL_DEFAULT);         \
+		CONOUT_LL_CPYCLR(g_conout.termFg, FGLL_DEFAULT);        \
+		CONOUT_LL_CPYCLR(g_conout.termBg, BGLL_DEFAULT);        \
 		CONOUT_LL_SET_FG_LABEL();                               \
 		CONOUT_LL_SET_BG_LABEL();                               \
 	} while( 0 )
@@ -1691,10 +1713,12 @@ do {                                                                    \
 		}                                                       \
 		                                                        \
 		printf( "%s", "\033[0m" );                              \
-		fflush(stdout);                                         \
+		CONOUT_LL_FLUSH();                                      \
 		                                                        \
 		CONOUT_LL_CPYCLR(g_conout.curFg, FGLL_DEFAULT);         \
 		CONOUT_LL_CPYCLR(g_conout.curBg, BGLL_DEFAULT);         \
+		CONOUT_LL_CPYCLR(g_conout.termFg, FGLL_DEFAULT);        \
+		CONOUT_LL_CPYCLR(g_conout.termBg, BGLL_DEFAULT);        \
 		CONOUT_LL_SET_FG_LABEL();                               \
 		CONOUT_LL_SET_BG_LABEL();                               \
 	} while(0)
@@ -1715,17 +1739,74 @@ do {                                                                    \
 	#define CONOUT_LL_CPYCLR( dst, src )	\
 		strncpy( (dst), (src), CONOUT_LL_CLRSZ-1 )
 
+	/*******************************//**
+	 * ANSI - Medi Level
+	 * @brief start composing a frame: until the matching
+	 *        CONOUT_LL_END_FRAME(), output is only buffered
+	 * @note  frames may be nested (only the outermost one counts)
+	 */
+	#define CONOUT_LL_BEGIN_FRAME()                                 \
+	do {                                                            \
+		g_conout.nframes++;                                     \
+	} while(0)
+
+	/*******************************//**
+	 * ANSI - Medi Level
+	 * @brief end composing a frame, emitting all of it at once
+	 *        (if it is the outermost one)
+	 * @note  the terminal colors get reset here, rather than after
+	 *        every colored output of the frame (see CONOUT_LL_RESET())
+	 */
+	#define CONOUT_LL_END_FRAME()                                   \
+	do {                                                            \
+		if ( g_conout.nframes > 0 && 0 == --g_conout.nframes ) {\
+			CONOUT_LL_RESET();                              \
+			fflush( stdout );                               \
+		}                                                       \
+	} while(0)
+
+	/*******************************//**
+	 * ANSI - Medi Level
+	 * @brief flush the output, unless a frame is being composed
+	 */
+	#define CONOUT_LL_FLUSH()                                       \
+	do {                                                            \
+		if ( 0 == g_conout.nframes ) {                          \
+			fflush( stdout );                               \
+		}                                                       \
+	} while(0)
+
 
 	/* ANSI LowLevel Macros (NOT intended for end-users) ---------- */
 
+	/* The SGR sequences of the colors are emitted only when the
+	 * terminal is not set to them already (see termFg & termBg).
+	 * Inside a frame, the reset after every colored output is also
+	 * skipped, and done just once at the end of the frame, so runs
+	 * of output in the same colors do not repeat any sequence.
+	 */
+
+	/* does the color (clr) turn bold on? (e.g. FGLL_RED) */
+	#define CONOUT_LL_ISBOLD( clr )    ( '1' == (clr)[2] )
+
 	#define CONOUT_LL_RESET()                                       \
 	do {                                                            \
 		if ( !g_conout.isInited ) {                             \
 			errPUTS( "*** CONOUT_RESET(): The interface is NOT inited! ***"); \
 			break;                                          \
 		}                                                       \
+		if ( 0 != g_conout.nframes ) {                          \
+			break;   /* deferred to the end of the frame */ \
+		}                                                       \
+		if ( CONOUT_LL_SAMECLR(g_conout.termFg, FGLL_DEFAULT)   \
+		&& CONOUT_LL_SAMECLR(g_conout.termBg, BGLL_DEFAULT)     \
+		){                                                      \
+			break;                                          \
+		}                                                       \
 		printf( "%s", "\033[0m" );                              \
-		fflush( stdout );                                       \
+		CONOUT_LL_FLUSH();                                      \
+		CONOUT_LL_CPYCLR(g_conout.termFg, FGLL_DEFAULT);        \
+		CONOUT_LL_CPYCLR(g_conout.termBg, BGLL_DEFAULT);        \
 	} while(0)
 
 
@@ -1753,8 +1834,19 @@ do {                                                                    \
 			break;                                          \
 		}                                                       \
 		                                                        \
-		printf( "%s", tryFg );                                  \
-		fflush( stdout );                                       \
+		/* only a reset turns bold off (it resets bg too) */   \
+		if ( CONOUT_LL_ISBOLD(g_conout.termFg)                  \
+		&& !CONOUT_LL_ISBOLD(tryFg)                             \
+		){                                                      \
+			printf( "%s", "\033[0m" );                      \
+			CONOUT_LL_CPYCLR(g_conout.termFg, FGLL_DEFAULT);\
+			CONOUT_LL_CPYCLR(g_conout.termBg, BGLL_DEFAULT);\
+		}                                                       \
+		if ( !CONOUT_LL_SAMECLR(tryFg, g_conout.termFg) ) {     \
+			printf( "%s", tryFg );                          \
+			CONOUT_LL_FLUSH();                              \
+			CONOUT_LL_CPYCLR(g_conout.termFg, tryFg);       \
+		}                                                       \
 		CONOUT_LL_CPYCLR(g_conout.curFg, tryFg);                \
 		CONOUT_LL_SET_FG_LABEL();                               \
 	} while(0)
@@ -1784,8 +1876,11 @@ do {                                                                    \
 			break;                                          \
 		}                                                       \
 		                                                        \
-		printf( "%s", tryBg );                                  \
-		fflush( stdout );                                       \
+		if ( !CONOUT_LL_SAMECLR(tryBg, g_conout.termBg) ) {     \
+			printf( "%s", tryBg );                          \
+			CONOUT_LL_FLUSH();                              \
+			CONOUT_LL_CPYCLR(g_conout.termBg, tryBg);       \
+		}                                                       \
 		CONOUT_LL_CPYCLR(g_conout.curBg, tryBg);                \
 		CONOUT_LL_SET_BG_LABEL();                               \
 	} while(0)
@@ -5,7 +5,7 @@
  * Version:      0.3a3
  * Date:         July 20, 2014
  * License:      Free Software (see comments in main.c for limitations)
- * Dependencies: common.h, board.h, gs.h
+ * Dependencies: common.h, pool.h, board.h, board_private.h, gs.h
  * --------------------------------------------------------------
  *
  * Private implementation of the GameState & GSNode "classes".
@@ -68,6 +68,11 @@
  * iterators. Without them, it would be a bit too messy to implement
  * the replay-mode of the game. Look for functions having the prefix
  * "gsstack_iter_" in their names.
+ *
+ * Finally, a node may be lazy (see gsstack_push_lazy()). Instead of a
+ * game-state, a lazy node points to the serialized text of one (e.g.
+ * inside a memory-mapped replay file) and it gets decoded the first
+ * time the node is peeked. The text MUST outlive the node.
  ****************************************************************
  */
  
@@ -80,7 +85,9 @@
 #include <string.h>
 
 #include "common.h"
+#include "pool.h"
 #include "board.h"
+#include "board_private.h"
 #include "gs.h"
 
 /* Validation macro for game-state's next & previous moves.
@@ -113,22 +120,35 @@
 						: "ERROR"         \
 )
 
-/* Private definition of the GameState "class" */
+/* Private definition of the GameState "class".
+ *
+ * The board is embedded by value (with its inline grid) so a game-state
+ * is a single contiguous block, which gets duplicated by a single memcpy()
+ * of its meaningful bytes (see _SZSTATE() below).
+ *
+ * NOTE: The board MUST remain the last field.
+ */
 struct _GameState {
-	Board    *board;
 	long int score;        /* current score */
 	long int bscore;       /* best-score across multiple games */
 	int      iswin;        /* has the sentinel value reached? */
 	int      prevmv;       /* direction of previous move */
 	int      nextmv;       /* direction of next move */
+	Board    board;
 };
 
+/* Macro for the count of leading bytes of a game-state that are meaningful,
+ * when its board has the specified single-dimension (dim).
+ */
+#define _SZSTATE(dim)    ( offsetof(struct _GameState, board) + BOARD_SZUSED(dim) )
+
 /* Private definition of the GSNode "class"
  * (single node for game-state stacks)
  */
 struct _GSNode{
 	long int       count;   /* node's count (1-based) */
 	GameState      *state;  /* the game-state stored in the node*/
+	const char     *text;   /* serialized state, if not decoded yet */
 	struct _GSNode *down;   /* previous node (towards bottom) */
 	struct _GSNode *up;     /* next node (towards top) */
 };
@@ -144,23 +164,15 @@ struct _GSNode{
  */
 GameState *new_gamestate( int dim )
 {
-	GameState *state = calloc(1, sizeof(*state) );
+	GameState *state = pool_alloc( sizeof(*state) );
 	if ( NULL == state ) {
-		DBGF( "%s", "calloc failed!" );
+		DBGF( "%s", "pool_alloc failed!" );
 		return NULL;
 	}
 
-	state->board = new_board();
-	if ( NULL == state->board ) {
-		DBGF( "%s", "new_board() failed!" );
-		free( state );
-		return NULL;
-	}
-
-	if ( !board_resize_and_reset(state->board, dim) ) {
+	if ( !board_resize_and_reset(&state->board, dim) ) {
 		DBGF( "board_resize_and_reset(state->board, %d) failed!", dim );
-		board_free( state->board );
-		free( state );
+		pool_free( state, sizeof(*state) );
 		return NULL;
 	}
 
@@ -184,8 +196,7 @@ GameState *new_gamestate( int dim )
 GameState *gamestate_free( GameState *state )
 {
 	if ( state ) {
-		board_free( state->board );
-		free( state );
+		pool_free( state, sizeof(*state) );
 	}
 	return NULL;
 }
@@ -196,6 +207,9 @@ GameState *gamestate_free( GameState *state )
  * Copy the specified source game-state object (src) into the
  * specified destination game-state object (dst). Return 0 (false)
  * on error, 1 (true) otherwise.
+ *
+ * NOTE: The copy is a single memcpy() of the meaningful bytes of
+ *       the source (the unused tail of its inline grid is skipped).
  * --------------------------------------------------------------
  */
 int gamestate_copy( GameState *dst, const GameState *src )
@@ -209,19 +223,25 @@ int gamestate_copy( GameState *dst, const GameState *src )
 		return 0;  /* false */
 	}
 
-	if ( !board_copy(dst->board, src->board) ) {
-		DBGF( "%s", "board_copy() failed!" );
-		return 0;  /* false */
+	if ( dst != src ) {
+		memcpy( dst, src, _SZSTATE(src->board.dim) );
 	}
-	dst->score  = src->score;
-	dst->bscore = src->bscore;
-	dst->iswin  = src->iswin;
-	dst->prevmv = src->prevmv;
-	dst->nextmv = src->nextmv;
 
 	return 1;  /* true */
 }
 
+/* --------------------------------------------------------------
+ * size_t gamestate_sizeof():
+ *
+ * Return the count of bytes occupied by a single game-state object,
+ * including its board.
+ * --------------------------------------------------------------
+ */
+size_t gamestate_sizeof( void )
+{
+	return sizeof(GameState);
+}
+
 /* --------------------------------------------------------------
  * int board_reset():
  *
@@ -237,10 +257,11 @@ int gamestate_reset( GameState *state )
 		DBGF( "%s", "NULL pointer argument (state)!" );
 		return 0;  /* false */
 	}
-	board_reset( state->board );
+	board_reset( &state->board );
 	board_generate_ntiles(
-		state->board,
-		2 * board_get_nrandom( state->board )
+		&state->board,
+		2 * board_get_nrandom( &state->board ),
+		NULL
 		);
 	state->score  = 0;
 	state->iswin  = 0;  /* false */
@@ -264,7 +285,7 @@ const Board *gamestate_get_board( const GameState *state )
 		return NULL;
 	}
 
-	return state->board;
+	return &state->board;
 }
 
 /* --------------------------------------------------------------
@@ -334,6 +355,23 @@ int gamestate_get_prevmove( const GameState *state )
 	return state->prevmv;
 }
 
+/* --------------------------------------------------------------
+ * (Getter) int gamestate_get_nextmove():
+ *
+ * Return the current enumerated value of the nextmv field, of the
+ * specified game-state object (state), or GS_MVDIR_NONE on error.
+ * --------------------------------------------------------------
+ */
+int gamestate_get_nextmove( const GameState *state )
+{
+	if ( NULL == state ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return GS_MVDIR_NONE;
+	}
+
+	return state->nextmv;
+}
+
 /* --------------------------------------------------------------
  * (Getter) const char *gamestate_get_prevmove_label():
  *
@@ -380,45 +418,6 @@ const char *gamestate_get_nextmove_label( const GameState *state )
 	return _MVDIR_TO_LABEL( state->nextmv );
 }
 
-/* --------------------------------------------------------------
- * (Setter) int gamestate_set_board_reference():
- *
- * Change the internal pointer that points to the board object
- * of the specified game-state object (state), so it points to
- * the board object specified by the 2nd argument of the function.
- * Return 0 (false) on error, 1 (true) otherwise.
- *
- * NOTES (IMPORTANT!):
- *
- *    If not properly used, this function may not only LEAK memory
- *    but it may also cause the game to CRASH.
- *
- *    It must be CRYSTAL CLEAR that the function does NOT copy the
- *    specified board object into the specified game-state. Rather,
- *    it is brutally changing the internal pointer of the game-state
- *    board, so it points to the board specified by the 2nd argument.
- *    No copying, no freeing, no nothing!
- *
- *    Currently, the function is used exclusively by the function:
- *    tui_update_board_reference() which is defined in the file:
- *    "tui.c".
- * --------------------------------------------------------------
- */
-int gamestate_set_board_reference( GameState *state, Board *board )
-{
-	if ( NULL == state ) {
-		DBGF( "%s", "NULL pointer argument (state)!" );
-		return 0; /* false */
-	}
-	if ( NULL == board ) {
-		DBGF( "%s", "NULL pointer argument (board)!" );
-		return 0; /* false */
-	}
-
-	state->board = board;
-	return 1;  /* true */
-}
-
 /* --------------------------------------------------------------
  * (Setter) int gamestate_set_score():
  *
@@ -573,7 +572,7 @@ int gamestate_append_to_fp( const GameState *state, FILE *fp )
 	}
 
 	/* + state->board */
-	if ( !board_append_to_fp(state->board, fp) ) {
+	if ( !board_append_to_fp(&state->board, fp) ) {
 		DBGF( "%s", "board_append_to_fp() failed!" );
 		return 0;  /* false */
 	}
@@ -582,11 +581,13 @@ int gamestate_append_to_fp( const GameState *state, FILE *fp )
 }
 
 /* --------------------------------------------------------------
- * GameState *new_gamestate_from_text():
+ * const char *gamestate_parse_text():
  *
- * De-serialize the specified text and load it in a newly created
- * game-state object. Return a pointer to the new object, or NULL
- * on error.
+ * De-serialize the text found at the start of the specified c-string
+ * (text) into the specified game-state (state). Return a pointer to
+ * the character right after the parsed text (normally the eol), or
+ * NULL on error, in which case the game-state is left in an unspecified
+ * state.
  *
  * NOTES:
  *    Text is expected to be already serialized as following:
@@ -595,70 +596,31 @@ int gamestate_append_to_fp( const GameState *state, FILE *fp )
  *    For details about the serialized board-meta-data and
  *    board-tile-values, see the function: board_append_to_fp()
  *    defined in the file: "board.c"
+ *
+ *    The text is parsed in place, without any allocations (the board
+ *    gets resized to the parsed dimension, see board_parse_text()).
  * --------------------------------------------------------------
  */
-GameState *new_gamestate_from_text( char *text )
+const char *gamestate_parse_text( GameState *state, const char *text )
 {
-	Board     *board = NULL;      /* temporary board */
-	GameState *state = NULL;      /* new game-state to be returned */
-	char *tokens[2] = { NULL };
-	int  ntokens=0, n=0;
-
-	if ( NULL == text ) {
+	if ( NULL == state || NULL == text ) {
 		DBGF( "%s", "NULL pointer argument!" );
 		return NULL;
 	}
 
-	/* tokenize text on '@' (up to 2 tokens) */
-	ntokens = s_tokenize( text, tokens, 2, "@" );
-	if ( ntokens < 2 ) {
-		DBGF( "%s", "s_tokenize(text) failed to produce 2 tokens" );
+	/* the state meta-data (score, bscore, iswin, prevmv, nextmv) */
+	if ( NULL == (text = s_parse_long(text, &state->score))
+	|| NULL == (text = s_parse_long(text, &state->bscore))
+	|| NULL == (text = s_parse_int(text, &state->iswin))
+	|| NULL == (text = s_parse_int(text, &state->prevmv))
+	|| NULL == (text = s_parse_int(text, &state->nextmv))
+	|| '@' != *text
+	){
 		return NULL;
 	}
 
-	/*
-	 * From the 2nd text-token, create a temp board. Then create the
-	 * new game-state, copy the temp board into it & free the temp board.
-	 */
-	board = new_board_from_text( tokens[1] );
-	if ( NULL == board ) {
-		DBGF( "%s", "new_board_from_text() failed!" );
-		goto ret_failure;
-	}
-	state = new_gamestate( board_get_dim(board) );
-	if ( NULL == state ) {
-		DBGF( "%s", "new_gamestate(board->dim) failed!" );
-		goto ret_failure;
-	}
-	if ( !board_copy( state->board, board ) ) {
-		DBGF( "%s", "board_copy(state->board, board) failed!" );
-		goto ret_failure;
-	}
-	board = board_free( board );
-
-	/* from the 1st token, get the state meta-data
-	 * (score, bscore, iswin, prevmv, nextmv)
-         */
-	n = sscanf(
-		tokens[0],
-		"%ld %ld %d %d %d",
-		&state->score,
-		&state->bscore,
-		&state->iswin,
-		&state->prevmv,
-		&state->nextmv
-		);
-	if ( n < 5 ) {
-		DBGF( "%s", "sscanf(tokens[0]) failed!" );
-		goto ret_failure;
-	}
-
-	return state;
-
-ret_failure:
-	board_free( board );
-	gamestate_free( state );
-	return NULL;
+	/* + the board */
+	return board_parse_text( &state->board, text + 1 );
 }
 
 /* --------------------------------------------------------------
@@ -671,16 +633,16 @@ ret_failure:
  */
 static inline GSNode *_make_node( int dim )
 {
-	GSNode *node = calloc( 1, sizeof(*node) );
+	GSNode *node = pool_alloc( sizeof(*node) );
 	if ( NULL == node ) {
-		DBGF( "%s", "calloc failed!" );
+		DBGF( "%s", "pool_alloc failed!" );
 		return NULL;
 	}
 
 	node->state = new_gamestate( dim );
 	if ( NULL == node->state ) {
 		DBGF( "new_gamestate(%d) failed!", dim );
-		free( node );
+		pool_free( node, sizeof(*node) );
 		return NULL;
 	}
 
@@ -699,7 +661,7 @@ static inline GSNode *_node_free( GSNode *node )
 {
 	if ( node ) {
 		gamestate_free( node->state );
-		free( node );
+		pool_free( node, sizeof(*node) );
 	}
 
 	return NULL;
@@ -724,7 +686,7 @@ int gsstack_push( GSNode **stack, const GameState *state )
 	}
 
 	/* alloc mem for new node */
-	dim = board_get_dim( state->board );
+	dim = board_get_dim( &state->board );
 	newnode = _make_node( dim );
 	if ( NULL == newnode ) {
 		DBGF( "_make_node(%d) failed!", dim );
@@ -750,6 +712,110 @@ int gsstack_push( GSNode **stack, const GameState *state )
 
 }
 
+/* --------------------------------------------------------------
+ * int gsstack_push_lazy():
+ *
+ * Push to the top of the specified gsstack (stack) a lazy node, that
+ * is a node whose game-state is NOT decoded from the specified text
+ * (text) until the node gets peeked (see gsstack_peek_state()). Return
+ * 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    The text is expected to be serialized as described in the func:
+ *    gamestate_parse_text(). It is NOT validated here, but when the
+ *    node gets decoded (see _node_decode()).
+ *
+ *    The text is referenced, NOT copied, so it MUST remain intact for
+ *    as long as the node exists.
+ * --------------------------------------------------------------
+ */
+int gsstack_push_lazy( GSNode **stack, const char *text )
+{
+	GSNode *newnode = NULL;
+
+	if ( NULL == stack || NULL == text ) {
+		DBGF( "%s", "NULL pointer argument" );
+		return 0;  /* false */
+	}
+
+	newnode = pool_alloc( sizeof(*newnode) );
+	if ( NULL == newnode ) {
+		DBGF( "%s", "pool_alloc failed!" );
+		return 0;  /* false */
+	}
+
+	newnode->text = text;
+	newnode->down = *stack;
+	if ( *stack ) {
+		newnode->count = 1 + (*stack)->count;
+		(*stack)->up   = newnode;
+	}
+	else {
+		newnode->count = 1;
+	}
+	*stack = newnode;
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _text_decode():
+ *
+ * Decode the specified serialized text of a lazy node (text) into the
+ * specified game-state (state). Return 0 (false) on error, in which
+ * case the game-state is left in an unspecified state, 1 (true)
+ * otherwise.
+ *
+ * NOTE: This is where the text of a lazy node gets validated: all of
+ *       its line but trailing blanks must be parsed, its move-directions
+ *       must be valid and the cached count of the empty tiles of its
+ *       board must fit in the board (whether it is the correct count is
+ *       up to mvhist_verify(), in the file "mvhist.c").
+ * --------------------------------------------------------------
+ */
+static inline int _text_decode( GameState *state, const char *text )
+{
+	const char *cp = gamestate_parse_text( state, text );
+
+	while ( NULL != cp && (' ' == *cp || '\t' == *cp) ) {
+		cp++;
+	}
+	return NULL != cp
+		&& ('\0' == *cp || '\r' == *cp || '\n' == *cp)
+		&& _VALID_MVDIR( state->prevmv )
+		&& _VALID_MVDIR( state->nextmv )
+		&& state->board.nempty >= 0
+		&& state->board.nempty <= state->board.dim * state->board.dim;
+}
+
+/* --------------------------------------------------------------
+ * GameState *_node_decode():
+ *
+ * Decode the serialized text of the specified lazy node (node) into
+ * a newly created game-state, which from then on is stored in the
+ * node. Return a pointer to the game-state, or NULL on error.
+ * --------------------------------------------------------------
+ */
+static inline GameState *_node_decode( GSNode *node )
+{
+	GameState *state = new_gamestate( BOARD_DIM_4 );
+	if ( NULL == state ) {
+		DBGF( "%s", "new_gamestate() failed!" );
+		return NULL;
+	}
+
+	if ( !_text_decode(state, node->text) ) {
+		DBGF( "Failed to decode the game-state of node %ld", node->count );
+		gamestate_free( state );
+		return NULL;
+	}
+	node->state = state;
+	node->text  = NULL;
+
+	return state;
+}
+
 /* --------------------------------------------------------------
  * long int gsstack_peek_count():
  *
@@ -773,6 +839,9 @@ long int gsstack_peek_count( const GSNode *stack )
  *
  * Return a pointer to the game-state object stored at the current
  * top node of the specified gsstack (stack), or NULL on error.
+ *
+ * NOTE: The game-state of a lazy node gets decoded at this point,
+ *       which does not change the node as far as callers can tell.
  * --------------------------------------------------------------
  */
 const GameState *gsstack_peek_state( const GSNode *stack )
@@ -781,9 +850,69 @@ const GameState *gsstack_peek_state( const GSNode *stack )
 		return NULL;
 	}
 
+	if ( NULL == stack->state ) {
+		return _node_decode( (GSNode *)stack );
+	}
 	return stack->state;
 }
 
+/* --------------------------------------------------------------
+ * const GameState *gsstack_peek_state_into():
+ *
+ * Return a pointer to the game-state object stored at the current
+ * top node of the specified gsstack (stack), or NULL on error. The
+ * game-state of a lazy node is decoded into the specified game-state
+ * (scratch) instead, which is returned.
+ *
+ * NOTE: Unlike gsstack_peek_state(), the gsstack is not changed at
+ *       all (a lazy node stays lazy), so gsstacks that are not used
+ *       by any other thread may be walked through this function from
+ *       a thread that did not create them (the memory pool is per-
+ *       -thread, see "pool.c").
+ * --------------------------------------------------------------
+ */
+const GameState *gsstack_peek_state_into(
+	const GSNode *stack,
+	GameState    *scratch
+	)
+{
+	if ( NULL == stack || NULL == scratch ) {
+		return NULL;
+	}
+
+	if ( NULL != stack->state ) {
+		return stack->state;
+	}
+	if ( !_text_decode(scratch, stack->text) ) {
+		DBGF( "Failed to decode the game-state of node %ld", stack->count );
+		return NULL;
+	}
+	return scratch;
+}
+
+/* --------------------------------------------------------------
+ * int gsstack_set_nextmove():
+ *
+ * Set the nextmv field of the game-state object stored at the current
+ * top node of the specified gsstack (stack), to the specified move-
+ * direction (nextmv). Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTE: The game-state of a lazy node gets decoded first.
+ * --------------------------------------------------------------
+ */
+int gsstack_set_nextmove( GSNode *stack, int nextmv )
+{
+	if ( NULL == stack ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+
+	if ( NULL == stack->state && NULL == _node_decode(stack) ) {
+		return 0;  /* false */
+	}
+	return gamestate_set_nextmove( stack->state, nextmv );
+}
+
 /* --------------------------------------------------------------
  * int gsstack_pop():
  *
@@ -832,8 +961,14 @@ GSNode *gsstack_dup_reversed( const GSNode *stack )
 		return NULL;
 	}
 
+	/* lazy nodes are duplicated as lazy nodes */
 	while ( NULL != stack ) {
-		gsstack_push( &ret, stack->state );
+		if ( NULL == stack->state ) {
+			gsstack_push_lazy( &ret, stack->text );
+		}
+		else {
+			gsstack_push( &ret, stack->state );
+		}
 		stack = stack->down;
 	}
 
@@ -841,6 +976,181 @@ GSNode *gsstack_dup_reversed( const GSNode *stack )
 
 }
 
+/* --------------------------------------------------------------
+ * int gsstack_reverse():
+ *
+ * Reverse in place the order of the nodes of the specified gsstack
+ * (stack), and re-number them so their counts are 1-based again.
+ * Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTE: Unlike gsstack_dup_reversed(), nothing gets allocated or
+ *       copied, the nodes are just re-linked.
+ * --------------------------------------------------------------
+ */
+int gsstack_reverse( GSNode **stack )
+{
+	long int count = 0;
+	GSNode *it = NULL, *next = NULL;
+
+	if ( NULL == stack ) {
+		DBGF( "%s", "NULL pointer argument (stack)" );
+		return 0;  /* false */
+	}
+
+	/* the old top becomes the new bottom */
+	for (it = *stack; it; it = next) {
+		next     = it->down;
+		it->down = it->up;
+		it->up   = next;
+		it->count = ++count;
+		*stack   = it;
+	}
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * GSNode *gsstack_split():
+ *
+ * Detach from the specified gsstack (stack) all the nodes having
+ * a count less than or equal to the specified one (count), and
+ * return a pointer to the top node of the detached nodes (they
+ * form a separate gsstack) or NULL if there are no such nodes.
+ *
+ * NOTE: The counts of the detached nodes are NOT changed.
+ * --------------------------------------------------------------
+ */
+GSNode *gsstack_split( GSNode **stack, long int count )
+{
+	GSNode *it = NULL;
+	GSNode *below = NULL;
+
+	if ( NULL == stack ) {
+		DBGF( "%s", "NULL pointer argument (stack)" );
+		return NULL;
+	}
+	if ( NULL == *stack ) {
+		return NULL;
+	}
+
+	/* the whole stack gets detached */
+	if ( (*stack)->count <= count ) {
+		below = *stack;
+		*stack = NULL;
+		return below;
+	}
+
+	/* counts are decreasing towards the bottom */
+	for (it = *stack; it->down && it->down->count > count; it = it->down) {
+		;  /* void */
+	}
+	below = it->down;
+	it->down = NULL;
+	if ( below ) {
+		below->up = NULL;
+	}
+
+	return below;
+}
+
+/* --------------------------------------------------------------
+ * int gsstack_join():
+ *
+ * Put the specified gsstack (below) under the bottom node of the
+ * specified gsstack (stack), and set (*below) to NULL. Return 0
+ * (false) on error, 1 (true) otherwise.
+ *
+ * NOTE: The nodes of (below) are re-numbered, so their counts
+ *       continue downwards from the count of the bottom node of
+ *       (stack). Thus, the latter MUST have enough room under it
+ *       (e.g. a bottom node with count 5 can take up to 4 nodes).
+ * --------------------------------------------------------------
+ */
+int gsstack_join( GSNode **stack, GSNode **below )
+{
+	long int n = 0, count;
+	GSNode *it = NULL;
+	GSNode *bottom = NULL;
+
+	if ( NULL == stack || NULL == below ) {
+		DBGF( "%s", "NULL pointer argument" );
+		return 0;  /* false */
+	}
+	if ( NULL == *below ) {
+		return 1;  /* true */
+	}
+	if ( NULL == *stack ) {
+		*stack = *below;
+		*below = NULL;
+		return 1;  /* true */
+	}
+
+	for (it = *below; it; it = it->down) {
+		n++;
+	}
+	for (bottom = *stack; bottom->down; bottom = bottom->down) {
+		;  /* void */
+	}
+	if ( bottom->count - n < 1 ) {
+		DBGF( "No room for %ld nodes under node %ld!", n, bottom->count );
+		return 0;  /* false */
+	}
+
+	count = bottom->count;
+	for (it = *below; it; it = it->down) {
+		it->count = --count;
+	}
+	bottom->down  = *below;
+	(*below)->up  = bottom;
+	*below = NULL;
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * long int gsstack_renumber():
+ *
+ * Re-number the nodes of the specified gsstack (stack), so the count
+ * of its bottom node becomes the specified one (count) and the counts
+ * keep increasing by 1 towards the top. Return the count of the nodes
+ * of the gsstack, or 0 on error.
+ * --------------------------------------------------------------
+ */
+long int gsstack_renumber( GSNode *stack, long int count )
+{
+	long int n = 0;
+	GSNode *it = NULL;
+
+	if ( NULL == stack || count < 1 ) {
+		DBGF( "%s", "Invalid argument!" );
+		return 0;
+	}
+
+	for (it = stack; it->down; it = it->down) {
+		;  /* void */
+	}
+	for (; it; it = it->up) {
+		it->count = count + n++;
+	}
+
+	return n;
+}
+
+/* --------------------------------------------------------------
+ * size_t gsstack_sizeof_node():
+ *
+ * Return the count of bytes occupied by a single gsstack node,
+ * including its game-state (and thus its board).
+ *
+ * NOTE: Lazy nodes occupy just sizeof(GSNode) until they are
+ *       peeked, so this is an upper bound for them.
+ * --------------------------------------------------------------
+ */
+size_t gsstack_sizeof_node( void )
+{
+	return sizeof(GSNode) + sizeof(GameState);
+}
+
 /* --------------------------------------------------------------
  * const GSNode *gsstack_iter_top():
  *
@@ -922,6 +1232,49 @@ GSNode *gsstack_free( GSNode **stack )
 	return *stack;
 }
 
+/* --------------------------------------------------------------
+ * GSNode *gsstack_dup():
+ *
+ * Create a new gsstack which is a duplicate of the specified gsstack
+ * (stack), its nodes having the same counts, and return a pointer to
+ * the top node of the new gsstack, or NULL on error.
+ *
+ * NOTE: Lazy nodes are duplicated as lazy nodes. If the argument (to)
+ *       is not NULL, their text is expected to lie inside the specified
+ *       c-string (from), and the duplicates point to the same offsets
+ *       inside (to) instead, e.g. a copy of from that outlives it.
+ * --------------------------------------------------------------
+ */
+GSNode *gsstack_dup( const GSNode *stack, const char *from, const char *to )
+{
+	GSNode *ret = NULL;
+	const GSNode *bottom = stack;
+	const GSNode *it = NULL;
+
+	if ( NULL == stack ) {
+		DBGF( "%s", "NULL pointer argument (stack)" );
+		return NULL;
+	}
+
+	while ( NULL != bottom->down ) {
+		bottom = bottom->down;
+	}
+	for (it = bottom; it; it = it->up)
+	{
+		if ( NULL != it->state
+		? !gsstack_push( &ret, it->state )
+		: !gsstack_push_lazy( &ret, to ? to + (it->text - from) : it->text )
+		){
+			DBGF( "Failed to duplicate node %ld", it->count );
+			gsstack_free( &ret );
+			return NULL;
+		}
+	}
+	gsstack_renumber( ret, bottom->count );
+
+	return ret;
+}
+
 /* --------------------------------------------------------------
  * int gsstack_append_to_fp():
  *
@@ -937,6 +1290,8 @@ GSNode *gsstack_free( GSNode **stack )
  *    If the specified gsstack is empty, the produced text-line becomes:
  *    "NULL:\r\n"
  *
+ *    Lazy nodes are NOT decoded. Their serialized text is copied as is.
+ *
  *    For details about the serialization see also the functions:
  *    gamestate_append_to_fp()
  *    board_append_to_fp() (defined in the file: "board.c")
@@ -966,7 +1321,16 @@ int gsstack_append_to_fp( const GSNode *stack, FILE *fp )
 		}
 
 		/* + node's state */
-		if ( !gamestate_append_to_fp(stack->state, fp) ) {
+		if ( NULL == stack->state ) {
+			const size_t len = strcspn( stack->text, "\r\n" );
+			if ( fwrite(stack->text, 1, len, fp) != len
+			|| fprintf(fp, "%s", "\r\n") != 2
+			){
+				DBGF( "%s", "fwrite() failed!" );
+				return 0;  /* false */
+			}
+		}
+		else if ( !gamestate_append_to_fp(stack->state, fp) ) {
 			DBGF( "%s", "gamestate_append_to_fp() failed!" );
 			return 0;  /* false */
 		}
@@ -977,78 +1341,6 @@ int gsstack_append_to_fp( const GSNode *stack, FILE *fp )
 	return 1;  /* true */
 }
 
-/* --------------------------------------------------------------
- * GSNode *new_gsnode_from_text():
- *
- * De-serialize the specified text and load it in a newly created
- * gsstack node. Return a pointer to the new node, or NULL on error.
- *
- * NOTES:
- *    Text is expected to be already serialized as following:
- *    "count:state-meta-data@state-board-meta-data#state-board-tile-values\r\n"
- *
- *    For details about the serialization see also the functions:
- *    gsstack_append_to_fp()
- *    gamestate_append_to_fp()
- *    board_append_to_fp() (defined in the file: "board.c")
- * --------------------------------------------------------------
- */
-GSNode *new_gsnode_from_text( char *text )
-{
-	GameState *state = NULL;      /* temporary state */
-	GSNode    *node  = NULL;      /* new node to be returned */
-	char *tokens[2] = { NULL };
-	int  ntokens=0, n=0;
-
-	if ( NULL == text ) {
-		DBGF( "%s", "NULL pointer argument!" );
-		return NULL;
-	}
-
-	/* tokenize text on ':' (up to 2 tokens) */
-	ntokens = s_tokenize( text, tokens, 2, ":" );
-	if ( ntokens < 2 ) {
-		DBGF( "%s", "s_tokenize(text) failed to produce 2 tokens" );
-		return NULL;
-	}
-
-	/*
-	 * From the 2nd text-token, create a temp gamesstate. Then create
-	 * the new node, copy the temp game-state into it and free the temp
-	 * game-state.
-	 */
-	state = new_gamestate_from_text( tokens[1] );
-	if ( NULL == state ) {
-		DBGF( "%s", "new_gamestate_from_text(tokens[1]) failed!" );
-		goto ret_failure;
-	}
-	node = _make_node( board_get_dim( gamestate_get_board(state) ) );
-	if ( NULL == node ) {
-		DBGF( "%s", "_make_node failed!" );
-		goto ret_failure;
-	}
-
-	if ( !gamestate_copy(node->state, state) ) {
-		DBGF( "%s", "gamestate_copy(node->state, state) failed!" );
-		goto ret_failure;
-	}
-	state = gamestate_free( state );
-
-	/* from the 1st token, get the node meta-data (count) */
-	n = sscanf( tokens[0], "%ld", &node->count );
-	if ( n < 1 ) {
-		DBGF( "%s", "sscanf(tokens[0]) failed!" );
-		goto ret_failure;
-	}
-
-	return node;
-
-ret_failure:
-	gamestate_free( state );
-	_node_free( node );
-	return NULL;
-}
-
 /* --------------------------------------------------------------
  * For DEBUGGING Purposes: ***
  *
@@ -1064,8 +1356,14 @@ void dbg_gsnode_dump( GSNode *node )
 	}
 
 	printf( "count: %ld\n", node->count );
+	if ( NULL == node->state ) {
+		printf( "text: %.*s\n", (int)strcspn(node->text, "\r\n"), node->text );
+		printf( "&down: 0x%p\n", (void *)(node->down) );
+		printf( "&up  : 0x%p\n", (void *)(node->up) );
+		return;
+	}
 	puts( "state:" );
-	dbg_board_dump( node->state->board );
+	dbg_board_dump( &node->state->board );
 	printf( "\tscore: %ld\n", node->state->score );
 	printf( "\tbscore: %ld\n", node->state->bscore );
 	printf( "\tnextmv: %d\n", node->state->prevmv );
@@ -40,16 +40,17 @@ extern GameState  *new_gamestate( int dim );
 extern GameState  *gamestate_free( GameState *state );
 extern int        gamestate_reset( GameState *state );
 extern int        gamestate_copy( GameState *dst, const GameState *src );
+extern size_t     gamestate_sizeof( void );
 
 extern Board      *gamestate_get_board( const GameState *state );
 extern long int   gamestate_get_score( const GameState *state );
 extern long int   gamestate_get_bestscore( const GameState *state );
 extern int        gamestate_get_iswin( const GameState *state );
 extern int        gamestate_get_prevmove( const GameState *state );
+extern int        gamestate_get_nextmove( const GameState *state );
 extern const char *gamestate_get_prevmove_label( const GameState *state );
 extern const char *gamestate_get_nextmove_label( const GameState *state );
 
-extern int        gamestate_set_board_reference( GameState *state, Board *board );
 extern int        gamestate_set_score( GameState *state, long int score );
 extern int        gamestate_set_bestscore( GameState *state, long int bscore );
 extern int        gamestate_set_iswin( GameState *state, int iswin );
@@ -57,16 +58,25 @@ extern int        gamestate_set_prevmove( GameState *state, int prevmv );
 extern int        gamestate_set_nextmove( GameState *state, int nextmv );
 
 extern int        gamestate_append_to_fp( const GameState *state, FILE *fp );
-extern GameState  *new_gamestate_from_text( char *text );
+extern const char *gamestate_parse_text( GameState *state, const char *text );
 
 
 /* gsstack interface */
 
 extern int             gsstack_push( GSNode **stack, const GameState *state );
+extern int             gsstack_push_lazy( GSNode **stack, const char *text );
 extern long int        gsstack_peek_count( const GSNode *stack );
 extern const GameState *gsstack_peek_state( const GSNode *stack );
+extern const GameState *gsstack_peek_state_into( const GSNode *stack, GameState *scratch );
+extern int             gsstack_set_nextmove( GSNode *stack, int nextmv );
 extern int             gsstack_pop( GSNode **stack );
+extern GSNode          *gsstack_dup( const GSNode *stack, const char *from, const char *to );
 extern GSNode          *gsstack_dup_reversed( const GSNode *stack );
+extern int             gsstack_reverse( GSNode **stack );
+extern GSNode          *gsstack_split( GSNode **stack, long int count );
+extern int             gsstack_join( GSNode **stack, GSNode **below );
+extern long int        gsstack_renumber( GSNode *stack, long int count );
+extern size_t          gsstack_sizeof_node( void );
 extern GSNode          *gsstack_free( GSNode **stack );
 
 extern const GSNode    *gsstack_iter_top( const GSNode *stack );
@@ -75,7 +85,6 @@ extern const GSNode    *gsstack_iter_down( const GSNode *it );
 extern const GSNode    *gsstack_iter_up( const GSNode *it );
 
 extern int             gsstack_append_to_fp( const GSNode *stack, FILE *fp );
-extern GSNode          *new_gsnode_from_text( char *text );
 
 extern void            dbg_gsnode_dump( GSNode *node );
 extern void            dbg_gsstack_dump( GSNode *stack );
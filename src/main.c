@@ -5,7 +5,7 @@
  * Version:      0.3a3
  * Date:         July 20, 2014
  * License:      Free Software (see following comments for limitations)
- * Dependencies: common.h, board.h, gs.h, mvhist.h, tui.h
+ * Dependencies: common.h, pool.h, board.h, gs.h, mvhist.h, tui.h
  * --------------------------------------------------------------
  *
  * Description
@@ -19,6 +19,7 @@
  * Compared to the original game, this version additionally supports:
  * - skins (color themes)
  * - undo/redo (it disables best-score tracking)
+ * - branches (moves played after an undo, keep the undone ones too)
  * - replays
  * - load/save games (via replays)
  *
@@ -55,11 +56,30 @@
 #include <time.h>
 
 #include "common.h"   /* constants, macros, unctions common across all files*/
+#include "pool.h"     /* pool allocator (boards, game-states, etc) */
 #include "board.h"    /* board related functions */
 #include "gs.h"       /* game-state */
 #include "mvhist.h"   /* moves history (undo, redo, replay) */
+#include "catalog.h"  /* catalog of replay-files */
 #include "tui.h"      /* text-user-interface */
 
+/* Default delay (in millisecs) between the moves of a replay */
+#define _MSECS_REPLAY_DELAY     750
+
+/* Speeds of replay auto-play, as multiples of the replay delay
+ * (see _do_replay_auto()). The top one (0) means as fast as the
+ * moves get rendered.
+ */
+static const double _replayspeeds[] = { .25, .5, 1, 2, 4, 8, 16, 0 };
+#define _REPLAYSPEED_NORMAL     2   /* index of 1x in _replayspeeds[] */
+#define _REPLAYSPEED_TOP                                              \
+	( (int)(sizeof(_replayspeeds) / sizeof(_replayspeeds[0])) - 1 )
+
+/* Max time (in millisecs) spent on playing a batch of queued moves,
+ * before rendering them (see _do_play_moves()). 0 means no limit.
+ */
+#define _MSECS_RENDER_BUDGET    40
+
 /* Macro for validating an input key as a command for starting a new
  * variant of the game (the valid keys are defined in the file: "tui.h").
  */
@@ -104,10 +124,10 @@
  *
  *        Finally, the c-string gets suffixed with the contents
  *        of the string REPLAY_FNAME_EXT (also defined in "common.h")
- *        which is the filename extension (currently: ".sav").
+ *        which is the filename extension (currently: ".sav2").
  *
  *        So upon success, the format of fname is as follows:
- *        REPLAYS_FOLDER/Day_Month_DD_HHMMSS_Year.sav"
+ *        REPLAYS_FOLDER/Day_Month_DD_HHMMSS_Year.sav2"
  *
  *        IMPORTANT!!
  *
@@ -178,6 +198,7 @@ static int _do_play_board(
 {
 	int moved = 0;    /* was a move successfully played? */
 	int iswin = 0;    /* was a winning move played? */
+	BoardEvents events;  /* which tiles changed (see "board.h") */
 
 	/* just for brevity later on */
 	Board *board;
@@ -196,31 +217,32 @@ static int _do_play_board(
 	switch( key )
 	{
 		case TUI_KEY_UP:
-			moved = board_move_up( board, &score, &iswin );
+			moved = board_move_up( board, &score, &iswin, &events );
 			break;
 
 		case TUI_KEY_DOWN:
-			moved = board_move_down( board, &score, &iswin );
+			moved = board_move_down( board, &score, &iswin, &events );
 			break;
 
 		case TUI_KEY_LEFT:
-			moved = board_move_left( board, &score, &iswin );
+			moved = board_move_left( board, &score, &iswin, &events );
 			break;
 
 		case TUI_KEY_RIGHT:
-			moved = board_move_right( board, &score, &iswin );
+			moved = board_move_right( board, &score, &iswin, &events );
 			break;
 
 		default:
 			moved = 0;  /* false */
+			events.n = 0;
 			break;
 		}
 
 	didundo = mvhist_get_didundo( mvhist );
 
-	/* a move done after any undo, invalidates the redo-stack */
+	/* a move done after any undo, forks off the redo-stack as a branch */
 	if ( didundo && moved ) {
-		mvhist_free_redo_stack( mvhist );
+		mvhist_fork_redo_stack( mvhist );
 	}
 
 	/* update game-state's score, and if needed best-score too */
@@ -229,14 +251,16 @@ static int _do_play_board(
 		gamestate_set_bestscore( gs, score ) ;
 	}
 
-	/* update game-state's prevmv */
-	gamestate_set_prevmove( gs, _KEY_TO_MVDIR(key) );
-
-	/* update nextmove of previous game-state
-	 * (deliberately violate constness of prevstate)
+	/* update game-state's prevmv, and nextmove of previous game-state
+	 * (deliberately violate constness of prevstate), but only if the
+	 * board did move: the recorded moves must lead from one game-state
+	 * to the next (see mvhist_fork_redo_stack() in "mvhist.c")
 	 */
-	const GameState *prevstate = mvhist_peek_undo_stack_state(mvhist);
-	gamestate_set_nextmove( (GameState *)prevstate, _KEY_TO_MVDIR(key) );
+	if ( moved ) {
+		const GameState *prevstate = mvhist_peek_undo_stack_state(mvhist);
+		gamestate_set_prevmove( gs, _KEY_TO_MVDIR(key) );
+		gamestate_set_nextmove( (GameState *)prevstate, _KEY_TO_MVDIR(key) );
+	}
 
 	/* was it a winning move? */
 	if ( iswin ) {
@@ -248,11 +272,15 @@ static int _do_play_board(
 	else if ( moved ) {
 		board_generate_ntiles(
 			board,
-			board_get_nrandom( board )
+			board_get_nrandom( board ),
+			&events
 			);
 		mvhist_push_undo_stack( mvhist, gs );
 	}
 
+	/* only the tiles affected by the move need to be redrawn */
+	tui_set_board_events( tui, &events );
+
 	/* is current game over? */
 	return iswin
 	       ||
@@ -260,6 +288,145 @@ static int _do_play_board(
 	       ;
 }
 
+/* --------------------------------------------------------------
+ * int _do_play_moves():
+ *
+ * Play the move indicated by the key pointed to by pkey (just like
+ * _do_play_board() does), and then keep playing any arrow-keys that
+ * are already pending on the input (e.g. when an arrow-key is held
+ * down, or a sequence of moves is pasted), so the caller renders
+ * them all at once, as a single frame.
+ *
+ * The batch stops when the input is drained, when the game is over,
+ * or when it has taken _MSECS_RENDER_BUDGET milliseconds (if not 0),
+ * so the screen keeps getting updated while the input keeps coming.
+ *
+ * When the game is compiled with the macro CC2048_ANIMATE defined, a
+ * move that is not followed by any pending keys gets animated (see the
+ * function tui_animate_board()).
+ *
+ * If a non-arrow key is met, it is passed back via pkey & pkeymask
+ * and haskey is set to 1 (true), so the caller handles it next
+ * instead of reading a new key. Otherwise haskey is set to 0 (false).
+ *
+ * Return 1 (true) if a move caused game-over, 0 (false) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _do_play_moves(
+	int          *pkey,
+	unsigned int *pkeymask,
+	int          *haskey,
+	GameState    *gs,
+	MovesHistory *mvhist,
+	Tui          *tui
+	)
+{
+	double tstop = th_wall_secs() + _MSECS_RENDER_BUDGET / 1000.0;
+	int gameover = _do_play_board( *pkey, gs, mvhist, tui );
+
+#ifdef CC2048_ANIMATE
+	/* a single move gets animated (until the next key is pressed) */
+	if ( !gameover && !tui_sys_wait_key(0) ) {
+		tui_animate_board( tui );
+	}
+#endif
+
+	*haskey = 0;  /* false */
+	while ( !gameover && tui_sys_wait_key(0) )
+	{
+		if ( _MSECS_RENDER_BUDGET > 0 && th_wall_secs() >= tstop ) {
+			break;
+		}
+
+		*pkey = toupper( tui_sys_getkey(pkeymask) );
+		if ( !(*pkeymask & TUI_KEYMASK_ARROW) ) {
+			*haskey = 1;  /* true */
+			break;
+		}
+		gameover = _do_play_board( *pkey, gs, mvhist, tui );
+	}
+
+	return gameover;
+}
+
+/* --------------------------------------------------------------
+ * void _journal_recover():
+ *
+ * If the journal of a previous session was left behind (e.g. after
+ * a crash or a power loss) keep it as a replay-file named after the
+ * system clock, so it can be loaded like any other.
+ *
+ * NOTE: Journaling is enabled only when the macro CC2048_JOURNAL is
+ *       defined at compile-time, otherwise this function does nothing.
+ * --------------------------------------------------------------
+ */
+static void _journal_recover( void )
+{
+#ifdef CC2048_JOURNAL
+	char fname[SZMAX_FNAME] = {'\0'};
+
+	if ( f_exists(JOURNAL_FNAME) ) {
+		_fname_from_clock( fname );
+		if ( 0 != rename(JOURNAL_FNAME, fname) ) {
+			DBGF( "Could not rename %s to %s", JOURNAL_FNAME, fname );
+		}
+	}
+#endif
+}
+
+/* --------------------------------------------------------------
+ * void _journal_begin():
+ *
+ * Start journaling the current game of the specified moves-history
+ * object (mvhist) to the file JOURNAL_FNAME (see "common.h").
+ *
+ * NOTE: Journaling is enabled only when the macro CC2048_JOURNAL is
+ *       defined at compile-time, otherwise this function does nothing.
+ * --------------------------------------------------------------
+ */
+static void _journal_begin( MovesHistory *mvhist )
+{
+#ifdef CC2048_JOURNAL
+	if ( !mvhist_journal_open(mvhist, JOURNAL_FNAME) ) {
+		DBGF( "%s", "mvhist_journal_open() failed!" );
+	}
+#else
+	(void)mvhist;
+#endif
+}
+
+/* --------------------------------------------------------------
+ * void _journal_end():
+ *
+ * Stop journaling the current game of the specified moves-history
+ * object (mvhist). If anything got journaled, the journal is kept
+ * as a replay-file named after the system clock, otherwise it is
+ * deleted.
+ *
+ * NOTE: Journaling is enabled only when the macro CC2048_JOURNAL is
+ *       defined at compile-time, otherwise this function does nothing.
+ * --------------------------------------------------------------
+ */
+static void _journal_end( MovesHistory *mvhist )
+{
+#ifdef CC2048_JOURNAL
+	char fname[SZMAX_FNAME] = {'\0'};
+
+	if ( !mvhist_isjournaling(mvhist) ) {
+		return;
+	}
+	if ( mvhist_get_journal_nrecords(mvhist) > 0 ) {
+		_fname_from_clock( fname );
+		mvhist_journal_close( mvhist, fname );
+	}
+	else {
+		mvhist_journal_close( mvhist, NULL );
+	}
+#else
+	(void)mvhist;
+#endif
+}
+
 /* --------------------------------------------------------------
  * void _do_reset_game():
  *
@@ -278,8 +445,10 @@ static void _do_reset_game( GameState *gs, MovesHistory *mvhist, Tui *tui )
 	if ( 'y' == tolower( tui_draw_iobar_prompt_newgame(tui)) ) {
 		gamestate_reset( gs );
 
+		_journal_end( mvhist );
 		mvhist_reset( mvhist );
 		mvhist_push_undo_stack( mvhist, gs );
+		_journal_begin( mvhist );
 
 		tui_clear_infobar( tui );
 	}
@@ -295,15 +464,14 @@ static void _do_reset_game( GameState *gs, MovesHistory *mvhist, Tui *tui )
  * NOTES: ( IMPORTANT! )
  *
  *        Launching a new variant of the game, is usually requiring
- *        to also resize the board. Resizing is done in the function
- *        board_resize_and_reset(), via realloc(), which does NOT
- *        guarantee that the resized board will stay at the same
- *        location in memory.
+ *        to also resize the board. The resized board stays at the
+ *        same location in memory (its grid is inline) but its new
+ *        dimension changes the screen layout.
  *
  *        Thus, it is IMPORTANT to call the function:
  *        tui_update_board_reference() AFTER the board has been
- *        resized, so the text-user-interface gets aware of the
- *        new memory location of the resized board.
+ *        resized, so the text-user-interface re-initializes its
+ *        layout for the resized board.
  * --------------------------------------------------------------
  */
 static void _do_new_variant( int key,
@@ -333,13 +501,16 @@ static void _do_new_variant( int key,
 			board_resize_and_reset( board, dim );
 			board_generate_ntiles(
 				board,
-				2 * board_get_nrandom( board )
+				2 * board_get_nrandom( board ),
+				NULL
 				);
 
 			gamestate_set_score( gs, 0 );
 
+			_journal_end( mvhist );
 			mvhist_reset( mvhist );
 			mvhist_push_undo_stack( mvhist, gs );
+			_journal_begin( mvhist );
 
 			tui_update_board_reference( tui, board );
 			tui_cls( tui );
@@ -450,6 +621,37 @@ static void _do_redo( GameState *gs, MovesHistory *mvhist, Tui *tui )
 	mvhist_push_undo_stack( mvhist, gs );
 }
 
+/* --------------------------------------------------------------
+ * void _do_switch_branch():
+ *
+ * Switch to the oldest branch forking off the current line of the
+ * specified moves-history (mvhist), and update accordingly the
+ * specified game-state (gs). The player is taken to the fork point,
+ * and the moves of the branch can then be walked with redo.
+ *
+ * NOTE: The line left behind is archived as the newest branch, so
+ *       repeated switching cycles through all the alternative lines
+ *       (see the function: mvhist_switch_branch() in "mvhist.c").
+ * --------------------------------------------------------------
+ */
+static void _do_switch_branch( GameState *gs, MovesHistory *mvhist, Tui *tui )
+{
+	if ( NULL == gs || NULL == mvhist || NULL == tui ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return;
+	}
+
+	if ( 0 == mvhist_count_branches(mvhist) ) {
+		tui_sys_beep(1);
+		return;
+	}
+
+	if ( !mvhist_switch_branch(mvhist, 0, gs) ) {
+		DBGF( "%s", "mvhist_switch_branch() failed!" );
+		tui_sys_beep(1);
+	}
+}
+
 /* --------------------------------------------------------------
  * void _do_replay_end():
  *
@@ -574,12 +776,23 @@ static inline void _do_replay_prev(
  * specified moves-history object (mvhist), starting from the currently
  * viewed move, referred to by the specified iterator pointer (it).
  *
+ * Auto-play is driven by a loop waiting on both the timer of the next
+ * move and the keyboard (see tui_sys_wait_key()). The moves are timed
+ * by the replay delay of mvhist, scaled by the current speed (see the
+ * array _replayspeeds[]) which the keys TUI_KEY_REPLAY_FASTER & _SLOWER
+ * (or the up & down arrows) change on the fly. TUI_KEY_REPLAY_PAUSE
+ * (or space) pauses & resumes auto-play, while any other key stops it.
+ *
  * In each iteration of the auto-play loop, the specified game-state
- * object (gs) gets updated accordingly, and the specified text-user-
- * interface object (tui) is redrawn.
+ * object (gs) gets updated with all the moves that are due by then,
+ * and the specified text-user-interface object (tui) is redrawn just
+ * once for them. So, when the speed is higher than what rendering can
+ * keep up with, frames are skipped rather than slowing down playback.
+ * At the top speed (0) moves are played as fast as they get rendered.
  *
  * When auto-play finishes, the updated iterator pointer gets back
- * to the caller as a reference to the last recorded move.
+ * to the caller as a reference to the last recorded move (or to the
+ * move auto-play was stopped at).
  *
  * NOTE: The top of the replay-stack is expected to hold the oldest
  *       recorded move.
@@ -592,22 +805,86 @@ static inline void _do_replay_auto(
 	Tui          *tui
 	)
 {
-	unsigned int delay = 750;      /* msecs to delay between moves */
+	/* index of the speed in _replayspeeds[] (kept between auto-plays) */
+	static int ispeed = _REPLAYSPEED_NORMAL;
+
+	const GSNode *next = NULL;
+	unsigned long int delay = mvhist_get_replay_delay( mvhist );
+	double   speed, tnext, msecs;
+	int      key, paused = 0, done = 0, redraw = 0, nplayed;
+	unsigned int keymask;
 
 	if ( gsstack_peek_count(*it) == 1 ) {
 		tui_sys_beep(1);
 		return;
 	}
+	if ( 0 == delay ) {
+		delay = _MSECS_REPLAY_DELAY;
+	}
 
-	while ( NULL != (*it = mvhist_iter_down_replay_stack(mvhist,*it)) ) {
-		gamestate_copy( gs, gsstack_peek_state(*it) );
+	tnext = th_wall_secs();  /* the 1st move is due right away */
+	for (;;)
+	{
+		/* play the moves due by now (at the top speed, just one) */
+		speed   = _replayspeeds[ ispeed ];
+		nplayed = 0;
+		while ( !paused && (0 == nplayed || speed > 0)
+		&& th_wall_secs() >= tnext
+		){
+			next = mvhist_iter_down_replay_stack( mvhist, *it );
+			if ( NULL == next ) {
+				*it  = mvhist_iter_bottom_replay_stack( mvhist );
+				done = 1;  /* true */
+				break;
+			}
+			*it = next;
+			gamestate_copy( gs, gsstack_peek_state(*it) );
+			tnext += speed > 0 ? delay / speed / 1000.0 : 0;
+			nplayed++;
+		}
 
-		tui_redraw( tui, 0 );  /* 0: disabled commands in help-box */
-		tui_draw_iobar2_replaynavigation( tui );
-		tui_draw_iobar_autoreplayinfo( tui );
-		tui_sys_sleep( delay );
+		/* render them all at once */
+		if ( nplayed > 0 || redraw ) {
+			tui_begin_frame( tui );
+			tui_redraw( tui, 0 );  /* 0: disabled commands in help-box */
+			tui_draw_iobar2_replaynavigation( tui );
+			tui_draw_iobar_autoreplayinfo( tui, speed, paused );
+			tui_end_frame( tui );
+			redraw = 0;  /* false */
+		}
+		if ( done ) {
+			break;
+		}
+
+		/* wait until the next move is due, or a key is pressed */
+		msecs = (tnext - th_wall_secs()) * 1000;
+		if ( !tui_sys_wait_key(paused ? -1 : msecs > 0 ? msecs + 1 : 0) ) {
+			continue;
+		}
+
+		key = toupper( tui_sys_getkey(&keymask) );
+		if ( TUI_KEY_REPLAY_PAUSE == key || ' ' == key ) {
+			paused = !paused;
+		}
+		else if ( TUI_KEY_REPLAY_FASTER == key
+		|| ((keymask & TUI_KEYMASK_ARROW) && TUI_KEY_UP == key)
+		){
+			ispeed += ispeed < _REPLAYSPEED_TOP;
+		}
+		else if ( TUI_KEY_REPLAY_SLOWER == key
+		|| ((keymask & TUI_KEYMASK_ARROW) && TUI_KEY_DOWN == key)
+		){
+			ispeed -= ispeed > 0;
+		}
+		else {  /* any other key stops auto-play */
+			break;
+		}
+
+		/* the next move is due after a whole (new) delay */
+		speed  = _replayspeeds[ ispeed ];
+		tnext  = th_wall_secs() + (speed > 0 ? delay / speed / 1000.0 : 0);
+		redraw = 1;  /* true */
 	}
-	*it = mvhist_iter_bottom_replay_stack( mvhist );
 }
 
 /* --------------------------------------------------------------
@@ -616,6 +893,9 @@ static inline void _do_replay_auto(
  * Save to disk the currently viewed replay, along with all other
  * needed info available in the specified moves-history object (mvhist)
  * and redraw the specified text-user-interface object (tui).
+ *
+ * NOTE: The replay-file is written in the background, so the game
+ *       stays responsive (see _report_async_save()).
  * --------------------------------------------------------------
  */
 static void _do_replay_save( MovesHistory *mvhist, Tui *tui )
@@ -627,15 +907,30 @@ static void _do_replay_save( MovesHistory *mvhist, Tui *tui )
 
 	if ( 'y' == tolower( tui_draw_iobar_prompt_savereplay(tui) ) )
 	{
-		tui_draw_iobar_savingreplay(tui);
-		if ( !mvhist_save_to_file(mvhist, fname) ) {
-			DBGF( "%s", "mvhist_save_to_file() failed" );
+		if ( !mvhist_save_to_file_async(mvhist, fname) ) {
+			DBGF( "%s", "mvhist_save_to_file_async() failed" );
 			return;
 		}
 	}
 	return;
 }
 
+/* --------------------------------------------------------------
+ * void _report_async_save():
+ *
+ * Use the specified text-user-interface object (tui) to report the
+ * progress, or the outcome, of saving a replay-file in the background
+ * (see _do_replay_save()).
+ *
+ * NOTE: Keyboard input is blocking, so a completed save gets reported
+ *       the next time the screen is redrawn (that is, after a key).
+ * --------------------------------------------------------------
+ */
+static void _report_async_save( Tui *tui )
+{
+	tui_draw_iobar2_asyncsave( tui, mvhist_poll_async_save() );
+}
+
 /* --------------------------------------------------------------
  * void _do_replay_load():
  *
@@ -648,8 +943,7 @@ static void _do_replay_save( MovesHistory *mvhist, Tui *tui )
  *     When a replay-file gets loaded successfully, it overwrites
  *     completely the previous game-state (gs). In case the size
  *     of the loaded board was different from the size of the
- *     overwritten one, realloc() may have moved the board to
- *     a different memory location.
+ *     overwritten one, the screen layout has to change too.
  *
  *     So, it is really IMPORTANT that the text-user-interface gets
  *     well aware of this possible change, by calling the function:
@@ -675,13 +969,20 @@ static void _do_replay_load(
 	Tui          *tui
 	)
 {
-	MovesHistory *tmp = NULL;
+	MovesHistory  *tmp = NULL;
+	ReplayCatalog *catalog = NULL;
 
 	if ( 'y' == tolower( tui_draw_iobar_prompt_loadreplay(tui) ) )
 	{
 		char fname[SZMAX_FNAME] = {'\0'};
 
-		tui_prompt_replay_fname_to_load( tui, fname );
+		/* a NULL catalog just lists nothing */
+		catalog = new_catalog( REPLAYS_FOLDER );
+		if ( catalog && !catalog_refresh(catalog) ) {
+			catalog = catalog_free( catalog );
+		}
+		tui_prompt_replay_fname_to_load( tui, catalog, fname );
+		catalog = catalog_free( catalog );
 		if  ( !f_exists(fname) ) {
 			goto ret_nofile;
 		}
@@ -692,8 +993,10 @@ static void _do_replay_load(
 			goto ret_failure;
 		}
 
+		_journal_end( *mvhist );
 		*mvhist = mvhist_free( *mvhist );
 		*mvhist = tmp;
+		_journal_begin( *mvhist );
 		*it = mvhist_iter_top_replay_stack( *mvhist );
 
 		gamestate_copy( gs, gsstack_peek_state(*it) );
@@ -751,14 +1054,14 @@ ret_failure:
  *
  *        Then, until the replay-stack gets exhausted, its elements
  *        are popped out one after the other, replacing the current
- *        game-state in the way (with a fixed time delay).
+ *        game-state in the way (see _do_replay_auto()).
  * --------------------------------------------------------------
  */
 static int _do_replay( GameState *gs, MovesHistory **mvhist, Tui *tui )
 {
 	int key = TUI_KEY_NUL;
 	unsigned int keymask;
-	unsigned int delay = 750;      /* msecs to delay between moves */
+	unsigned int delay = _MSECS_REPLAY_DELAY; /* between moves */
 	const GSNode *it   = NULL;     /* iterator for the replay-stack */
 
 	if ( NULL == gs || NULL == mvhist || NULL == tui ) {
@@ -850,6 +1153,7 @@ static int _do_replay( GameState *gs, MovesHistory **mvhist, Tui *tui )
 		}
 
 		tui_draw_iobar2_replaynavigation( tui );
+		_report_async_save( tui );
 	}
 
 	return 1;  /* true */
@@ -881,7 +1185,8 @@ static void _do_cycle_skin( Tui *tui )
  * void _cleanup():
  *
  * Release the memory reserved for the specified game-state (gs),
- * moves-history (mvhist) and text-user-interface (tui).
+ * moves-history (mvhist) and text-user-interface (tui), and then
+ * release the memory reserved by the pool allocator.
  * --------------------------------------------------------------
  */
 static void _cleanup( GameState *gs, MovesHistory *mvhist, Tui *tui )
@@ -893,6 +1198,11 @@ static void _cleanup( GameState *gs, MovesHistory *mvhist, Tui *tui )
 	tui_free( tui );
 	mvhist_free( mvhist );
 	gamestate_free( gs );
+
+	/* give the pooled memory back to the system */
+	if ( !pool_release() ) {
+		DBGF( "%s", "pool_release() found blocks still in use!" );
+	}
 }
 
 /* --------------------------------------------------------------
@@ -948,6 +1258,7 @@ int main( void )
 {
 	int gameover  = 0;          /* is current game over? */
 	int key       = TUI_KEY_NUL;/* user keypress (see tui.h) */
+	int haskey    = 0;          /* was key read by a batch of moves? */
 	unsigned int keymask = 0x00;/* indicates Arrows and/or FKeys */
 	Tui          *tui = NULL;   /* text user interface */
 	GameState    *gs  = NULL;   /* current game-state */
@@ -967,6 +1278,10 @@ int main( void )
 	mvhist_reset( mvhist );
 	mvhist_push_undo_stack( mvhist, gs );
 
+	/* keep any journal left behind & start journaling this game */
+	_journal_recover();
+	_journal_begin( mvhist );
+
 	/* game loop */
 	for (;;)
 	{
@@ -975,8 +1290,12 @@ int main( void )
 		gameover = 0;         /* reset to false */
 
 		tui_redraw( tui, 1 ); /* 1: enabled commands in help-box */
+		_report_async_save( tui );
 
-		key = toupper( tui_sys_getkey(&keymask) );
+		if ( !haskey ) {
+			key = toupper( tui_sys_getkey(&keymask) );
+		}
+		haskey = 0;  /* false */
 
 		/* esc or quit key */
 		if ( TUI_KEY_ESCAPE == key || TUI_KEY_QUIT == key ) {
@@ -985,7 +1304,10 @@ int main( void )
 
 		/* arrow key */
 		else if ( keymask & TUI_KEYMASK_ARROW ) {
-			gameover = _do_play_board( key, gs, mvhist, tui);
+			gameover = _do_play_moves(
+					&key, &keymask, &haskey,
+					gs, mvhist, tui
+					);
 		}
 
 		/* cycle-skin key */
@@ -1013,6 +1335,16 @@ int main( void )
 			_do_redo( gs, mvhist, tui );
 		}
 
+		/* branch key */
+		else if ( TUI_KEY_BRANCH == key ) {
+			_do_switch_branch( gs, mvhist, tui );
+		}
+
+		/* memory-info key */
+		else if ( TUI_KEY_MEMINFO == key ) {
+			tui_toggle_meminfo( tui );
+		}
+
 		/* replay key */
 		else if ( TUI_KEY_REPLAY == key ) {
 			gameover = _do_replay( gs, &mvhist, tui );
@@ -1025,9 +1357,11 @@ int main( void )
 
 		/* is current game over? */
 		if ( gameover ) {
+			tui_begin_frame( tui );
 			tui_draw_board( tui );
 			tui_draw_scoresbar( tui );
 			tui_draw_iobar2_movescounter( tui );
+			tui_end_frame( tui );
 
 			tui_sys_beep(1);
 			if ( 'y' == tolower( tui_draw_iobar_prompt_watchreplay(tui)) ) {
@@ -1036,8 +1370,10 @@ int main( void )
 			if ( 'y' == tolower( tui_draw_iobar_prompt_newgame(tui)) ) {
 				gamestate_reset( gs );
 
+				_journal_end( mvhist );
 				mvhist_reset( mvhist );
 				mvhist_push_undo_stack( mvhist, gs );
+				_journal_begin( mvhist );
 
 				tui_clear_infobar( tui );
 			}
@@ -1048,6 +1384,8 @@ int main( void )
 
 	}
 
+	_journal_end( mvhist );
+	mvhist_wait_async_save();
 	_cleanup( gs, mvhist, tui );
 	exit( EXIT_SUCCESS );
 }
@@ -5,7 +5,7 @@
  * Version:      0.3a3
  * Date:         July 21, 2014
  * License:      Free Software (see comments in main.c for limitations)
- * Dependencies: common.h, gs.h, mvhist.h
+ * Dependencies: common.h, board.h, gs.h, rcoder.h, mvhist.h
  * --------------------------------------------------------------
  *
  * Private implementation of the MovesHistory "class". The accompanying
@@ -40,6 +40,107 @@
  * The replay.stack is actually a reversed duplicate of the undo
  * gsstack. However, the count field of each node is NOT reversed,
  * so extra care should be taken in calculations involving them! 
+ * Unless it was loaded from a text replay-file, it holds only a
+ * window of the reversed line: one segment at a time, decoded from
+ * its nearest keyframe when the replay iterators reach it (see the
+ * function: mvhist_init_replay()).
+ *
+ * Branches
+ * --------
+ *
+ * Playing a move after some undo used to throw away the redo gsstack,
+ * that is the line of moves that had been undone. Instead, the redo
+ * gsstack is now archived as a branch which forks off the top of the
+ * undo gsstack (see mvhist_fork_redo_stack()). This way, the object
+ * keeps a tree of all the lines explored by the player, with the
+ * current line (undo + redo gsstacks) being its trunk.
+ *
+ * Branches do NOT store game-states. Every move (ply) of a branch is
+ * stored as a few bytes of delta against its preceding game-state:
+ * the direction of the move, whether it updated the best-score, and
+ * the tiles generated randomly after it (see struct _ply below). The
+ * common prefix of a branch (up to its fork point) is shared with the
+ * current line.
+ *
+ * Every branch may have its own sub-branches (kids), which fork off
+ * it at counts greater than its own fork point. Only the branches
+ * forking off the current line are kept in the branches array of the
+ * object, so when switching to a branch (see mvhist_switch_branch())
+ * the current line is first walked to the fork point, then the rest
+ * of it gets archived as a new branch, and finally the 1st move of the
+ * selected branch is re-constructed in the redo gsstack. The rest of
+ * its moves are kept as deltas in the redo tail, and each one of them
+ * gets decoded only when it is redone, so switching costs time in the
+ * depth-difference rather than the length of the branch. Its kids are
+ * then promoted to the branches array of the object.
+ *
+ * Bounded memory
+ * --------------
+ *
+ * The undo gsstack used to keep a full game-state for every single move
+ * of the game, so marathon games (e.g. on 8x8 boards) made it grow large.
+ * The object now has a memory budget (see mvhist_set_budget()). When the
+ * resident nodes of the undo gsstack exceed it, the oldest half of them
+ * (but never the newest _MINRESIDENT ones) gets compacted into an archive
+ * (see _archive_compact()) which keeps one full game-state (keyframe)
+ * every _KEYINTERVAL moves, plus a ply (the same delta used by branches)
+ * and the nextmv field for every other move.
+ *
+ * The counts of the resident undo nodes are NOT changed, so the count of
+ * the top node is still the count of all the recorded moves. The oldest
+ * resident node is the one right above the last archived game-state.
+ *
+ * The archived moves remain reachable. When undo exhausts the resident
+ * nodes, the last keyframe segment is decoded back into full nodes (see
+ * _archive_restore()), and replays & saved files decode the archive on
+ * the fly, one segment at a time.
+ *
+ * Binary files
+ * ------------
+ *
+ * Text files (.sav) write a full line per game-state, and the undo
+ * gsstack twice (as replay.stack too). Files with the REPLAY_FNAME_EXT
+ * extension (.sav2) use a versioned binary format instead, which keeps
+ * just the 1st game-state of the current line. Every next one is stored
+ * as its move plus the tiles generated after it, since replaying the
+ * move re-constructs everything else (see _binline_add()). The moves
+ * are compressed by a range coder (see the file: "rcoder.c"), which
+ * predicts each direction from the previous one, and codes each tile
+ * as its rank among the empty tiles of the board. Text files, and
+ * older binary files with uncompressed moves, are still loaded.
+ *
+ * So every move is stored exactly once: the redo gsstack is just the
+ * tail of the current line, the branches are deltas off of it, and the
+ * replay.stack is not stored at all. Loading re-constructs it from the
+ * undo gsstack (see _replay_rebuild()), like entering replay-mode does.
+ *
+ * Journal
+ * -------
+ *
+ * While a journal is open (see mvhist_journal_open()) every change of
+ * the undo gsstack is appended to it as soon as it happens, as a tiny
+ * record: a move is stored like in binary files (its direction and its
+ * generated tiles), an undo as a single byte, and any game-state that
+ * cannot be encoded as a move in full (see _jnl_put_state()). The
+ * nextmv of a game-state is taken from the move following it, unless a
+ * byte with another one is put before that move. Writes
+ * are buffered and committed to the disk every _JNL_SYNCEVERY records.
+ *
+ * A journal is a valid file on its own (only the current line is kept
+ * though, without the redo gsstack and the branches). Thus, finalizing
+ * it into a replay-file is just a matter of renaming it, and after a
+ * crash it may be loaded as is, up to its last intact record.
+ *
+ * Memory accounting
+ * -----------------
+ *
+ * The bytes occupied by the undo (resident nodes + archive), redo &
+ * replay gsstacks are computed on demand from their counts, while the
+ * bytes of the branches are kept as a running count (nbbranches), which
+ * is updated wherever a branch gets allocated or freed (see the function:
+ * _mem_nbytes()). So all of them cost O(1) to get, and their high-water
+ * marks are kept up to date by every function that may grow any of them,
+ * via the function: _mem_track()
  ****************************************************************
  */
 
@@ -47,11 +148,161 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 #include "common.h"
+#include "pool.h"
+#include "board.h"
 #include "gs.h"
+#include "rcoder.h"
 #include "mvhist.h"
 
+/* Maximum count of tiles generated randomly after a single move
+ * (the 6x6 variant generates 2 tiles per move, all others just 1).
+ */
+#define _MAXSPAWNS  2
+
+/* Keyframe interval of the archive (in moves) and minimum count of
+ * resident undo nodes, no matter how small the memory budget is.
+ */
+#define _KEYINTERVAL  32
+#define _MINRESIDENT  (2 * _KEYINTERVAL)
+
+/* A single move (ply) of an archived branch, stored as a delta
+ * against the game-state it was played on (see: _ply_make()).
+ */
+struct _ply {
+	unsigned char mvdir;              /* GS_MVDIR_XXX of the move */
+	unsigned char bsup;               /* did it update the best-score? */
+	unsigned char nspawns;            /* # of tiles generated after it */
+	unsigned char pos[ _MAXSPAWNS ];  /* grid-index of generated tiles */
+	unsigned char val[ _MAXSPAWNS ];  /* values of generated tiles */
+};
+
+/* An archived branch of the moves-history tree */
+struct _branch {
+	long int       fork;     /* count of the node it forks off */
+	long int       nplies;   /* # of moves in the branch */
+	struct _ply    *plies;   /* the moves (as deltas) */
+	int            nkids;    /* # of sub-branches forking off this one */
+	struct _branch *kids;    /* the sub-branches */
+};
+
+/* A keyframe of the archive (a full copy of an archived game-state) */
+struct _key {
+	long int  count;          /* count of the archived game-state */
+	GameState *state;         /* the game-state */
+};
+
+/* Signature & version of the binary format of saved files */
+#define _BIN_MAGIC     "2048sav2"
+#define _SZBIN_MAGIC   (sizeof(_BIN_MAGIC) - 1)
+#define _BIN_VERSION   2
+#define _BIN_VERSION_1 1          /* uncompressed moves (still loaded) */
+
+/* Upper bound of the moves a byte of the binary format may hold. Every
+ * compressed move costs at least the 2 adaptive bits of its direction,
+ * none of which costs less than 1/45 of a bit (see _NBITS_ADAPT in the
+ * file "rcoder.c"), so a byte holds at most 180 of them. Uncompressed
+ * moves take at least 2 bits each.
+ */
+#define _BIN_MAXMOVESPERBYTE  256
+
+/* A cursor over the contents of a file in the binary format */
+struct _bincursor {
+	const unsigned char *cp;  /* next byte to be read */
+	const unsigned char *end; /* end of the contents */
+};
+
+/* Signature & version of journal files, how many records are written
+ * between commits to the storage device, and the size of their buffer.
+ */
+#define _JNL_MAGIC       "2048jnl1"
+#define _SZJNL_MAGIC     (sizeof(_JNL_MAGIC) - 1)
+#define _JNL_VERSION     2
+#define _JNL_SYNCEVERY   32
+#define _JNL_SZBUF       (64 * 1024)
+
+/* Size of the buffer of files being saved */
+#define _SAVE_SZBUF      (64 * 1024)
+
+/* Opcodes of journal records, stored in the 3 least significant bits
+ * of their 1st byte. Opcodes 1 to 4 are moves (their GS_MVDIR_XXX).
+ */
+enum {
+	_JNL_KEY     = 0,   /* a full game-state, as a text line */
+	_JNL_POP     = 5,   /* the top game-state got un-done */
+	_JNL_DIDUNDO = 6,   /* didundo got changed (new value in bit 3) */
+	_JNL_NEXTMV  = 7    /* nextmv of the top (in bits 3-5), since v2 */
+};
+
+/* A game-state whose nextmv is not the direction of the next move */
+struct _binnext {
+	long int  count;          /* count of the game-state */
+	int       mvdir;          /* its nextmv */
+};
+
+/* Adaptive models of the compressed moves, in the current line (see:
+ * _binline_add()) and in the branches (see: _bin_ply_encode())
+ */
+struct _binmodel {
+	RcProb dirs[ GS_MVDIR_RIGHT + 1 ][4];  /* by previous direction */
+	RcProb vals[ _MAXSPAWNS ];           /* 4 instead of 2 */
+	RcProb brdirs[8][8];                 /* mvdir, by previous one */
+	RcProb bsup[2];                      /* bsup, by previous one */
+	RcProb nspawns[4];
+	RcProb pos[256];                     /* grid-index of a tile */
+	RcProb val[256];                     /* value of a tile */
+};
+
+/* The binary encoding of a current line (see: _binline_encode()) */
+struct _binline {
+	long int        nundo;    /* # of game-states in the undo gsstack */
+	long int        nredo;    /* # of game-states in the redo gsstack */
+	long int        nmax;     /* nundo + nredo */
+	long int        nstates;  /* # of game-states encoded so far */
+	GameState       *first;   /* the 1st game-state of the line */
+	GameState       *prev;    /* the last encoded game-state */
+	GameState       *scratch; /* work-area */
+	RcEncoder       moves;    /* compressed moves & generated tiles */
+	struct _binmodel model;   /* adaptive models of the moves */
+	int             lastdir;  /* direction of the last encoded move */
+	int             tracked;  /* is the best-score following the score? */
+	long int        *toggles; /* counts of moves toggling tracked */
+	long int        ntoggles; /* # of toggles */
+	struct _binnext *nexts;   /* nextmv exceptions */
+	long int        nnexts;   /* # of nextmv exceptions */
+};
+
+/* A re-simulation of a current line, checking that every game-state
+ * follows from the previous one (see mvhist_verify()).
+ */
+struct _verify {
+	long int    nstates;      /* # of game-states checked so far */
+	GameState   *prev;        /* the last checked game-state */
+	GameState   *scratch;     /* work-area */
+	const char  *reason;      /* why the last one is inconsistent */
+};
+
+/* The saving of a moves-history object to a file (see _savejob_run())
+ * possibly in the background, from a snapshot of the object (see the
+ * function mvhist_save_to_file_async()).
+ */
+struct _savejob {
+	const MovesHistory   *mvhist;    /* the object, or its snapshot */
+	MovesHistory         *snap;      /* the snapshot, if any */
+	char                 *fname;     /* the file to be replaced */
+	char                 *tmpname;   /* the file actually written */
+	void                 *worker;    /* background thread, if any */
+	int                  ok;         /* outcome, if saved in foreground */
+};
+
+/* The save in progress in the background, if any (there is at most one
+ * per process, since replay-files outlive the objects they are saved
+ * from, e.g. when a replay-file gets loaded).
+ */
+static struct _savejob *_asyncjob = NULL;
+
 /* The definition of the "class"
  * (it is publicly exposed as an opaque data-type).
  */
@@ -59,1002 +310,5487 @@ struct _MovesHistory {
 	int    didundo;    /* has the player done at least 1 undo? */
 	GSNode *undo;      /* undo stack (stores game-states) */
 	GSNode *redo;      /* redo stack (stores game-states) */
+	struct {
+		struct _ply *plies;   /* moves following the bottom redo node */
+		long int    nplies;   /* # of those moves */
+		long int    next;     /* index of the 1st one not decoded yet */
+	} redotail;  /* rest of a switched branch (see _redo_pop()) */
 	struct {
 		unsigned long int delay;/* time delay during autoplay (msecs)*/
 		long int nmoves;        /* length of replay-stack */
 		long int itcount;       /* count of node under iterator */
 		GSNode   *stack;        /* the replay-stack */
+		long int iseg;          /* its segment of the line, -1: all */
+		long int nnodes;        /* # of nodes of the segment */
 	} replay;
+	int            nbranches; /* # of branches forking off undo+redo */
+	struct _branch *branches; /* branches forking off undo+redo */
+	size_t         nbbranches;/* bytes of the branches (& sub-branches) */
+	struct {
+		size_t      budget;   /* bytes of resident undo nodes (0: no max)*/
+		long int    nstates;  /* # of archived (oldest) undo game-states */
+		struct _ply *plies;   /* plies[c-1]: delta of game-state c */
+		unsigned char *nextmvs; /* nextmvs[c-1]: nextmv of game-state c */
+		long int    nkeys;    /* # of keyframes */
+		struct _key *keys;    /* keyframes, in increasing count order */
+	} archive;
+	size_t nbpeak[ MVHIST_MEM_TOTAL+1 ]; /* high-water marks of memory */
+	struct {
+		char   *buf;      /* contents of the loaded file (or NULL) */
+		size_t size;      /* size of the contents */
+		int    mapped;    /* memory-mapped, or read into the heap? */
+	} src;     /* text of the lazy nodes of a loaded file (see gs.c) */
+	struct {
+		FILE      *fp;        /* open journal (NULL: not journaling) */
+		char      *fname;     /* its filename */
+		GameState *scratch;   /* work-area for encoding moves */
+		long int  nunsynced;  /* # of records since the last commit */
+		long int  nrecords;   /* # of records since it got opened */
+	} journal;
 };
 
 /* --------------------------------------------------------------
- * (Constructor) MovesHistory *new_mvhist():
+ * void _branches_free():
  *
- * The moves-history constructor instantiates a new object in memory,
- * initializes it with default values, and returns a pointer to it,
- * or NULL on error.
+ * Release all resources occupied by the specified array of (n)
+ * branches, including all of their sub-branches.
  * --------------------------------------------------------------
  */
-MovesHistory *new_mvhist( void )
+static void _branches_free( struct _branch *branches, int n )
 {
-	MovesHistory *mvhist = calloc(1, sizeof(*mvhist) );
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "calloc() failed!" );
-		return NULL;
-	}
+	int i;
 
-	mvhist->replay.delay = 750;
-	return mvhist;
+	for (i=0; i < n; i++) {
+		free( branches[i].plies );
+		_branches_free( branches[i].kids, branches[i].nkids );
+	}
+	free( branches );
 }
 
 /* --------------------------------------------------------------
- * (Destructor) MovesHistory *mvhist_free():
+ * struct _branch *_branches_dup():
  *
- * The moves-history destructor releases all resources occupied
- * by the specified object, and returns NULL (so the caller may
- * assign it back to the object pointer).
+ * Return a deep copy of the specified array of (n) branches, including
+ * all of their sub-branches, or NULL on error (or if n is 0). It should
+ * be released via _branches_free().
  * --------------------------------------------------------------
  */
-MovesHistory *mvhist_free( MovesHistory *mvhist )
+static struct _branch *_branches_dup( const struct _branch *branches, int n )
 {
-	if ( mvhist ) {
-		gsstack_free( &mvhist->undo );
-		gsstack_free( &mvhist->redo );
-		gsstack_free( &mvhist->replay.stack );
-		free( mvhist );
+	int i;
+	struct _branch *dup = NULL;
+
+	if ( 0 == n || NULL == (dup = calloc(n, sizeof(*dup))) ) {
+		return NULL;
+	}
+
+	for (i=0; i < n; i++)
+	{
+		dup[i] = branches[i];
+		dup[i].plies = NULL;
+		dup[i].kids  = NULL;
+		if ( branches[i].nplies > 0 ) {
+			dup[i].plies = malloc( branches[i].nplies * sizeof(struct _ply) );
+			if ( NULL == dup[i].plies ) {
+				goto ret_failure;
+			}
+			memcpy(
+				dup[i].plies,
+				branches[i].plies,
+				branches[i].nplies * sizeof(struct _ply)
+				);
+		}
+		if ( branches[i].nkids > 0 ) {
+			dup[i].kids = _branches_dup( branches[i].kids, branches[i].nkids );
+			if ( NULL == dup[i].kids ) {
+				goto ret_failure;
+			}
+		}
 	}
 
+	return dup;
+
+ret_failure:
+	_branches_free( dup, i + 1 );
 	return NULL;
 }
 
 /* --------------------------------------------------------------
- * int mvhist_reset():
+ * void _src_release():
  *
- * Reset the specified moves-history object (mvhist) for a new game.
- * Return 0 (false) on error, 1 (true) otherwise.
- *
- * NOTE: Resetting a moves-history object does NOT change its
- *       replay.delay field.
+ * Release the contents of the file that the specified moves-history
+ * object (mvhist) was loaded from, if any. It MUST be called only when
+ * none of its gsstacks has lazy nodes left (e.g. after freeing them).
  * --------------------------------------------------------------
  */
-int mvhist_reset( MovesHistory *mvhist )
+static inline void _src_release( MovesHistory *mvhist )
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)!" );
-		return 0; /* false */
+	if ( mvhist->src.mapped ) {
+		f_unmap_all( mvhist->src.buf, mvhist->src.size );
 	}
-	mvhist->didundo = 0; /* false */
-	mvhist->undo = gsstack_free( &mvhist->undo );
-	mvhist->redo = gsstack_free( &mvhist->redo );
-	mvhist->replay.stack = gsstack_free( &mvhist->replay.stack );
-	mvhist->replay.nmoves = 0;
-	mvhist->replay.itcount = 0;
-
-	return 1;
+	else {
+		free( mvhist->src.buf );
+	}
+	memset( &mvhist->src, 0, sizeof(mvhist->src) );
 }
 
 /* --------------------------------------------------------------
- * int mvhist_isempty_undo_stack():
+ * size_t _branches_nbytes():
  *
- * Return 1 (true) if the undo gsstack of the specified moves-history
- * object (mvhist) is empty, or on error. Return 0 (false) otherwise. 
+ * Return the count of bytes occupied by the specified array of (n)
+ * branches, including all of their sub-branches.
+ *
+ * NOTE: It walks the whole tree of the branches, so it is meant to
+ *       be called only when they get loaded or freed (see the field
+ *       nbbranches of struct _MovesHistory).
  * --------------------------------------------------------------
  */
-int mvhist_isempty_undo_stack( const MovesHistory *mvhist )
+static size_t _branches_nbytes( const struct _branch *branches, int n )
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument!" );
-		return 1; /* true */
-	}
+	int i;
+	size_t nbytes = n * sizeof(*branches);
 
-	return NULL == mvhist->undo;
+	for (i=0; i < n; i++) {
+		nbytes += branches[i].nplies * sizeof(*branches[i].plies);
+		nbytes += _branches_nbytes( branches[i].kids, branches[i].nkids );
+	}
+	return nbytes;
 }
 
 /* --------------------------------------------------------------
- * int mvhist_push_undo_stack():
+ * void _branches_prune_above():
  *
- * Push the specified game-state object (state) onto the undo
- * gsstack of the specified moves-history object (mvhist).
- * Return 0 (false) on error, 1 (true) otherwise.
+ * Destroy all branches of the specified moves-history object (mvhist)
+ * which fork off its current line at a count greater than (fork).
+ * The order of the remaining branches is preserved.
  * --------------------------------------------------------------
  */
-int mvhist_push_undo_stack( MovesHistory *mvhist, const GameState *state )
+static inline void _branches_prune_above( MovesHistory *mvhist, long int fork )
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return 0;  /* false */
-	}
+	int i, n = 0;
 
-	return gsstack_push( &mvhist->undo, state );
+	for (i=0; i < mvhist->nbranches; i++) {
+		if ( mvhist->branches[i].fork > fork ) {
+			mvhist->nbbranches -= _branches_nbytes( &mvhist->branches[i], 1 );
+			free( mvhist->branches[i].plies );
+			_branches_free(
+				mvhist->branches[i].kids,
+				mvhist->branches[i].nkids
+				);
+			continue;
+		}
+		mvhist->branches[n++] = mvhist->branches[i];
+	}
+	mvhist->nbranches = n;
+	if ( 0 == n ) {
+		free( mvhist->branches );
+		mvhist->branches = NULL;
+	}
 }
 
 /* --------------------------------------------------------------
- * long int mvhist_peek_undo_stack_count():
+ * size_t _mem_nbytes():
  *
- * Return the value of the count field, stored at the top node of
- * the undo gsstack of the specified moves-history object (mvhsit),
- * or 0 on error.
+ * Return the count of bytes currently occupied by the specified
+ * category (which) of the specified moves-history object (mvhist).
+ * The categories are the MVHIST_MEM_XXX constants of "mvhist.h".
  *
- * NOTE: The count of nodes in a gsstack is 1-based.
+ * NOTES: Counts of nodes are taken from the counts of top nodes,
+ *        which works because apart from the archived moves of the
+ *        undo gsstack and the window of the replay.stack, all
+ *        gsstacks are numbered from 1. The bytes of the branches
+ *        are kept as a running count, so this is O(1) for every
+ *        category.
+ *
+ *        Lazy nodes of a loaded file are counted as full nodes, so
+ *        the figures are upper bounds until they get peeked.
  * --------------------------------------------------------------
  */
-long int mvhist_peek_undo_stack_count( const MovesHistory *mvhist )
+static size_t _mem_nbytes( const MovesHistory *mvhist, int which )
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return 0;
+	const size_t sznode = gsstack_sizeof_node();
+
+	switch ( which )
+	{
+		case MVHIST_MEM_UNDO:
+			return sznode * (
+				gsstack_peek_count( mvhist->undo )
+				- mvhist->archive.nstates
+				)
+				+ mvhist->archive.nstates * sizeof(struct _ply)
+				+ mvhist->archive.nstates
+				+ mvhist->archive.nkeys * (
+					sizeof(struct _key) + gamestate_sizeof()
+					);
+
+		case MVHIST_MEM_REDO:
+			return sznode * gsstack_peek_count( mvhist->redo )
+				+ mvhist->redotail.nplies * sizeof(struct _ply);
+
+		case MVHIST_MEM_REPLAY:  /* it may be a window (see _replay_seek()) */
+			return sznode * (
+				mvhist->replay.iseg > -1
+				? mvhist->replay.nnodes
+				: gsstack_peek_count( mvhist->replay.stack )
+				);
+
+		case MVHIST_MEM_BRANCHES:
+			return mvhist->nbbranches;
+
+		case MVHIST_MEM_TOTAL:
+			return _mem_nbytes( mvhist, MVHIST_MEM_UNDO )
+				+ _mem_nbytes( mvhist, MVHIST_MEM_REDO )
+				+ _mem_nbytes( mvhist, MVHIST_MEM_REPLAY )
+				+ _mem_nbytes( mvhist, MVHIST_MEM_BRANCHES );
+
+		default:
+			break;
 	}
 
-	return gsstack_peek_count( mvhist->undo );
+	return 0;
 }
 
 /* --------------------------------------------------------------
- * const GameState *mvhist_peek_undo_stack_state():
+ * void _mem_track():
  *
- * Return a pointer to the game-state object stored at the top
- * node of the undo gsstack of the specified moves-history object
- * (mvhist), or NULL on error.
+ * Update the high-water marks of all the memory categories of the
+ * specified moves-history object (mvhist).
  * --------------------------------------------------------------
  */
-const GameState *mvhist_peek_undo_stack_state( const MovesHistory *mvhist )
+static inline void _mem_track( MovesHistory *mvhist )
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return NULL;
+	int i;
+	size_t nbytes;
+
+	for (i=0; i <= MVHIST_MEM_TOTAL; i++) {
+		nbytes = _mem_nbytes( mvhist, i );
+		if ( nbytes > mvhist->nbpeak[i] ) {
+			mvhist->nbpeak[i] = nbytes;
+		}
 	}
-	return gsstack_peek_state( mvhist->undo );
 }
 
 /* --------------------------------------------------------------
- * int mvhist_pop_undo_stack():
+ * int _board_play_mvdir():
  *
- * Remove the top node of the undo gsstack of the specified
- * moves-history object (mvhist). Return 0 (false) on error,
- * 1 (true) otherwise.
+ * Play on the specified board a move towards the specified direction
+ * (mvdir), updating the score & won status (see: board_move_XXX()
+ * functions in the file: "board.c"). Return 1 (true) if the board
+ * was moved, 0 (false) otherwise.
  * --------------------------------------------------------------
  */
-int mvhist_pop_undo_stack( MovesHistory *mvhist )
+static inline int _board_play_mvdir(
+	Board    *board,
+	int      mvdir,
+	long int *score,
+	int      *won
+	)
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return 0;  /* false */
+	switch ( mvdir )
+	{
+		case GS_MVDIR_UP:
+			return board_move_up( board, score, won, NULL );
+		case GS_MVDIR_DOWN:
+			return board_move_down( board, score, won, NULL );
+		case GS_MVDIR_LEFT:
+			return board_move_left( board, score, won, NULL );
+		case GS_MVDIR_RIGHT:
+			return board_move_right( board, score, won, NULL );
+		default:
+			break;
 	}
-	return gsstack_pop( &mvhist->undo );
+
+	return 0;  /* false */
 }
 
 /* --------------------------------------------------------------
- * int mvhist_isempty_redo_stack():
+ * int _ply_make_mvdir():
  *
- * Return 1 (true) if the redo gsstack of the specified moves-history
- * object (mvhist) is empty, or on error. Return 0 (false) otherwise. 
+ * Encode in the specified ply the delta between the game-states
+ * (prev) and (next), where the latter is expected to be the result
+ * of playing the specified move direction (mvdir) on the former. The
+ * game-state (scratch) is used as a work-area, and its board MUST
+ * have the same dimension with the others. Return 0 (false) if next
+ * cannot be reached that way from prev, 1 (true) otherwise.
  * --------------------------------------------------------------
  */
-int mvhist_isempty_redo_stack( const MovesHistory *mvhist )
+static inline int _ply_make_mvdir(
+	struct _ply     *ply,
+	const GameState *prev,
+	const GameState *next,
+	int             mvdir,
+	GameState       *scratch
+	)
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument!" );
-		return 1; /* true */
+	int i,j, dim, v0, v1;
+	int won = 0;
+	long int score;
+	Board *board = NULL;
+	const Board *nextboard = gamestate_get_board( next );
+
+	memset( ply, 0, sizeof(*ply) );
+	ply->mvdir = mvdir;
+
+	/* replay the move on a copy of prev */
+	gamestate_copy( scratch, prev );
+	board = gamestate_get_board( scratch );
+	score = gamestate_get_score( scratch );
+	if ( !_board_play_mvdir(board, ply->mvdir, &score, &won)
+	|| score != gamestate_get_score(next)
+	){
+		return 0;  /* false */
 	}
 
-	return NULL == mvhist->redo;
+	/* best-score is either unchanged, or it follows the score */
+	if ( gamestate_get_bestscore(next) != gamestate_get_bestscore(prev) ) {
+		if ( gamestate_get_bestscore(next) != score ) {
+			return 0;  /* false */
+		}
+		ply->bsup = 1;  /* true */
+	}
+
+	/* whatever differs now, should be a randomly generated tile */
+	dim = board_get_dim( board );
+	if ( dim != board_get_dim(nextboard) ) {
+		return 0;  /* false */
+	}
+	for (i=0; i < dim; i++) {
+		for (j=0; j < dim; j++) {
+			v0 = board_get_tile_value( board, i,j );
+			v1 = board_get_tile_value( nextboard, i,j );
+			if ( v0 == v1 ) {
+				continue;
+			}
+			if ( 0 != v0 || v1 > UCHAR_MAX
+			|| _MAXSPAWNS == ply->nspawns
+			){
+				return 0;  /* false */
+			}
+			ply->pos[ ply->nspawns ] = i * dim + j;
+			ply->val[ ply->nspawns ] = v1;
+			ply->nspawns++;
+		}
+	}
+
+	return 1;  /* true */
 }
 
 /* --------------------------------------------------------------
- * int mvhist_free_redo_stack():
+ * int _ply_make():
  *
- * Destroy all nodes of the redo gsstack of the specified moves-history
- * object (mvhist). Return 0 (false) on error, 1 (true) otherwise.
+ * Encode in the specified ply the delta between the game-states
+ * (prev) and (next), where the latter is expected to be the result
+ * of playing a move on the former (see _ply_make_mvdir()). Return
+ * 0 (false) if next cannot be reached from prev, 1 (true) otherwise.
+ *
+ * NOTE: The move direction is taken from the prevmv field of next,
+ *       but if that one does not lead to next (e.g. a history saved
+ *       by older versions, which recorded keys that moved nothing)
+ *       the other directions are tried too. The ply gets the one
+ *       that does, so it rebuilds next with the right prevmv.
  * --------------------------------------------------------------
  */
-int mvhist_free_redo_stack( MovesHistory *mvhist )
+static inline int _ply_make(
+	struct _ply     *ply,
+	const GameState *prev,
+	const GameState *next,
+	GameState       *scratch
+	)
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument!" );
-		return 0;  /* false */
-	}
+	int mvdir, prevmv = gamestate_get_prevmove( next );
 
-	mvhist->redo = gsstack_free( &mvhist->redo );
-	return 1;  /* true */
+	if ( _ply_make_mvdir(ply, prev, next, prevmv, scratch) ) {
+		return 1;  /* true */
+	}
+	for (mvdir = GS_MVDIR_UP; mvdir <= GS_MVDIR_RIGHT; mvdir++) {
+		if ( mvdir != prevmv
+		&& _ply_make_mvdir(ply, prev, next, mvdir, scratch)
+		){
+			return 1;  /* true */
+		}
+	}
+	return 0;  /* false */
 }
 
 /* --------------------------------------------------------------
- * int mvhist_push_redo_stack():
+ * int _ply_apply():
  *
- * Push the specified game-state object (state) onto the redo
- * gsstack of the specified moves-history object (mvhist).
+ * Apply the specified ply on the specified game-state (state), so
+ * it becomes the game-state the ply was originally encoded from.
  * Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTE: The nextmv field of the game-state is set to GS_MVDIR_NONE.
  * --------------------------------------------------------------
  */
-int mvhist_push_redo_stack( MovesHistory *mvhist, const GameState *state )
+static inline int _ply_apply( GameState *state, const struct _ply *ply )
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
+	int k, dim, won = 0;
+	long int score = gamestate_get_score( state );
+	Board *board = gamestate_get_board( state );
+
+	if ( !_board_play_mvdir(board, ply->mvdir, &score, &won) ) {
 		return 0;  /* false */
 	}
-	return gsstack_push( &mvhist->redo, state );
+
+	dim = board_get_dim( board );
+	for (k=0; k < ply->nspawns; k++) {
+		if ( !board_set_tile_value(
+			board,
+			ply->pos[k] / dim,
+			ply->pos[k] % dim,
+			ply->val[k]
+			)
+		){
+			return 0;  /* false */
+		}
+	}
+
+	gamestate_set_score( state, score );
+	if ( ply->bsup ) {
+		gamestate_set_bestscore( state, score );
+	}
+	if ( won ) {
+		gamestate_set_iswin( state, 1 );  /* true */
+	}
+	gamestate_set_prevmove( state, ply->mvdir );
+	gamestate_set_nextmove( state, GS_MVDIR_NONE );
+
+	return 1;  /* true */
 }
 
 /* --------------------------------------------------------------
- * long int mvhist_peek_redo_stack_count():
- *
- * Return the value of the count field, stored at the top node of
- * the redo gsstack of the specified moves-history object (mvhsit),
- * or 0 on error.
+ * int _plies_apply_nth():
  *
- * NOTE: The count of nodes in a gsstack is 1-based.
+ * Apply on the specified game-state (state) the ply (i) of the
+ * specified array of (n) plies, and set its nextmv field to the
+ * direction of the ply following it (if any), like moves played
+ * one after the other do. Return 0 (false) on error, 1 (true)
+ * otherwise.
  * --------------------------------------------------------------
  */
-long int mvhist_peek_redo_stack_count( const MovesHistory *mvhist )
+static inline int _plies_apply_nth(
+	GameState         *state,
+	const struct _ply *plies,
+	long int          i,
+	long int          n
+	)
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return 0;
+	if ( !_ply_apply(state, &plies[i]) ) {
+		return 0;  /* false */
+	}
+	if ( i < n - 1 ) {
+		gamestate_set_nextmove( state, plies[i+1].mvdir );
 	}
-	return gsstack_peek_count( mvhist->redo );
+	return 1;  /* true */
 }
 
 /* --------------------------------------------------------------
- * const GameState *mvhist_peek_redo_stack_state():
+ * void _redotail_free():
  *
- * Return a pointer to the game-state object stored at the top
- * node of the redo gsstack of the specified moves-history object
- * (mvhist), or NULL on error.
+ * Release the moves of the redo tail of the specified moves-history
+ * object (mvhist), that is the moves following the bottom node of
+ * its redo gsstack (see _redo_pop()).
  * --------------------------------------------------------------
  */
-const GameState *mvhist_peek_redo_stack_state( const MovesHistory *mvhist )
+static inline void _redotail_free( MovesHistory *mvhist )
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return NULL;
-	}
-	return gsstack_peek_state( mvhist->redo );
+	free( mvhist->redotail.plies );
+	memset( &mvhist->redotail, 0, sizeof(mvhist->redotail) );
 }
 
 /* --------------------------------------------------------------
- * int mvhist_pop_redo_stack():
+ * long int _redotail_count():
  *
- * Remove the top node of the redo gsstack of the specified
- * moves-history object (mvhist). Return 0 (false) on error,
- * 1 (true) otherwise.
+ * Return the count of the moves of the redo tail of the specified
+ * moves-history object (mvhist), that are not decoded yet.
  * --------------------------------------------------------------
  */
-int mvhist_pop_redo_stack( MovesHistory *mvhist )
+static inline long int _redotail_count( const MovesHistory *mvhist )
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return 0;  /* false */
-	}
-	return gsstack_pop( &mvhist->redo );
+	return mvhist->redotail.nplies - mvhist->redotail.next;
 }
 
 /* --------------------------------------------------------------
- * GSNode *mvhist_init_replay():
- *
- * Prepare the replay nested structure of the specified moves-history
- * object (mvhist) for first use. Return a pointer to the newly created
- * replay.stack, or NULL on error.
- *
- * NOTES (IMPORTANT!):
- *
- *     Preparation involves creating a new replay.stack as a reversed
- *     duplicate of mvhist's undo gsstack. The undo gsstack CANNOT be
- *     empty, because it always contains at least the 1st move of the
- *     game (since it is performed automatically). 
- *
- *     On the other hand, if the replay.stack in NOT already NULL,
- *     the function returns an error. This is an extra precaution
- *     for reducing chances of MEMORY-LEAKS, and for enforcing the
- *     GOOD PRACTICE of setting all pointers to NULL before using
- *     them.
+ * void _archive_free():
  *
- *     In this "class", the replay.stack is ALWAYS either initialized
- *     to NULL via calloc() in new_mvhist(), or it is explicitly set
- *     to NULL every time it gets freed, via mvhist_cleanup_replay().
- *        
- *     On success, replay.nmoves is set equal to the count of nodes of
- *     the newly created replay.stack, replay.delay is set equal to the
- *     2nd argument of the function (NO SANITY CHECK, should be fixed?)
- *     and replay.itcount is set to 0.
+ * Release all resources occupied by the archive of the specified
+ * moves-history object (mvhist), and empty it. Its budget is kept.
  * --------------------------------------------------------------
  */
-GSNode *mvhist_init_replay( MovesHistory *mvhist, unsigned int delay )
+static inline void _archive_free( MovesHistory *mvhist )
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)!" );
-		return NULL;
-	}
-	if ( NULL != mvhist->replay.stack ) {
-		DBGF( "%s", "replay.stack is non-NULL. Cannot create replay!" );
-		return NULL;
-	}
+	long int i;
 
-	mvhist->replay.stack = gsstack_dup_reversed( mvhist->undo );
-	if ( NULL == mvhist->replay.stack ) {
-		DBGF( "%s", "gsstack_dup_reversed(mvhist->undo) failed!)" );
-		return NULL;
+	for (i=0; i < mvhist->archive.nkeys; i++) {
+		gamestate_free( mvhist->archive.keys[i].state );
 	}
-
-	mvhist->replay.nmoves  = gsstack_peek_count( mvhist->undo );
-	mvhist->replay.itcount = 0;
-	mvhist->replay.delay   = delay;
-
-	return mvhist->replay.stack;
+	free( mvhist->archive.keys );
+	free( mvhist->archive.plies );
+	free( mvhist->archive.nextmvs );
+	mvhist->archive.keys    = NULL;
+	mvhist->archive.plies   = NULL;
+	mvhist->archive.nextmvs = NULL;
+	mvhist->archive.nkeys   = 0;
+	mvhist->archive.nstates = 0;
 }
 
 /* --------------------------------------------------------------
- int mvhist_cleanup_replay():
- *
- * Cleanup the replay nested structure of the specified moves-history
- * object (mvhist). Return 0 (false) on error, 1 (true) otherwise.
+ * int _archive_add_key():
  *
- * NOTE: Cleanup involves, among other things, freeing up the
- *       replay.stack and setting its pointer equal to NULL.
+ * Append to the archive of the specified moves-history object (mvhist)
+ * a keyframe with a copy of the specified game-state (state), having
+ * the specified count. Return 0 (false) on error, 1 (true) otherwise.
  * --------------------------------------------------------------
  */
-int mvhist_cleanup_replay( MovesHistory *mvhist )
+static inline int _archive_add_key(
+	MovesHistory    *mvhist,
+	long int        count,
+	const GameState *state
+	)
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "calloc() failed!" );
+	struct _key *try = NULL;
+	GameState *copy = new_gamestate(
+				board_get_dim( gamestate_get_board(state) )
+				);
+	if ( NULL == copy ) {
+		DBGF( "%s", "new_gamestate() failed!" );
 		return 0;  /* false */
 	}
+	gamestate_copy( copy, state );
 
-	mvhist->replay.stack   = gsstack_free( &mvhist->replay.stack );
-	mvhist->replay.nmoves  = 0;
-	mvhist->replay.itcount = 0;
-	mvhist->replay.delay   = 750;
+	try = realloc(
+		mvhist->archive.keys,
+		(mvhist->archive.nkeys + 1) * sizeof(*try)
+		);
+	if ( NULL == try ) {
+		DBGF( "%s", "realloc(mvhist->archive.keys) failed!" );
+		gamestate_free( copy );
+		return 0;  /* false */
+	}
+	mvhist->archive.keys = try;
+	try[ mvhist->archive.nkeys ].count = count;
+	try[ mvhist->archive.nkeys ].state = copy;
+	mvhist->archive.nkeys++;
 
 	return 1;  /* true */
 }
 
 /* --------------------------------------------------------------
- * long int mvhist_peek_replay_stack_count():
+ * int _archive_decode_segment():
  *
- * Return the value of the count field, stored at the top node of
- * the replay.stack of the specified moves-history object (mvhsit),
- * or 0 on error.
+ * Decode the archived game-states of the specified keyframe (ikey) of
+ * the specified moves-history object (mvhist), that is all game-states
+ * from the keyframe up to the next keyframe (exclusive) or up to the
+ * last archived game-state, and push them in increasing count order
+ * onto the specified gsstack (out). Return 0 (false) on error, 1 (true)
+ * otherwise.
  *
- * NOTE: The count of nodes in a gsstack is 1-based.
+ * NOTE: The nextmv fields of the decoded game-states are the archived
+ *       ones, so they are exactly what they were before archiving.
  * --------------------------------------------------------------
  */
-long int mvhist_peek_replay_stack_count( const MovesHistory *mvhist )
+static int _archive_decode_segment(
+	const MovesHistory *mvhist,
+	long int           ikey,
+	GSNode             **out
+	)
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return 0;
+	long int c, end;
+	const struct _key *key = &mvhist->archive.keys[ ikey ];
+	const struct _ply *plies = mvhist->archive.plies;
+	GameState *work = NULL;
+
+	end = (ikey < mvhist->archive.nkeys - 1)
+		? mvhist->archive.keys[ ikey+1 ].count - 1
+		: mvhist->archive.nstates;
+
+	work = new_gamestate( board_get_dim(gamestate_get_board(key->state)) );
+	if ( NULL == work ) {
+		DBGF( "%s", "new_gamestate() failed!" );
+		return 0;  /* false */
 	}
-	return gsstack_peek_count( mvhist->replay.stack );
+	gamestate_copy( work, key->state );
+
+	for (c = key->count; ; c++)
+	{
+		gamestate_set_nextmove( work, mvhist->archive.nextmvs[c-1] );
+		if ( !gsstack_push(out, work) ) {
+			DBGF( "%s", "gsstack_push() failed!" );
+			goto ret_failure;
+		}
+		if ( c == end ) {
+			break;
+		}
+		/* game-state c+1 */
+		if ( !_ply_apply(work, &plies[c]) ) {
+			DBGF( "_ply_apply(%ld) failed!", c+1 );
+			goto ret_failure;
+		}
+	}
+
+	gamestate_free( work );
+	return 1;  /* true */
+
+ret_failure:
+	gamestate_free( work );
+	return 0;  /* false */
 }
 
 /* --------------------------------------------------------------
- * const GameState *mvhist_peek_replay_stack_state():
+ * int _archive_compact():
  *
- * Return a pointer to the game-state object stored at the top
- * node of the replay.stack of the specified moves-history object
- * (mvhist), or NULL on error.
+ * If the resident nodes of the undo gsstack of the specified moves-
+ * -history object (mvhist) exceed its memory budget, move the oldest
+ * ones into the archive, until half the budget is used. Return 0
+ * (false) on error, 1 (true) otherwise (including when nothing had
+ * to be compacted). If a game-state fails to be archived, the ones
+ * older than it stay archived, and 0 (false) is returned.
+ *
+ * NOTES:
+ *
+ *    Every archived game-state is stored as a ply against its
+ *    preceding one, unless it is the 1st game-state of the game,
+ *    or _KEYINTERVAL moves have passed since the last keyframe,
+ *    or it cannot be encoded as a ply (e.g. a winning move). In
+ *    those cases a keyframe is stored instead.
+ *
+ *    The budget is converted to a count of nodes, which is never
+ *    less than _MINRESIDENT, and no less than _MINRESIDENT nodes
+ *    are left resident.
  * --------------------------------------------------------------
  */
-const GameState *mvhist_peek_replay_stack_state( const MovesHistory *mvhist )
+static int _archive_compact( MovesHistory *mvhist )
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return NULL;
+	int      ret = 1;  /* true */
+	long int c, n, live, maxnodes, keep;
+	long int lastkey = 0;
+	const long int nstates = mvhist->archive.nstates;
+	struct _ply     *plies = NULL;
+	unsigned char   *nextmvs = NULL;
+	GSNode          *tail = NULL;     /* decoded last keyframe segment */
+	GSNode          *cut = NULL;      /* compacted undo nodes */
+	GameState       *scratch = NULL;
+	const GameState *prev = NULL;
+	const GameState *next = NULL;
+	const GSNode    *it = NULL;
+
+	if ( 0 == mvhist->archive.budget || NULL == mvhist->undo ) {
+		return 1;  /* true */
 	}
-	return gsstack_peek_state( mvhist->replay.stack );
+	maxnodes = mvhist->archive.budget / gsstack_sizeof_node();
+	if ( maxnodes < _MINRESIDENT ) {
+		maxnodes = _MINRESIDENT;
+	}
+	live = gsstack_peek_count( mvhist->undo ) - nstates;
+	if ( live <= maxnodes ) {
+		return 1;  /* true */
+	}
+	keep = maxnodes / 2;
+	if ( keep < _MINRESIDENT ) {
+		keep = _MINRESIDENT;
+	}
+	n = live - keep;
+
+	plies = realloc( mvhist->archive.plies, (nstates + n) * sizeof(*plies) );
+	if ( NULL == plies ) {
+		DBGF( "%s", "realloc(mvhist->archive.plies) failed!" );
+		return 0;  /* false */
+	}
+	mvhist->archive.plies = plies;
+	nextmvs = realloc( mvhist->archive.nextmvs, nstates + n );
+	if ( NULL == nextmvs ) {
+		DBGF( "%s", "realloc(mvhist->archive.nextmvs) failed!" );
+		return 0;  /* false */
+	}
+	mvhist->archive.nextmvs = nextmvs;
+
+	scratch = new_gamestate( BOARD_DIM_4 );
+	if ( NULL == scratch ) {
+		DBGF( "%s", "new_gamestate() failed!" );
+		return 0;  /* false */
+	}
+
+	/* the last archived game-state precedes the oldest resident one */
+	if ( nstates > 0 ) {
+		if ( !_archive_decode_segment(
+			mvhist,
+			mvhist->archive.nkeys - 1,
+			&tail
+			)
+		){
+			DBGF( "%s", "_archive_decode_segment() failed!" );
+			goto ret_failure;
+		}
+		prev = gsstack_peek_state( tail );
+		lastkey = mvhist->archive.keys[ mvhist->archive.nkeys-1 ].count;
+	}
+
+	it = gsstack_iter_bottom( mvhist->undo );
+	for (c = nstates + 1; c <= nstates + n; c++, it = gsstack_iter_up(it))
+	{
+		next = gsstack_peek_state( it );
+		if ( NULL == prev
+		|| c - lastkey >= _KEYINTERVAL
+		|| gamestate_get_iswin(next) != gamestate_get_iswin(prev)
+		|| !_ply_make( &plies[c-1], prev, next, scratch )
+		){
+			if ( !_archive_add_key(mvhist, c, next) ) {
+				DBGF( "Cannot archive game-state %ld!", c );
+				ret = 0;  /* false */
+				break;
+			}
+			memset( &plies[c-1], 0, sizeof(*plies) );
+			plies[c-1].mvdir = gamestate_get_prevmove( next );
+			lastkey = c;
+		}
+		nextmvs[c-1] = (unsigned char) gamestate_get_nextmove( next );
+		prev = next;
+	}
+
+	/* discard the compacted nodes */
+	mvhist->archive.nstates = c - 1;
+	cut = gsstack_split( &mvhist->undo, mvhist->archive.nstates );
+	gsstack_free( &cut );
+
+	gsstack_free( &tail );
+	gamestate_free( scratch );
+	return ret;
+
+ret_failure:
+	gsstack_free( &tail );
+	gamestate_free( scratch );
+	return 0;  /* false */
 }
 
 /* --------------------------------------------------------------
- * int mvhist_pop_replay_stack():
+ * int _archive_restore():
  *
- * Remove the top node of the replay.stack of the specified
- * moves-history object (mvhist). Return 0 (false) on error,
- * 1 (true) otherwise.
+ * Decode the last keyframe segment of the archive of the specified
+ * moves-history object (mvhist) back into full nodes, put them under
+ * the resident nodes of the undo gsstack, and remove them from the
+ * archive. Return 0 (false) on error, 1 (true) otherwise.
  * --------------------------------------------------------------
  */
-int mvhist_pop_replay_stack( MovesHistory *mvhist )
+static int _archive_restore( MovesHistory *mvhist )
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return 0;  /* false */
+	long int    ikey = mvhist->archive.nkeys - 1;
+	GSNode      *seg = NULL;
+	struct _ply *plies = NULL;
+	unsigned char *nextmvs = NULL;
+	struct _key *keys = NULL;
+
+	if ( !_archive_decode_segment(mvhist, ikey, &seg) ) {
+		DBGF( "%s", "_archive_decode_segment() failed!" );
+		goto ret_failure;
+	}
+	if ( !gsstack_join(&mvhist->undo, &seg) ) {
+		DBGF( "%s", "gsstack_join() failed!" );
+		goto ret_failure;
 	}
 
-	return gsstack_pop( &mvhist->replay.stack );
+	mvhist->archive.nstates = mvhist->archive.keys[ ikey ].count - 1;
+	gamestate_free( mvhist->archive.keys[ ikey ].state );
+	mvhist->archive.nkeys--;
+	if ( 0 == mvhist->archive.nstates ) {
+		_archive_free( mvhist );
+		return 1;  /* true */
+	}
+
+	/* give back the unused tails of the arrays (shrinking cannot fail) */
+	plies = realloc(
+		mvhist->archive.plies,
+		mvhist->archive.nstates * sizeof(*plies)
+		);
+	if ( plies ) {
+		mvhist->archive.plies = plies;
+	}
+	nextmvs = realloc( mvhist->archive.nextmvs, mvhist->archive.nstates );
+	if ( nextmvs ) {
+		mvhist->archive.nextmvs = nextmvs;
+	}
+	keys = realloc(
+		mvhist->archive.keys,
+		mvhist->archive.nkeys * sizeof(*keys)
+		);
+	if ( keys ) {
+		mvhist->archive.keys = keys;
+	}
+	return 1;  /* true */
+
+ret_failure:
+	gsstack_free( &seg );
+	return 0;  /* false */
 }
 
 /* --------------------------------------------------------------
- * (Getter) unsigned long int mvhist_get_replay_delay():
+ * void _jnl_stop():
  *
- * Return the current value of the delay field, inside the replay
- * nested structure of the specified moves-history object (mvhist),
- * or 0 on error.
+ * Close the journal of the specified moves-history object (mvhist)
+ * as is, and stop journaling.
  * --------------------------------------------------------------
  */
-unsigned long int mvhist_get_replay_delay( const MovesHistory *mvhist )
+static void _jnl_stop( MovesHistory *mvhist )
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return 0;
+	if ( mvhist->journal.fp ) {
+		fclose( mvhist->journal.fp );
 	}
-
-	return mvhist->replay.delay;
+	free( mvhist->journal.fname );
+	gamestate_free( mvhist->journal.scratch );
+	memset( &mvhist->journal, 0, sizeof(mvhist->journal) );
 }
 
 /* --------------------------------------------------------------
- * long int mvhist_get_replay_nmoves():
+ * void _jnl_commit():
  *
- * Return the current value of the nmoves field, inside the replay
- * nested structure of the specified moves-history object (mvhist),
- * or -1 on error.
+ * Account a record just written (ok is false if writing it failed)
+ * to the journal of the specified moves-history object (mvhist), and
+ * commit the journal to the disk every _JNL_SYNCEVERY records. After
+ * any error, journaling stops.
  * --------------------------------------------------------------
  */
-long int mvhist_get_replay_nmoves( const MovesHistory *mvhist )
+static void _jnl_commit( MovesHistory *mvhist, int ok )
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return -1;
+	if ( ok ) {
+		mvhist->journal.nrecords++;
+	}
+	if ( ok && ++mvhist->journal.nunsynced >= _JNL_SYNCEVERY ) {
+		ok = f_sync( mvhist->journal.fp );
+		mvhist->journal.nunsynced = 0;
+	}
+	if ( !ok ) {
+		DBGF( "Journaling stopped, cannot write to: %s", mvhist->journal.fname );
+		_jnl_stop( mvhist );
 	}
-
-	return mvhist->replay.nmoves;
 }
 
 /* --------------------------------------------------------------
- * long int mvhist_get_replay_itcount():
+ * int _jnl_put_state():
  *
- * Return the current value of the itcount field, inside the replay
- * nested structure of the specified moves-history object (mvhist),
- * or -1 on error.
+ * Append to the journal of the specified moves-history object (mvhist)
+ * a record for the specified game-state (state) pushed on top of the
+ * game-state (prev), which is NULL if the undo gsstack was empty. When
+ * (putnext) is true, the nextmv of the game-state is recorded too. Return
+ * 0 (false) on error, 1 (true) otherwise.
  *
- * NOTE (IMPORTANT!):
+ * NOTES:
  *
- *     The itcount field makes sense ONLY in replay-mode, when
- *     an iteration has been started on the replay.stack. It
- *     exists due to decoupling of the tui "class" from the
- *     gsstack "class", and thus from the replay.stack.
+ *    If the game-state can be reached from prev by a single move, the
+ *    record is a byte with the direction of the move in bits 0-2, the
+ *    best-score update in bit 3, the count of generated tiles in bits
+ *    4-5, and whether a nextmv byte follows in bit 6. Then follows 1
+ *    byte per generated tile, as in binary files (see _binline_add())
+ *    and finally the nextmv byte, if any.
  *
- *     For example, without it, a tui object wouldn't be able to
- *     display the count of the current move in the replay-mode.
- *     However, this may be a design-flaw to be re-considered. 
+ *    Otherwise, the record is a _JNL_KEY byte, followed by the whole
+ *    game-state as a text line (see gamestate_append_to_fp() in the
+ *    file "gs.c").
+ *
+ *    The nextmv of prev is normally implied by the prevmv of the game-
+ *    state (see _jnl_push()). When it is not, the record starts with a
+ *    _JNL_NEXTMV byte having the nextmv of prev in bits 3-5.
  * --------------------------------------------------------------
  */
-long int mvhist_get_replay_itcount( const MovesHistory *mvhist )
+static int _jnl_put_state(
+	MovesHistory    *mvhist,
+	const GameState *prev,
+	const GameState *state,
+	int             putnext
+	)
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return -1;
+	int k;
+	struct _ply ply;
+	FILE *fp = mvhist->journal.fp;
+	const int nextmv = putnext ? gamestate_get_nextmove(state) : GS_MVDIR_NONE;
+
+	if ( NULL != prev
+	&& gamestate_get_nextmove(prev) != gamestate_get_prevmove(state)
+	&& EOF == fputc( _JNL_NEXTMV | (gamestate_get_nextmove(prev) << 3), fp )
+	){
+		return 0;  /* false */
 	}
 
-	return mvhist->replay.itcount;
+	if ( NULL == prev
+	|| gamestate_get_iswin(prev) != gamestate_get_iswin(state)
+	|| !_ply_make(&ply, prev, state, mvhist->journal.scratch)
+	){
+		goto put_key;
+	}
+	for (k=0; k < ply.nspawns; k++) {
+		if ( ply.pos[k] > 0x3F || (2 != ply.val[k] && 4 != ply.val[k]) ) {
+			goto put_key;
+		}
+	}
+
+	fputc(
+		ply.mvdir
+		| (ply.bsup << 3)
+		| (ply.nspawns << 4)
+		| ((GS_MVDIR_NONE != nextmv) << 6),
+		fp
+		);
+	for (k=0; k < ply.nspawns; k++) {
+		fputc( ply.pos[k] | (4 == ply.val[k] ? 0x40 : 0), fp );
+	}
+	if ( GS_MVDIR_NONE != nextmv ) {
+		fputc( nextmv, fp );
+	}
+	return !ferror( fp );
+
+put_key:
+	return EOF != fputc( _JNL_KEY, fp ) && gamestate_append_to_fp( state, fp );
 }
 
 /* --------------------------------------------------------------
- * const GSNode *mvhist_iter_top_replay_stack():
- *
- * Return an (iterator) pointer to the top node of the replay.stack
- * of the specified moves-history object (mvhist), or NULL on error.
+ * int _jnl_put_header():
  *
- * NOTE: On success, the count of the top-node of the replay.stack
- *       is stored in the replay.itcount field. For details, see
- *       the comments of the function: mvhist_get_replay_itcount().
+ * Write the signature & the version of journals to the specified
+ * file (fp). Return 0 (false) on error, 1 (true) otherwise.
  * --------------------------------------------------------------
  */
-const GSNode *mvhist_iter_top_replay_stack( MovesHistory *mvhist )
+static inline int _jnl_put_header( FILE *fp )
 {
-	const GSNode *it = NULL;
-
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return NULL;
-	}
+	return _SZJNL_MAGIC == fwrite( _JNL_MAGIC, 1, _SZJNL_MAGIC, fp )
+		&& EOF != fputc( _JNL_VERSION, fp );
+}
 
-	it = gsstack_iter_top( mvhist->replay.stack );
-	if ( it ) {
-		mvhist->replay.itcount = gsstack_peek_count( it );
+/* --------------------------------------------------------------
+ * void _didundo_set():
+ *
+ * Set the didundo field of the specified moves-history object
+ * (mvhist) to the specified value (didundo), and journal it.
+ * --------------------------------------------------------------
+ */
+static inline void _didundo_set( MovesHistory *mvhist, int didundo )
+{
+	didundo = (0 != didundo);
+	if ( mvhist->didundo != didundo && mvhist->journal.fp ) {
+		_jnl_commit(
+			mvhist,
+			EOF != fputc( _JNL_DIDUNDO | (didundo << 3), mvhist->journal.fp )
+			);
 	}
-	return it;
+	mvhist->didundo = didundo;
 }
 
 /* --------------------------------------------------------------
- * const GSNode *mvhist_iter_bottom_replay_stack():
+ * int _undo_push():
  *
- * Return an (iterator) pointer to the bottom node of the replay.stack
- * of the specified moves-history object (mvhist), or NULL on error.
- *
- * NOTE: On success, the count of the bottom-node of the replay.stack
- *       is stored in the replay.itcount field. For details, see
- *       the comments of the function: mvhist_get_replay_itcount().
+ * Push the specified game-state (state) onto the undo gsstack of the
+ * specified moves-history object (mvhist), compacting its oldest nodes
+ * if the memory budget gets exceeded. Return 0 (false) on error, 1
+ * (true) otherwise.
  * --------------------------------------------------------------
  */
-const GSNode *mvhist_iter_bottom_replay_stack( MovesHistory *mvhist )
+static inline int _undo_push( MovesHistory *mvhist, const GameState *state )
 {
-	const GSNode *it = NULL;
+	const GameState *prev = gsstack_peek_state( mvhist->undo );
 
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return NULL;
+	if ( !gsstack_push(&mvhist->undo, state) ) {
+		return 0;  /* false */
 	}
-
-	it = gsstack_iter_bottom( mvhist->replay.stack );
-	if ( it ) {
-		mvhist->replay.itcount = gsstack_peek_count( it );
+	if ( mvhist->journal.fp ) {
+		_jnl_commit( mvhist, _jnl_put_state(mvhist, prev, state, 1) );
 	}
-	return it;
+	_mem_track( mvhist );
+	if ( !_archive_compact(mvhist) ) {
+		DBGF( "%s", "_archive_compact() failed!" );
+	}
+	return 1;  /* true */
 }
 
 /* --------------------------------------------------------------
- * const GSNode *mvhist_iter_down_replay_stack():
+ * int _undo_pop():
  *
- * Given an iterator pointer (it) to a node of the replay.stack of
- * the specified moves-history object (mvhist), return an iterator
- * pointer to the node below it, or NULL on error.
- *
- * NOTES: On success, the count of the newly pointed node in
- *        the replay.stack is stored in the replay.itcount field.
- *        For details, see the comments of the function:
- *        mvhist_get_replay_itcount().
+ * Remove the top node of the undo gsstack of the specified moves-
+ * -history object (mvhist), restoring archived nodes when the last
+ * resident one is about to be exposed. Return 0 (false) on error, 1
+ * (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _undo_pop( MovesHistory *mvhist )
+{
+	if ( !gsstack_pop(&mvhist->undo) ) {
+		return 0;  /* false */
+	}
+	if ( mvhist->journal.fp ) {
+		_jnl_commit( mvhist, EOF != fputc(_JNL_POP, mvhist->journal.fp) );
+	}
+	if ( mvhist->archive.nstates > 0
+	&& gsstack_peek_count(mvhist->undo) - mvhist->archive.nstates < 2
+	&& !_archive_restore(mvhist)
+	){
+		DBGF( "%s", "_archive_restore() failed!" );
+	}
+	_mem_track( mvhist );
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * (Constructor) MovesHistory *new_mvhist():
  *
- *        Iterator pointers are plain pointers to GSNode nodes.
+ * The moves-history constructor instantiates a new object in memory,
+ * initializes it with default values, and returns a pointer to it,
+ * or NULL on error.
  * --------------------------------------------------------------
  */
-const GSNode *mvhist_iter_down_replay_stack(
-	MovesHistory *mvhist,
-	const GSNode *it
-	)
+MovesHistory *new_mvhist( void )
 {
+	MovesHistory *mvhist = calloc(1, sizeof(*mvhist) );
 	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		DBGF( "%s", "calloc() failed!" );
 		return NULL;
 	}
 
-	it = gsstack_iter_down( it );
-	if ( it ) {
-		mvhist->replay.itcount = gsstack_peek_count( it );
+	mvhist->replay.delay   = 750;
+	mvhist->replay.iseg    = -1;
+	mvhist->archive.budget = MVHIST_DEF_BUDGET;
+	return mvhist;
+}
+
+/* --------------------------------------------------------------
+ * (Destructor) MovesHistory *mvhist_free():
+ *
+ * The moves-history destructor releases all resources occupied
+ * by the specified object, and returns NULL (so the caller may
+ * assign it back to the object pointer).
+ *
+ * NOTE: An open journal is closed as is (see mvhist_journal_close()
+ *       for finalizing it instead).
+ * --------------------------------------------------------------
+ */
+MovesHistory *mvhist_free( MovesHistory *mvhist )
+{
+	if ( mvhist ) {
+		gsstack_free( &mvhist->undo );
+		gsstack_free( &mvhist->redo );
+		_redotail_free( mvhist );
+		gsstack_free( &mvhist->replay.stack );
+		_branches_free( mvhist->branches, mvhist->nbranches );
+		_archive_free( mvhist );
+		_src_release( mvhist );
+		_jnl_stop( mvhist );
+		free( mvhist );
 	}
-	return it;
+
+	return NULL;
 }
 
 /* --------------------------------------------------------------
- * const GSNode *mvhist_iter_up_replay_stack():
+ * int mvhist_reset():
  *
- * Given an iterator pointer (it) to a node of the replay.stack of
- * the specified moves-history object (mvhist), return an iterator
- * pointer to the node above it, or NULL on error.
+ * Reset the specified moves-history object (mvhist) for a new game.
+ * Return 0 (false) on error, 1 (true) otherwise.
  *
- * NOTES: On success, the count of the newly pointed node in
- *        the replay.stack is stored in the replay.itcount field.
- *        For details, see the comments of the function:
- *        mvhist_get_replay_itcount().
+ * NOTES: Resetting a moves-history object does NOT change its
+ *        replay.delay field, nor its memory budget.
  *
- *        Iterator pointers are plain pointers to GSNode nodes.
+ *        An open journal is truncated, so it starts over with the
+ *        new game.
  * --------------------------------------------------------------
  */
-const GSNode *mvhist_iter_up_replay_stack(
-	MovesHistory *mvhist,
-	const GSNode *it
-	)
+int mvhist_reset( MovesHistory *mvhist )
 {
 	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)" );
-		return NULL;
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0; /* false */
 	}
+	mvhist->didundo = 0; /* false */
+	mvhist->undo = gsstack_free( &mvhist->undo );
+	mvhist->redo = gsstack_free( &mvhist->redo );
+	_redotail_free( mvhist );
+	mvhist->replay.stack = gsstack_free( &mvhist->replay.stack );
+	mvhist->replay.nmoves = 0;
+	mvhist->replay.itcount = 0;
+	mvhist->replay.iseg = -1;
+	mvhist->replay.nnodes = 0;
 
-	it = gsstack_iter_up( it );
-	if ( it ) {
-		mvhist->replay.itcount = gsstack_peek_count( it );
+	_branches_free( mvhist->branches, mvhist->nbranches );
+	mvhist->branches   = NULL;
+	mvhist->nbranches  = 0;
+	mvhist->nbbranches = 0;
+
+	_archive_free( mvhist );
+	_src_release( mvhist );
+
+	if ( mvhist->journal.fp ) {
+		fclose( mvhist->journal.fp );
+		mvhist->journal.fp = fopen( mvhist->journal.fname, "wb" );
+		mvhist->journal.nunsynced = 0;
+		mvhist->journal.nrecords  = 0;
+		if ( NULL == mvhist->journal.fp
+		|| 0 != setvbuf(mvhist->journal.fp, NULL, _IOFBF, _JNL_SZBUF)
+		|| !_jnl_put_header(mvhist->journal.fp)
+		){
+			DBGF( "Journaling stopped, cannot write to: %s", mvhist->journal.fname );
+			_jnl_stop( mvhist );
+		}
 	}
-	return it;
+
+	return 1;
 }
 
 /* --------------------------------------------------------------
- * (Getter) int mvhist_get_didundo():
+ * int mvhist_isempty_undo_stack():
  *
- * Return the current value of the boolean didundo field, inside
- * the replay nested structure of the specified moves-history
- * object (mvhist), or 0 (false) on error.
+ * Return 1 (true) if the undo gsstack of the specified moves-history
+ * object (mvhist) is empty, or on error. Return 0 (false) otherwise. 
  * --------------------------------------------------------------
  */
-int mvhist_get_didundo( const MovesHistory *mvhist )
+int mvhist_isempty_undo_stack( const MovesHistory *mvhist )
 {
 	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		DBGF( "%s", "NULL pointer argument!" );
+		return 1; /* true */
+	}
+
+	return NULL == mvhist->undo;
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_push_undo_stack():
+ *
+ * Push the specified game-state object (state) onto the undo
+ * gsstack of the specified moves-history object (mvhist).
+ * Return 0 (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+int mvhist_push_undo_stack( MovesHistory *mvhist, const GameState *state )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return 0;  /* false */
+	}
+
+	return _undo_push( mvhist, state );
+}
+
+/* --------------------------------------------------------------
+ * long int mvhist_peek_undo_stack_count():
+ *
+ * Return the value of the count field, stored at the top node of
+ * the undo gsstack of the specified moves-history object (mvhsit),
+ * or 0 on error.
+ *
+ * NOTE: The count of nodes in a gsstack is 1-based.
+ * --------------------------------------------------------------
+ */
+long int mvhist_peek_undo_stack_count( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
 		return 0;
 	}
-	return mvhist->didundo;
+
+	return gsstack_peek_count( mvhist->undo );
 }
 
 /* --------------------------------------------------------------
- * (Setter) int mvhist_set_didundo():
+ * const GameState *mvhist_peek_undo_stack_state():
  *
- * Set the boolean value of the didundo field inside the
- * replay nested structure of the specified moves-history
- * object (mvhist), to the value specified by the 2nd
- * argument (didundo). Return 0 (false) on error, 1 (true)
- * otherwise.
+ * Return a pointer to the game-state object stored at the top
+ * node of the undo gsstack of the specified moves-history object
+ * (mvhist), or NULL on error.
  * --------------------------------------------------------------
  */
-int mvhist_set_didundo( MovesHistory *mvhist, int didundo )
+const GameState *mvhist_peek_undo_stack_state( const MovesHistory *mvhist )
 {
 	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return NULL;
+	}
+	return gsstack_peek_state( mvhist->undo );
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_pop_undo_stack():
+ *
+ * Remove the top node of the undo gsstack of the specified
+ * moves-history object (mvhist). Return 0 (false) on error,
+ * 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+int mvhist_pop_undo_stack( MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
 		return 0;  /* false */
 	}
+	return _undo_pop( mvhist );
+}
 
-	mvhist->didundo = didundo;
+/* --------------------------------------------------------------
+ * int _redo_pop():
+ *
+ * Remove the top node of the redo gsstack of the specified moves-
+ * -history object (mvhist). If it is the last node and the redo tail
+ * is not exhausted, the next move of the tail is decoded from it into
+ * the new (single) node of the redo gsstack. Return 0 (false) on error,
+ * 1 (true) otherwise.
+ *
+ * NOTE: If the next move of the tail cannot be decoded, the rest of
+ *       the tail is dropped (the node still gets removed).
+ * --------------------------------------------------------------
+ */
+static int _redo_pop( MovesHistory *mvhist )
+{
+	GameState       *work = NULL;
+	const GameState *last = NULL;
+
+	if ( 1 != gsstack_peek_count(mvhist->redo) || _redotail_count(mvhist) < 1 ) {
+		return gsstack_pop( &mvhist->redo );
+	}
+
+	last = gsstack_peek_state( mvhist->redo );
+	if ( NULL == last ) {
+		goto ret_drop;
+	}
+	work = new_gamestate( board_get_dim(gamestate_get_board(last)) );
+	if ( NULL == work ) {
+		DBGF( "%s", "new_gamestate() failed!" );
+		goto ret_drop;
+	}
+	gamestate_copy( work, last );
+	if ( !_plies_apply_nth(
+		work,
+		mvhist->redotail.plies,
+		mvhist->redotail.next,
+		mvhist->redotail.nplies
+		)
+	){
+		DBGF( "_plies_apply_nth(%ld) failed!", mvhist->redotail.next );
+		goto ret_drop;
+	}
+
+	gsstack_pop( &mvhist->redo );
+	if ( !gsstack_push(&mvhist->redo, work) ) {
+		DBGF( "%s", "gsstack_push() failed!" );
+		goto ret_drop;
+	}
+	work = gamestate_free( work );
+	if ( ++mvhist->redotail.next == mvhist->redotail.nplies ) {
+		_redotail_free( mvhist );
+	}
+
+	return 1;  /* true */
+
+ret_drop:
+	DBGF( "%s", "The rest of the redo tail is dropped!" );
+	gamestate_free( work );
+	_redotail_free( mvhist );
+	gsstack_pop( &mvhist->redo );
 	return 1;  /* true */
 }
 
 /* --------------------------------------------------------------
- * int _replay_append_to_fp():
+ * int _line_seek():
  *
- * Serialize the replay nested structure of the specified moves-history
- * object (mvhist) and append it to the specified file (fp). Return 0
- * (false) on error, 1 (true) otherwise.
+ * Walk the current line of the specified moves-history object (mvhist),
+ * by moving nodes between its undo & redo gsstacks, until the count of
+ * the undo gsstack gets equal to the specified one (count). Return 0
+ * (false) on error or if the line is not that long, 1 (true) otherwise.
  *
- * NOTES:
+ * NOTE: It takes time proportional to the depth-difference between
+ *       the current node and the requested one.
+ * --------------------------------------------------------------
+ */
+static int _line_seek( MovesHistory *mvhist, long int count )
+{
+	while ( gsstack_peek_count(mvhist->undo) > count ) {
+		if ( !gsstack_push(&mvhist->redo, gsstack_peek_state(mvhist->undo))
+		|| !_undo_pop(mvhist)
+		){
+			return 0;  /* false */
+		}
+	}
+	while ( gsstack_peek_count(mvhist->undo) < count && mvhist->redo ) {
+		if ( !_undo_push(mvhist, gsstack_peek_state(mvhist->redo))
+		|| !_redo_pop(mvhist)
+		){
+			return 0;  /* false */
+		}
+	}
+
+	return gsstack_peek_count( mvhist->undo ) == count;
+}
+
+/* --------------------------------------------------------------
+ * int _redo_to_branch():
  *
- *    The serialization first produces a text line of the form:
+ * Encode the redo gsstack along with the redo tail of the specified
+ * moves-history object (mvhist) into the specified branch (br), as
+ * forking off the top node of the undo gsstack. The kids array of
+ * the branch gets room for the branches forking off the encoded
+ * moves, but it is left empty (see _redo_commit_branch()). Return
+ * 0 (false) on error, 1 (true) otherwise.
  *
- *    "replay.delay replay.nmoves replay.itcount\r\n"
+ * NOTE: The moves-history object is NOT modified, and on error
+ *       nothing is allocated for the branch.
+ * --------------------------------------------------------------
+ */
+static int _redo_to_branch( const MovesHistory *mvhist, struct _branch *br )
+{
+	long int        i = 0;
+	int             k, nkids = 0;
+	GameState       *scratch = NULL;
+	const GameState *prev = NULL;
+	const GSNode    *it = NULL;
+	const long int  nnodes = gsstack_peek_count( mvhist->redo );
+
+	memset( br, 0, sizeof(*br) );
+
+	prev = gsstack_peek_state( mvhist->undo );
+	if ( NULL == prev ) {
+		DBGF( "%s", "Cannot fork off an empty undo stack!" );
+		return 0;  /* false */
+	}
+	br->fork   = gsstack_peek_count( mvhist->undo );
+	br->nplies = nnodes + _redotail_count( mvhist );
+	br->plies  = calloc( br->nplies, sizeof(*br->plies) );
+	if ( NULL == br->plies ) {
+		DBGF( "%s", "calloc(br->plies) failed!" );
+		goto ret_failure;
+	}
+
+	/* encode the redo stack (top to bottom) as deltas */
+	scratch = new_gamestate( board_get_dim(gamestate_get_board(prev)) );
+	if ( NULL == scratch ) {
+		DBGF( "%s", "new_gamestate() failed!" );
+		goto ret_failure;
+	}
+	it = gsstack_iter_top( mvhist->redo );
+	for (i=0; it; i++, it = gsstack_iter_down(it) )
+	{
+		if ( !_ply_make(
+			&br->plies[i],
+			prev,
+			gsstack_peek_state(it),
+			scratch
+			)
+		){
+			DBGF( "Redo node %ld cannot be encoded as a delta!", i+1 );
+			goto ret_failure;
+		}
+		prev = gsstack_peek_state( it );
+	}
+	scratch = gamestate_free( scratch );
+
+	/* the moves of the redo tail are deltas already */
+	if ( _redotail_count(mvhist) > 0 ) {
+		memcpy(
+			&br->plies[ nnodes ],
+			&mvhist->redotail.plies[ mvhist->redotail.next ],
+			_redotail_count(mvhist) * sizeof(*br->plies)
+			);
+	}
+
+	/* branches forking off the encoded moves, will become its kids */
+	for (k=0; k < mvhist->nbranches; k++) {
+		if ( mvhist->branches[k].fork > br->fork ) {
+			nkids++;
+		}
+	}
+	if ( nkids > 0 ) {
+		br->kids = calloc( nkids, sizeof(*br->kids) );
+		if ( NULL == br->kids ) {
+			DBGF( "%s", "calloc(br->kids) failed!" );
+			goto ret_failure;
+		}
+	}
+
+	return 1;  /* true */
+
+ret_failure:
+	gamestate_free( scratch );
+	free( br->plies );
+	memset( br, 0, sizeof(*br) );
+	return 0;  /* false */
+}
+
+/* --------------------------------------------------------------
+ * int _branches_reserve():
  *
- *    Then it produces a series of text-lines, each one corresponding
- *    to a serialized node of the replay.stack. Each of those lines
- *    has the following form:
+ * Make room for the specified count (n) of branches in the array
+ * of branches of the specified moves-history object (mvhist). Return
+ * 0 (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _branches_reserve( MovesHistory *mvhist, int n )
+{
+	struct _branch *try = realloc(
+		mvhist->branches,
+		n * sizeof(*try)
+		);
+	if ( NULL == try ) {
+		DBGF( "%s", "realloc(mvhist->branches) failed!" );
+		return 0;  /* false */
+	}
+	mvhist->branches = try;
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * void _redo_commit_branch():
  *
- *    "game-state-meta-data@board-meta-data#board-tile-values\r\n"
+ * Append the specified branch (br), as prepared by _redo_to_branch(),
+ * to the branches of the specified moves-history object (mvhist), and
+ * then empty its redo gsstack & redo tail. The branches forking off
+ * the moves of the branch become its kids.
  *
- *    For details about the serialized game-state-meta-data,
- *    board-meta-data and board-tile-values, see the function:
+ * NOTE: The caller must have reserved room for the branch (see
+ *       _branches_reserve()), so this function cannot fail.
+ * --------------------------------------------------------------
+ */
+static void _redo_commit_branch( MovesHistory *mvhist, struct _branch *br )
+{
+	int k, n;
+
+	for (n=0, k=0; k < mvhist->nbranches; k++) {
+		if ( mvhist->branches[k].fork > br->fork ) {
+			br->kids[ br->nkids++ ] = mvhist->branches[k];
+		}
+		else {
+			mvhist->branches[n++] = mvhist->branches[k];
+		}
+	}
+	mvhist->branches[n] = *br;
+	mvhist->nbranches = n + 1;
+	mvhist->nbbranches += sizeof(*br) + br->nplies * sizeof(*br->plies);
+
+	mvhist->redo = gsstack_free( &mvhist->redo );
+	_redotail_free( mvhist );
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_isempty_redo_stack():
+ *
+ * Return 1 (true) if the redo gsstack of the specified moves-history
+ * object (mvhist) is empty, or on error. Return 0 (false) otherwise. 
+ * --------------------------------------------------------------
+ */
+int mvhist_isempty_redo_stack( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 1; /* true */
+	}
+
+	return NULL == mvhist->redo;
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_free_redo_stack():
+ *
+ * Destroy all nodes of the redo gsstack of the specified moves-history
+ * object (mvhist), along with its redo tail. Return 0 (false) on error,
+ * 1 (true) otherwise.
+ *
+ * NOTE: Any branches forking off the destroyed nodes are destroyed
+ *       too. See mvhist_fork_redo_stack() for keeping them instead.
+ * --------------------------------------------------------------
+ */
+int mvhist_free_redo_stack( MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+
+	mvhist->redo = gsstack_free( &mvhist->redo );
+	_redotail_free( mvhist );
+	_branches_prune_above( mvhist, gsstack_peek_count(mvhist->undo) );
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_fork_redo_stack():
+ *
+ * Archive the redo gsstack of the specified moves-history object
+ * (mvhist) as a new branch, forking off the top node of the undo
+ * gsstack, and then empty the redo gsstack. Return 0 (false) on
+ * error, 1 (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    The branches forking off the archived nodes become sub-branches
+ *    of the new branch, which is appended to the branches of mvhist.
+ *
+ *    If the redo gsstack cannot be archived (e.g. a game-state in
+ *    it is not reachable from its preceding one) the function falls
+ *    back to mvhist_free_redo_stack() and returns 0 (false).
+ * --------------------------------------------------------------
+ */
+int mvhist_fork_redo_stack( MovesHistory *mvhist )
+{
+	struct _branch br = {0};
+
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+	if ( NULL == mvhist->redo ) {
+		return 1;  /* true */
+	}
+
+	if ( !_redo_to_branch(mvhist, &br) ) {
+		DBGF( "%s", "_redo_to_branch() failed!" );
+		goto ret_failure;
+	}
+	if ( !_branches_reserve(mvhist, mvhist->nbranches + 1) ) {
+		DBGF( "%s", "_branches_reserve() failed!" );
+		goto ret_failure;
+	}
+	_redo_commit_branch( mvhist, &br );
+	_mem_track( mvhist );
+
+	return 1;  /* true */
+
+ret_failure:
+	free( br.plies );
+	free( br.kids );
+	mvhist_free_redo_stack( mvhist );
+	return 0;  /* false */
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_push_redo_stack():
+ *
+ * Push the specified game-state object (state) onto the redo
+ * gsstack of the specified moves-history object (mvhist).
+ * Return 0 (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+int mvhist_push_redo_stack( MovesHistory *mvhist, const GameState *state )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return 0;  /* false */
+	}
+	if ( !gsstack_push(&mvhist->redo, state) ) {
+		return 0;  /* false */
+	}
+	_mem_track( mvhist );
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * long int mvhist_peek_redo_stack_count():
+ *
+ * Return the value of the count field, stored at the top node of
+ * the redo gsstack of the specified moves-history object (mvhsit),
+ * plus the count of the moves of its redo tail, or 0 on error.
+ *
+ * NOTE: The count of nodes in a gsstack is 1-based.
+ * --------------------------------------------------------------
+ */
+long int mvhist_peek_redo_stack_count( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return 0;
+	}
+	return gsstack_peek_count( mvhist->redo ) + _redotail_count( mvhist );
+}
+
+/* --------------------------------------------------------------
+ * const GameState *mvhist_peek_redo_stack_state():
+ *
+ * Return a pointer to the game-state object stored at the top
+ * node of the redo gsstack of the specified moves-history object
+ * (mvhist), or NULL on error.
+ * --------------------------------------------------------------
+ */
+const GameState *mvhist_peek_redo_stack_state( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return NULL;
+	}
+	return gsstack_peek_state( mvhist->redo );
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_pop_redo_stack():
+ *
+ * Remove the top node of the redo gsstack of the specified
+ * moves-history object (mvhist), decoding the next move of its
+ * redo tail (if any) when the last node gets removed. Return 0
+ * (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+int mvhist_pop_redo_stack( MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return 0;  /* false */
+	}
+	return _redo_pop( mvhist );
+}
+
+/* --------------------------------------------------------------
+ * long int _replay_nsegs():
+ *
+ * Return the count of the segments that the replay of the current line
+ * of the specified moves-history object (mvhist) is split into: one per
+ * keyframe of the archive, followed by the resident undo nodes in runs
+ * of _KEYINTERVAL game-states (see _replay_decode_segment()).
+ * --------------------------------------------------------------
+ */
+static inline long int _replay_nsegs( const MovesHistory *mvhist )
+{
+	const long int nresident
+		= gsstack_peek_count( mvhist->undo ) - mvhist->archive.nstates;
+
+	return mvhist->archive.nkeys
+		+ (nresident + _KEYINTERVAL - 1) / _KEYINTERVAL;
+}
+
+/* --------------------------------------------------------------
+ * int _replay_decode_segment():
+ *
+ * Create in the specified gsstack (out) the specified segment (iseg)
+ * of the replay of the current line of the specified moves-history
+ * object (mvhist), that is its game-states in decreasing count order,
+ * with the count of each node being that of the same game-state in
+ * a replay.stack of the whole line. Return 0 (false) on error, 1 (true)
+ * otherwise.
+ *
+ * NOTES:
+ *
+ *    Archived segments get decoded from their keyframes, while
+ *    resident ones are just copied from the undo gsstack. Either
+ *    way, the time taken is proportional to the length of the
+ *    segment (plus the depth of a resident one in the undo gsstack).
+ *
+ *    (*out) MUST be NULL when the function is called.
+ * --------------------------------------------------------------
+ */
+static int _replay_decode_segment(
+	const MovesHistory *mvhist,
+	long int           iseg,
+	GSNode             **out
+	)
+{
+	long int       first, last;  /* undo counts of the segment */
+	GameState      *work = NULL; /* for decoding lazy undo nodes */
+	const GSNode   *it = NULL;
+	const long int nundo = gsstack_peek_count( mvhist->undo );
+
+	if ( iseg < mvhist->archive.nkeys ) {
+		if ( !_archive_decode_segment(mvhist, iseg, out)
+		|| !gsstack_reverse( out )
+		){
+			DBGF( "_archive_decode_segment(%ld) failed!", iseg );
+			goto ret_failure;
+		}
+		last = gsstack_peek_count( *out )
+			+ mvhist->archive.keys[ iseg ].count - 1;
+	}
+	else {
+		first = mvhist->archive.nstates + 1
+			+ (iseg - mvhist->archive.nkeys) * _KEYINTERVAL;
+		last  = first + _KEYINTERVAL - 1;
+		if ( last > nundo ) {
+			last = nundo;
+		}
+		if ( NULL == (work = new_gamestate(BOARD_DIM_4)) ) {
+			DBGF( "%s", "new_gamestate() failed!" );
+			goto ret_failure;
+		}
+		it = gsstack_iter_top( mvhist->undo );
+		while ( it && gsstack_peek_count(it) > last ) {
+			it = gsstack_iter_down( it );
+		}
+		for (; it && gsstack_peek_count(it) >= first; it = gsstack_iter_down(it))
+		{
+			if ( !gsstack_push(out, gsstack_peek_state_into(it, work)) ) {
+				DBGF( "%s", "gsstack_push() failed!" );
+				goto ret_failure;
+			}
+		}
+		work = gamestate_free( work );
+	}
+
+	if ( !gsstack_renumber(*out, nundo - last + 1) ) {
+		goto ret_failure;
+	}
+	return 1;  /* true */
+
+ret_failure:
+	gamestate_free( work );
+	gsstack_free( out );
+	return 0;  /* false */
+}
+
+/* --------------------------------------------------------------
+ * int _replay_seek():
+ *
+ * Make the specified segment (iseg) of the replay of the current line
+ * of the specified moves-history object (mvhist) its replay.stack,
+ * unless it is already. Return 0 (false) on error, leaving replay.stack
+ * intact, 1 (true) otherwise.
+ *
+ * NOTE: Since the replay.stack gets replaced, any iterators pointing
+ *       to its nodes become invalid.
+ * --------------------------------------------------------------
+ */
+static int _replay_seek( MovesHistory *mvhist, long int iseg )
+{
+	GSNode *seg = NULL;
+
+	if ( iseg == mvhist->replay.iseg && mvhist->replay.stack ) {
+		return 1;  /* true */
+	}
+	if ( iseg < 0 || iseg >= _replay_nsegs(mvhist)
+	|| !_replay_decode_segment(mvhist, iseg, &seg)
+	){
+		DBGF( "Cannot decode replay segment %ld!", iseg );
+		return 0;  /* false */
+	}
+
+	gsstack_free( &mvhist->replay.stack );
+	mvhist->replay.stack  = seg;
+	mvhist->replay.iseg   = iseg;
+	mvhist->replay.nnodes = gsstack_peek_count( seg )
+		- gsstack_peek_count( gsstack_iter_bottom(seg) ) + 1;
+	_mem_track( mvhist );
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _replay_rebuild():
+ *
+ * Create the replay.stack of the specified moves-history object
+ * (mvhist) as a window over the reversed current line, holding its
+ * 1st segment (see _replay_seek()), and set replay.nmoves accordingly.
+ * Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTE: The replay.stack MUST be NULL when the function is called.
+ * --------------------------------------------------------------
+ */
+static int _replay_rebuild( MovesHistory *mvhist )
+{
+	if ( NULL == mvhist->undo ) {
+		DBGF( "%s", "Cannot replay an empty undo stack!" );
+		return 0;  /* false */
+	}
+	mvhist->replay.iseg = -1;
+	if ( !_replay_seek(mvhist, 0) ) {
+		DBGF( "%s", "_replay_seek(0) failed!" );
+		return 0;  /* false */
+	}
+	mvhist->replay.nmoves = gsstack_peek_count( mvhist->undo );
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * GSNode *mvhist_init_replay():
+ *
+ * Prepare the replay nested structure of the specified moves-history
+ * object (mvhist) for first use. Return a pointer to the newly created
+ * replay.stack, or NULL on error.
+ *
+ * NOTES (IMPORTANT!):
+ *
+ *     Preparation involves creating a new replay.stack as a window
+ *     over the reversed undo gsstack. The undo gsstack CANNOT be
+ *     empty, because it always contains at least the 1st move of the
+ *     game (since it is performed automatically). The window holds
+ *     one segment of the line at a time (see _replay_seek()), and the
+ *     iterator functions below slide it as they reach its ends. So
+ *     the whole game gets replayed (archived moves included), while
+ *     only a segment of it is decoded at any time.
+ *
+ *     On the other hand, if the replay.stack in NOT already NULL,
+ *     the function returns an error. This is an extra precaution
+ *     for reducing chances of MEMORY-LEAKS, and for enforcing the
+ *     GOOD PRACTICE of setting all pointers to NULL before using
+ *     them.
+ *
+ *     In this "class", the replay.stack is ALWAYS either initialized
+ *     to NULL via calloc() in new_mvhist(), or it is explicitly set
+ *     to NULL every time it gets freed, via mvhist_cleanup_replay().
+ *        
+ *     On success, replay.nmoves is set equal to the count of moves of
+ *     the whole replay, replay.delay is set equal to the
+ *     2nd argument of the function (NO SANITY CHECK, should be fixed?)
+ *     and replay.itcount is set to 0.
+ * --------------------------------------------------------------
+ */
+GSNode *mvhist_init_replay( MovesHistory *mvhist, unsigned int delay )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return NULL;
+	}
+	if ( NULL != mvhist->replay.stack ) {
+		DBGF( "%s", "replay.stack is non-NULL. Cannot create replay!" );
+		return NULL;
+	}
+
+	if ( !_replay_rebuild(mvhist) ) {
+		return NULL;
+	}
+	_mem_track( mvhist );
+
+	mvhist->replay.itcount = 0;
+	mvhist->replay.delay   = delay;
+
+	return mvhist->replay.stack;
+}
+
+/* --------------------------------------------------------------
+ int mvhist_cleanup_replay():
+ *
+ * Cleanup the replay nested structure of the specified moves-history
+ * object (mvhist). Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTE: Cleanup involves, among other things, freeing up the
+ *       replay.stack and setting its pointer equal to NULL.
+ * --------------------------------------------------------------
+ */
+int mvhist_cleanup_replay( MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "calloc() failed!" );
+		return 0;  /* false */
+	}
+
+	mvhist->replay.stack   = gsstack_free( &mvhist->replay.stack );
+	mvhist->replay.nmoves  = 0;
+	mvhist->replay.itcount = 0;
+	mvhist->replay.delay   = 750;
+	mvhist->replay.iseg    = -1;
+	mvhist->replay.nnodes  = 0;
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * long int mvhist_peek_replay_stack_count():
+ *
+ * Return the value of the count field, stored at the top node of
+ * the replay.stack of the specified moves-history object (mvhsit),
+ * or 0 on error.
+ *
+ * NOTE: The count of nodes in a gsstack is 1-based.
+ * --------------------------------------------------------------
+ */
+long int mvhist_peek_replay_stack_count( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return 0;
+	}
+	return gsstack_peek_count( mvhist->replay.stack );
+}
+
+/* --------------------------------------------------------------
+ * const GameState *mvhist_peek_replay_stack_state():
+ *
+ * Return a pointer to the game-state object stored at the top
+ * node of the replay.stack of the specified moves-history object
+ * (mvhist), or NULL on error.
+ * --------------------------------------------------------------
+ */
+const GameState *mvhist_peek_replay_stack_state( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return NULL;
+	}
+	return gsstack_peek_state( mvhist->replay.stack );
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_pop_replay_stack():
+ *
+ * Remove the top node of the replay.stack of the specified
+ * moves-history object (mvhist). Return 0 (false) on error,
+ * 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+int mvhist_pop_replay_stack( MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return 0;  /* false */
+	}
+
+	return gsstack_pop( &mvhist->replay.stack );
+}
+
+/* --------------------------------------------------------------
+ * (Getter) unsigned long int mvhist_get_replay_delay():
+ *
+ * Return the current value of the delay field, inside the replay
+ * nested structure of the specified moves-history object (mvhist),
+ * or 0 on error.
+ * --------------------------------------------------------------
+ */
+unsigned long int mvhist_get_replay_delay( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return 0;
+	}
+
+	return mvhist->replay.delay;
+}
+
+/* --------------------------------------------------------------
+ * long int mvhist_get_replay_nmoves():
+ *
+ * Return the current value of the nmoves field, inside the replay
+ * nested structure of the specified moves-history object (mvhist),
+ * or -1 on error.
+ * --------------------------------------------------------------
+ */
+long int mvhist_get_replay_nmoves( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return -1;
+	}
+
+	return mvhist->replay.nmoves;
+}
+
+/* --------------------------------------------------------------
+ * long int mvhist_get_replay_itcount():
+ *
+ * Return the current value of the itcount field, inside the replay
+ * nested structure of the specified moves-history object (mvhist),
+ * or -1 on error.
+ *
+ * NOTE (IMPORTANT!):
+ *
+ *     The itcount field makes sense ONLY in replay-mode, when
+ *     an iteration has been started on the replay.stack. It
+ *     exists due to decoupling of the tui "class" from the
+ *     gsstack "class", and thus from the replay.stack.
+ *
+ *     For example, without it, a tui object wouldn't be able to
+ *     display the count of the current move in the replay-mode.
+ *     However, this may be a design-flaw to be re-considered. 
+ * --------------------------------------------------------------
+ */
+long int mvhist_get_replay_itcount( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return -1;
+	}
+
+	return mvhist->replay.itcount;
+}
+
+/* --------------------------------------------------------------
+ * const GSNode *mvhist_iter_top_replay_stack():
+ *
+ * Return an (iterator) pointer to the top node of the replay.stack
+ * of the specified moves-history object (mvhist), or NULL on error.
+ *
+ * NOTE: On success, the count of the top-node of the replay.stack
+ *       is stored in the replay.itcount field. For details, see
+ *       the comments of the function: mvhist_get_replay_itcount().
+ * --------------------------------------------------------------
+ */
+const GSNode *mvhist_iter_top_replay_stack( MovesHistory *mvhist )
+{
+	const GSNode *it = NULL;
+
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return NULL;
+	}
+
+	if ( mvhist->replay.iseg > -1 && !_replay_seek(mvhist, 0) ) {
+		return NULL;
+	}
+	it = gsstack_iter_top( mvhist->replay.stack );
+	if ( it ) {
+		mvhist->replay.itcount = gsstack_peek_count( it );
+	}
+	return it;
+}
+
+/* --------------------------------------------------------------
+ * const GSNode *mvhist_iter_bottom_replay_stack():
+ *
+ * Return an (iterator) pointer to the bottom node of the replay.stack
+ * of the specified moves-history object (mvhist), or NULL on error.
+ *
+ * NOTE: On success, the count of the bottom-node of the replay.stack
+ *       is stored in the replay.itcount field. For details, see
+ *       the comments of the function: mvhist_get_replay_itcount().
+ * --------------------------------------------------------------
+ */
+const GSNode *mvhist_iter_bottom_replay_stack( MovesHistory *mvhist )
+{
+	const GSNode *it = NULL;
+
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return NULL;
+	}
+
+	if ( mvhist->replay.iseg > -1
+	&& !_replay_seek(mvhist, _replay_nsegs(mvhist) - 1)
+	){
+		return NULL;
+	}
+	it = gsstack_iter_bottom( mvhist->replay.stack );
+	if ( it ) {
+		mvhist->replay.itcount = gsstack_peek_count( it );
+	}
+	return it;
+}
+
+/* --------------------------------------------------------------
+ * const GSNode *mvhist_iter_down_replay_stack():
+ *
+ * Given an iterator pointer (it) to a node of the replay.stack of
+ * the specified moves-history object (mvhist), return an iterator
+ * pointer to the node below it, or NULL on error.
+ *
+ * NOTES: On success, the count of the newly pointed node in
+ *        the replay.stack is stored in the replay.itcount field.
+ *        For details, see the comments of the function:
+ *        mvhist_get_replay_itcount().
+ *
+ *        Iterator pointers are plain pointers to GSNode nodes.
+ *        When (it) is at an end of the window of the replay.stack
+ *        (see mvhist_init_replay()) the window slides, so any other
+ *        iterators pointing into it become invalid.
+ * --------------------------------------------------------------
+ */
+const GSNode *mvhist_iter_down_replay_stack(
+	MovesHistory *mvhist,
+	const GSNode *it
+	)
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return NULL;
+	}
+
+	/* past the bottom of the window, slide it to the next segment */
+	if ( it && NULL == gsstack_iter_down(it)
+	&& mvhist->replay.iseg > -1 && gsstack_peek_count(it) > 1
+	){
+		it = _replay_seek( mvhist, mvhist->replay.iseg + 1 )
+			? gsstack_iter_top( mvhist->replay.stack )
+			: NULL;
+	}
+	else {
+		it = gsstack_iter_down( it );
+	}
+	if ( it ) {
+		mvhist->replay.itcount = gsstack_peek_count( it );
+	}
+	return it;
+}
+
+/* --------------------------------------------------------------
+ * const GSNode *mvhist_iter_up_replay_stack():
+ *
+ * Given an iterator pointer (it) to a node of the replay.stack of
+ * the specified moves-history object (mvhist), return an iterator
+ * pointer to the node above it, or NULL on error.
+ *
+ * NOTES: On success, the count of the newly pointed node in
+ *        the replay.stack is stored in the replay.itcount field.
+ *        For details, see the comments of the function:
+ *        mvhist_get_replay_itcount().
+ *
+ *        Iterator pointers are plain pointers to GSNode nodes.
+ *        When (it) is at an end of the window of the replay.stack
+ *        (see mvhist_init_replay()) the window slides, so any other
+ *        iterators pointing into it become invalid.
+ * --------------------------------------------------------------
+ */
+const GSNode *mvhist_iter_up_replay_stack(
+	MovesHistory *mvhist,
+	const GSNode *it
+	)
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return NULL;
+	}
+
+	/* past the top of the window, slide it to the previous segment */
+	if ( it && NULL == gsstack_iter_up(it)
+	&& mvhist->replay.iseg > 0
+	&& gsstack_peek_count(it) < mvhist->replay.nmoves
+	){
+		it = _replay_seek( mvhist, mvhist->replay.iseg - 1 )
+			? gsstack_iter_bottom( mvhist->replay.stack )
+			: NULL;
+	}
+	else {
+		it = gsstack_iter_up( it );
+	}
+	if ( it ) {
+		mvhist->replay.itcount = gsstack_peek_count( it );
+	}
+	return it;
+}
+
+/* --------------------------------------------------------------
+ * (Getter) int mvhist_get_didundo():
+ *
+ * Return the current value of the boolean didundo field, inside
+ * the replay nested structure of the specified moves-history
+ * object (mvhist), or 0 (false) on error.
+ * --------------------------------------------------------------
+ */
+int mvhist_get_didundo( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;
+	}
+	return mvhist->didundo;
+}
+
+/* --------------------------------------------------------------
+ * (Setter) int mvhist_set_didundo():
+ *
+ * Set the boolean value of the didundo field inside the
+ * replay nested structure of the specified moves-history
+ * object (mvhist), to the value specified by the 2nd
+ * argument (didundo). Return 0 (false) on error, 1 (true)
+ * otherwise.
+ * --------------------------------------------------------------
+ */
+int mvhist_set_didundo( MovesHistory *mvhist, int didundo )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;  /* false */
+	}
+
+	_didundo_set( mvhist, didundo );
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * (Getter) size_t mvhist_get_budget():
+ *
+ * Return the memory budget (in bytes) of the resident nodes of
+ * the undo gsstack of the specified moves-history object (mvhist),
+ * or 0 on error. A budget of 0 means no limit.
+ * --------------------------------------------------------------
+ */
+size_t mvhist_get_budget( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;
+	}
+
+	return mvhist->archive.budget;
+}
+
+/* --------------------------------------------------------------
+ * (Setter) int mvhist_set_budget():
+ *
+ * Set the memory budget (in bytes) of the resident nodes of the undo
+ * gsstack of the specified moves-history object (mvhist) and compact
+ * the gsstack if needed. A budget of 0 means no limit. Return 0 (false)
+ * on error, 1 (true) otherwise.
+ *
+ * NOTES: Budgets smaller than _MINRESIDENT nodes are treated as if
+ *        they were that large (see gsstack_sizeof_node() in the file
+ *        "gs.c" for the size of a node).
+ *
+ *        Raising the budget does NOT restore already archived moves.
+ * --------------------------------------------------------------
+ */
+int mvhist_set_budget( MovesHistory *mvhist, size_t nbytes )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;  /* false */
+	}
+
+	mvhist->archive.budget = nbytes;
+	return _archive_compact( mvhist );
+}
+
+/* --------------------------------------------------------------
+ * (Getter) long int mvhist_get_narchived():
+ *
+ * Return the count of the oldest moves of the undo gsstack of the
+ * specified moves-history object (mvhist) which are currently kept
+ * compacted in its archive (instead of resident nodes), or 0 on error.
+ * --------------------------------------------------------------
+ */
+long int mvhist_get_narchived( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;
+	}
+
+	return mvhist->archive.nstates;
+}
+
+/* --------------------------------------------------------------
+ * (Getter) size_t mvhist_get_nbytes():
+ *
+ * Return the count of bytes currently occupied by the specified
+ * category (which) of the specified moves-history object (mvhist),
+ * or 0 on error. The categories are the MVHIST_MEM_XXX constants
+ * defined in "mvhist.h".
+ *
+ * NOTE: The bytes of game-states include their boards (and thus
+ *       their grids). Archived moves are counted at their actual
+ *       (compacted) size.
+ * --------------------------------------------------------------
+ */
+size_t mvhist_get_nbytes( const MovesHistory *mvhist, int which )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;
+	}
+	if ( which < 0 || which > MVHIST_MEM_TOTAL ) {
+		DBGF( "Invalid memory category (%d)!", which );
+		return 0;
+	}
+
+	return _mem_nbytes( mvhist, which );
+}
+
+/* --------------------------------------------------------------
+ * (Getter) size_t mvhist_get_nbpeak():
+ *
+ * Return the high-water mark of the count of bytes occupied by the
+ * specified category (which) of the specified moves-history object
+ * (mvhist), or 0 on error.
+ *
+ * NOTE: The high-water marks refer to the whole lifetime of mvhist
+ *       (they are NOT cleared by mvhist_reset()). The peak of the
+ *       total is NOT the sum of the peaks of the other categories.
+ * --------------------------------------------------------------
+ */
+size_t mvhist_get_nbpeak( const MovesHistory *mvhist, int which )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;
+	}
+	if ( which < 0 || which > MVHIST_MEM_TOTAL ) {
+		DBGF( "Invalid memory category (%d)!", which );
+		return 0;
+	}
+
+	return mvhist->nbpeak[ which ];
+}
+
+/* --------------------------------------------------------------
+ * (Getter) int mvhist_count_branches():
+ *
+ * Return the count of branches forking off the current line (undo
+ * + redo gsstacks) of the specified moves-history object (mvhist),
+ * or 0 on error.
+ *
+ * NOTE: Sub-branches of those branches are NOT counted.
+ * --------------------------------------------------------------
+ */
+int mvhist_count_branches( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;
+	}
+
+	return mvhist->nbranches;
+}
+
+/* --------------------------------------------------------------
+ * (Getter) long int mvhist_peek_branch_fork():
+ *
+ * Return the count of the node of the current line, off which forks
+ * the specified branch (ibranch, 0-based) of the specified moves-history
+ * object (mvhist), or 0 on error.
+ * --------------------------------------------------------------
+ */
+long int mvhist_peek_branch_fork( const MovesHistory *mvhist, int ibranch )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;
+	}
+	if ( ibranch < 0 || ibranch >= mvhist->nbranches ) {
+		DBGF( "Invalid branch index (%d)!", ibranch );
+		return 0;
+	}
+
+	return mvhist->branches[ibranch].fork;
+}
+
+/* --------------------------------------------------------------
+ * (Getter) long int mvhist_peek_branch_nmoves():
+ *
+ * Return the count of moves recorded in the specified branch (ibranch,
+ * 0-based) of the specified moves-history object (mvhist), or 0 on
+ * error.
+ * --------------------------------------------------------------
+ */
+long int mvhist_peek_branch_nmoves( const MovesHistory *mvhist, int ibranch )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;
+	}
+	if ( ibranch < 0 || ibranch >= mvhist->nbranches ) {
+		DBGF( "Invalid branch index (%d)!", ibranch );
+		return 0;
+	}
+
+	return mvhist->branches[ibranch].nplies;
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_switch_branch():
+ *
+ * Make the specified branch (ibranch, 0-based) of the specified
+ * moves-history object (mvhist) its current line, and copy into
+ * the specified game-state (gs) the game-state of the fork point.
+ * Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    First the current line is walked to the fork point, by moving
+ *    nodes between the undo & redo gsstacks (thus, it takes time
+ *    proportional to the depth-difference between the current node
+ *    and the fork point). Then only the 1st move of the branch is
+ *    applied on the game-state of the fork point, into a new redo
+ *    gsstack; the rest of its moves become the redo tail, and they
+ *    get decoded one at a time as they are redone (see _redo_pop()).
+ *    The rest of the old line gets archived as a new branch (see:
+ *    _redo_to_branch()), which is appended to the branches of mvhist,
+ *    along with the kids of the selected branch.
+ *
+ *    Everything that may fail is prepared before mvhist & gs get
+ *    modified. On error, the current line is walked back to where
+ *    it was, and gs is left intact.
+ *
+ *    So on success, the player is at the fork point and the moves of
+ *    the branch can be walked with redo. Since the branches are kept
+ *    in order of archiving, switching always to branch 0 cycles
+ *    through all the alternatives of the current line.
+ *
+ *    The didundo field is set to 1 (true), so the best-score does
+ *    NOT get updated while exploring a branch.
+ * --------------------------------------------------------------
+ */
+int mvhist_switch_branch( MovesHistory *mvhist, int ibranch, GameState *gs )
+{
+	long int  orig;
+	int       k;
+	struct _branch  br;
+	struct _branch  old = {0};     /* rest of the current line */
+	GSNode          *line = NULL;  /* 1st move of the branch */
+	GameState       *work = NULL;
+	const GameState *forkgs = NULL;
+
+	if ( NULL == mvhist || NULL == gs ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+	if ( ibranch < 0 || ibranch >= mvhist->nbranches ) {
+		DBGF( "Invalid branch index (%d)!", ibranch );
+		return 0;  /* false */
+	}
+	br = mvhist->branches[ ibranch ];
+	orig = gsstack_peek_count( mvhist->undo );
+	if ( br.nplies < 1 || br.fork < 1
+	|| br.fork > orig + mvhist_peek_redo_stack_count(mvhist)
+	){
+		DBGF( "Fork point %ld is not on the current line!", br.fork );
+		return 0;  /* false */
+	}
+
+	/* walk the current line to the fork point */
+	if ( !_line_seek(mvhist, br.fork) ) {
+		DBGF( "_line_seek(%ld) failed!", br.fork );
+		goto ret_failure;
+	}
+	forkgs = gsstack_peek_state( mvhist->undo );
+	if ( NULL == forkgs ) {
+		DBGF( "%s", "gsstack_peek_state() failed!" );
+		goto ret_failure;
+	}
+
+	/* decode only the 1st move of the branch (see _redo_pop()) */
+	work = new_gamestate( board_get_dim(gamestate_get_board(forkgs)) );
+	if ( NULL == work ) {
+		DBGF( "%s", "new_gamestate() failed!" );
+		goto ret_failure;
+	}
+	gamestate_copy( work, forkgs );
+	if ( !_plies_apply_nth(work, br.plies, 0, br.nplies) ) {
+		DBGF( "%s", "_plies_apply_nth(0) failed!" );
+		goto ret_failure;
+	}
+	if ( !gsstack_push(&line, work) ) {
+		DBGF( "%s", "gsstack_push() failed!" );
+		goto ret_failure;
+	}
+	work = gamestate_free( work );
+
+	/* prepare the rest of the old line as a branch, and room for all */
+	if ( mvhist->redo && !_redo_to_branch(mvhist, &old) ) {
+		DBGF( "%s", "_redo_to_branch() failed!" );
+		goto ret_failure;
+	}
+	if ( !_branches_reserve(mvhist, mvhist->nbranches + br.nkids) ) {
+		DBGF( "%s", "_branches_reserve() failed!" );
+		goto ret_failure;
+	}
+
+	/* nothing can fail from now on: detach the branch ... */
+	memmove(
+		&mvhist->branches[ibranch],
+		&mvhist->branches[ibranch+1],
+		(mvhist->nbranches - ibranch - 1) * sizeof(*mvhist->branches)
+		);
+	mvhist->nbranches--;
+	mvhist->nbbranches -= sizeof(br) + br.nplies * sizeof(*br.plies);
+
+	/* ... archive the rest of the old line ... */
+	if ( NULL != mvhist->redo ) {
+		_redo_commit_branch( mvhist, &old );
+	}
+
+	/* ... and make the branch the current line, its kids forking off it */
+	for (k=0; k < br.nkids; k++) {
+		mvhist->branches[ mvhist->nbranches++ ] = br.kids[k];
+	}
+	free( br.kids );
+	gsstack_set_nextmove( mvhist->undo, br.plies[0].mvdir );
+	mvhist->redo = line;
+	if ( br.nplies > 1 ) {
+		mvhist->redotail.plies  = br.plies;
+		mvhist->redotail.nplies = br.nplies;
+		mvhist->redotail.next   = 1;
+	}
+	else {
+		free( br.plies );
+	}
+
+	gamestate_copy( gs, forkgs );
+	_didundo_set( mvhist, 1 );  /* true */
+	_mem_track( mvhist );
+
+	return 1;  /* true */
+
+ret_failure:
+	gamestate_free( work );
+	gsstack_free( &line );
+	free( old.plies );
+	free( old.kids );
+	if ( !_line_seek(mvhist, orig) ) {
+		DBGF( "_line_seek(%ld) failed!", orig );
+	}
+	return 0;  /* false */
+}
+
+/* --------------------------------------------------------------
+ * int _replay_append_to_fp():
+ *
+ * Serialize the replay nested structure of the specified moves-history
+ * object (mvhist) and append it to the specified file (fp). Return 0
+ * (false) on error, 1 (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    The serialization first produces a text line of the form:
+ *
+ *    "replay.delay replay.nmoves replay.itcount\r\n"
+ *
+ *    Then it produces a series of text-lines, each one corresponding
+ *    to a serialized node of the replay.stack (all of its segments,
+ *    if it is a window, see mvhist_init_replay()). Each of those
+ *    lines has the following form:
+ *
+ *    "game-state-meta-data@board-meta-data#board-tile-values\r\n"
+ *
+ *    For details about the serialized game-state-meta-data,
+ *    board-meta-data and board-tile-values, see the function:
  *    gsstack_append_to_fp() (defined in the file: "gs.c")
  * --------------------------------------------------------------
  */
-static inline int _replay_append_to_fp( const MovesHistory *mvhist, FILE *fp )
+static inline int _replay_append_to_fp( const MovesHistory *mvhist, FILE *fp )
+{
+	long int iseg;
+	GSNode   *seg = NULL;
+
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;  /* false */
+	}
+	if ( NULL == fp ) {
+		DBGF( "%s", "NULL pointer argument (fp)!" );
+		return 0;  /* false */
+	}
+
+	/* mvhist->replay.delay
+	 * + mvhist->replay.nmoves
+	 * + mvhist->replay.itcount
+	 */
+	if ( fprintf(
+		fp,
+		"%lu %ld %ld\r\n",
+		mvhist->replay.delay,
+		mvhist->replay.nmoves,
+		mvhist->replay.itcount
+		) < 0
+	){
+		DBGF( "%s", "fprintf() failed!" );
+		return 0;  /* false */
+	}
+
+	/* + mvhist->replay.stack */
+	if ( NULL == mvhist->replay.stack || mvhist->replay.iseg < 0 ) {
+		if ( !gsstack_append_to_fp(mvhist->replay.stack, fp) ) {
+			DBGF( "%s", "gsstack_append_to_fp(mvhist->replay.stack) failed!" );
+			return 0;  /* false */
+		}
+		return 1;
+	}
+
+	/* ... or all the segments of its window, one at a time */
+	for (iseg=0; iseg < _replay_nsegs(mvhist); iseg++)
+	{
+		if ( iseg != mvhist->replay.iseg
+		&& !_replay_decode_segment(mvhist, iseg, &seg)
+		){
+			DBGF( "_replay_decode_segment(%ld) failed!", iseg );
+			return 0;  /* false */
+		}
+		if ( !gsstack_append_to_fp(seg ? seg : mvhist->replay.stack, fp) ) {
+			DBGF( "%s", "gsstack_append_to_fp() failed!" );
+			gsstack_free( &seg );
+			return 0;  /* false */
+		}
+		gsstack_free( &seg );
+	}
+
+	return 1;
+}
+
+/* --------------------------------------------------------------
+ * int _branches_append_to_fp():
+ *
+ * Serialize the specified array of (n) branches, along with all their
+ * sub-branches, and append them to the specified file (fp). Return 0
+ * (false) on error, 1 (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    The serialization first produces a text line with the count
+ *    of the branches: "n\r\n"
+ *
+ *    Then, for every branch it produces a text line of the form:
+ *    "fork nplies\r\n"
+ *
+ *    followed by nplies text-lines, one per move of the branch,
+ *    each one of the form:
+ *    "mvdir bsup nspawns pos val [pos val]\r\n"
+ *
+ *    followed by the recursive serialization of its sub-branches
+ *    (which starts with their count, so it is "0\r\n" for a branch
+ *    without any sub-branches).
+ * --------------------------------------------------------------
+ */
+static int _branches_append_to_fp(
+	const struct _branch *branches,
+	int                  n,
+	FILE                 *fp
+	)
+{
+	int  i, k;
+	long int j;
+	const struct _ply *ply = NULL;
+
+	if ( fprintf(fp, "%d\r\n", n) < 0 ) {
+		DBGF( "%s", "fprintf() failed!" );
+		return 0;  /* false */
+	}
+
+	for (i=0; i < n; i++)
+	{
+		if ( fprintf(
+			fp,
+			"%ld %ld\r\n",
+			branches[i].fork,
+			branches[i].nplies
+			) < 0
+		){
+			DBGF( "%s", "fprintf() failed!" );
+			return 0;  /* false */
+		}
+
+		for (j=0; j < branches[i].nplies; j++) {
+			ply = &branches[i].plies[j];
+			fprintf(fp, "%d %d %d", ply->mvdir, ply->bsup, ply->nspawns);
+			for (k=0; k < ply->nspawns; k++) {
+				fprintf( fp, " %d %d", ply->pos[k], ply->val[k] );
+			}
+			if ( fprintf(fp, "\r\n") < 0 ) {
+				DBGF( "%s", "fprintf() failed!" );
+				return 0;  /* false */
+			}
+		}
+
+		if ( !_branches_append_to_fp(
+			branches[i].kids,
+			branches[i].nkids,
+			fp
+			)
+		){
+			return 0;  /* false */
+		}
+	}
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _archive_append_to_fp():
+ *
+ * Serialize the archived game-states of the specified moves-history
+ * object (mvhist) as gsstack nodes, in decreasing count order, and
+ * append them to the specified file (fp). Return 0 (false) on error,
+ * 1 (true) otherwise.
+ *
+ * NOTE: This is meant to be called right after the resident nodes
+ *       of the undo gsstack have been serialized, so the file gets
+ *       the same lines as if the whole undo gsstack was resident.
+ *       For details see the function: gsstack_append_to_fp()
+ *       (defined in the file: "gs.c")
+ * --------------------------------------------------------------
+ */
+static int _archive_append_to_fp( const MovesHistory *mvhist, FILE *fp )
+{
+	long int     ikey, count;
+	GSNode       *seg = NULL;
+	const GSNode *it  = NULL;
+
+	count = mvhist->archive.nstates;
+	for (ikey = mvhist->archive.nkeys - 1; ikey > -1; ikey--)
+	{
+		if ( !_archive_decode_segment(mvhist, ikey, &seg) ) {
+			DBGF( "_archive_decode_segment(%ld) failed!", ikey );
+			goto ret_failure;
+		}
+		for (it = gsstack_iter_top(seg); it; it = gsstack_iter_down(it))
+		{
+			if ( fprintf(fp, "%ld:", count--) < 0
+			|| !gamestate_append_to_fp(gsstack_peek_state(it), fp)
+			){
+				DBGF( "%s", "Failed to write archived game-state!" );
+				goto ret_failure;
+			}
+		}
+		gsstack_free( &seg );
+	}
+
+	return 1;  /* true */
+
+ret_failure:
+	gsstack_free( &seg );
+	return 0;  /* false */
+}
+
+/* --------------------------------------------------------------
+ * int _redo_append_to_fp():
+ *
+ * Serialize the redo gsstack of the specified moves-history object
+ * (mvhist) along with its redo tail, and append it to the specified
+ * file (fp), so the file gets the same lines as if the tail had been
+ * decoded into the redo gsstack. Return 0 (false) on error, 1 (true)
+ * otherwise.
+ *
+ * NOTE: For details see the function: gsstack_append_to_fp()
+ *       (defined in the file: "gs.c")
+ * --------------------------------------------------------------
+ */
+static int _redo_append_to_fp( const MovesHistory *mvhist, FILE *fp )
+{
+	long int        i;
+	GameState       *work = NULL;
+	const GameState *last = NULL;
+	const GSNode    *it   = NULL;
+	const long int  npending = _redotail_count( mvhist );
+
+	if ( npending < 1 ) {
+		return gsstack_append_to_fp( mvhist->redo, fp );
+	}
+	if ( NULL == (work = new_gamestate(BOARD_DIM_4)) ) {
+		DBGF( "%s", "new_gamestate() failed!" );
+		return 0;  /* false */
+	}
+
+	/* nodes of the redo gsstack, counted after the tail */
+	for (it = gsstack_iter_top(mvhist->redo); it; it = gsstack_iter_down(it))
+	{
+		last = gsstack_peek_state_into( it, work );
+		if ( NULL == last
+		|| fprintf(fp, "%ld:", gsstack_peek_count(it) + npending) < 0
+		|| !gamestate_append_to_fp(last, fp)
+		){
+			DBGF( "%s", "Failed to write redo game-state!" );
+			goto ret_failure;
+		}
+	}
+
+	/* + the tail, decoded after the bottom node */
+	if ( last != work ) {
+		gamestate_copy( work, last );
+	}
+	for (i = mvhist->redotail.next; i < mvhist->redotail.nplies; i++)
+	{
+		if ( !_plies_apply_nth(work, mvhist->redotail.plies, i, mvhist->redotail.nplies)
+		|| fprintf(fp, "%ld:", mvhist->redotail.nplies - i) < 0
+		|| !gamestate_append_to_fp(work, fp)
+		){
+			DBGF( "%s", "Failed to write redo-tail game-state!" );
+			goto ret_failure;
+		}
+	}
+	gamestate_free( work );
+
+	return 1;  /* true */
+
+ret_failure:
+	gamestate_free( work );
+	return 0;  /* false */
+}
+
+/* --------------------------------------------------------------
+ * int _bin_put_varint():
+ *
+ * Append to the specified binary file (fp) the specified unsigned
+ * value (u), as a variable-length integer: 7 bits per byte, least
+ * significant group first, with the high bit of every byte but the
+ * last one set. Return 0 (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _bin_put_varint( FILE *fp, unsigned long int u )
+{
+	while ( u > 0x7F ) {
+		if ( EOF == putc( (int)(0x80 | (u & 0x7F)), fp ) ) {
+			return 0;  /* false */
+		}
+		u >>= 7;
+	}
+	return EOF != putc( (int)u, fp );
+}
+
+/* --------------------------------------------------------------
+ * int _ply_nspawns():
+ *
+ * Play on a copy of the specified game-state (state) a move towards
+ * the specified direction (mvdir), using the game-state (scratch) as
+ * work-area. Return the count of tiles the game generates randomly
+ * after that move, or -1 if the move is not possible. The argument
+ * (won) tells the caller whether it was a winning move.
+ *
+ * NOTE: On return, scratch holds the game-state right after the move
+ *       (including its score), but before any tile gets generated.
+ *       The count is derived the same way as _do_play_board() does
+ *       in the file "main.c": no tiles after a winning move, else as
+ *       many as the board variant generates, if there is room.
+ * --------------------------------------------------------------
+ */
+static inline int _ply_nspawns(
+	const GameState *state,
+	int             mvdir,
+	GameState       *scratch,
+	int             *won
+	)
+{
+	int n;
+	long int score = gamestate_get_score( state );
+	Board *board = NULL;
+
+	*won = 0;  /* false */
+	gamestate_copy( scratch, state );
+	board = gamestate_get_board( scratch );
+	if ( !_board_play_mvdir(board, mvdir, &score, won) ) {
+		return -1;
+	}
+	gamestate_set_score( scratch, score );
+	if ( *won ) {
+		return 0;
+	}
+
+	n = board_get_nrandom( board );
+	return n < board_get_nempty(board) ? n : board_get_nempty( board );
+}
+
+/* --------------------------------------------------------------
+ * void _binmodel_init():
+ *
+ * Initialize the specified adaptive models of compressed moves (m).
+ * --------------------------------------------------------------
+ */
+static inline void _binmodel_init( struct _binmodel *m )
+{
+	int i;
+
+	for (i=0; i <= GS_MVDIR_RIGHT; i++) {
+		rc_init_probs( m->dirs[i], 4 );
+	}
+	for (i=0; i < 8; i++) {
+		rc_init_probs( m->brdirs[i], 8 );
+	}
+	rc_init_probs( m->vals, _MAXSPAWNS );
+	rc_init_probs( m->bsup, 2 );
+	rc_init_probs( m->nspawns, 4 );
+	rc_init_probs( m->pos, 256 );
+	rc_init_probs( m->val, 256 );
+}
+
+/* --------------------------------------------------------------
+ * int _board_empty_rank():
+ *
+ * Return the rank of the tile with the specified grid-index (pos)
+ * among the empty tiles of the specified board, in row-major order,
+ * or -1 if the tile is not empty.
+ * --------------------------------------------------------------
+ */
+static inline int _board_empty_rank( const Board *board, int pos )
+{
+	int i, rank = 0;
+	const int dim = board_get_dim( board );
+
+	if ( pos < 0 || pos >= dim * dim
+	|| 0 != board_get_tile_value(board, pos / dim, pos % dim)
+	){
+		return -1;
+	}
+	for (i=0; i < pos; i++) {
+		if ( 0 == board_get_tile_value(board, i / dim, i % dim) ) {
+			rank++;
+		}
+	}
+	return rank;
+}
+
+/* --------------------------------------------------------------
+ * int _board_empty_at():
+ *
+ * Return the grid-index of the empty tile having the specified rank
+ * among the empty tiles of the specified board, in row-major order,
+ * or -1 if there is no such tile.
+ * --------------------------------------------------------------
+ */
+static inline int _board_empty_at( const Board *board, int rank )
+{
+	int i;
+	const int dim = board_get_dim( board );
+
+	for (i=0; i < dim * dim; i++) {
+		if ( 0 == board_get_tile_value(board, i / dim, i % dim)
+		&& 0 == rank--
+		){
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* --------------------------------------------------------------
+ * void _binline_free():
+ *
+ * Release all resources occupied by the specified binary encoding
+ * of a current line (see _binline_encode()), and empty it.
+ * --------------------------------------------------------------
+ */
+static void _binline_free( struct _binline *bl )
+{
+	gamestate_free( bl->first );
+	gamestate_free( bl->prev );
+	gamestate_free( bl->scratch );
+	rcenc_free( &bl->moves );
+	free( bl->toggles );
+	free( bl->nexts );
+	memset( bl, 0, sizeof(*bl) );
+}
+
+/* --------------------------------------------------------------
+ * int _binline_add():
+ *
+ * Append the specified game-state (state) to the specified binary
+ * encoding of a current line (arg), as the move leading to it from
+ * the previously added game-state. Return 0 (false) if the game-state
+ * cannot be encoded that way, 1 (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    The 1st game-state is kept as is. Every next one is range-coded
+ *    into bl->moves as the direction of its move (2 bits, modelled on
+ *    the direction of the previous move) followed by every randomly
+ *    generated tile: its rank among the empty tiles of the board right
+ *    after the move (uniformly) and whether it is a 4 instead of a 2.
+ *    The count of generated tiles is NOT stored, because it is derived
+ *    from the move (see _ply_nspawns()).
+ *
+ *    The best-score is stored as the counts of the moves where it
+ *    stops or starts following the score (that is, normally just the
+ *    1st move played after an undo). The nextmv fields are stored
+ *    only for game-states where they differ from the direction of the
+ *    following move (e.g. the last one).
+ *
+ *    Boards are deliberately NOT coded as deltas (e.g. XORed against
+ *    their predecessors). A board follows from the previous one by its
+ *    move plus the generated tiles, so a delta would have to code every
+ *    tile slid or merged by the move, which the direction determines
+ *    anyway, along with the generated tiles coded above. Either way it
+ *    streams: one game-state gets added at a time, and the loader
+ *    re-constructs one at a time too (see _bin_load_line()).
+ * --------------------------------------------------------------
+ */
+static int _binline_add( void *arg, const GameState *state )
+{
+	struct _binline *bl = arg;
+	int k, n, won, val, bsup, rank;
+	const long int c = bl->nstates;     /* count of the move to encode */
+	Board  *board = NULL;
+	struct _ply ply;
+
+	if ( NULL == state ) {
+		return 0;  /* false */
+	}
+	if ( 0 == bl->nstates ) {
+		gamestate_copy( bl->first, state );
+		gamestate_copy( bl->prev, state );
+		bl->nstates = 1;
+		return 1;  /* true */
+	}
+	if ( c >= bl->nmax || !_ply_make(&ply, bl->prev, state, bl->scratch) ) {
+		return 0;  /* false */
+	}
+
+	n = _ply_nspawns( bl->prev, ply.mvdir, bl->scratch, &won );
+	if ( n != ply.nspawns
+	|| gamestate_get_iswin(state)
+	   != (gamestate_get_iswin(bl->prev) || won)
+	){
+		return 0;  /* false */
+	}
+
+	/* direction */
+	rcenc_tree( &bl->moves, bl->model.dirs[bl->lastdir], 2, ply.mvdir - 1 );
+	bl->lastdir = ply.mvdir;
+
+	/* generated tiles, ranked on the board they were generated on */
+	board = gamestate_get_board( bl->scratch );
+	for (k=0; k < n; k++) {
+		val  = ply.val[k];
+		rank = _board_empty_rank( board, ply.pos[k] );
+		if ( rank < 0 || (2 != val && 4 != val) ) {
+			return 0;  /* false */
+		}
+		rcenc_uniform( &bl->moves, rank, board_get_nempty(board) );
+		rcenc_bit( &bl->moves, &bl->model.vals[k], 4 == val );
+		board_set_tile_value(
+			board,
+			ply.pos[k] / board_get_dim(board),
+			ply.pos[k] % board_get_dim(board),
+			val
+			);
+	}
+
+	/* best-score */
+	bsup = bl->tracked
+		&& gamestate_get_score(state) > gamestate_get_bestscore(bl->prev);
+	if ( bsup != ply.bsup ) {
+		bl->tracked = !bl->tracked;
+		bl->toggles[ bl->ntoggles++ ] = c;
+		bsup = bl->tracked
+		    && gamestate_get_score(state) > gamestate_get_bestscore(bl->prev);
+		if ( bsup != ply.bsup ) {
+			return 0;  /* false */
+		}
+	}
+
+	/* nextmv of the previous game-state */
+	if ( gamestate_get_nextmove(bl->prev) != ply.mvdir ) {
+		bl->nexts[ bl->nnexts ].count = c;
+		bl->nexts[ bl->nnexts ].mvdir = gamestate_get_nextmove( bl->prev );
+		bl->nnexts++;
+	}
+
+	gamestate_copy( bl->prev, state );
+	bl->nstates++;
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _line_walk():
+ *
+ * Call the specified function (fn) for every game-state of the current
+ * line (undo + redo gsstacks, including any archived moves) of the
+ * specified moves-history object (mvhist), in increasing count order,
+ * passing it along the specified argument (arg). Stop as soon as fn
+ * returns 0 (false). Return 0 (false) if fn did so or on error, 1
+ * (true) otherwise.
+ *
+ * NOTE: mvhist is not changed at all (lazy nodes are decoded into a
+ *       work-area, see gsstack_peek_state_into() in "gs.c") so the
+ *       function may run in a background thread, on a snapshot of the
+ *       object (see _mvhist_snapshot()). A lazy node that cannot be
+ *       decoded is passed to fn as a NULL game-state.
+ * --------------------------------------------------------------
+ */
+static int _line_walk(
+	const MovesHistory *mvhist,
+	int                (*fn)( void *arg, const GameState *state ),
+	void               *arg
+	)
+{
+	long int        ikey, i;
+	GSNode          *seg  = NULL;
+	GameState       *work = new_gamestate( BOARD_DIM_4 );
+	const GameState *last = NULL;
+	const GSNode    *it   = NULL;
+
+	if ( NULL == work ) {
+		DBGF( "%s", "new_gamestate() failed!" );
+		return 0;  /* false */
+	}
+
+	/* archived game-states, in increasing count order */
+	for (ikey=0; ikey < mvhist->archive.nkeys; ikey++)
+	{
+		if ( !_archive_decode_segment(mvhist, ikey, &seg) ) {
+			DBGF( "_archive_decode_segment(%ld) failed!", ikey );
+			goto ret_failure;
+		}
+		for (it = gsstack_iter_bottom(seg); it; it = gsstack_iter_up(it)) {
+			if ( !(*fn)(arg, gsstack_peek_state(it)) ) {
+				goto ret_failure;
+			}
+		}
+		gsstack_free( &seg );
+	}
+
+	/* resident undo nodes (bottom-up), then redo nodes (top-down) */
+	it = gsstack_iter_bottom( mvhist->undo );
+	for (; it; it = gsstack_iter_up(it)) {
+		if ( !(*fn)(arg, gsstack_peek_state_into(it, work)) ) {
+			goto ret_failure;
+		}
+	}
+	for (it = gsstack_iter_top(mvhist->redo); it; it = gsstack_iter_down(it)) {
+		if ( !(*fn)(arg, last = gsstack_peek_state_into(it, work)) ) {
+			goto ret_failure;
+		}
+	}
+
+	/* moves of the redo tail, decoded after the bottom redo node */
+	if ( _redotail_count(mvhist) > 0 ) {
+		if ( NULL == last ) {
+			goto ret_failure;
+		}
+		if ( last != work ) {
+			gamestate_copy( work, last );
+		}
+		for (i = mvhist->redotail.next; i < mvhist->redotail.nplies; i++) {
+			if ( !_plies_apply_nth(
+				work,
+				mvhist->redotail.plies,
+				i,
+				mvhist->redotail.nplies
+				)
+			|| !(*fn)(arg, work)
+			){
+				goto ret_failure;
+			}
+		}
+	}
+
+	gamestate_free( work );
+	return 1;  /* true */
+
+ret_failure:
+	gsstack_free( &seg );
+	gamestate_free( work );
+	return 0;  /* false */
+}
+
+/* --------------------------------------------------------------
+ * int _board_count_empty():
+ *
+ * Return the count of the empty tiles of the specified board,
+ * as found on its grid (that is, not its cached nempty field).
+ * --------------------------------------------------------------
+ */
+static inline int _board_count_empty( const Board *board )
+{
+	int i, n = 0;
+	const int dim = board_get_dim( board );
+
+	for (i=0; i < dim * dim; i++) {
+		if ( 0 == board_get_tile_value(board, i / dim, i % dim) ) {
+			n++;
+		}
+	}
+	return n;
+}
+
+/* --------------------------------------------------------------
+ * int _verify_add():
+ *
+ * Check that the specified game-state (state) follows from the
+ * previously checked game-state of the specified re-simulation (arg),
+ * by replaying its move on a copy of that game-state. Return 0 (false)
+ * if it does not, after setting the reason, 1 (true) otherwise.
+ *
+ * NOTE: A game-state follows from the previous one when its move is
+ *       possible, its score & iswin fields are those resulting from
+ *       the move, its board differs from the one resulting from the
+ *       move only by as many generated 2s or 4s as the game generates
+ *       after that move (see _ply_nspawns()), and the cached count of
+ *       its empty tiles is correct.
+ * --------------------------------------------------------------
+ */
+static int _verify_add( void *arg, const GameState *state )
+{
+	struct _verify *v = arg;
+	int i, dim, n, won, val, nspawns = 0;
+	const Board *board = NULL;
+	const Board *moved = NULL;
+
+	/* e.g. a lazy node whose text cannot be decoded */
+	if ( NULL == state ) {
+		v->reason = "it cannot be decoded";
+		return 0;  /* false */
+	}
+	board = gamestate_get_board( state );
+	dim   = board_get_dim( board );
+	if ( board_get_nempty(board) != _board_count_empty(board) ) {
+		v->reason = "the count of its empty tiles is wrong";
+		return 0;  /* false */
+	}
+	if ( 0 == v->nstates ) {
+		v->prev    = new_gamestate( dim );
+		v->scratch = new_gamestate( dim );
+		if ( !v->prev || !v->scratch ) {
+			v->reason = "out of memory";
+			return 0;  /* false */
+		}
+		goto ret_success;
+	}
+	if ( dim != board_get_dim(gamestate_get_board(v->prev)) ) {
+		v->reason = "its board variant differs";
+		return 0;  /* false */
+	}
+
+	n = _ply_nspawns(
+		v->prev,
+		gamestate_get_prevmove(state),
+		v->scratch,
+		&won
+		);
+	if ( n < 0 ) {
+		v->reason = "its move is not possible";
+		return 0;  /* false */
+	}
+	if ( gamestate_get_score(state) != gamestate_get_score(v->scratch) ) {
+		v->reason = "its score does not follow from its move";
+		return 0;  /* false */
+	}
+	if ( gamestate_get_iswin(state)
+	!= (gamestate_get_iswin(v->prev) || won)
+	){
+		v->reason = "its winning status does not follow from its move";
+		return 0;  /* false */
+	}
+
+	moved = gamestate_get_board( v->scratch );
+	for (i=0; i < dim * dim; i++) {
+		val = board_get_tile_value( board, i / dim, i % dim );
+		if ( val == board_get_tile_value(moved, i / dim, i % dim) ) {
+			continue;
+		}
+		if ( 0 != board_get_tile_value(moved, i / dim, i % dim)
+		|| (2 != val && 4 != val)
+		){
+			v->reason = "its tiles do not follow from its move";
+			return 0;  /* false */
+		}
+		nspawns++;
+	}
+	if ( nspawns != n ) {
+		v->reason = "the count of its generated tiles is wrong";
+		return 0;  /* false */
+	}
+
+ret_success:
+	gamestate_copy( v->prev, state );
+	v->nstates++;
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _binline_encode():
+ *
+ * Encode in (bl) the current line (undo + redo gsstacks, including
+ * any archived moves) of the specified moves-history object (mvhist).
+ * Return 0 (false) if it cannot be encoded as a series of moves (e.g.
+ * a hand-edited file got loaded) or on error, 1 (true) otherwise.
+ *
+ * NOTE: On success, the caller is responsible for releasing bl, via
+ *       the function: _binline_free()
+ * --------------------------------------------------------------
+ */
+static int _binline_encode( struct _binline *bl, const MovesHistory *mvhist )
+{
+	memset( bl, 0, sizeof(*bl) );
+	bl->nundo   = gsstack_peek_count( mvhist->undo );
+	bl->nredo   = mvhist_peek_redo_stack_count( mvhist );
+	bl->nmax    = bl->nundo + bl->nredo;
+	bl->tracked = 1;  /* true */
+	if ( 0 == bl->nmax ) {
+		return 1;  /* true */
+	}
+	if ( 0 == bl->nundo ) {
+		return 0;  /* false */
+	}
+
+	/* their boards get the dimension of the 1st game-state */
+	bl->first   = new_gamestate( BOARD_DIM_4 );
+	bl->prev    = new_gamestate( BOARD_DIM_4 );
+	bl->scratch = new_gamestate( BOARD_DIM_4 );
+	bl->toggles = malloc( bl->nmax * sizeof(*bl->toggles) );
+	bl->nexts   = malloc( bl->nmax * sizeof(*bl->nexts) );
+	if ( !bl->first || !bl->prev || !bl->scratch
+	|| !bl->toggles || !bl->nexts
+	){
+		DBGF( "%s", "Out of memory!" );
+		goto ret_failure;
+	}
+	rcenc_init( &bl->moves );
+	_binmodel_init( &bl->model );
+
+	if ( !_line_walk(mvhist, _binline_add, bl) ) {
+		goto ret_failure;
+	}
+
+	/* the last game-state is not followed by any move */
+	if ( GS_MVDIR_NONE != gamestate_get_nextmove(bl->prev) ) {
+		bl->nexts[ bl->nnexts ].count = bl->nstates;
+		bl->nexts[ bl->nnexts ].mvdir = gamestate_get_nextmove( bl->prev );
+		bl->nnexts++;
+	}
+
+	if ( !rcenc_flush(&bl->moves) ) {
+		DBGF( "%s", "Out of memory!" );
+		goto ret_failure;
+	}
+
+	return 1;  /* true */
+
+ret_failure:
+	_binline_free( bl );
+	return 0;  /* false */
+}
+
+/* --------------------------------------------------------------
+ * int _binline_append_to_fp():
+ *
+ * Append the specified binary encoding of a current line (bl) to the
+ * specified binary file (fp). Return 0 (false) on error, 1 (true)
+ * otherwise.
+ *
+ * NOTES:
+ *
+ *    The encoding is written as:
+ *    - the counts of undo & redo game-states (varints),
+ *    and, unless both of them are 0:
+ *    - the 1st game-state, serialized as text (see the function
+ *      gamestate_append_to_fp(), defined in the file: "gs.c")
+ *    - the count of best-score toggles, followed by their counts
+ *      (varints, each one as a difference from the previous one)
+ *    - the count of nextmv exceptions, followed by their counts
+ *      (likewise) each one followed by a byte with its nextmv
+ *    - the size of the compressed moves (varint) followed by their
+ *      bytes (see _binline_add()).
+ *
+ *    Files of _BIN_VERSION_1 had instead the directions of the moves
+ *    packed 4 per byte (the 1st one in the 2 least significant bits,
+ *    as GS_MVDIR_XXX - 1), and then the count of generated tiles (as
+ *    a varint) followed by one byte per tile (its grid-index in the
+ *    low 6 bits, and 0x40 for a 4 instead of a 2).
+ *
+ *    Errors are NOT reported here, since the function may be running
+ *    in a background thread (see mvhist_save_to_file_async()).
+ * --------------------------------------------------------------
+ */
+static int _binline_append_to_fp( const struct _binline *bl, FILE *fp )
+{
+	long int i, last;
+
+	if ( !_bin_put_varint(fp, bl->nundo) || !_bin_put_varint(fp, bl->nredo) ) {
+		return 0;  /* false */
+	}
+	if ( 0 == bl->nmax ) {
+		return 1;  /* true */
+	}
+
+	if ( !gamestate_append_to_fp(bl->first, fp) ) {
+		return 0;  /* false */
+	}
+
+	_bin_put_varint( fp, bl->ntoggles );
+	for (i=0, last=0; i < bl->ntoggles; last = bl->toggles[i++]) {
+		_bin_put_varint( fp, bl->toggles[i] - last );
+	}
+
+	_bin_put_varint( fp, bl->nnexts );
+	for (i=0, last=0; i < bl->nnexts; last = bl->nexts[i++].count) {
+		_bin_put_varint( fp, bl->nexts[i].count - last );
+		putc( bl->nexts[i].mvdir, fp );
+	}
+
+	_bin_put_varint( fp, bl->moves.size );
+	if ( fwrite(bl->moves.buf, 1, bl->moves.size, fp) < bl->moves.size ) {
+		return 0;  /* false */
+	}
+
+	return !ferror( fp );
+}
+
+/* --------------------------------------------------------------
+ * void _bin_ply_encode():
+ *
+ * Range-code the specified ply (ply) of a branch, following the ply
+ * (prev) in that branch (NULL for the 1st one), via the specified
+ * encoder (rc) and adaptive models (model).
+ *
+ * NOTE: Unlike in the current line (see _binline_add()) there is no
+ *       board to rank the generated tiles on, so their grid-indices
+ *       and values are coded as 8-bit trees, which quickly learn the
+ *       few values that actually occur.
+ * --------------------------------------------------------------
+ */
+static inline void _bin_ply_encode(
+	RcEncoder         *rc,
+	struct _binmodel  *model,
+	const struct _ply *ply,
+	const struct _ply *prev
+	)
+{
+	int k;
+
+	rcenc_tree(
+		rc,
+		model->brdirs[ prev ? (prev->mvdir & 0x07) : 0 ],
+		3,
+		ply->mvdir & 0x07
+		);
+	rcenc_bit( rc, &model->bsup[ prev && prev->bsup ], 0 != ply->bsup );
+	rcenc_tree( rc, model->nspawns, 2, ply->nspawns );
+	for (k=0; k < ply->nspawns; k++) {
+		rcenc_tree( rc, model->pos, 8, ply->pos[k] );
+		rcenc_tree( rc, model->val, 8, ply->val[k] );
+	}
+}
+
+/* --------------------------------------------------------------
+ * void _bin_branches_encode():
+ *
+ * Range-code via the specified encoder (rc) and adaptive models (model)
+ * the plies of the specified array of (n) branches, along with those
+ * of all their sub-branches, in the order the branches get written by
+ * the function: _bin_branch_tree_append_to_fp()
+ * --------------------------------------------------------------
+ */
+static void _bin_branches_encode(
+	const struct _branch *branches,
+	int                  n,
+	RcEncoder            *rc,
+	struct _binmodel     *model
+	)
+{
+	int  i;
+	long int j;
+
+	for (i=0; i < n; i++) {
+		for (j=0; j < branches[i].nplies; j++) {
+			_bin_ply_encode(
+				rc,
+				model,
+				&branches[i].plies[j],
+				j > 0 ? &branches[i].plies[j-1] : NULL
+				);
+		}
+		_bin_branches_encode( branches[i].kids, branches[i].nkids, rc, model );
+	}
+}
+
+/* --------------------------------------------------------------
+ * int _bin_branch_tree_append_to_fp():
+ *
+ * Serialize the layout of the specified array of (n) branches, along
+ * with all their sub-branches, and append it to the specified binary
+ * file (fp). Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTE: The layout follows the one of _branches_append_to_fp(), but
+ *       counts are written as varints, and the plies are NOT written
+ *       at all (see _bin_branches_append_to_fp()).
+ * --------------------------------------------------------------
+ */
+static int _bin_branch_tree_append_to_fp(
+	const struct _branch *branches,
+	int                  n,
+	FILE                 *fp
+	)
+{
+	int  i;
+
+	if ( !_bin_put_varint(fp, n) ) {
+		return 0;  /* false */
+	}
+
+	for (i=0; i < n; i++)
+	{
+		_bin_put_varint( fp, branches[i].fork );
+		_bin_put_varint( fp, branches[i].nplies );
+		if ( !_bin_branch_tree_append_to_fp(
+			branches[i].kids,
+			branches[i].nkids,
+			fp
+			)
+		){
+			return 0;  /* false */
+		}
+	}
+
+	return !ferror( fp );
+}
+
+/* --------------------------------------------------------------
+ * int _bin_branches_append_to_fp():
+ *
+ * Serialize the specified array of (n) branches, along with all their
+ * sub-branches, and append them to the specified binary file (fp).
+ * Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    The plies of all the branches are range-coded together (see the
+ *    function: _bin_ply_encode()) and written first, as the size of
+ *    the compressed data (varint) followed by their bytes. Then comes
+ *    the layout of the branches (see _bin_branch_tree_append_to_fp()).
+ *    So the loader decodes the plies while it reads the layout. With
+ *    no branches at all, the size is 0 and no compressed data follow.
+ *
+ *    Files of _BIN_VERSION_1 had instead every ply written right after
+ *    the count of plies of its branch, as a single byte (mvdir in bits
+ *    0-2, bsup in bit 3, nspawns in bits 4-5) which was followed by a
+ *    (pos, val) pair of bytes per generated tile.
+ *
+ *    Errors are NOT reported here, since the function may be running
+ *    in a background thread (see mvhist_save_to_file_async()).
+ * --------------------------------------------------------------
+ */
+static int _bin_branches_append_to_fp(
+	const struct _branch *branches,
+	int                  n,
+	FILE                 *fp
+	)
+{
+	int ret;
+	RcEncoder rc;
+	struct _binmodel model;
+
+	if ( 0 == n ) {
+		return _bin_put_varint( fp, 0 ) && _bin_put_varint( fp, 0 );
+	}
+
+	rcenc_init( &rc );
+	_binmodel_init( &model );
+	_bin_branches_encode( branches, n, &rc, &model );
+
+	ret = rcenc_flush( &rc )
+		&& _bin_put_varint( fp, rc.size )
+		&& fwrite( rc.buf, 1, rc.size, fp ) == rc.size
+		&& _bin_branch_tree_append_to_fp( branches, n, fp );
+
+	rcenc_free( &rc );
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int _bin_append_to_fp():
+ *
+ * Serialize in the binary format the specified moves-history object
+ * (mvhist), whose current line has been already encoded in (bl), and
+ * write it to the specified binary file (fp). Return 0 (false) on
+ * error, 1 (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    The file starts with the _BIN_MAGIC signature, followed by a
+ *    byte with the _BIN_VERSION of the format. Then come (as varints)
+ *    didundo, replay.delay, replay.nmoves, replay.itcount and whether
+ *    there is a replay.stack, followed by the current line (see the
+ *    function: _binline_append_to_fp()) and finally the branches (see
+ *    the function: _bin_branches_append_to_fp()).
+ *
+ *    The replay.stack is not written at all, since it is always a
+ *    window over the reversed undo gsstack (see mvhist_init_replay()).
+ *
+ *    Errors are NOT reported here, since the function may be running
+ *    in a background thread (see mvhist_save_to_file_async()).
+ * --------------------------------------------------------------
+ */
+static int _bin_append_to_fp(
+	const MovesHistory    *mvhist,
+	const struct _binline *bl,
+	FILE                  *fp
+	)
+{
+	return fwrite(_BIN_MAGIC, 1, _SZBIN_MAGIC, fp) == _SZBIN_MAGIC
+		&& EOF != putc( _BIN_VERSION, fp )
+		&& _bin_put_varint( fp, mvhist->didundo )
+		&& _bin_put_varint( fp, mvhist->replay.delay )
+		&& _bin_put_varint( fp, mvhist->replay.nmoves )
+		&& _bin_put_varint( fp, mvhist->replay.itcount )
+		&& _bin_put_varint( fp, NULL != mvhist->replay.stack )
+		&& _binline_append_to_fp( bl, fp )
+		&& _bin_branches_append_to_fp(
+			mvhist->branches,
+			mvhist->nbranches,
+			fp
+			);
+}
+
+/* --------------------------------------------------------------
+ * int _text_append_to_fp():
+ *
+ * Serialize the specified moves-history object (mvhist) in the text
+ * format, and write it to the specified file (fp). Return 0 (false)
+ * on error, 1 (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    The serialization first produces a text line of the form:
+ *    "didundo\r\n"
+ *
+ *    Then it produces a series of text-lines, each one corresponding
+ *    to a serialized node of the undo gsstack of the object. If the
+ *    undo gsstack is empty, then a single line is produced instead:
+ *    "NULL:\r\n"
+ *    (archived moves are decoded and written as ordinary nodes, so
+ *    the produced file does not depend on the memory budget).
+ *
+ *    Next it produces a series of text-lines, each one corresponding
+ *    to a serialized node of the redo gsstack of the object. If the
+ *    redo gsstack is empty, then once again just one single line is
+ *    produced instead:
+ *    "NULL:\r\n"
+ *
+ *    Next, it produces a text-line with the serialized meta-data
+ *    of the replay nested structure of the object, followed by a series
+ *    of lines, each one corresponding to a serialized node of the
+ *    replay.stack. If the replay.stack is empty, then again just a
+ *    single line gets produced instead: "NULL:\r\n"
+ *
+ *    Finally, it produces the serialized branches of the object. Since
+ *    branches are stored as deltas from their fork points, the common
+ *    prefix of the moves-history tree is written only once (as part of
+ *    the undo & redo gsstacks). Files written by earlier versions end
+ *    right after the replay.stack, and they are loaded without any
+ *    branches.
+ *
+ *    For details about the exact serializations, see the functions:
+ *    - replay_append_to_fp()
+ *    - _branches_append_to_fp()
+ *    - gsstack_append_to_fp()   (defined in the file: "gs.c") 
+ *    - gamestate_append_to_fp() (defined in the file: "gs.c") 
+ *    - board_append_to_fp()     (defined in the file: "board.c") 
+ * --------------------------------------------------------------
+ */
+static int _text_append_to_fp( const MovesHistory *mvhist, FILE *fp )
+{
+	/* mvhist->didundo */
+	if ( fprintf(fp, "%d\r\n", mvhist->didundo) < 0 ) {
+		DBGF( "%s", "fprintf() failed!" );
+		return 0;  /* false */
+	}
+
+	/* + mvhist->undo (stack), including any archived moves */
+	if ( !gsstack_append_to_fp(mvhist->undo, fp) ) {
+		DBGF( "%s", "gsstack_append_to_fp(mvhist->undo) failed!" );
+		return 0;  /* false */
+	}
+	if ( !_archive_append_to_fp(mvhist, fp) ) {
+		DBGF( "%s", "_archive_append_to_fp() failed!" );
+		return 0;  /* false */
+	}
+	
+	/* + mvhist->redo (stack, along with its tail) */
+	if ( !_redo_append_to_fp(mvhist, fp) ) {
+		DBGF( "%s", "_redo_append_to_fp() failed!" );
+		return 0;  /* false */
+	}
+
+	/* + mvhist->replay */
+	if ( !_replay_append_to_fp(mvhist, fp) ) {
+		DBGF( "%s", "_replay_append_to_fp() failed!" );
+		return 0;  /* false */
+	}
+
+	/* + mvhist->branches */
+	if ( !_branches_append_to_fp(mvhist->branches, mvhist->nbranches, fp) ) {
+		DBGF( "%s", "_branches_append_to_fp() failed!" );
+		return 0;  /* false */
+	}
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * MovesHistory *_mvhist_snapshot():
+ *
+ * Create a snapshot of the specified moves-history object (mvhist),
+ * that is a new moves-history object sharing nothing with it, and
+ * return a pointer to it, or NULL on error.
+ *
+ * NOTES:
+ *
+ *    Nothing gets encoded, decoded or serialized here: the gsstacks
+ *    are duplicated node by node, and the archive, the redo tail & the
+ *    branches are copied as they are (their moves are already plies).
+ *    Lazy nodes stay lazy, pointing into a copy of the contents of the
+ *    file the object was loaded from. Its journal is not part of the
+ *    snapshot.
+ *
+ *    The snapshot is meant to be saved by another thread, which may
+ *    walk it (see _line_walk()) but MUST NOT change it, since its
+ *    nodes come from the memory pool of the calling thread (see the
+ *    file "pool.c").
+ * --------------------------------------------------------------
+ */
+static MovesHistory *_mvhist_snapshot( const MovesHistory *mvhist )
+{
+	long int     i;
+	const size_t szply = sizeof( struct _ply );
+	MovesHistory *snap = new_mvhist();
+
+	if ( NULL == snap ) {
+		DBGF( "%s", "new_mvhist() failed!" );
+		return NULL;
+	}
+
+	/* the contents of the loaded file, for the lazy nodes */
+	if ( NULL != mvhist->src.buf ) {
+		snap->src.buf = malloc( mvhist->src.size + 1 );
+		if ( NULL == snap->src.buf ) {
+			DBGF( "%s", "malloc(snap->src.buf) failed!" );
+			goto ret_failure;
+		}
+		memcpy( snap->src.buf, mvhist->src.buf, mvhist->src.size );
+		snap->src.buf[ mvhist->src.size ] = '\0';
+		snap->src.size = mvhist->src.size;
+	}
+
+	/* the gsstacks */
+	snap->didundo = mvhist->didundo;
+	snap->replay  = mvhist->replay;
+	snap->replay.stack = NULL;
+	if ( (mvhist->undo && NULL == (snap->undo
+		= gsstack_dup(mvhist->undo, mvhist->src.buf, snap->src.buf)))
+	|| (mvhist->redo && NULL == (snap->redo
+		= gsstack_dup(mvhist->redo, mvhist->src.buf, snap->src.buf)))
+	|| (mvhist->replay.stack && NULL == (snap->replay.stack
+		= gsstack_dup(mvhist->replay.stack, mvhist->src.buf, snap->src.buf)))
+	){
+		DBGF( "%s", "gsstack_dup() failed!" );
+		goto ret_failure;
+	}
+
+	/* the redo tail */
+	if ( mvhist->redotail.nplies > 0 ) {
+		snap->redotail.plies = malloc( mvhist->redotail.nplies * szply );
+		if ( NULL == snap->redotail.plies ) {
+			DBGF( "%s", "malloc(snap->redotail.plies) failed!" );
+			goto ret_failure;
+		}
+		memcpy(
+			snap->redotail.plies,
+			mvhist->redotail.plies,
+			mvhist->redotail.nplies * szply
+			);
+		snap->redotail.nplies = mvhist->redotail.nplies;
+		snap->redotail.next   = mvhist->redotail.next;
+	}
+
+	/* the branches */
+	if ( mvhist->nbranches > 0 ) {
+		snap->branches = _branches_dup( mvhist->branches, mvhist->nbranches );
+		if ( NULL == snap->branches ) {
+			DBGF( "%s", "_branches_dup() failed!" );
+			goto ret_failure;
+		}
+		snap->nbranches  = mvhist->nbranches;
+		snap->nbbranches = mvhist->nbbranches;
+	}
+
+	/* the archive */
+	snap->archive.budget = mvhist->archive.budget;
+	if ( mvhist->archive.nstates > 0 ) {
+		snap->archive.plies   = malloc( mvhist->archive.nstates * szply );
+		snap->archive.nextmvs = malloc( mvhist->archive.nstates );
+		if ( NULL == snap->archive.plies || NULL == snap->archive.nextmvs ) {
+			DBGF( "%s", "Out of memory!" );
+			goto ret_failure;
+		}
+		memcpy(
+			snap->archive.plies,
+			mvhist->archive.plies,
+			mvhist->archive.nstates * szply
+			);
+		memcpy(
+			snap->archive.nextmvs,
+			mvhist->archive.nextmvs,
+			mvhist->archive.nstates
+			);
+		snap->archive.nstates = mvhist->archive.nstates;
+	}
+	for (i=0; i < mvhist->archive.nkeys; i++) {
+		if ( !_archive_add_key(
+			snap,
+			mvhist->archive.keys[i].count,
+			mvhist->archive.keys[i].state
+			)
+		){
+			DBGF( "%s", "_archive_add_key() failed!" );
+			goto ret_failure;
+		}
+	}
+
+	return snap;
+
+ret_failure:
+	mvhist_free( snap );
+	return NULL;
+}
+
+/* --------------------------------------------------------------
+ * void _savejob_free():
+ *
+ * Release all resources occupied by the specified saving of a moves-
+ * -history object (job), but NOT the job itself.
+ * --------------------------------------------------------------
+ */
+static void _savejob_free( struct _savejob *job )
+{
+	mvhist_free( job->snap );
+	free( job->fname );
+	free( job->tmpname );
+	memset( job, 0, sizeof(*job) );
+}
+
+/* --------------------------------------------------------------
+ * int _savejob_init():
+ *
+ * Prepare in (job) the saving of the specified moves-history object
+ * (mvhist) to the specified file (fname). Return 0 (false) on error,
+ * 1 (true) otherwise.
+ *
+ * NOTE: The job refers to the object itself. To save it while it may
+ *       change (or be freed) its snapshot should be put in the job
+ *       instead (see mvhist_save_to_file_async()).
+ * --------------------------------------------------------------
+ */
+static int _savejob_init(
+	struct _savejob    *job,
+	const MovesHistory *mvhist,
+	const char         *fname
+	)
+{
+	memset( job, 0, sizeof(*job) );
+	job->mvhist  = mvhist;
+	job->fname   = printf_to_text( "%s", fname );
+	job->tmpname = printf_to_text( "%s.tmp", fname );
+	if ( NULL == job->fname || NULL == job->tmpname ) {
+		DBGF( "%s", "Out of memory!" );
+		_savejob_free( job );
+		return 0;  /* false */
+	}
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _savejob_run():
+ *
+ * Write the moves-history object (or the snapshot) of the specified
+ * saving (job) to its file. Return 0 (false) on error, 1 (true)
+ * otherwise.
+ *
+ * NOTES:
+ *
+ *    The binary format is used when the name of the file ends with
+ *    REPLAY_FNAME_EXT (defined in "common.h") and the current line
+ *    can be encoded as a series of moves (see _binline_encode()).
+ *    Otherwise, the text format of earlier versions is used.
+ *
+ *    The object is first written to a temporary file, committed to
+ *    the disk and then it replaces the file. So, a failed save does
+ *    not ruin an existing file, and the file that a loaded object keeps
+ *    mapped (see new_mvhist_from_file()) is never overwritten in place.
+ *
+ *    The function is the entry-point of background saves too (see the
+ *    function _savejob_work()), so it only reads the object.
+ * --------------------------------------------------------------
+ */
+static int _savejob_run( void *arg )
+{
+	int  ok, isbin = 0;
+	FILE *fp = NULL;
+	struct _binline bl;
+	struct _savejob *job = arg;
+	const MovesHistory *mvhist = job->mvhist;
+	const size_t len    = strlen( job->fname );
+	const size_t lenext = strlen( REPLAY_FNAME_EXT );
+
+	if ( len >= lenext
+	&& 0 == strcmp(job->fname + len - lenext, REPLAY_FNAME_EXT)
+	&& (NULL == mvhist->replay.stack
+	   || mvhist->replay.iseg > -1
+	   || gsstack_peek_count(mvhist->replay.stack)
+	      == gsstack_peek_count(mvhist->undo))
+	){
+		isbin = _binline_encode( &bl, mvhist );
+	}
+
+	fp = fopen( job->tmpname, "wb" );
+	if ( NULL == fp ) {
+		ok = 0;  /* false */
+		goto ret_cleanup;
+	}
+	setvbuf( fp, NULL, _IOFBF, _SAVE_SZBUF );
+
+	ok = isbin
+		? _bin_append_to_fp( mvhist, &bl, fp )
+		: _text_append_to_fp( mvhist, fp );
+	ok = ok && f_sync( fp );
+	if ( EOF == fclose(fp) ) {
+		ok = 0;  /* false */
+	}
+
+	/* replace the file (rename() does not overwrite on Windows) */
+	if ( ok
+	&& 0 != rename(job->tmpname, job->fname)
+	&& (0 != remove(job->fname) || 0 != rename(job->tmpname, job->fname))
+	){
+		ok = 0;  /* false */
+	}
+	if ( !ok ) {
+		remove( job->tmpname );
+	}
+
+ret_cleanup:
+	if ( isbin ) {
+		_binline_free( &bl );
+	}
+	return ok;
+}
+
+/* --------------------------------------------------------------
+ * (thread entry-point) int _savejob_work():
+ *
+ * Run the specified saving (arg) of a snapshot in a background thread
+ * (see _savejob_run()), and return its outcome.
+ *
+ * NOTE: The memory pool of the thread is released when done, since
+ *       everything that got allocated by it has been freed by then.
+ *       Errors are not reported in the background (see DBGF() in
+ *       "common.h").
+ * --------------------------------------------------------------
+ */
+static int _savejob_work( void *arg )
+{
+	const int ok = _savejob_run( arg );
+
+	pool_release();
+	return ok;
+}
+
+/* --------------------------------------------------------------
+ * long int mvhist_verify():
+ *
+ * Re-simulate the current line (undo + redo gsstacks, including any
+ * archived moves) of the specified moves-history object (mvhist),
+ * checking that every game-state follows from the previous one by its
+ * move plus the randomly generated tiles (see _verify_add()). Return
+ * the count of the 1st inconsistent game-state, 0 if there is none,
+ * or -1 on error.
+ *
+ * If the argument (nchecked) is not NULL, it is set to the count of the
+ * game-states that were found consistent. If the argument (reason) is
+ * not NULL, it is set to a short description of what is inconsistent
+ * (or to NULL, if there is nothing).
+ *
+ * The counts of empty tiles that get checked are the ones stored with
+ * the game-states (for text replay-files, the ones read from the file)
+ * against the tiles of their boards, not recounts of the tiles.
+ *
+ * NOTE: The branches of mvhist are not re-simulated. Since the function
+ *       does not modify mvhist, it may be called concurrently for
+ *       different moves-history objects (e.g. one per thread).
+ *
+ * NOTE: A binary replay-file stores only its 1st game-state along with
+ *       the moves & the generated tiles, not any later game-state, nor
+ *       any keyframe or final score (see _bin_load_line()). Its loader
+ *       derives every later game-state (scores, best-scores, winning
+ *       status & counts of empty tiles included) by replaying those
+ *       moves, so they follow from their moves by construction. Thus,
+ *       for such files this function checks the 1st game-state and that
+ *       every move & generated tile was possible, but it has nothing
+ *       stored to compare the derived scores against.
+ * --------------------------------------------------------------
+ */
+long int mvhist_verify(
+	const MovesHistory *mvhist,
+	long int           *nchecked,
+	const char         **reason
+	)
+{
+	long int ret = 0;
+	struct _verify v;
+
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)" );
+		return -1;
+	}
+
+	memset( &v, 0, sizeof(v) );
+	if ( !_line_walk(mvhist, _verify_add, &v) ) {
+		if ( NULL == v.reason ) {
+			DBGF( "%s", "_line_walk() failed!" );
+			ret = -1;
+		}
+		else {
+			ret = v.nstates + 1;
+		}
+	}
+
+	if ( nchecked ) {
+		*nchecked = v.nstates;
+	}
+	if ( reason ) {
+		*reason = v.reason;
+	}
+	gamestate_free( v.prev );
+	gamestate_free( v.scratch );
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_save_to_file():
+ *
+ * Serialize the specified moves-history object (mvhist) and write
+ * it to the specified file (fname). Return 0 (false) on error, 1
+ * (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    When fname ends with REPLAY_FNAME_EXT (defined in "common.h")
+ *    the compact binary format is used (see _bin_append_to_fp()),
+ *    which stores just the 1st game-state and then every move as a
+ *    couple of bits plus its generated tiles. Otherwise the object
+ *    is saved in the text format of earlier versions (see the func:
+ *    _text_append_to_fp()).
+ *
+ *    A current line which cannot be encoded as a series of moves
+ *    (e.g. one loaded from a hand-edited text file) is saved in the
+ *    text format, whatever the extension of fname is. Loading does
+ *    not depend on the extension either (see new_mvhist_from_file()).
+ *
+ *    The file is replaced atomically (see _savejob_run()). To save
+ *    without blocking the caller, see mvhist_save_to_file_async().
+ * --------------------------------------------------------------
+ */
+int mvhist_save_to_file( const MovesHistory *mvhist, const char *fname )
+{
+	int ok;
+	struct _savejob job;
+
+	if ( NULL == mvhist || NULL == fname ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+
+	if ( !_savejob_init(&job, mvhist, fname) ) {
+		return 0;  /* false */
+	}
+	ok = _savejob_run( &job );
+	if ( !ok ) {
+		DBGF( "Could not write to file %s", fname );
+	}
+	_savejob_free( &job );
+
+	return ok;
+}
+
+/* --------------------------------------------------------------
+ * int _asyncjob_collect():
+ *
+ * Wait for the save in the background (if any) to complete, release
+ * its resources, and return its outcome as one of the MVHIST_ASYNC_XXX
+ * constants (defined in "mvhist.h").
+ * --------------------------------------------------------------
+ */
+static int _asyncjob_collect( void )
+{
+	int ok;
+
+	if ( NULL == _asyncjob ) {
+		return MVHIST_ASYNC_NONE;
+	}
+
+	ok = _asyncjob->worker ? th_join( _asyncjob->worker ) : _asyncjob->ok;
+	_savejob_free( _asyncjob );
+	free( _asyncjob );
+	_asyncjob = NULL;
+
+	return ok ? MVHIST_ASYNC_SAVED : MVHIST_ASYNC_FAILED;
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_save_to_file_async():
+ *
+ * Start saving the specified moves-history object (mvhist) to the
+ * specified file (fname) in the background, and return immediately.
+ * Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    Only a snapshot of the object is taken by the caller (see the
+ *    function _mvhist_snapshot()), which copies its nodes & moves as
+ *    they are, so the object may keep changing, or even be freed,
+ *    while another thread encodes the snapshot and writes the file
+ *    (in either format, see mvhist_save_to_file()). The outcome is
+ *    reported later by mvhist_poll_async_save(), and it MUST be
+ *    collected (or waited for, via mvhist_wait_async_save()) at some
+ *    point, e.g. before the program exits.
+ *
+ *    At most one save runs in the background. If one is still in
+ *    progress, it is waited for first, and its outcome is superseded.
+ *
+ *    If there is no memory for the snapshot, or no thread can be
+ *    started (see th_start() in "common.c"), the object is saved
+ *    before the function returns. Its outcome is still reported by
+ *    mvhist_poll_async_save().
+ * --------------------------------------------------------------
+ */
+int mvhist_save_to_file_async( const MovesHistory *mvhist, const char *fname )
+{
+	struct _savejob *job = NULL;
+
+	if ( NULL == mvhist || NULL == fname ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+
+	_asyncjob_collect();
+
+	if ( NULL == (job = calloc(1, sizeof(*job))) ) {
+		DBGF( "%s", "calloc() failed!" );
+		return 0;  /* false */
+	}
+	if ( !_savejob_init(job, mvhist, fname) ) {
+		free( job );
+		return 0;  /* false */
+	}
+
+	/* the snapshot is saved in the background, else the object here */
+	job->snap = _mvhist_snapshot( mvhist );
+	if ( NULL != job->snap ) {
+		job->mvhist = job->snap;
+		job->worker = th_start( _savejob_work, job );
+	}
+	if ( NULL == job->worker ) {
+		job->ok = _savejob_run( job );
+	}
+	_asyncjob = job;
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_poll_async_save():
+ *
+ * Check, without blocking, the save started in the background by
+ * mvhist_save_to_file_async(). Return MVHIST_ASYNC_PENDING while it
+ * is in progress, and its outcome (MVHIST_ASYNC_SAVED or _FAILED)
+ * just once, when it completes. Return MVHIST_ASYNC_NONE otherwise.
+ * --------------------------------------------------------------
+ */
+int mvhist_poll_async_save( void )
+{
+	if ( _asyncjob && _asyncjob->worker && !th_isdone(_asyncjob->worker) ) {
+		return MVHIST_ASYNC_PENDING;
+	}
+	return _asyncjob_collect();
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_wait_async_save():
+ *
+ * Wait for the save started in the background by the function
+ * mvhist_save_to_file_async() to complete. Return its outcome
+ * (MVHIST_ASYNC_SAVED or _FAILED) or MVHIST_ASYNC_NONE if there
+ * is nothing to wait for (e.g. it has been already polled).
+ * --------------------------------------------------------------
+ */
+int mvhist_wait_async_save( void )
+{
+	return _asyncjob_collect();
+}
+
+/* --------------------------------------------------------------
+ * int _jnl_put_line():
+ *
+ * Append to the journal of the specified moves-history object (mvhist)
+ * a record for every game-state of its undo gsstack (including any
+ * archived ones) from the bottom up. Return 0 (false) on error, 1
+ * (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _jnl_put_line( MovesHistory *mvhist )
+{
+	long int     ikey;
+	GSNode       *seg = NULL;
+	GameState    *prev = NULL;
+	const GSNode *it  = NULL;
+
+	if ( NULL == mvhist->undo ) {
+		return 1;  /* true */
+	}
+	if ( NULL == (prev = new_gamestate(BOARD_DIM_4)) ) {
+		DBGF( "%s", "new_gamestate() failed!" );
+		return 0;  /* false */
+	}
+
+	/* archived game-states */
+	for (ikey=0; ikey < mvhist->archive.nkeys; ikey++)
+	{
+		if ( !_archive_decode_segment(mvhist, ikey, &seg) ) {
+			DBGF( "_archive_decode_segment(%ld) failed!", ikey );
+			goto ret_failure;
+		}
+		for (it = gsstack_iter_bottom(seg); it; it = gsstack_iter_up(it)) {
+			if ( !_jnl_put_state(
+				mvhist,
+				gsstack_iter_down(it) || ikey > 0 ? prev : NULL,
+				gsstack_peek_state(it),
+				0
+				)
+			){
+				goto ret_failure;
+			}
+			gamestate_copy( prev, gsstack_peek_state(it) );
+		}
+		gsstack_free( &seg );
+	}
+
+	/* resident undo nodes */
+	it = gsstack_iter_bottom( mvhist->undo );
+	for (; it; it = gsstack_iter_up(it)) {
+		if ( !_jnl_put_state(
+			mvhist,
+			gsstack_iter_down(it) || mvhist->archive.nstates > 0
+				? prev
+				: NULL,
+			gsstack_peek_state(it),
+			NULL == gsstack_iter_up(it)
+			)
+		){
+			goto ret_failure;
+		}
+		gamestate_copy( prev, gsstack_peek_state(it) );
+	}
+
+	gamestate_free( prev );
+	return 1;  /* true */
+
+ret_failure:
+	gsstack_free( &seg );
+	gamestate_free( prev );
+	return 0;  /* false */
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_journal_open():
+ *
+ * Create the specified file (fname) as the journal of the specified
+ * moves-history object (mvhist), and start journaling every change of
+ * its undo gsstack (see the section "Journal" in the comments at the
+ * top of this file). Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    The current line of the object (its undo gsstack) is written to
+ *    the journal first, so it is a complete record of the game so far.
+ *
+ *    An existing file is overwritten, and mvhist_reset() truncates it
+ *    again, when a new game starts.
+ * --------------------------------------------------------------
+ */
+int mvhist_journal_open( MovesHistory *mvhist, const char *fname )
+{
+	if ( NULL == mvhist || NULL == fname ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+	if ( NULL != mvhist->journal.fp ) {
+		DBGF( "Already journaling to: %s", mvhist->journal.fname );
+		return 0;  /* false */
+	}
+
+	mvhist->journal.fname   = printf_to_text( "%s", fname );
+	mvhist->journal.scratch = new_gamestate( BOARD_DIM_4 );
+	if ( NULL == mvhist->journal.fname || NULL == mvhist->journal.scratch ) {
+		DBGF( "%s", "Out of memory!" );
+		goto ret_failure;
+	}
+
+	mvhist->journal.fp = fopen( fname, "wb" );
+	if ( NULL == mvhist->journal.fp
+	|| 0 != setvbuf(mvhist->journal.fp, NULL, _IOFBF, _JNL_SZBUF)
+	){
+		DBGF( "Could not write to file %s", fname );
+		goto ret_failure;
+	}
+
+	if ( !_jnl_put_header(mvhist->journal.fp)
+	|| !_jnl_put_line(mvhist)
+	|| (mvhist->didundo
+	   && EOF == fputc(_JNL_DIDUNDO | (1 << 3), mvhist->journal.fp))
+	|| !f_sync(mvhist->journal.fp)
+	){
+		DBGF( "Could not write to file %s", fname );
+		goto ret_failure;
+	}
+
+	return 1;  /* true */
+
+ret_failure:
+	_jnl_stop( mvhist );
+	return 0;  /* false */
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_journal_close():
+ *
+ * Commit to the disk & close the journal of the specified moves-history
+ * object (mvhist), and stop journaling. If (fname) is not NULL, the
+ * journal becomes a replay-file by that name, otherwise it is deleted.
+ * Return 0 (false) on error, or if the object is not journaling. Return
+ * 1 (true) otherwise.
+ *
+ * NOTE: The journal is renamed, NOT re-serialized. It can be loaded
+ *       as is (see new_mvhist_from_file()).
+ * --------------------------------------------------------------
+ */
+int mvhist_journal_close( MovesHistory *mvhist, const char *fname )
+{
+	int  ok;
+	FILE *fp = NULL;
+
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;  /* false */
+	}
+	if ( NULL == (fp = mvhist->journal.fp) ) {
+		return 0;  /* false */
+	}
+
+	ok = f_sync( fp );
+	mvhist->journal.fp = NULL;
+	if ( EOF == fclose(fp) ) {
+		ok = 0;  /* false */
+	}
+
+	if ( NULL == fname ) {
+		remove( mvhist->journal.fname );
+	}
+	else if ( ok
+	&& 0 != rename(mvhist->journal.fname, fname)
+	&& (0 != remove(fname) || 0 != rename(mvhist->journal.fname, fname))
+	){
+		DBGF( "Could not rename %s to %s", mvhist->journal.fname, fname );
+		ok = 0;  /* false */
+	}
+
+	_jnl_stop( mvhist );
+	return ok;
+}
+
+/* --------------------------------------------------------------
+ * int mvhist_isjournaling():
+ *
+ * Return 1 (true) if the specified moves-history object (mvhist)
+ * has an open journal, 0 (false) otherwise, or on error.
+ * --------------------------------------------------------------
+ */
+int mvhist_isjournaling( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;  /* false */
+	}
+
+	return NULL != mvhist->journal.fp;
+}
+
+/* --------------------------------------------------------------
+ * long int mvhist_get_journal_nrecords():
+ *
+ * Return the count of records appended to the journal of the specified
+ * moves-history object (mvhist) since it got opened (or truncated by
+ * mvhist_reset()), that is without the current line that was written
+ * when it got opened. Return 0 if the object is not journaling, or on
+ * error.
+ * --------------------------------------------------------------
+ */
+long int mvhist_get_journal_nrecords( const MovesHistory *mvhist )
+{
+	if ( NULL == mvhist ) {
+		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+		return 0;
+	}
+
+	return mvhist->journal.fp ? mvhist->journal.nrecords : 0;
+}
+
+/* --------------------------------------------------------------
+ * const char *_text_skip_line():
+ *
+ * Return a pointer to the start of the text line following the one
+ * which the specified c-string (text) points into, or to its NUL
+ * terminating byte if there is no following line. Any eol convention
+ * is accepted ("\r\n", '\n' or '\r').
+ * --------------------------------------------------------------
+ */
+static inline const char *_text_skip_line( const char *text )
+{
+	while ( '\0' != *text && '\n' != *text && '\r' != *text ) {
+		text++;
+	}
+	if ( '\r' == *text ) {
+		text++;
+	}
+	if ( '\n' == *text ) {
+		text++;
+	}
+	return text;
+}
+
+/* --------------------------------------------------------------
+ * int _load_stack_from_text():
+ *
+ * De-serialize a gsstack from the text lines found at the start of the
+ * specified c-string (*text), pushing its nodes onto the specified
+ * gsstack (stack). On success, (*text) is advanced to the line following
+ * the gsstack. Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTES:
+ *
+ *    The lines are expected to be already serialized as gsstack
+ *    nodes (see gsstack_append_to_fp(), defined in "gs.c"). Their
+ *    total count is taken from the count of the 1st line, since it
+ *    is part of the serialization of a gsstack node to produce its
+ *    1-based count inside the stack as the first thing in its text.
+ *    An empty gsstack is serialized as the line: "NULL:\r\n"
+ *
+ *    The game-states are NOT decoded here. The lines are just scanned
+ *    for their structure (the descending counts, the ':' separators &
+ *    the line ends) and indexed (top node first). They are then pushed
+ *    in reverse order as lazy nodes pointing into the text (see the func
+ *    gsstack_push_lazy()), which thus MUST outlive the gsstack. Each
+ *    game-state gets decoded & validated the first time its node is
+ *    peeked, so a malformed one is reported then (mvhist_verify() thus
+ *    reports it for the whole file).
+ * --------------------------------------------------------------
+ */
+static int _load_stack_from_text( GSNode **stack, const char **text )
+{
+	long int   i, c, count = 0;   /* total number of lines to load */
+	const char *cp = *text;
+	const char **index = NULL;    /* serialized game-states, top first */
+
+	if ( 0 == strncmp(cp, "NULL:", 5) ) {
+		*text = _text_skip_line( cp );
+		return 1;  /* true */
+	}
+
+	/* every line takes at least 2 chars (its count & the ':') */
+	if ( NULL == s_parse_long(cp, &count) || count < 1
+	|| (unsigned long)count > strlen(cp) / 2
+	){
+		DBGF( "%s", "Failed to read the count of the top node" );
+		return 0;  /* false */
+	}
+	index = calloc( count, sizeof(*index) );
+	if ( NULL == index ) {
+		DBGF( "%s", "calloc(index) failed!" );
+		return 0;  /* false */
+	}
+
+	for (i=0; i < count; i++)
+	{
+		if ( NULL == (cp = s_parse_long(cp, &c)) || ':' != *cp
+		|| c != count - i
+		){
+			DBGF( "Failed to read the count of node %ld", i );
+			goto ret_failure;
+		}
+		index[i] = cp + 1;
+		cp = _text_skip_line( cp );
+	}
+
+	for (i = count-1; i > -1; i--) {
+		if ( !gsstack_push_lazy(stack, index[i]) ) {
+			DBGF( "%s", "gsstack_push_lazy() failed!" );
+			goto ret_failure;
+		}
+	}
+
+	free( index );
+	*text = cp;
+	return 1;  /* true */
+
+ret_failure:
+	free( index );
+	gsstack_free( stack );
+	return 0;
+}
+
+/* --------------------------------------------------------------
+ * int _load_branches_from_text():
+ *
+ * De-serialize as a count of branches the text line found at the start
+ * of the specified c-string (*text), and then load that many branches
+ * (along with their sub-branches) from the lines following it, into a
+ * newly created array. On success, the array and its length get back
+ * to the caller via the arguments (branches) and (n), and (*text) is
+ * advanced to the line following the branches.
+ *
+ * Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTE: The expected serialization is described in the comments of
+ *       the function: _branches_append_to_fp()
+ * --------------------------------------------------------------
+ */
+static int _load_branches_from_text(
+	struct _branch **branches,
+	int            *n,
+	const char     **text
+	)
+{
+	int  i, k, count, mvdir, bsup, nspawns, pos, val;
+	long int j;
+	const char *cp = *text;
+	struct _branch *br = NULL;
+
+	*branches = NULL;
+	*n = 0;
+
+	if ( NULL == (cp = s_parse_int(cp, &count)) || count < 0 ) {
+		DBGF( "%s", "Failed to read count of branches" );
+		return 0;  /* false */
+	}
+	cp = _text_skip_line( cp );
+	if ( 0 == count ) {
+		*text = cp;
+		return 1;  /* true */
+	}
+	*branches = calloc( count, sizeof(**branches) );
+	if ( NULL == *branches ) {
+		DBGF( "%s", "calloc() failed!" );
+		return 0;  /* false */
+	}
+	*n = count;
+
+	for (i=0; i < count; i++)
+	{
+		br = &(*branches)[i];
+
+		/* fork & nplies */
+		if ( NULL == (cp = s_parse_long(cp, &br->fork))
+		|| NULL == (cp = s_parse_long(cp, &br->nplies))
+		|| br->fork < 1
+		|| br->nplies < 1
+		){
+			DBGF( "Failed to read header of branch %d", i );
+			goto ret_failure;
+		}
+		cp = _text_skip_line( cp );
+		br->plies = calloc( br->nplies, sizeof(*br->plies) );
+		if ( NULL == br->plies ) {
+			DBGF( "%s", "calloc(br->plies) failed!" );
+			goto ret_failure;
+		}
+
+		/* plies */
+		for (j=0; j < br->nplies; j++) {
+			if ( NULL == (cp = s_parse_int(cp, &mvdir))
+			|| NULL == (cp = s_parse_int(cp, &bsup))
+			|| NULL == (cp = s_parse_int(cp, &nspawns))
+			|| nspawns < 0 || nspawns > _MAXSPAWNS
+			){
+				DBGF( "Failed to read move %ld of branch %d", j, i );
+				goto ret_failure;
+			}
+			br->plies[j].mvdir   = mvdir;
+			br->plies[j].bsup    = bsup;
+			br->plies[j].nspawns = nspawns;
+			for (k=0; k < nspawns; k++) {
+				if ( NULL == (cp = s_parse_int(cp, &pos))
+				|| NULL == (cp = s_parse_int(cp, &val))
+				|| pos < 0 || pos > UCHAR_MAX
+				|| val < 0 || val > UCHAR_MAX
+				){
+					DBGF( "Bad tile in move %ld of branch %d", j, i );
+					goto ret_failure;
+				}
+				br->plies[j].pos[k] = pos;
+				br->plies[j].val[k] = val;
+			}
+			cp = _text_skip_line( cp );
+		}
+
+		/* sub-branches */
+		if ( !_load_branches_from_text(&br->kids, &br->nkids, &cp) ) {
+			DBGF( "Failed to read sub-branches of branch %d", i );
+			goto ret_failure;
+		}
+	}
+
+	*text = cp;
+	return 1;  /* true */
+
+ret_failure:
+	_branches_free( *branches, *n );
+	*branches = NULL;
+	*n = 0;
+	return 0;  /* false */
+}
+
+/* --------------------------------------------------------------
+ * int _text_load():
+ *
+ * De-serialize the specified c-string (text), holding the contents of
+ * a whole file in the text format, into the specified, freshly created,
+ * moves-history object (mvh). Return 0 (false) on error, 1 (true)
+ * otherwise.
+ *
+ * NOTES: The expected serialization is described in the comments of
+ *        the function: _text_append_to_fp()
+ *
+ *        The nodes of all gsstacks are lazy, pointing into the text
+ *        (see _load_stack_from_text()).
+ * --------------------------------------------------------------
+ */
+static int _text_load( MovesHistory *mvh, const char *text )
+{
+	long int  delay;
+
+	/* didundo value */
+	if ( NULL == (text = s_parse_int(text, &mvh->didundo)) ) {
+		DBGF( "%s", "Failed to read mvh->didundo!" );
+		return 0;  /* false */
+	}
+	text = _text_skip_line( text );
+
+	/* the undo-stack & the redo-stack */
+	if ( !_load_stack_from_text(&mvh->undo, &text) ) {
+		DBGF( "%s", "_load_stack_from_text(undo) failed!" );
+		return 0;  /* false */
+	}
+	if ( !_load_stack_from_text(&mvh->redo, &text) ) {
+		DBGF( "%s", "_load_stack_from_text(redo) failed!" );
+		return 0;  /* false */
+	}
+
+	/* the replay struct, first the meta-data then the replay-stack */
+	if ( NULL == (text = s_parse_long(text, &delay))
+	|| NULL == (text = s_parse_long(text, &mvh->replay.nmoves))
+	|| NULL == (text = s_parse_long(text, &mvh->replay.itcount))
+	|| delay < 0
+	){
+		DBGF( "%s", "Failed to read replay meta-data!" );
+		return 0;  /* false */
+	}
+	mvh->replay.delay = delay;
+	text = _text_skip_line( text );
+	if ( !_load_stack_from_text(&mvh->replay.stack, &text) ) {
+		DBGF( "%s", "_load_stack_from_text(replay.stack) failed!" );
+		return 0;  /* false */
+	}
+
+	/* the branches (files of earlier versions have none) */
+	if ( '\0' != *text
+	&& !_load_branches_from_text(&mvh->branches, &mvh->nbranches, &text)
+	){
+		DBGF( "%s", "_load_branches_from_text() failed!" );
+		return 0;  /* false */
+	}
+	mvh->nbbranches = _branches_nbytes( mvh->branches, mvh->nbranches );
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _bin_get_byte():
+ *
+ * Read from the specified cursor (cur) a single byte, and pass it
+ * back to the caller via the argument (b). Return 0 (false) at the
+ * end of the data, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _bin_get_byte( struct _bincursor *cur, int *b )
+{
+	if ( cur->cp >= cur->end ) {
+		return 0;  /* false */
+	}
+	*b = *cur->cp++;
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _bin_get_varint():
+ *
+ * Read from the specified cursor (cur) a variable-length integer, as
+ * written by _bin_put_varint(), and pass it back to the caller via the
+ * argument (u). Return 0 (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _bin_get_varint( struct _bincursor *cur, unsigned long int *u )
+{
+	int b;
+	unsigned int shift = 0;
+
+	*u = 0;
+	do {
+		if ( !_bin_get_byte(cur, &b) || shift >= sizeof(*u) * CHAR_BIT ) {
+			return 0;  /* false */
+		}
+		*u |= (unsigned long int)(b & 0x7F) << shift;
+		shift += 7;
+	} while ( b & 0x80 );
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _bin_ply_decode():
+ *
+ * Decode via the specified decoder (rc) and adaptive models (model)
+ * a ply encoded by _bin_ply_encode(), into the specified one (ply),
+ * following the ply (prev) in its branch (NULL for the 1st one).
+ * Return 0 (false) on corrupted data, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _bin_ply_decode(
+	RcDecoder         *rc,
+	struct _binmodel  *model,
+	struct _ply       *ply,
+	const struct _ply *prev
+	)
+{
+	int k;
+
+	ply->mvdir = rcdec_tree(
+			rc,
+			model->brdirs[ prev ? (prev->mvdir & 0x07) : 0 ],
+			3
+			);
+	ply->bsup    = rcdec_bit( rc, &model->bsup[ prev && prev->bsup ] );
+	ply->nspawns = rcdec_tree( rc, model->nspawns, 2 );
+	if ( ply->nspawns > _MAXSPAWNS ) {
+		return 0;  /* false */
+	}
+	for (k=0; k < ply->nspawns; k++) {
+		ply->pos[k] = rcdec_tree( rc, model->pos, 8 );
+		ply->val[k] = rcdec_tree( rc, model->val, 8 );
+	}
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _bin_load_branch_tree():
+ *
+ * De-serialize from the specified cursor (cur) a count of branches,
+ * followed by that many branches (along with their sub-branches), into
+ * a newly created array. On success, the array and its length get back
+ * to the caller via the arguments (branches) and (n). Return 0 (false)
+ * on error, 1 (true) otherwise.
+ *
+ * NOTE: The plies are decoded via the specified decoder (rc) and its
+ *       adaptive models (model), or they are read from the cursor if
+ *       rc is NULL (_BIN_VERSION_1). The expected serialization is
+ *       described in the comments of _bin_branches_append_to_fp().
+ * --------------------------------------------------------------
+ */
+static int _bin_load_branch_tree(
+	struct _branch    **branches,
+	int               *n,
+	struct _bincursor *cur,
+	RcDecoder         *rc,
+	struct _binmodel  *model
+	)
+{
+	int  i, k, b, pos, val;
+	long int j;
+	unsigned long int count, fork, nplies;
+	struct _branch *br = NULL;
+
+	*branches = NULL;
+	*n = 0;
+
+	/* every branch takes at least 2 bytes (its fork & nplies) */
+	if ( !_bin_get_varint(cur, &count) || count > INT_MAX
+	|| count > (unsigned long)(cur->end - cur->cp) / 2
+	){
+		DBGF( "%s", "Failed to read count of branches" );
+		return 0;  /* false */
+	}
+	if ( 0 == count ) {
+		return 1;  /* true */
+	}
+	*branches = calloc( count, sizeof(**branches) );
+	if ( NULL == *branches ) {
+		DBGF( "%s", "calloc() failed!" );
+		return 0;  /* false */
+	}
+	*n = count;
+
+	for (i=0; i < *n; i++)
+	{
+		br = &(*branches)[i];
+
+		/* fork & nplies (see _BIN_MAXMOVESPERBYTE) */
+		if ( !_bin_get_varint(cur, &fork) || !_bin_get_varint(cur, &nplies)
+		|| fork < 1 || fork > LONG_MAX
+		|| nplies < 1
+		|| (NULL == rc && nplies > (unsigned long)(cur->end - cur->cp))
+		|| (NULL != rc && nplies / _BIN_MAXMOVESPERBYTE
+		                  > (unsigned long)(rc->end - rc->cp))
+		){
+			DBGF( "Failed to read header of branch %d", i );
+			goto ret_failure;
+		}
+		br->fork   = fork;
+		br->nplies = nplies;
+		br->plies  = calloc( br->nplies, sizeof(*br->plies) );
+		if ( NULL == br->plies ) {
+			DBGF( "%s", "calloc(br->plies) failed!" );
+			goto ret_failure;
+		}
+
+		/* plies */
+		for (j=0; j < br->nplies; j++) {
+			if ( NULL != rc ) {
+				if ( !_bin_ply_decode(
+					rc,
+					model,
+					&br->plies[j],
+					j > 0 ? &br->plies[j-1] : NULL
+					)
+				){
+					DBGF( "Failed to decode move %ld of branch %d", j, i );
+					goto ret_failure;
+				}
+				continue;
+			}
+			if ( !_bin_get_byte(cur, &b) || (b >> 4) > _MAXSPAWNS ) {
+				DBGF( "Failed to read move %ld of branch %d", j, i );
+				goto ret_failure;
+			}
+			br->plies[j].mvdir   = b & 0x07;
+			br->plies[j].bsup    = (b & 0x08) ? 1 : 0;
+			br->plies[j].nspawns = b >> 4;
+			for (k=0; k < br->plies[j].nspawns; k++) {
+				if ( !_bin_get_byte(cur, &pos)
+				|| !_bin_get_byte(cur, &val)
+				){
+					DBGF( "Bad tile in move %ld of branch %d", j, i );
+					goto ret_failure;
+				}
+				br->plies[j].pos[k] = pos;
+				br->plies[j].val[k] = val;
+			}
+		}
+
+		/* sub-branches */
+		if ( !_bin_load_branch_tree(&br->kids, &br->nkids, cur, rc, model) ) {
+			DBGF( "Failed to read sub-branches of branch %d", i );
+			goto ret_failure;
+		}
+	}
+
+	return 1;  /* true */
+
+ret_failure:
+	_branches_free( *branches, *n );
+	*branches = NULL;
+	*n = 0;
+	return 0;  /* false */
+}
+
+/* --------------------------------------------------------------
+ * int _bin_load_branches():
+ *
+ * De-serialize from the specified cursor (cur) the branches written by
+ * _bin_branches_append_to_fp() in the specified version of the binary
+ * format, into a newly created array. On success, the array and its
+ * length get back to the caller via the arguments (branches) and (n).
+ * Return 0 (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _bin_load_branches(
+	struct _branch    **branches,
+	int               *n,
+	struct _bincursor *cur,
+	int               version
+	)
 {
-	if ( NULL == mvhist ) {
-		DBGF( "%s", "NULL pointer argument (mvhist)!" );
+	unsigned long int size;
+	RcDecoder rc;
+	struct _binmodel model;
+
+	if ( _BIN_VERSION_1 == version ) {
+		return _bin_load_branch_tree( branches, n, cur, NULL, NULL );
+	}
+
+	*branches = NULL;
+	*n = 0;
+	if ( !_bin_get_varint(cur, &size)
+	|| size > (unsigned long)(cur->end - cur->cp)
+	){
+		DBGF( "%s", "Failed to read the compressed moves of branches" );
 		return 0;  /* false */
 	}
-	if ( NULL == fp ) {
-		DBGF( "%s", "NULL pointer argument (fp)!" );
+	if ( 0 == size ) {
+		if ( !_bin_get_varint(cur, &size) || 0 != size ) {
+			DBGF( "%s", "Failed to read count of branches" );
+			return 0;  /* false */
+		}
+		return 1;  /* true */
+	}
+	if ( !rcdec_init(&rc, cur->cp, cur->cp + size) ) {
+		DBGF( "%s", "Failed to read the compressed moves of branches" );
 		return 0;  /* false */
 	}
+	cur->cp += size;
+	_binmodel_init( &model );
 
-	/* mvhist->replay.delay
-	 * + mvhist->replay.nmoves
-	 * + mvhist->replay.itcount
-	 */
-	if ( fprintf(
-		fp,
-		"%lu %ld %ld\r\n",
-		mvhist->replay.delay,
-		mvhist->replay.nmoves,
-		mvhist->replay.itcount
-		) < 0
-	){
-		DBGF( "%s", "fprintf() failed!" );
+	if ( !_bin_load_branch_tree(branches, n, cur, &rc, &model) ) {
 		return 0;  /* false */
 	}
-
-	/* + mvhist->replay.stack */
-	if ( !gsstack_append_to_fp(mvhist->replay.stack, fp) ) {
-		DBGF( "%s", "gsstack_append_to_fp(mvhist->replay.stack) failed!" );
+	if ( NULL == rcdec_finish(&rc) ) {
+		DBGF( "%s", "The compressed moves of branches are truncated!" );
+		_branches_free( *branches, *n );
+		*branches = NULL;
+		*n = 0;
 		return 0;  /* false */
 	}
 
-	return 1;
+	return 1;  /* true */
 }
 
 /* --------------------------------------------------------------
- * int mvhist_save_to_file():
- *
- * Serialize the specified moves-history object (mvhist) and write
- * it to the specified text file (fname). Return 0 (false) on error,
- * 1 (true) otherwise.
- *
- * NOTES:
- *
- *    The serialization first produces a text line of the form:
- *    "didundo\r\n"
- *
- *    Then it produces a series of text-lines, each one corresponding
- *    to a serialized node of the undo gsstack of the object. If the
- *    undo gsstack is empty, then a single line is produced instead:
- *    "NULL:\r\n"
+ * int _bin_decode_spawns():
  *
- *    Next it produces a series of text-lines, each one corresponding
- *    to a serialized node of the redo gsstack of the object. If the
- *    redo gsstack is empty, then once again just one single line is
- *    produced instead:
- *    "NULL:\r\n"
+ * Decode from the specified range decoder (rc) and adaptive models
+ * (model) the tiles generated after the move of the specified ply,
+ * as encoded by _binline_add(), into that ply. The game-state (scratch)
+ * should hold the board right after the move (see _ply_nspawns()), and
+ * gets the tiles too. Return 0 (false) on corrupted data, 1 (true)
+ * otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _bin_decode_spawns(
+	RcDecoder        *rc,
+	struct _binmodel *model,
+	GameState        *scratch,
+	struct _ply      *ply
+	)
+{
+	int k, pos;
+	Board *board = gamestate_get_board( scratch );
+
+	for (k=0; k < ply->nspawns; k++) {
+		pos = _board_empty_at(
+			board,
+			rcdec_uniform( rc, board_get_nempty(board) )
+			);
+		if ( pos < 0 ) {
+			return 0;  /* false */
+		}
+		ply->pos[k] = pos;
+		ply->val[k] = rcdec_bit( rc, &model->vals[k] ) ? 4 : 2;
+		board_set_tile_value(
+			board,
+			pos / board_get_dim(board),
+			pos % board_get_dim(board),
+			ply->val[k]
+			);
+	}
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _bin_load_line():
  *
- *    Finally, it produces a text-line with the serialized meta-data
- *    of the replay nested structure of the object, followed by a series
- *    of lines, each one corresponding to a serialized node of the
- *    replay.stack. If the replay.stack is empty, then again just a
- *    single line gets produced instead: "NULL:\r\n"
+ * De-serialize from the specified cursor (cur) a current line, as
+ * written by _binline_append_to_fp() in the specified version of the
+ * binary format, and re-construct it into the undo & redo gsstacks of
+ * the specified moves-history object (mvh), which are expected to be
+ * empty. Return 0 (false) on error, 1 (true) otherwise.
  *
- *    For details about the exact serializations, see the functions:
- *    - replay_append_to_fp()
- *    - gsstack_append_to_fp()   (defined in the file: "gs.c") 
- *    - gamestate_append_to_fp() (defined in the file: "gs.c") 
- *    - board_append_to_fp()     (defined in the file: "board.c") 
+ * NOTE: Every game-state is re-constructed by replaying its move on
+ *       the previous one, and then putting the generated tiles on the
+ *       board. The undo gsstack is populated via _undo_push(), so the
+ *       memory budget is respected all along. The compressed moves
+ *       (or the packed directions, in _BIN_VERSION_1) are decoded in
+ *       place, while re-constructing.
  * --------------------------------------------------------------
  */
-int mvhist_save_to_file( const MovesHistory *mvhist, const char *fname )
+static int _bin_load_line(
+	MovesHistory      *mvh,
+	struct _bincursor *cur,
+	int               version
+	)
 {
-	FILE *fp  = NULL;
+	long int  c, i, nstates, itog = 0, inext = 0;
+	int       k, n, b, won, mvdir, nextmv, tracked = 1;
+	int       lastdir = GS_MVDIR_NONE;
+	unsigned long int nundo, nredo, ntoggles, nnexts, nspawns = 0, u;
+	const unsigned char *dirs = NULL;
+	RcDecoder       rc;
+	struct _binmodel model;
+	const char      *cp = NULL;
+	long int        *toggles = NULL;
+	struct _binnext *nexts = NULL;
+	GameState *work = NULL, *scratch = NULL;
+	GSNode    *redoline = NULL;
+	struct _ply ply;
 
-	if ( NULL == mvhist || NULL == fname ) {
-		DBGF( "%s", "NULL pointer argument!" );
+	if ( !_bin_get_varint(cur, &nundo) || !_bin_get_varint(cur, &nredo)
+	|| nundo > LONG_MAX / 2 || nredo > LONG_MAX / 2
+	|| (0 == nundo && 0 != nredo)
+	|| (nundo + nredo) / _BIN_MAXMOVESPERBYTE
+	   > (unsigned long)(cur->end - cur->cp)
+	){
+		DBGF( "%s", "Failed to read the counts of undo & redo!" );
 		return 0;  /* false */
 	}
-
-	fp = fopen( fname, "wb" );
-	if ( NULL == fp ) {
-		DBGF( "Could not write to file %s", fname );
-		return 0;  /* false */
+	if ( 0 == nundo ) {
+		return 1;  /* true */
 	}
+	nstates = nundo + nredo;
 
-	/* mvhist->didundo */
-	if ( fprintf(fp, "%d\r\n", mvhist->didundo) < 0 ) {
-		DBGF( "%s", "fprintf() failed!" );
+	/* the 1st game-state (the data are NUL-terminated, see f_read_all()) */
+	work    = new_gamestate( BOARD_DIM_4 );
+	scratch = new_gamestate( BOARD_DIM_4 );
+	if ( NULL == work || NULL == scratch ) {
+		DBGF( "%s", "new_gamestate() failed!" );
 		goto ret_failure;
 	}
+	cp = gamestate_parse_text( work, (const char *)cur->cp );
+	if ( NULL == cp || (const unsigned char *)cp > cur->end ) {
+		DBGF( "%s", "Failed to read the 1st game-state!" );
+		goto ret_failure;
+	}
+	cur->cp = (const unsigned char *) _text_skip_line( cp );
 
-	/* + mvhist->undo (stack) */
-	if ( !gsstack_append_to_fp(mvhist->undo, fp) ) {
-		DBGF( "%s", "gsstack_append_to_fp(mvhist->undo) failed!" );
+	/* best-score toggles & nextmv exceptions (a varint, plus a byte) */
+	if ( !_bin_get_varint(cur, &ntoggles) || ntoggles > (unsigned long)nstates
+	|| ntoggles > (unsigned long)(cur->end - cur->cp)
+	|| NULL == (toggles = calloc( ntoggles + 1, sizeof(*toggles) ))
+	){
+		DBGF( "%s", "Failed to read best-score toggles!" );
 		goto ret_failure;
 	}
-	
-	/* + mvhist->redo (stack) */
-	if ( !gsstack_append_to_fp(mvhist->redo, fp) ) {
-		DBGF( "%s", "gsstack_append_to_fp(mvhist->redo) failed!" );
+	for (i=0, c=0; i < (long)ntoggles; i++) {
+		if ( !_bin_get_varint(cur, &u) || u > (unsigned long)nstates ) {
+			DBGF( "%s", "Failed to read best-score toggles!" );
+			goto ret_failure;
+		}
+		toggles[i] = (c += u);
+	}
+	if ( !_bin_get_varint(cur, &nnexts) || nnexts > (unsigned long)nstates
+	|| nnexts > (unsigned long)(cur->end - cur->cp) / 2
+	|| NULL == (nexts = calloc( nnexts + 1, sizeof(*nexts) ))
+	){
+		DBGF( "%s", "Failed to read nextmv exceptions!" );
 		goto ret_failure;
 	}
+	for (i=0, c=0; i < (long)nnexts; i++) {
+		if ( !_bin_get_varint(cur, &u) || u > (unsigned long)nstates
+		|| !_bin_get_byte(cur, &b)
+		){
+			DBGF( "%s", "Failed to read nextmv exceptions!" );
+			goto ret_failure;
+		}
+		nexts[i].count = (c += u);
+		nexts[i].mvdir = b;
+	}
 
-	/* + mvhist->replay */
-	if ( !_replay_append_to_fp(mvhist, fp) ) {
-		DBGF( "%s", "_replay_append_to_fp() failed!" );
+	/* compressed moves (or directions & count of generated tiles) */
+	if ( _BIN_VERSION_1 != version ) {
+		if ( !_bin_get_varint(cur, &u)
+		|| u > (unsigned long)(cur->end - cur->cp)
+		|| (unsigned long)(nstates - 1) / _BIN_MAXMOVESPERBYTE > u
+		|| !rcdec_init( &rc, cur->cp, cur->cp + u )
+		){
+			DBGF( "%s", "Failed to read the compressed moves!" );
+			goto ret_failure;
+		}
+		cur->cp += u;
+		_binmodel_init( &model );
+	}
+	else {
+		dirs = cur->cp;
+		if ( (nstates + 2) / 4 > cur->end - cur->cp ) {
+			DBGF( "%s", "Failed to read the directions of the moves!" );
+			goto ret_failure;
+		}
+		cur->cp += (nstates + 2) / 4;
+		if ( !_bin_get_varint(cur, &nspawns)
+		|| nspawns > (unsigned long)(cur->end - cur->cp)
+		){
+			DBGF( "%s", "Failed to read the count of generated tiles!" );
+			goto ret_failure;
+		}
+	}
+
+	/* re-construct the line, moves are decoded as needed */
+	for (c=1; ; c++)
+	{
+		mvdir = GS_MVDIR_NONE;
+		if ( c < nstates && _BIN_VERSION_1 != version ) {
+			mvdir = lastdir = 1 + rcdec_tree( &rc, model.dirs[lastdir], 2 );
+		}
+		else if ( c < nstates ) {
+			mvdir = 1 + ((dirs[(c-1) / 4] >> (2 * ((c-1) % 4))) & 0x03);
+		}
+
+		nextmv = mvdir;
+		if ( inext < (long)nnexts && nexts[inext].count == c ) {
+			nextmv = nexts[ inext++ ].mvdir;
+		}
+		gamestate_set_nextmove( work, nextmv );
+
+		if ( c <= (long)nundo ) {
+			if ( !_undo_push(mvh, work) ) {
+				DBGF( "%s", "_undo_push() failed!" );
+				goto ret_failure;
+			}
+		}
+		else if ( !gsstack_push(&redoline, work) ) {
+			DBGF( "%s", "gsstack_push() failed!" );
+			goto ret_failure;
+		}
+		if ( c == nstates ) {
+			break;
+		}
+
+		/* game-state c+1 */
+		n = _ply_nspawns( work, mvdir, scratch, &won );
+		if ( n < 0
+		|| (_BIN_VERSION_1 == version && (unsigned long)n > nspawns)
+		){
+			DBGF( "Move %ld cannot be replayed!", c );
+			goto ret_failure;
+		}
+		memset( &ply, 0, sizeof(ply) );
+		ply.mvdir   = mvdir;
+		ply.nspawns = n;
+		if ( _BIN_VERSION_1 == version ) {
+			nspawns -= n;
+			for (k=0; k < n; k++) {
+				if ( !_bin_get_byte(cur, &b) ) {
+					DBGF( "The tiles of move %ld are truncated!", c );
+					goto ret_failure;
+				}
+				ply.pos[k] = b & 0x3F;
+				ply.val[k] = (b & 0x40) ? 4 : 2;
+			}
+		}
+		else if ( !_bin_decode_spawns(&rc, &model, scratch, &ply) ) {
+			DBGF( "Move %ld cannot be replayed!", c );
+			goto ret_failure;
+		}
+		if ( itog < (long)ntoggles && toggles[itog] == c ) {
+			tracked = !tracked;
+			itog++;
+		}
+		ply.bsup = tracked
+			&& gamestate_get_score(scratch) > gamestate_get_bestscore(work);
+
+		if ( !_ply_apply(work, &ply) ) {
+			DBGF( "_ply_apply(%ld) failed!", c );
+			goto ret_failure;
+		}
+	}
+
+	if ( _BIN_VERSION_1 != version && NULL == rcdec_finish(&rc) ) {
+		DBGF( "%s", "The compressed moves are truncated!" );
 		goto ret_failure;
 	}
 
-	fclose( fp );
+	/* redo pops the 1st move after the undo top first */
+	gsstack_reverse( &redoline );
+	mvh->redo = redoline;
+
+	free( nexts );
+	free( toggles );
+	gamestate_free( scratch );
+	gamestate_free( work );
 	return 1;  /* true */
 
 ret_failure:
-	fclose( fp );
+	gsstack_free( &redoline );
+	free( nexts );
+	free( toggles );
+	gamestate_free( scratch );
+	gamestate_free( work );
 	return 0;  /* false */
 }
 
 /* --------------------------------------------------------------
- * int _load_stack_from_line_plus_fp_lines():
+ * int _bin_load():
  *
- * Given a gsstack (stack), a text file pointer (fp) and a c-string
- * (line) with size at least (lnsize) including the NUL terminating
- * byte, de-serialize as a node the line, along with required file
- * lines after fp, while pushing them onto the stack. Reverse the
- * loaded stack before handing it back to the caller.
+ * De-serialize from the specified cursor (cur), positioned right after
+ * the _BIN_MAGIC signature, the contents of a moves-history object, and
+ * load them into the specified, freshly created, object (mvh). Return
+ * 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTE: The expected serialization is described in the comments of
+ *       the function: _bin_append_to_fp()
+ * --------------------------------------------------------------
+ */
+static int _bin_load( MovesHistory *mvh, struct _bincursor *cur )
+{
+	int version;
+	unsigned long int didundo, nmoves, itcount, hasreplay;
+
+	if ( !_bin_get_byte(cur, &version)
+	|| (_BIN_VERSION != version && _BIN_VERSION_1 != version)
+	){
+		DBGF( "%s", "Unsupported version of the binary format!" );
+		return 0;  /* false */
+	}
+	if ( !_bin_get_varint( cur, &didundo )
+	|| !_bin_get_varint( cur, &mvh->replay.delay )
+	|| !_bin_get_varint( cur, &nmoves )
+	|| !_bin_get_varint( cur, &itcount )
+	|| !_bin_get_varint( cur, &hasreplay )
+	){
+		DBGF( "%s", "Failed to read header!" );
+		return 0;  /* false */
+	}
+	mvh->didundo        = (0 != didundo);
+	mvh->replay.nmoves  = nmoves;
+	mvh->replay.itcount = itcount;
+
+	if ( !_bin_load_line(mvh, cur, version) ) {
+		DBGF( "%s", "_bin_load_line() failed!" );
+		return 0;  /* false */
+	}
+
+	/* the replay.stack is a window over the reversed undo gsstack */
+	if ( hasreplay && mvh->undo && !_replay_rebuild(mvh) ) {
+		DBGF( "%s", "Failed to re-construct replay.stack!" );
+		return 0;  /* false */
+	}
+
+	if ( !_bin_load_branches(&mvh->branches, &mvh->nbranches, cur, version) ) {
+		DBGF( "%s", "_bin_load_branches() failed!" );
+		return 0;  /* false */
+	}
+	mvh->nbbranches = _branches_nbytes( mvh->branches, mvh->nbranches );
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _jnl_push():
  *
+ * Push the specified game-state (state) loaded from a journal onto
+ * the undo gsstack of the specified moves-history object (mvh), and
+ * set the nextmv of the game-state under it to the specified one
+ * (nextmv), or to the prevmv of the game-state if (nextmv) is -1.
  * Return 0 (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _jnl_push(
+	MovesHistory    *mvh,
+	const GameState *state,
+	int             nextmv
+	)
+{
+	if ( mvh->undo
+	&& !gsstack_set_nextmove(
+		mvh->undo,
+		-1 == nextmv ? gamestate_get_prevmove( state ) : nextmv
+		)
+	){
+		DBGF( "%s", "gsstack_set_nextmove() failed!" );
+		return 0;  /* false */
+	}
+	return _undo_push( mvh, state );
+}
+
+/* --------------------------------------------------------------
+ * int _jnl_load():
  *
- * NOTES (IMPORTANT!):
+ * De-serialize from the specified cursor (cur), positioned right after
+ * the _JNL_MAGIC signature, the records of a journal and replay them
+ * into the specified, freshly created, object (mvh). Return 0 (false)
+ * on error, 1 (true) otherwise.
  *
- * 1. All pointer arguments of the function MUST be non-NULL and valid.
- * 2. The initial line and subsequent file lines MUST be already properly
- *    serialized as gsstack nodes.
- * 3. The initial line should have been already read from the file before
- *    being passed as an argument to this function. Thus, within the file,
- *    (fp) MUST initially point to the start of the NEXT line to be read
- *    (that is, excluding the line passed as an argument to the function).
- * 4. lnsize MUST be large enough to hold the LARGEST line in the file
- *    (including the NUL terminating byte).
- *
- * When ALL the above are true, the function knows how many lines to
- * read from the file while populating the stack, because their total
- * count is already stored in the beginning of the initial line that
- * has been passed as an argument to the function.
- *
- * It is part of the serialization of a gsstack node, to produce its
- * 1-based count inside the stack as the first thing in its serialized
- * text.
- * --------------------------------------------------------------
- */
-static inline int _load_stack_from_line_plus_fp_lines(
-	GSNode       **stack,
-	char         *line,
-	size_t       lnsize,
-	FILE         *fp
-	)
+ * NOTES:
+ *
+ *    The records are described in the comments of the functions:
+ *    _jnl_put_state(), _undo_pop() and _didundo_set()
+ *
+ *    Loading stops at the 1st record that is incomplete or invalid,
+ *    which is expected after a crash. It fails only if not even the
+ *    1st game-state could be loaded.
+ *
+ *    The replay.stack is re-constructed too, like for binary files.
+ * --------------------------------------------------------------
+ */
+static int _jnl_load( MovesHistory *mvh, struct _bincursor *cur )
 {
-	long int i = 0;
-	long int count;          /* total number of lines to load */
-	GSNode *revstack = NULL; /* reversed stack */
-	GSNode *node     = NULL; /* temporary node */
+	int b, op, k, version, nspawns, nextmv, topnext = -1;
+	const char *cp = NULL;
+	GameState  *work = NULL;
+	struct _ply ply;
 
-	if ( 0 == strcmp(line, "NULL:\n") ) {
-		return 1;  /* true */
+	/* version 1 had no _JNL_NEXTMV records */
+	if ( !_bin_get_byte(cur, &version)
+	|| version < 1 || version > _JNL_VERSION
+	){
+		DBGF( "%s", "Unsupported version of the journal format!" );
+		return 0;  /* false */
 	}
-
-	if ( sscanf(line, "%ld", &count) < 1 ) {
-		DBGF( "%s", "sscanf() failed to read count of lines" );
-		goto ret_failure;
+	if ( NULL == (work = new_gamestate(BOARD_DIM_4)) ) {
+		DBGF( "%s", "new_gamestate() failed!" );
+		return 0;  /* false */
 	}
-	for (i=0; i < count; i++) {
-		node = new_gsnode_from_text( line );
-		if (
-		!gsstack_push( stack, gsstack_peek_state(node) )
-		){
-			DBGF("%s", "gsstack_push() failed!");
-			free( node );
-			goto ret_failure;
+
+	while ( _bin_get_byte(cur, &op) )
+	{
+		/* a full game-state, as a text line */
+		if ( _JNL_KEY == op ) {
+			/* a torn line might still parse, so it must be complete */
+			if ( NULL == memchr(cur->cp, '\n', cur->end - cur->cp)
+			|| NULL == (cp = gamestate_parse_text(work, (const char *)cur->cp))
+			){
+				break;
+			}
+			cur->cp = (const unsigned char *) _text_skip_line( cp );
 		}
-		free( node );
 
-		if ( i == count-1 ) {
-			break;
+		/* an undo (the 1st game-state of the game is never undone) */
+		else if ( _JNL_POP == op ) {
+			if ( gsstack_peek_count(mvh->undo) < 2 ) {
+				break;
+			}
+			_undo_pop( mvh );
+			continue;
 		}
-		if ( NULL == fgets(line, lnsize, fp) ) {
-			DBGF( "%s", "fgets() failed while reading stack!" );
-			goto ret_failure;
+
+		/* didundo */
+		else if ( _JNL_DIDUNDO == (op & 0x07) ) {
+			mvh->didundo = (0 != (op & 0x08));
+			continue;
 		}
-		s_fixeol( line );
+
+		/* the nextmv of the top game-state, if not implied */
+		else if ( _JNL_NEXTMV == (op & 0x07) ) {
+			topnext = (op >> 3) & 0x07;
+			if ( topnext > GS_MVDIR_RIGHT ) {
+				break;
+			}
+			continue;
+		}
+
+		/* a move, played on the top game-state */
+		else {
+			memset( &ply, 0, sizeof(ply) );
+			ply.mvdir = op & 0x07;
+			ply.bsup  = (0 != (op & 0x08));
+			nspawns   = (op >> 4) & 0x03;
+			if ( NULL == mvh->undo
+			|| ply.mvdir < GS_MVDIR_UP || ply.mvdir > GS_MVDIR_RIGHT
+			|| nspawns > _MAXSPAWNS
+			){
+				break;
+			}
+			for (k=0; k < nspawns && _bin_get_byte(cur, &b); k++) {
+				ply.pos[k] = b & 0x3F;
+				ply.val[k] = (b & 0x40) ? 4 : 2;
+			}
+			ply.nspawns = k;
+			nextmv = GS_MVDIR_NONE;
+			if ( k < nspawns
+			|| (0 != (op & 0x40) && !_bin_get_byte(cur, &nextmv))
+			){
+				break;
+			}
+			gamestate_copy( work, gsstack_peek_state(mvh->undo) );
+			if ( !_ply_apply(work, &ply) ) {
+				break;
+			}
+			gamestate_set_nextmove( work, nextmv );
+		}
+
+		if ( !_jnl_push(mvh, work, topnext) ) {
+			DBGF( "%s", "_jnl_push() failed!" );
+			break;
+		}
+		topnext = -1;
 	}
+	gamestate_free( work );
 
-	/* reverse the loaded stack */
-	revstack = gsstack_dup_reversed( *stack );
-	if ( NULL == revstack ) {
-		DBGF( "%s", "gsstack_dup_reversed() failed!" );
-		goto ret_failure;
+	if ( NULL == mvh->undo ) {
+		DBGF( "%s", "No game-state found in the journal!" );
+		return 0;  /* false */
 	}
-	gsstack_free( stack );
-	*stack = revstack;
 
-	return 1;  /* true */
+	/* the replay.stack is a window over the reversed undo gsstack */
+	if ( !_replay_rebuild(mvh) ) {
+		DBGF( "%s", "Failed to re-construct replay.stack!" );
+		return 0;  /* false */
+	}
 
-ret_failure:
-	free( node );
-	gsstack_free( stack );
-	return 0;
+	return 1;  /* true */
 }
 
 /* --------------------------------------------------------------
  * MovesHist *new_mvhist_from_file():
  *
- * De-serialize the contents of the specified text file (fname)
+ * De-serialize the contents of the specified file (fname)
  * and load them into a newly created moves-histtoy object.
  * Return a pointer to the newly created object, or NULL on error.
  *
- * NOTE: The contents of the text file are expected to be already
- *       serialized, as described in the comments of the function:
- *       mvhist_save_to_file()
+ * NOTES:
+ *
+ *    The contents of the file are expected to be already
+ *    serialized, as described in the comments of the function:
+ *    mvhist_save_to_file(). The binary format and journals (see
+ *    mvhist_journal_open()) are recognized by their leading signatures,
+ *    otherwise the text format of earlier versions is assumed.
+ *
+ *    The whole file is memory-mapped (or read into memory at once,
+ *    where mapping is not possible, see f_map_all() in "common.c")
+ *    and then parsed in place in a single pass (see the functions
+ *    _text_load(), _bin_load() and _jnl_load()).
+ *
+ *    Files in the text format are merely indexed: their game-states
+ *    are decoded lazily, as the nodes get peeked (e.g. by a replay
+ *    iterator). So, their contents are kept in the object until its
+ *    gsstacks are freed (see _src_release()), and they are NOT subject
+ *    to the memory budget until moves get played on top of them.
+ *    The file should NOT be overwritten in place while the object
+ *    is alive (mvhist_save_to_file() replaces files instead).
  * --------------------------------------------------------------
  */
-#define MAX_LNSIZE  1024
 MovesHistory *new_mvhist_from_file( const char *fname )
 {
-	FILE *fp = NULL;
-	char line[MAX_LNSIZE] = {'\0'};  /* for reading single lines from file */
 	MovesHistory *mvh = NULL;
+	struct _bincursor cur;
 
 	if ( NULL == fname ) {
 		DBGF( "%s", "NULL pointer argument (fname)!" );
 		return NULL;
 	}
 
-	fp = fopen( fname, "r" );
-	if ( NULL == fp ) {
-		DBGF( "Could not read from file: %s", fname );
-		return NULL;
-	}
-
 	mvh = new_mvhist();
 	if ( NULL == mvh ) {
 		DBGF( "%s", "mvh = new_mvhist() failed!" );
-		goto ret_failure;
+		return NULL;
 	}
 
-	/* read didundo value */
-	if ( NULL == fgets(line, MAX_LNSIZE, fp) ) {
-		DBGF( "%s", "fgets() failed to read mvh->didundo line!" );
-		goto ret_failure;
+	mvh->src.buf = f_map_all( fname, &mvh->src.size );
+	mvh->src.mapped = (NULL != mvh->src.buf);
+	if ( !mvh->src.mapped ) {
+		mvh->src.buf = f_read_all( fname, &mvh->src.size );
 	}
-	s_fixeol( line );
-
-	if ( sscanf(line, "%d", &mvh->didundo) < 1 ) {
-		DBGF( "%s", "sscanf(&mvh->didundo) failed!" );
+	if ( NULL == mvh->src.buf ) {
+		DBGF( "Could not read from file: %s", fname );
 		goto ret_failure;
 	}
 
-	/*
-	 * read the undo-stack
-	*/
-	if ( NULL == fgets(line, MAX_LNSIZE, fp) ) {
-		DBGF( "%s", "fgets() failed to read undo-stack line" );
-		goto ret_failure;
-	}
-	s_fixeol( line );
-	if ( !_load_stack_from_line_plus_fp_lines(
-		&mvh->undo,
-		line,
-		MAX_LNSIZE,
-		fp
-		)
+	/* files in the binary format start with a signature */
+	if ( mvh->src.size >= _SZBIN_MAGIC
+	&& 0 == memcmp(mvh->src.buf, _BIN_MAGIC, _SZBIN_MAGIC)
 	){
-		DBGF(
-		    "%s",
-		    "_load_stack_from_line_plus_fp_lines(undo) failed!"
-		    );
-		goto ret_failure;
-	}
+		cur.cp  = (const unsigned char *) mvh->src.buf + _SZBIN_MAGIC;
+		cur.end = (const unsigned char *) mvh->src.buf + mvh->src.size;
+		if ( !_bin_load(mvh, &cur) ) {
+			DBGF( "%s", "_bin_load() failed!" );
+			goto ret_failure;
+		}
 
-	/*
-	 * read the redo-stack
-	 */
-	if ( NULL == fgets(line, MAX_LNSIZE, fp) ) {
-		DBGF( "%s", "fgets() failed to read redo-stack line" );
-		goto ret_failure;
-	}
-	s_fixeol( line );
-	if ( !_load_stack_from_line_plus_fp_lines(
-		&mvh->redo,
-		line,
-		MAX_LNSIZE,
-		fp
-		)
-	){
-		DBGF(
-		    "%s",
-		    "_load_stack_from_line_plus_fp_lines(redo) failed"
-		    );
-		goto ret_failure;
+		/* its nodes are fully decoded, so respect the budget */
+		_src_release( mvh );
+		_mem_track( mvh );
+		if ( !_archive_compact(mvh) ) {
+			DBGF( "%s", "_archive_compact() failed!" );
+		}
 	}
 
-	/*
-	 * read the replay struct
-	 */
-
-	/* first the meta-data */
-	if ( NULL == fgets(line, MAX_LNSIZE, fp) ) {
-		DBGF( "%s", "fgets() failed to read mvh->redo" );
-		goto ret_failure;
-	}
-	s_fixeol( line );
-	if ( sscanf(
-		line,
-		"%lu %ld %ld",
-		&mvh->replay.delay,
-		&mvh->replay.nmoves,
-		&mvh->replay.itcount
-		) < 3
+	/* and so do journals */
+	else if ( mvh->src.size >= _SZJNL_MAGIC
+	&& 0 == memcmp(mvh->src.buf, _JNL_MAGIC, _SZJNL_MAGIC)
 	){
-		DBGF( "%s", "sscanf() failed to read replay meta-data!" );
-		goto ret_failure;
-	}
-	/* then the replay-stack */
-	if ( NULL == fgets(line, MAX_LNSIZE, fp) ) {
-		DBGF( "%s", "fgets() failed to read redo-stack node" );
-		goto ret_failure;
+		cur.cp  = (const unsigned char *) mvh->src.buf + _SZJNL_MAGIC;
+		cur.end = (const unsigned char *) mvh->src.buf + mvh->src.size;
+		if ( !_jnl_load(mvh, &cur) ) {
+			DBGF( "%s", "_jnl_load() failed!" );
+			goto ret_failure;
+		}
+		_src_release( mvh );
+		_mem_track( mvh );
 	}
-	s_fixeol( line );
-	if (
-	!_load_stack_from_line_plus_fp_lines(
-		&mvh->replay.stack,
-		line,
-		MAX_LNSIZE,
-		fp
-		)
-	){
-		DBGF(
-		  "%s",
-		  "_load_stack_from_line_plus_fp_lines(replay.stack) failed"
-		  );
-		goto ret_failure;
+	else {
+		if ( !_text_load(mvh, mvh->src.buf) ) {
+			DBGF( "%s", "_text_load() failed!" );
+			goto ret_failure;
+		}
+		_mem_track( mvh );
 	}
 
-	fclose( fp );
-
 	return mvh;
 
 ret_failure:
-	fclose( fp );
-	free( mvh );
+	mvhist_free( mvh );
 	return NULL;
 }
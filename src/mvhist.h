@@ -21,6 +21,24 @@
 /* The "class" is forward-declared as an opaque data-type */
 typedef struct _MovesHistory MovesHistory;
 
+/* Default memory budget (in bytes) of the resident undo nodes */
+#define MVHIST_DEF_BUDGET  (1024 * 1024)
+
+enum {  /* Categories of memory accounting (see mvhist_get_nbytes()) */
+	MVHIST_MEM_UNDO = 0,  /* undo stack, including its archive */
+	MVHIST_MEM_REDO,      /* redo stack */
+	MVHIST_MEM_REPLAY,    /* replay stack */
+	MVHIST_MEM_BRANCHES,  /* branches, including sub-branches */
+	MVHIST_MEM_TOTAL      /* all of the above */
+};
+
+enum {  /* Outcomes of background saving (see mvhist_poll_async_save()) */
+	MVHIST_ASYNC_NONE = 0,/* no save has been started */
+	MVHIST_ASYNC_PENDING, /* a save is in progress */
+	MVHIST_ASYNC_SAVED,   /* the last save completed successfully */
+	MVHIST_ASYNC_FAILED   /* the last save failed */
+};
+
 #ifndef MVHIST_C
 extern MovesHistory  *new_mvhist( void );
 extern MovesHistory  *mvhist_free( MovesHistory *mvhist );
@@ -30,6 +48,13 @@ extern int mvhist_reset( MovesHistory *mvhist );
 extern int mvhist_get_didundo( const MovesHistory *mvhist );
 extern int mvhist_set_didundo( MovesHistory *mvhist, int didundo );
 
+extern size_t   mvhist_get_budget( const MovesHistory *mvhist );
+extern int      mvhist_set_budget( MovesHistory *mvhist, size_t nbytes );
+extern long int mvhist_get_narchived( const MovesHistory *mvhist );
+
+extern size_t   mvhist_get_nbytes( const MovesHistory *mvhist, int which );
+extern size_t   mvhist_get_nbpeak( const MovesHistory *mvhist, int which );
+
 /* undo stack */
 
 extern int              mvhist_isempty_undo_stack( const MovesHistory *mvhist );
@@ -61,6 +86,24 @@ extern const GameState  *mvhist_peek_redo_stack_state(
                                 );
 extern int              mvhist_pop_redo_stack( MovesHistory *mvhist );
 
+/* branches */
+
+extern int              mvhist_fork_redo_stack( MovesHistory *mvhist );
+extern int              mvhist_count_branches( const MovesHistory *mvhist );
+extern long int         mvhist_peek_branch_fork(
+                                const MovesHistory *mvhist,
+                                int                ibranch
+                                );
+extern long int         mvhist_peek_branch_nmoves(
+                                const MovesHistory *mvhist,
+                                int                ibranch
+                                );
+extern int              mvhist_switch_branch(
+                                MovesHistory *mvhist,
+                                int          ibranch,
+                                GameState    *gs
+                                );
+
 /* replay */
 
 extern GSNode           *mvhist_init_replay(
@@ -102,12 +145,38 @@ extern long int          mvhist_get_replay_itcount(
                                const MovesHistory *mvhist
                                );
 
+extern long int          mvhist_verify(
+                               const MovesHistory *mvhist,
+                               long int           *nchecked,
+                               const char         **reason
+                               );
+
 extern int               mvhist_save_to_file(
                                const MovesHistory *mvhist,
                                const char         *fname
                                );
 extern MovesHistory      *new_mvhist_from_file( const char *fname );
 
+extern int               mvhist_save_to_file_async(
+                               const MovesHistory *mvhist,
+                               const char         *fname
+                               );
+extern int               mvhist_poll_async_save( void );
+extern int               mvhist_wait_async_save( void );
+
+extern int               mvhist_journal_open(
+                               MovesHistory *mvhist,
+                               const char   *fname
+                               );
+extern int               mvhist_journal_close(
+                               MovesHistory *mvhist,
+                               const char   *fname
+                               );
+extern int               mvhist_isjournaling( const MovesHistory *mvhist );
+extern long int          mvhist_get_journal_nrecords(
+                               const MovesHistory *mvhist
+                               );
+
 #endif
 
 #endif
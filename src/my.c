@@ -23,6 +23,16 @@
 
 #define MY_C
 
+/* Custom streams, for the headless output sinks (see my_output_sink()) */
+#if defined(__linux__) || defined(__linux) || defined(__gnu_linux__)   \
+|| defined(__CYGWIN__)
+	#define _GNU_SOURCE     /* fopencookie() */
+	#define _MY_HAS_FOPENCOOKIE
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) \
+|| defined(__OpenBSD__) || defined(__DragonFly__)
+	#define _MY_HAS_FUNOPEN
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -30,123 +40,344 @@
 
 #include "my.h"
 
+#define _SZ_SINKBUF     (64 * 1024)  /* buffer of a headless output sink */
+#define _SINK_W         80  /* console size reported when headless */
+#define _SINK_H         24
+
+/* Where the standard output goes (see my_output_sink()) */
+static struct {
+	int             kind;     /* MY_SINK_XXX */
+	FILE            *term;    /* the original stdout (or NULL) */
+	FILE            *fp;      /* the stream of the headless sinks */
+	unsigned long   nbytes;   /* # of bytes written to it */
+	unsigned long   nwrites;  /* # of writes done to it */
+	char            *mem;     /* what was written to MY_SINK_MEMORY */
+	size_t          szmem;    /* # of bytes in mem */
+	size_t          capacity; /* # of bytes reserved for mem */
+} _sink;
+
+#if defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
+#include <errno.h>
+#include <limits.h>
+
+#define _SZMAX_KEYBUF   64  /* max # of bytes pending in the key-buffer */
+#define _MSECS_ESCSEQ   25  /* max wait for the rest of an esc-sequence */
+#define _MSECS_CPR      500 /* max wait for a cursor-position report */
+
+/* Depth of the frames being composed (see my_begin_frame()) */
+static int _nframes = 0;
+
+/* Raw mode of the terminal (see my_raw_begin()) */
+static struct {
+	int             on;     /* is the terminal in raw mode? */
+	int             hooked; /* are the exit & signal hooks installed? */
+	struct termios  orig;   /* the settings before entering raw mode */
+} _raw;
+
+/* Bytes read from stdin, but not consumed yet by my_getch() */
+static struct {
+	unsigned char   buf[ _SZMAX_KEYBUF ];
+	int             n;      /* # of bytes in buf */
+	int             eof;    /* has stdin reached its end? */
+} _keybuf;
+
+/* Escape-sequences of the special keys (see my_getch()) */
+static const struct _escseq {
+	const char      *seq;   /* the sequence, without the leading ESC */
+	int             key;
+	unsigned int    mask;
+} _escseqs[] = {
+	/* arrow keys */
+	{ "[A",   MY_KEY_UP,        MY_KEYMASK_ARROW },
+	{ "[B",   MY_KEY_DOWN,      MY_KEYMASK_ARROW },
+	{ "[C",   MY_KEY_RIGHT,     MY_KEYMASK_ARROW },
+	{ "[D",   MY_KEY_LEFT,      MY_KEYMASK_ARROW },
+	{ "OA",   MY_KEY_UP,        MY_KEYMASK_ARROW },
+	{ "OB",   MY_KEY_DOWN,      MY_KEYMASK_ARROW },
+	{ "OC",   MY_KEY_RIGHT,     MY_KEYMASK_ARROW },
+	{ "OD",   MY_KEY_LEFT,      MY_KEYMASK_ARROW },
+
+	/* insert & delete keys */
+	{ "[2~",  MY_KEY_INSERT,    MY_KEYMASK_ARROW },
+	{ "[3~",  MY_KEY_DELETE,    MY_KEYMASK_ARROW },
+
+	/* home & end keys */
+	{ "OH",   MY_KEY_HOME,      MY_KEYMASK_ARROW },
+	{ "[H",   MY_KEY_HOME,      MY_KEYMASK_ARROW },
+	{ "[1~",  MY_KEY_HOME,      MY_KEYMASK_ARROW },
+	{ "OF",   MY_KEY_END,       MY_KEYMASK_ARROW },
+	{ "[F",   MY_KEY_END,       MY_KEYMASK_ARROW },
+	{ "[4~",  MY_KEY_END,       MY_KEYMASK_ARROW },
+
+	/* page-up & page-down keys */
+	{ "[5~",  MY_KEY_PAGE_UP,   MY_KEYMASK_ARROW },
+	{ "[6~",  MY_KEY_PAGE_DOWN, MY_KEYMASK_ARROW },
+
+	/* FKEYS */
+	{ "OP",   MY_KEY_F1,        MY_KEYMASK_FKEY },
+	{ "[11~", MY_KEY_F1,        MY_KEYMASK_FKEY },
+	{ "OQ",   MY_KEY_F2,        MY_KEYMASK_FKEY },
+	{ "[12~", MY_KEY_F2,        MY_KEYMASK_FKEY },
+	{ "OR",   MY_KEY_F3,        MY_KEYMASK_FKEY },
+	{ "[13~", MY_KEY_F3,        MY_KEYMASK_FKEY },
+	{ "OS",   MY_KEY_F4,        MY_KEYMASK_FKEY },
+	{ "[14~", MY_KEY_F4,        MY_KEYMASK_FKEY },
+	{ "[15~", MY_KEY_F5,        MY_KEYMASK_FKEY },
+	{ "[17~", MY_KEY_F6,        MY_KEYMASK_FKEY },
+	{ "[18~", MY_KEY_F7,        MY_KEYMASK_FKEY },
+	{ "[19~", MY_KEY_F8,        MY_KEYMASK_FKEY },
+	{ "[20~", MY_KEY_F9,        MY_KEYMASK_FKEY },
+	{ "[21~", MY_KEY_F10,       MY_KEYMASK_FKEY },
+	{ "[23~", MY_KEY_F11,       MY_KEYMASK_FKEY },
+	{ "[24~", MY_KEY_F12,       MY_KEYMASK_FKEY },
+
+	{ NULL,   MY_KEY_NUL,       MY_KEYMASK_RESET }
+};
+#endif
+
 /* --------------------------------------------------------------
- * Enable raw mode
+ * Flush the standard output, unless a frame is being composed
+ * (see my_begin_frame()).
  * --------------------------------------------------------------
  */
-static int _my_raw_on( void )
+static inline void _my_flush( void )
 {
-#if defined( MY_OS_WINDOWS )
-	HANDLE hConsole = GetStdHandle(STD_INPUT_HANDLE);
-	DWORD mode = 0;
-
-	if ( INVALID_HANDLE_VALUE == hConsole) {
-		return 0;
-	}
-	if ( !GetConsoleMode(hConsole, &mode) ) {
-		return 0;
-	}
-	if ( !SetConsoleMode(hConsole, mode & ~(ENABLE_LINE_INPUT)) ) {
-		return 0;
+#if defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
+	if ( 0 == _nframes ) {
+		fflush( stdout );
 	}
+#else
+	fflush( stdout );
+#endif
+}
 
-#elif defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
-	struct termios term;
+#if defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
+/* --------------------------------------------------------------
+ * Restore the original settings of the terminal when a terminating
+ * signal is caught, and then re-raise the signal with its default
+ * action (only async-signal-safe calls are used in here).
+ * --------------------------------------------------------------
+ */
+static void _my_on_signal( int sig )
+{
+	static const char restore[] = "\033[0m\033[?25h\n";
+	ssize_t unused;
 
-	if ( 0 != tcgetattr(STDOUT_FILENO, &term) ) {
-		return 0;
+	if ( _raw.on ) {
+		tcsetattr( STDIN_FILENO, TCSANOW, &_raw.orig );
 	}
+	unused = write( STDOUT_FILENO, restore, sizeof(restore)-1 );
+	(void)unused;
 
-	term.c_lflag &= ~(IXOFF);
-	term.c_lflag &= ~(ICANON);
+	signal( sig, SIG_DFL );
+	raise( sig );
+}
 
-/*	if ( 0 != tcsetattr(STDOUT_FILENO, TCSAFLUSH, &term) ) {*/
-	if ( 0 != tcsetattr(STDOUT_FILENO, TCSANOW, &term) ) {
-		return 0;
+/* --------------------------------------------------------------
+ * Restore the original settings of the terminal on exit().
+ * --------------------------------------------------------------
+ */
+static void _my_on_exit( void )
+{
+	if ( _raw.on ) {
+		tcsetattr( STDIN_FILENO, TCSANOW, &_raw.orig );
+		_raw.on = 0;
 	}
-
-#else	/* on Unsupported Platforms */
-	return 0;
-#endif
-
-	return 1;
 }
 
 /* --------------------------------------------------------------
- * Disable raw mode
+ * Wait up to the specified milliseconds (msecs, -1 for ever) for
+ * stdin to become readable, and append to the key-buffer whatever
+ * is pending there. Return the # of bytes in the key-buffer.
  * --------------------------------------------------------------
  */
-static int _my_raw_off( void )
+static int _my_keybuf_fill( int msecs )
 {
-#if defined( MY_OS_WINDOWS )
-	HANDLE hConsole = GetStdHandle(STD_INPUT_HANDLE);
-	DWORD mode = 0;
+	struct pollfd pfd;
+	ssize_t n;
 
-	if ( INVALID_HANDLE_VALUE == hConsole) {
-		return 0;
+	if ( _keybuf.eof || _SZMAX_KEYBUF == _keybuf.n ) {
+		return _keybuf.n;
 	}
-	if ( !GetConsoleMode(hConsole, &mode) ) {
-		return 0;
+
+	pfd.fd      = STDIN_FILENO;
+	pfd.events  = POLLIN;
+	pfd.revents = 0;
+	if ( poll(&pfd, 1, msecs) < 1 ) {   /* timed out, or interrupted */
+		return _keybuf.n;
 	}
-	if ( !SetConsoleMode(hConsole, mode | ENABLE_LINE_INPUT) ) {
-		return 0;
+
+	n = read( STDIN_FILENO, &_keybuf.buf[_keybuf.n], _SZMAX_KEYBUF - _keybuf.n );
+	if ( n > 0 ) {
+		_keybuf.n += n;
+	}
+	else if ( 0 == n || EINTR != errno ) {
+		_keybuf.eof = 1;
 	}
 
-#elif defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
-	struct termios term;
+	return _keybuf.n;
+}
 
-	if ( 0 != tcgetattr(STDOUT_FILENO, &term) ) {
-		return 0;
-	}
+/* --------------------------------------------------------------
+ * Remove the specified # of bytes (n) from the front of the key-buffer.
+ * --------------------------------------------------------------
+ */
+static inline void _my_keybuf_consume( int n )
+{
+	_keybuf.n -= n;
+	memmove( _keybuf.buf, &_keybuf.buf[n], _keybuf.n );
+}
 
-	term.c_lflag |= IXOFF;
-	term.c_lflag |= ICANON;
+/* --------------------------------------------------------------
+ * Take from the key-buffer the reply of the terminal to a query of
+ * the cursor position (ESC [ row ; col R) into the specified row
+ * and col, leaving any key-presses around it in the buffer. Wait
+ * up to _MSECS_CPR for new bytes to arrive. Return 0 (false) if
+ * no reply was found, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _my_keybuf_take_cpr( int *row, int *col )
+{
+	char s[ _SZMAX_KEYBUF+1 ];
+	int i, len, n;
+
+	do {
+		memcpy( s, _keybuf.buf, _keybuf.n );
+		s[ _keybuf.n ] = '\0';
+		for (i=0; i < _keybuf.n; i++) {
+			len = 0;
+			if ( 27 == s[i]
+			&& 2 == sscanf(&s[i], "\033[%d;%dR%n", row, col, &len)
+			&& len > 0
+			){
+				_keybuf.n -= len;
+				memmove( &_keybuf.buf[i], &_keybuf.buf[i+len], _keybuf.n - i );
+				return 1;  /* true */
+			}
+		}
+		n = _keybuf.n;
+	} while ( n != _my_keybuf_fill(_MSECS_CPR) );
 
-/*	if ( 0 != tcsetattr(STDOUT_FILENO, TCSAFLUSH, &term) ) {*/
-	if ( 0 != tcsetattr(STDOUT_FILENO, TCSANOW, &term) ) {
-		return 0;
+	return 0;  /* false */
+}
+
+/* --------------------------------------------------------------
+ * int _my_escseq_len():
+ *
+ * Run the escape-sequence state machine on the specified bytes (s, n),
+ * the 1st of which is an ESC. Return the length of the complete
+ * sequence found at their front, 1 if the ESC is followed by an
+ * ordinary key (that is, it is a lone ESC), or 0 if the sequence
+ * is not complete yet.
+ *
+ * Recognized are the CSI sequences (ESC [ params... final-byte)
+ * and the SS3 sequences (ESC O char).
+ * --------------------------------------------------------------
+ */
+static int _my_escseq_len( const unsigned char *s, int n )
+{
+	enum { ST_ESC, ST_INTRO, ST_CSI, ST_SS3 } state = ST_ESC;
+	int i;
+
+	for (i=0; i < n; i++)
+	{
+		switch ( state )
+		{
+			case ST_ESC:
+				state = ST_INTRO;
+				break;
+
+			case ST_INTRO:
+				if ( '[' == s[i] ) {
+					state = ST_CSI;
+				}
+				else if ( 'O' == s[i] ) {
+					state = ST_SS3;
+				}
+				else {
+					return 1;
+				}
+				break;
+
+			case ST_CSI:
+				if ( s[i] >= 0x40 && s[i] <= 0x7E ) { /* final */
+					return i+1;
+				}
+				if ( s[i] < 0x20 || s[i] > 0x3F ) {   /* malformed */
+					return i;
+				}
+				break;
+
+			case ST_SS3:
+				return i+1;
+		}
 	}
 
-#else	/* on Unsupported Platforms */
 	return 0;
-#endif
-
-	return 1;
 }
+#endif
 
 /* --------------------------------------------------------------
- * Enable echo when inputting
+ * int my_raw_begin():
+ *
+ * Put the terminal in raw mode (no line-buffering and no echo) for
+ * the rest of the session, that is until my_raw_end() is called.
+ * The original settings are also restored automatically on exit(),
+ * and when a terminating signal is caught. Calling it repeatedly
+ * is harmless. Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTE: Inputting whole lines (say with fgets()) needs the original
+ *       settings, so wrap it in my_raw_end() & my_raw_begin().
  * --------------------------------------------------------------
  */
-static int _my_echo_on( void )
+int my_raw_begin( void )
 {
 #if defined( MY_OS_WINDOWS )
-	HANDLE hConsole = GetStdHandle(STD_INPUT_HANDLE);
+	HANDLE hStdin = GetStdHandle(STD_INPUT_HANDLE);
 	DWORD mode = 0;
 
-	if ( INVALID_HANDLE_VALUE == hConsole) {
+	if ( INVALID_HANDLE_VALUE == hStdin) {
 		return 0;
 	}
-	if ( !GetConsoleMode(hConsole, &mode) ) {
+	if ( !GetConsoleMode(hStdin, &mode) ) {
 		return 0;
 	}
-	if ( !SetConsoleMode(hConsole, mode | ENABLE_ECHO_INPUT) ) {
+	mode &= ~(ENABLE_LINE_INPUT | ENABLE_ECHO_INPUT);
+	if ( !SetConsoleMode(hStdin, mode) ) {
 		return 0;
 	}
 
 #elif defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
+	static const int sigs[] = { SIGINT, SIGTERM, SIGHUP, SIGQUIT };
 	struct termios term;
+	size_t i;
 
-	if ( 0 != tcgetattr(STDOUT_FILENO, &term) ) {
+	if ( _raw.on ) {
+		return 1;
+	}
+	if ( 0 != tcgetattr(STDIN_FILENO, &_raw.orig) ) {
 		return 0;
 	}
 
-	term.c_lflag |= ECHO;
-
-	if ( 0 != tcsetattr(STDOUT_FILENO, TCSAFLUSH, &term) ) {
-/*	if ( 0 != tcsetattr(STDOUT_FILENO, TCSANOW, &term) ) {*/
+	term = _raw.orig;
+	term.c_lflag &= ~(ECHO | ICANON);
+	term.c_cc[ VMIN  ] = 1;
+	term.c_cc[ VTIME ] = 0;
+	if ( 0 != tcsetattr(STDIN_FILENO, TCSANOW, &term) ) {
 		return 0;
 	}
+	_raw.on = 1;
+
+	if ( !_raw.hooked ) {
+		_raw.hooked = 1;
+		atexit( _my_on_exit );
+		for (i=0; i < sizeof(sigs) / sizeof(sigs[0]); i++) {
+			/* leave alone the signals that were ignored */
+			if ( SIG_IGN == signal(sigs[i], _my_on_signal) ) {
+				signal( sigs[i], SIG_IGN );
+			}
+		}
+	}
 
 #else	/* on Unsupported Platforms */
 	return 0;
@@ -156,10 +387,13 @@ static int _my_echo_on( void )
 }
 
 /* --------------------------------------------------------------
- * Disable echo when inputting
+ * int my_raw_end():
+ *
+ * Restore the settings the terminal had before my_raw_begin().
+ * Return 0 (false) on error, 1 (true) otherwise.
  * --------------------------------------------------------------
  */
-static int _my_echo_off( void )
+int my_raw_end( void )
 {
 #if defined( MY_OS_WINDOWS )
 	HANDLE hStdin = GetStdHandle(STD_INPUT_HANDLE);
@@ -171,23 +405,19 @@ static int _my_echo_off( void )
 	if ( !GetConsoleMode(hStdin, &mode) ) {
 		return 0;
 	}
-	if ( !SetConsoleMode(hStdin, mode & (~ENABLE_ECHO_INPUT)) ) {
+	mode |= ENABLE_LINE_INPUT | ENABLE_ECHO_INPUT;
+	if ( !SetConsoleMode(hStdin, mode) ) {
 		return 0;
 	}
 
 #elif defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
-	struct termios term;
-
-	if ( 0 != tcgetattr(STDOUT_FILENO, &term) ) {
-		return 0;
+	if ( !_raw.on ) {
+		return 1;
 	}
-
-	term.c_lflag &= ~ECHO;
-
-	if ( 0 != tcsetattr(STDOUT_FILENO, TCSAFLUSH, &term) ) {
-/*	if ( 0 != tcsetattr(STDOUT_FILENO, TCSANOW, &term) ) {*/
+	if ( 0 != tcsetattr(STDIN_FILENO, TCSANOW, &_raw.orig) ) {
 		return 0;
 	}
+	_raw.on = 0;
 
 #else	/* on Unsupported Platforms */
 	return 0;
@@ -196,6 +426,47 @@ static int _my_echo_off( void )
 	return 1;
 }
 
+/* --------------------------------------------------------------
+ * int my_wait_key():
+ *
+ * Wait up to the specified milliseconds (msecs, negative for ever)
+ * for a key-press to become available to my_getch(). Return 1 (true)
+ * if one is available, 0 (false) otherwise (the wait may be cut short
+ * by a signal).
+ *
+ * It lets the callers wait on timers as well as on keys.
+ * --------------------------------------------------------------
+ */
+int my_wait_key( long int msecs )
+{
+#if defined( MY_OS_WINDOWS )
+	while ( !_kbhit() ) {
+		if ( 0 == msecs ) {
+			return 0;
+		}
+		SleepEx( 1, FALSE );
+		if ( msecs > 0 ) {
+			msecs--;
+		}
+	}
+	return 1;
+
+#elif defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
+	if ( _keybuf.n > 0 || _keybuf.eof ) {
+		return 1;
+	}
+	if ( msecs > INT_MAX ) {
+		msecs = INT_MAX;
+	}
+	_my_keybuf_fill( msecs < 0 ? -1 : (int)msecs );
+	return _keybuf.n > 0 || _keybuf.eof;
+
+#else	/* on Unsupported Platforms, getchar() blocks anyway */
+	(void)msecs;
+	return 1;
+#endif
+}
+
 /* --------------------------------------------------------------
  * int my_getch():
  *
@@ -208,9 +479,15 @@ static int _my_echo_off( void )
  *       ASCII-code returned by the function: getch() which is
  *       available with Windows compilers, via <conio.h>.
  *
- *       For compilers on other platforms, termios is used for
- *       reading the key-press. The latter is then converted to
- *       its corresponding ASCII-code before it is returned.
+ *       For compilers on other platforms, the bytes pending on
+ *       stdin are read (with poll() & read()) into a key-buffer,
+ *       whose front key-press is decoded by an escape-sequence
+ *       state machine and converted to its corresponding ASCII-code
+ *       before it is returned. A lone ESC is told apart from the
+ *       start of a sequence by waiting _MSECS_ESCSEQ for the rest
+ *       of it. The end of stdin is reported as MY_KEY_ESCAPE.
+ *
+ *       It is meant to be used in raw mode (see my_raw_begin()).
  *
  *       The ASCII-codes are abstracted with enumerated values,
  *       defined in the file: "my.h".
@@ -240,167 +517,54 @@ int my_getch( unsigned int *outKeyMask )
 #elif defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
 	/* on Linux & Unix platforms */
 
-	#define MY_MAGIC_MAX_CHARS 18
-
-	struct termios	oldt, newt;
-	unsigned char	keycodes[ MY_MAGIC_MAX_CHARS ] = {'\0'};
-	int		count;
-
-	/* get the terminal settings for stdin */
-	tcgetattr( STDIN_FILENO, &oldt );
-
-	/* we want to keep the old settings, to restore them at the end */
-	newt = oldt;
-
-	/* Input must have at least this number of chars for read to return */
-	newt.c_cc[ VMIN  ] = MY_MAGIC_MAX_CHARS;
-	/* Time in 0.1 seconds after first char to wait before returning */
-	newt.c_cc[ VTIME ] = 1;
-	newt.c_iflag &= ~(IXOFF);
-
-	/* disable canonical mode (buffered i/o) and local echo */
-	newt.c_lflag &= ~(ECHO | ICANON);
+	const struct _escseq *es = NULL;
+	int len = 1, n;
 
-	/* set the new settings */
-/*	tcsetattr( STDIN_FILENO, TCSAFLUSH, &newt );*/
-	tcsetattr( STDIN_FILENO, TCSANOW, &newt );
-
-	count = read( STDIN_FILENO, keycodes, MY_MAGIC_MAX_CHARS );
-	if ( 1 == count )
-	{
-		key = keycodes[0];
-		if ( '\r' == key || '\n' == key ) {
-			key = MY_KEY_ENTER;
-		}
-		else if ( '\b' == key || 127 == key ) {
-			key = MY_KEY_BACKSPACE;
-		}
+	while ( 0 == _keybuf.n && !_keybuf.eof ) {
+		_my_keybuf_fill( -1 );
+	}
+	if ( 0 == _keybuf.n ) {
+		return MY_KEY_ESCAPE;
 	}
-	else
-	{
-		if ( '\r' == keycodes[0] || '\n' == keycodes[0] ) {
-			key = MY_KEY_ENTER;
-		}
-
-		/* arrow keys */
-		else if (0 == memcmp(&keycodes[1], "[A", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_ARROW;
-			key = MY_KEY_UP;
-		}
-		else if (0 == memcmp(&keycodes[1], "[B", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_ARROW;
-			key = MY_KEY_DOWN;
-		}
-		else if (0 == memcmp(&keycodes[1], "[C", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_ARROW;
-			key = MY_KEY_RIGHT;
-		}
-		else if (0 == memcmp(&keycodes[1], "[D", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_ARROW;
-			key = MY_KEY_LEFT;
-		}
-
-		/* insert & delete keys */
-		else if (0 == memcmp(&keycodes[1], "[2~", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_ARROW;
-			key = MY_KEY_INSERT;
-		}
-		else if (0 == memcmp(&keycodes[1], "[3~", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_ARROW;
-			key = MY_KEY_DELETE;
-		}
-
-		/* home & end keys */
-		else if (0 == memcmp(&keycodes[1], "OH", count-1)
-		|| 0 == memcmp(&keycodes[1], "[1~", count-1)
-		){
-			*outKeyMask |= MY_KEYMASK_ARROW;
-			key = MY_KEY_HOME;
-		}
-		else if (0 == memcmp(&keycodes[1], "OF", count-1)
-		|| 0 == memcmp(&keycodes[1], "[4~", count-1)
-		){
-			*outKeyMask |= MY_KEYMASK_ARROW;
-			key = MY_KEY_END;
-		}
-
-		/* page-up & page-down keys */
-		else if (0 == memcmp(&keycodes[1], "[5~", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_ARROW;
-			key = MY_KEY_PAGE_UP;
-		}
-		else if (0 == memcmp(&keycodes[1], "[6~", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_ARROW;
-			key = MY_KEY_PAGE_DOWN;
-		}
 
-		/* FKEYS */
-		else if (0 == memcmp(&keycodes[1], "OP", count-1)
-		|| 0 == memcmp(&keycodes[1], "[11~", count-1)
-		){
-			*outKeyMask |= MY_KEYMASK_FKEY;
-			key = MY_KEY_F1;
-		}
-		else if (0 == memcmp(&keycodes[1], "OQ", count-1)
-		|| 0 == memcmp(&keycodes[1], "[12~", count-1)
-		){
-			*outKeyMask |= MY_KEYMASK_FKEY;
-			key = MY_KEY_F2;
-		}
-		else if (0 == memcmp(&keycodes[1], "OR", count-1)
-		|| 0 == memcmp(&keycodes[1], "[13~", count-1)
-		){
-			*outKeyMask |= MY_KEYMASK_FKEY;
-			key = MY_KEY_F3;
-		}
-		else if (0 == memcmp(&keycodes[1], "OS", count-1)
-		|| 0 == memcmp(&keycodes[1], "[14~", count-1)
-		){
-			*outKeyMask |= MY_KEYMASK_FKEY;
-			key = MY_KEY_F4;
-		}
-		else if (0 == memcmp(&keycodes[1], "[15~", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_FKEY;
-			key = MY_KEY_F5;
-		}
-		else if (0 == memcmp(&keycodes[1], "[17~", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_FKEY;
-			key = MY_KEY_F6;
-		}
-		else if (0 == memcmp(&keycodes[1], "[18~", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_FKEY;
-			key = MY_KEY_F7;
-		}
-		else if (0 == memcmp(&keycodes[1], "[19~", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_FKEY;
-			key = MY_KEY_F8;
-		}
-		else if (0 == memcmp(&keycodes[1], "[20~", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_FKEY;
-			key = MY_KEY_F9;
-		}
-		else if (0 == memcmp(&keycodes[1], "[21~", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_FKEY;
-			key = MY_KEY_F10;
-		}
-		else if (0 == memcmp(&keycodes[1], "[23~", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_FKEY;
-			key = MY_KEY_F11;
-		}
-		else if (0 == memcmp(&keycodes[1], "[24~", count-1) ) {
-			*outKeyMask |= MY_KEYMASK_FKEY;
-			key = MY_KEY_F12;
+	key = _keybuf.buf[0];
+	if ( MY_KEY_ESCAPE == key )
+	{
+		/* wait briefly for the rest of an incomplete sequence */
+		while ( 0 == (len = _my_escseq_len(_keybuf.buf, _keybuf.n)) ) {
+			n = _keybuf.n;
+			if ( n == _my_keybuf_fill(_MSECS_ESCSEQ) ) {
+				len = n;
+				break;
+			}
 		}
 
-		/* other multi-character ANSI escape sequences */
-		else {
-			*outKeyMask |= MY_KEYMASK_UNKNOWN;
-			key = -(int)keycodes[count-1];
+		if ( len > 1 ) {
+			for (es = _escseqs; NULL != es->seq; es++) {
+				if ( len-1 == (int)strlen(es->seq)
+				&& 0 == memcmp(&_keybuf.buf[1], es->seq, len-1)
+				){
+					break;
+				}
+			}
+			if ( NULL != es->seq ) {
+				*outKeyMask |= es->mask;
+				key = es->key;
+			}
+			else {  /* other multi-character ANSI escape sequences */
+				*outKeyMask |= MY_KEYMASK_UNKNOWN;
+				key = -(int)_keybuf.buf[len-1];
+			}
 		}
 	}
+	else if ( '\r' == key || '\n' == key ) {
+		key = MY_KEY_ENTER;
+	}
+	else if ( '\b' == key || 127 == key ) {
+		key = MY_KEY_BACKSPACE;
+	}
 
-	/* restore the former settings */
-	tcsetattr ( STDIN_FILENO, TCSANOW, &oldt );
+	_my_keybuf_consume( len );
 
 #else 	/* On Unsupported Platforms, fall-back to bufferd getchar() */
 	key = getchar();
@@ -506,7 +670,7 @@ int my_cls( void )
 
 #elif defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
 	printf( "%s%s", "\033[2J", "\033[H" );
-	fflush( stdout );
+	_my_flush();
 
 #else	/* On Unsupported Platforms */
 	for (int i=0; i < 24; i++)
@@ -537,8 +701,13 @@ int my_console_width( void )
 
 #elif defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
 	struct winsize ws;
-	(void) ioctl(0, TIOCGWINSZ, &ws);
 
+	if ( MY_SINK_TERMINAL != _sink.kind ) {
+		return _SINK_W;
+	}
+	if ( 0 != ioctl(0, TIOCGWINSZ, &ws) ) {
+		return 0;
+	}
 	return (int) ws.ws_col;
 
 #else	/* on Unsupported Platforms */
@@ -568,8 +737,13 @@ int my_console_height( void )
 
 #elif defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
 	struct winsize ws;
-	(void) ioctl(0, TIOCGWINSZ, &ws);
 
+	if ( MY_SINK_TERMINAL != _sink.kind ) {
+		return _SINK_H;
+	}
+	if ( 0 != ioctl(0, TIOCGWINSZ, &ws) ) {
+		return 0;
+	}
 	return (int) ws.ws_row;
 
 #else	/* on Unsupported Platforms */
@@ -606,11 +780,11 @@ int my_cursor_onoff( int onoff )
 #elif defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
 	if ( onoff ) {
 		printf( "%s", "\033[?25h" );
-		fflush( stdout );
+		_my_flush();
 	}
 	else {
 		printf( "%s", "\033[?25l" );
-		fflush( stdout );
+		_my_flush();
 	}
 
 #else	/* On UnSupported Platforms */
@@ -641,28 +815,27 @@ int my_getxy( int *x, int *y )
 	*y = csbiInfo.dwCursorPosition.Y;
 
 #elif defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
-	char keycodes[18+1] = {'\0'};
-	int  tempX, tempY;
+	int wasraw = _raw.on;
+	int ret, tempX, tempY;
 
-	_my_echo_off();
-	_my_raw_on();
+	if ( !wasraw && !my_raw_begin() ) {
+		return 0;
+	}
 
 	/* query cursor coords */
 	printf( "%s", "\033[6n" );
 	fflush( stdout );
 
-	read( STDIN_FILENO, keycodes, 18 );
-
-	keycodes[18] = '\0';
-	if ( 2 != sscanf(keycodes, "\033[%d;%dR", &tempY, &tempX) ) {
+	ret = _my_keybuf_take_cpr( &tempY, &tempX );
+	if ( !wasraw ) {
+		my_raw_end();
+	}
+	if ( !ret ) {
 		return 0;
 	}
 	*x = tempX-1;
 	*y = tempY-1;
 
-	_my_raw_off();
-	_my_echo_on();
-
 #else	/* On UnSupported Platforms */
 
 	return 0;
@@ -711,7 +884,7 @@ int my_gotoxy( int x, int y )
 
 #elif defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
 	printf( "%s%d;%dH", "\033[", y+1, x+1 );
-	fflush( stdout );
+	_my_flush();
 
 #else	/* On UnSupported Platforms */
 	return 0;
@@ -736,8 +909,247 @@ int my_printfxy( int x, int y, const char *fmt, ... )
 	my_gotoxy(x,y);
 	va_start( args, fmt );
 	ret = vprintf( fmt, args );
-	fflush( stdout );
+	_my_flush();
 	va_end( args );
 
 	return ret;
 }
+
+/* --------------------------------------------------------------
+ * int my_buffer_output():
+ *
+ * Give the standard output a buffer of the specified size (in bytes)
+ * so a whole frame fits in it (see my_begin_frame()). It stays line
+ * buffered (that is, it gets flushed on every '\n' and before any
+ * input is read). Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTE: This function MUST be called before anything gets written to
+ *       the standard output (only the 1st call counts). On Windows it
+ *       does nothing, because the console applies the cursor position
+ *       & colors as soon as they get set, so the output must stay
+ *       unbuffered.
+ * --------------------------------------------------------------
+ */
+int my_buffer_output( size_t size )
+{
+#if defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
+	/* NOT freed, since stdout uses it until the program exits (a NULL
+	 * buffer would not do, since the size would then be ignored).
+	 */
+	static char *buf = NULL;
+
+	if ( NULL != buf ) {
+		return 1;
+	}
+	if ( NULL == (buf = malloc(size)) ) {
+		return 0;
+	}
+	return 0 == setvbuf(
+			MY_SINK_TERMINAL == _sink.kind ? stdout : _sink.term,
+			buf,
+			_IOLBF,
+			size
+			);
+#else
+	(void)size;
+	return 1;
+#endif
+}
+
+/* --------------------------------------------------------------
+ * int my_begin_frame():
+ *
+ * Start composing a frame: until the matching call of my_end_frame()
+ * the output of the functions of this file is only buffered, instead
+ * of being flushed right away, so the whole frame can be written to
+ * the terminal at once. Frames may be nested, in which case only the
+ * outermost one counts. Return 1 (true).
+ *
+ * NOTE: It does nothing on Windows (see my_buffer_output()).
+ * --------------------------------------------------------------
+ */
+int my_begin_frame( void )
+{
+#if defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
+	_nframes++;
+#endif
+	return 1;
+}
+
+/* --------------------------------------------------------------
+ * int my_end_frame():
+ *
+ * End composing a frame, writing all of it to the terminal if it is
+ * the outermost one (see my_begin_frame()). Return 0 (false) if no
+ * frame was being composed, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+int my_end_frame( void )
+{
+#if defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
+	if ( 0 == _nframes ) {
+		return 0;
+	}
+	if ( 0 == --_nframes ) {
+		fflush( stdout );
+	}
+#endif
+	return 1;
+}
+
+#if defined( _MY_HAS_FOPENCOOKIE ) || defined( _MY_HAS_FUNOPEN )
+/* --------------------------------------------------------------
+ * Write callback of the stream of the headless sinks: count the
+ * specified bytes (buf, size) as a single write, and keep them
+ * too if the sink is MY_SINK_MEMORY (as many as fit in memory).
+ * --------------------------------------------------------------
+ */
+static size_t _my_sink_write( const char *buf, size_t size )
+{
+	size_t capacity;
+	char *try = NULL;
+
+	_sink.nbytes += size;
+	_sink.nwrites++;
+	if ( MY_SINK_MEMORY != _sink.kind ) {
+		return size;
+	}
+
+	if ( _sink.szmem + size > _sink.capacity ) {
+		capacity = _sink.capacity ? 2 * _sink.capacity : _SZ_SINKBUF;
+		while ( capacity < _sink.szmem + size ) {
+			capacity *= 2;
+		}
+		if ( NULL == (try = realloc(_sink.mem, capacity)) ) {
+			return size;  /* counted, but not kept */
+		}
+		_sink.mem      = try;
+		_sink.capacity = capacity;
+	}
+	memcpy( &_sink.mem[_sink.szmem], buf, size );
+	_sink.szmem += size;
+
+	return size;
+}
+
+#if defined( _MY_HAS_FOPENCOOKIE )
+static ssize_t _my_cookie_write( void *cookie, const char *buf, size_t size )
+{
+	(void)cookie;
+	return (ssize_t) _my_sink_write( buf, size );
+}
+#else
+static int _my_funopen_write( void *cookie, const char *buf, int size )
+{
+	(void)cookie;
+	return (int) _my_sink_write( buf, (size_t)size );
+}
+#endif
+#endif
+
+/* --------------------------------------------------------------
+ * int my_output_sink():
+ *
+ * Send the standard output to the specified sink: MY_SINK_TERMINAL
+ * (the default), MY_SINK_MEMORY (a growing in-memory buffer, see
+ * my_output_memory()) or MY_SINK_NULL (nowhere). The headless sinks
+ * count the bytes & the writes they get (see my_output_stats()) and
+ * the console is reported to be 80x24 while they are in use, so the
+ * output can be driven & measured without a terminal.
+ *
+ * Return 0 (false) on error, 1 (true) otherwise.
+ *
+ * NOTES: The headless sinks are custom streams, made with fopencookie()
+ *        or funopen() where available (on other platforms only the
+ *        terminal is supported), which get assigned to stdout. Like
+ *        the terminal, they are line buffered, with a buffer large
+ *        enough for a whole frame, so they get written to as often
+ *        as the terminal would (see my_begin_frame()).
+ * --------------------------------------------------------------
+ */
+int my_output_sink( int sink )
+{
+	if ( sink == _sink.kind ) {
+		return 1;
+	}
+	fflush( stdout );
+
+	if ( MY_SINK_TERMINAL == sink ) {
+		stdout = _sink.term;
+		_sink.kind = sink;
+		return 1;
+	}
+	if ( MY_SINK_MEMORY != sink && MY_SINK_NULL != sink ) {
+		return 0;
+	}
+
+#if defined( _MY_HAS_FOPENCOOKIE ) || defined( _MY_HAS_FUNOPEN )
+	if ( NULL == _sink.fp ) {
+#if defined( _MY_HAS_FOPENCOOKIE )
+		cookie_io_functions_t io = { NULL, _my_cookie_write, NULL, NULL };
+		_sink.fp = fopencookie( NULL, "w", io );
+#else
+		_sink.fp = funopen( NULL, NULL, _my_funopen_write, NULL, NULL );
+#endif
+		if ( NULL == _sink.fp ) {
+			return 0;
+		}
+		setvbuf( _sink.fp, NULL, _IOLBF, _SZ_SINKBUF );
+	}
+	if ( MY_SINK_TERMINAL == _sink.kind ) {
+		_sink.term = stdout;
+	}
+	stdout = _sink.fp;
+	_sink.kind = sink;
+	return 1;
+
+#else	/* only the terminal is supported */
+	return 0;
+#endif
+}
+
+/* --------------------------------------------------------------
+ * int my_output_stats():
+ *
+ * Pass back via the specified pointers (if non-NULL) the count of
+ * bytes (nbytes) and writes (nwrites) that the headless sinks got
+ * so far (see my_output_sink()), after flushing the standard output.
+ * If reset is 1 (true) zero out them, along with the memory of the
+ * MY_SINK_MEMORY sink. Return 1 (true).
+ * --------------------------------------------------------------
+ */
+int my_output_stats(
+	unsigned long int *nbytes,
+	unsigned long int *nwrites,
+	int               reset
+	)
+{
+	fflush( stdout );
+	if ( nbytes ) {
+		*nbytes = _sink.nbytes;
+	}
+	if ( nwrites ) {
+		*nwrites = _sink.nwrites;
+	}
+	if ( reset ) {
+		_sink.nbytes  = 0;
+		_sink.nwrites = 0;
+		_sink.szmem   = 0;
+	}
+	return 1;
+}
+
+/* --------------------------------------------------------------
+ * const char *my_output_memory():
+ *
+ * Return what the MY_SINK_MEMORY sink got so far (not nul-terminated)
+ * after flushing the standard output, and pass back its length via
+ * the specified pointer (size). Return NULL if it got nothing.
+ * --------------------------------------------------------------
+ */
+const char *my_output_memory( size_t *size )
+{
+	fflush( stdout );
+	*size = _sink.szmem;
+	return _sink.szmem > 0 ? _sink.mem : NULL;
+}
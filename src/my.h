@@ -41,6 +41,8 @@
  * -------------
  */
 
+#include <stddef.h>     /* size_t */
+
 #if defined( MY_OS_WINDOWS )
 	#include <conio.h>
 	#include <windows.h>
@@ -49,6 +51,8 @@
 	#endif
 
 #elif defined( MY_OS_UNIX ) || defined( MY_OS_LINUX )
+	#include <poll.h>
+	#include <signal.h>
 	#include <sys/ioctl.h>
 	#include <termios.h>
 	#include <unistd.h>
@@ -98,8 +102,17 @@ enum {	/* unbuffered i/o related constants & masks */
 	MY_KEY_F12       = 134
 };
 
+enum {	/* output sinks (see my_output_sink()) */
+	MY_SINK_TERMINAL = 0,   /* the standard output (default) */
+	MY_SINK_MEMORY,         /* an in-memory buffer (headless) */
+	MY_SINK_NULL            /* nowhere (headless) */
+};
+
 #ifndef MY_C
 extern int my_cursor_onoff( int onoff );
+extern int my_raw_begin( void );
+extern int my_raw_end( void );
+extern int my_wait_key( long int msecs );
 extern int my_getch( unsigned int *outKeyMask );
 extern int my_sleep_msecs( unsigned long int msecs );
 extern int my_cls( void );
@@ -110,6 +123,18 @@ extern int my_getx( void );
 extern int my_gety( void );
 extern int my_gotoxy( int x, int y );
 extern int my_printfxy( int x, int y, const char *fmt, ... );
+
+extern int my_buffer_output( size_t size );
+extern int my_begin_frame( void );
+extern int my_end_frame( void );
+
+extern int my_output_sink( int sink );
+extern int my_output_stats(
+                  unsigned long int *nbytes,
+                  unsigned long int *nwrites,
+                  int               reset
+                  );
+extern const char *my_output_memory( size_t *size );
 #endif
 
 #endif
@@ -0,0 +1,339 @@
+/****************************************************************
+ * This file is part of the "2048cc" game.
+ *
+ * Author:       migf1 <mig_f1@hotmail.com>
+ * Version:      0.3a3
+ * Date:         July 21, 2014
+ * License:      Free Software (see comments in main.c for limitations)
+ * Dependencies: common.h, pool.h
+ * --------------------------------------------------------------
+ *
+ * Private implementation of a size-classed pool allocator, used for
+ * the objects that get created & destroyed at very high rates during
+ * the game (boards, game-states and gsstack nodes). Undo/redo churn
+ * and replay loading used to hit calloc() & free() for every single
+ * one of them.
+ *
+ * Functions with a "_" prefix in their names are meant to be private
+ * in this source-module. They are usually inlined, without performing
+ * any sanity check on their arguments.
+ *
+ * Requested sizes are rounded up to a multiple of _SZCLASS bytes,
+ * which determines their size-class. Boards and game-states carry
+ * inline grids with capacity for the largest board variant, so each
+ * of them has a single size-class, whatever its current dimension.
+ *
+ * Every size-class keeps a free-list of released blocks, linked through
+ * the blocks themselves. When the free-list is empty, a new chunk of
+ * _NBLOCKS_PER_CHUNK blocks is reserved from the system and threaded
+ * onto the free-list. Chunks are never returned to the system while
+ * the program runs, unless pool_release() is explicitly called when
+ * no block is in use any more.
+ *
+ * The size-classes (free-lists, chunks & statistics) are thread-local,
+ * so several threads may use the allocator without locking. However,
+ * a block MUST be released by the same thread that allocated it.
+ *
+ * Requests larger than the largest size-class are served directly by
+ * calloc(), but they are still counted in the total statistics. When
+ * the macro POOL_DISABLED is defined at compile-time, ALL requests are
+ * served that way (handy when hunting memory bugs with external tools).
+ ****************************************************************
+ */
+
+#define POOL_C
+
+#include <stdlib.h>        /* calloc(), malloc(), free() */
+#include <string.h>        /* memset() */
+
+#include "common.h"
+#include "pool.h"
+
+enum {
+	_SZCLASS          = 16,  /* granularity of size-classes (bytes) */
+	_NCLASSES         = 32,  /* so the largest class is 512 bytes */
+	_NBLOCKS_PER_CHUNK= 64,  /* # of blocks reserved at once */
+	_SZCHUNKHDR       = 16   /* keeps the blocks of a chunk aligned */
+};
+
+/* Macro for converting a size (in bytes) to the index of its size-class */
+#define _SIZE_TO_CLASS(sz)    ( ((sz) + _SZCLASS - 1) / _SZCLASS - 1 )
+
+/* A chunk of blocks, as reserved from the system.
+ * Its blocks follow the header, _SZCHUNKHDR bytes after its start.
+ */
+struct _chunk {
+	struct _chunk *next;
+};
+
+/* A released block, linked in the free-list of its size-class */
+struct _freeblock {
+	struct _freeblock *next;
+};
+
+/* A size-class */
+struct _class {
+	struct _freeblock *freelist;  /* released blocks */
+	struct _chunk     *chunks;    /* reserved chunks */
+	size_t            nused;      /* # of blocks in use */
+	size_t            npeak;      /* high-water mark of nused */
+	size_t            nreserved;  /* # of blocks reserved */
+};
+
+/* The pools of the calling thread */
+static TH_LOCAL struct _class _classes[ _NCLASSES ];
+
+/* Total statistics of the calling thread (szblock is unused) */
+static TH_LOCAL PoolStats _totals;
+
+/* --------------------------------------------------------------
+ * void _totals_add():
+ *
+ * Account (nbytes) more bytes as being in use, in the total
+ * statistics of the calling thread.
+ * --------------------------------------------------------------
+ */
+static inline void _totals_add( size_t nbytes )
+{
+	_totals.nused++;
+	_totals.nbused += nbytes;
+	if ( _totals.nused > _totals.npeak ) {
+		_totals.npeak = _totals.nused;
+	}
+	if ( _totals.nbused > _totals.nbpeak ) {
+		_totals.nbpeak = _totals.nbused;
+	}
+}
+
+/* --------------------------------------------------------------
+ * void _totals_sub():
+ *
+ * Account (nbytes) less bytes as being in use, in the total
+ * statistics of the calling thread.
+ * --------------------------------------------------------------
+ */
+static inline void _totals_sub( size_t nbytes )
+{
+	_totals.nused--;
+	_totals.nbused -= nbytes;
+}
+
+/* --------------------------------------------------------------
+ * int _class_grow():
+ *
+ * Reserve a new chunk of blocks for the specified size-class (icls)
+ * and thread them onto its free-list. Return 0 (false) on error,
+ * 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _class_grow( int icls )
+{
+	int i;
+	struct _class *cls = &_classes[ icls ];
+	const size_t szblock = (icls + 1) * _SZCLASS;
+	struct _chunk *chunk = NULL;
+	char *blocks = NULL;
+
+	chunk = malloc( _SZCHUNKHDR + _NBLOCKS_PER_CHUNK * szblock );
+	if ( NULL == chunk ) {
+		DBGF( "%s", "malloc() failed!" );
+		return 0;  /* false */
+	}
+	chunk->next = cls->chunks;
+	cls->chunks = chunk;
+
+	/* thread the blocks in reverse, so they are handed out in order */
+	blocks = (char *)chunk + _SZCHUNKHDR;
+	for (i = _NBLOCKS_PER_CHUNK - 1; i > -1; i--) {
+		struct _freeblock *fb = (struct _freeblock *)(blocks + i * szblock);
+		fb->next = cls->freelist;
+		cls->freelist = fb;
+	}
+	cls->nreserved   += _NBLOCKS_PER_CHUNK;
+	_totals.nbreserved += _NBLOCKS_PER_CHUNK * szblock;
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * void *pool_alloc():
+ *
+ * Return a pointer to a zero-initialized block of memory, capable of
+ * holding at least the specified count of bytes (size), or NULL on
+ * error. The block should be released via pool_free(), passing it
+ * the same size.
+ * --------------------------------------------------------------
+ */
+void *pool_alloc( size_t size )
+{
+	int icls;
+	struct _class *cls = NULL;
+	struct _freeblock *fb = NULL;
+
+	if ( 0 == size ) {
+		DBGF( "%s", "Zero size requested!" );
+		return NULL;
+	}
+
+#ifndef POOL_DISABLED
+	icls = _SIZE_TO_CLASS( size );
+	if ( icls < _NCLASSES )
+	{
+		cls = &_classes[ icls ];
+		if ( NULL == cls->freelist && !_class_grow(icls) ) {
+			return NULL;
+		}
+		fb = cls->freelist;
+		cls->freelist = fb->next;
+
+		cls->nused++;
+		if ( cls->nused > cls->npeak ) {
+			cls->npeak = cls->nused;
+		}
+		_totals_add( (icls + 1) * _SZCLASS );
+
+		memset( fb, 0, (icls + 1) * _SZCLASS );
+		return fb;
+	}
+#else
+	(void)icls; (void)cls;
+#endif
+
+	/* too large for any size-class */
+	fb = calloc( 1, size );
+	if ( NULL == fb ) {
+		DBGF( "%s", "calloc() failed!" );
+		return NULL;
+	}
+	_totals_add( size );
+	_totals.nbreserved += size;
+	return fb;
+}
+
+/* --------------------------------------------------------------
+ * void *pool_free():
+ *
+ * Release the specified block, which MUST have been returned by
+ * pool_alloc() for the specified size (size), in the calling thread.
+ * Return NULL (so the caller may assign it back to the block pointer).
+ * --------------------------------------------------------------
+ */
+void *pool_free( void *block, size_t size )
+{
+	int icls;
+	struct _class *cls = NULL;
+	struct _freeblock *fb = block;
+
+	if ( NULL == block ) {
+		return NULL;
+	}
+
+#ifndef POOL_DISABLED
+	icls = _SIZE_TO_CLASS( size );
+	if ( icls < _NCLASSES )
+	{
+		cls = &_classes[ icls ];
+		fb->next = cls->freelist;
+		cls->freelist = fb;
+
+		cls->nused--;
+		_totals_sub( (icls + 1) * _SZCLASS );
+		return NULL;
+	}
+#else
+	(void)icls; (void)cls; (void)fb;
+#endif
+
+	free( block );
+	_totals_sub( size );
+	_totals.nbreserved -= size;
+	return NULL;
+}
+
+/* --------------------------------------------------------------
+ * int pool_release():
+ *
+ * Return to the system all the chunks reserved by the calling thread.
+ * Return 0 (false) if any block is still in use (in which case nothing
+ * gets released), 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+int pool_release( void )
+{
+	int i;
+	struct _chunk *chunk = NULL;
+
+	if ( 0 != _totals.nused ) {
+		return 0;  /* false */
+	}
+
+	for (i=0; i < _NCLASSES; i++) {
+		while ( NULL != (chunk = _classes[i].chunks) ) {
+			_classes[i].chunks = chunk->next;
+			free( chunk );
+		}
+		memset( &_classes[i], 0, sizeof(_classes[i]) );
+	}
+	_totals.nbreserved = 0;
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int pool_get_stats():
+ *
+ * Fill in the specified stats with the usage statistics of the
+ * size-class serving requests of the specified size (size), in
+ * the calling thread. Return 0 (false) on error, or if size is
+ * not served by any size-class. Return 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+int pool_get_stats( size_t size, PoolStats *stats )
+{
+	int icls;
+	const struct _class *cls = NULL;
+
+	if ( NULL == stats ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+
+	icls = _SIZE_TO_CLASS( size );
+	if ( 0 == size || icls >= _NCLASSES ) {
+		return 0;  /* false */
+	}
+
+	cls = &_classes[ icls ];
+	stats->szblock    = (icls + 1) * _SZCLASS;
+	stats->nused      = cls->nused;
+	stats->npeak      = cls->npeak;
+	stats->nbused     = cls->nused * stats->szblock;
+	stats->nbpeak     = cls->npeak * stats->szblock;
+	stats->nbreserved = cls->nreserved * stats->szblock;
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int pool_get_total_stats():
+ *
+ * Fill in the specified stats with the total usage statistics of
+ * the pool allocator, in the calling thread. Return 0 (false) on
+ * error, 1 (true) otherwise.
+ *
+ * NOTE: The peak values are the high-water marks of the totals,
+ *       which are NOT the sums of the peaks of all size-classes.
+ * --------------------------------------------------------------
+ */
+int pool_get_total_stats( PoolStats *stats )
+{
+	if ( NULL == stats ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+
+	*stats = _totals;
+	stats->szblock = 0;
+
+	return 1;  /* true */
+}
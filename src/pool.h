@@ -0,0 +1,41 @@
+/****************************************************************
+ * This file is part of the "2048cc" game.
+ *
+ * Author:       migf1 <mig_f1@hotmail.com>
+ * Version:      0.3a3
+ * Date:         July 21, 2014
+ * License:      Free Software (see comments in main.c for limitations)
+ * --------------------------------------------------------------
+ *
+ * The public interface of the size-classed pool allocator.
+ * For details, see the file: "pool.c"
+ ****************************************************************
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+/* Usage statistics of the pool allocator (per size-class, or in total).
+ * They refer ONLY to the pools of the calling thread.
+ */
+typedef struct _poolstats {
+	size_t szblock;     /* size of a single block (0 for totals) */
+	size_t nused;       /* # of blocks currently in use */
+	size_t npeak;       /* high-water mark of nused */
+	size_t nbused;      /* # of bytes currently in use */
+	size_t nbpeak;      /* high-water mark of nbused */
+	size_t nbreserved;  /* # of bytes reserved from the system */
+} PoolStats;
+
+#ifndef POOL_C
+extern void *pool_alloc( size_t size );
+extern void *pool_free( void *block, size_t size );
+extern int  pool_release( void );
+
+extern int  pool_get_stats( size_t size, PoolStats *stats );
+extern int  pool_get_total_stats( PoolStats *stats );
+#endif
+
+#endif
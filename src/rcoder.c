@@ -0,0 +1,419 @@
+/****************************************************************
+ * This file is part of the "2048cc" game.
+ *
+ * Author:       migf1 <mig_f1@hotmail.com>
+ * Version:      0.3a3
+ * Date:         July 21, 2014
+ * License:      Free Software (see comments in main.c for limitations)
+ * Dependencies: common.h, rcoder.h
+ * --------------------------------------------------------------
+ *
+ * Private implementation of a self-contained range coder (the same
+ * flavor as the one used by LZMA) for compressing the moves of replay
+ * files (see _binline_add() in the file: "mvhist.c"). The boards are
+ * not coded, not even as deltas, since they follow from the moves.
+ *
+ * Functions with a "_" prefix in their names are meant to be private
+ * in this source-module. They are usually inlined, without performing
+ * any sanity check on their arguments.
+ *
+ * Two kinds of symbols are coded:
+ *
+ * - bits, along with an adaptive probability of being 0, which is
+ *   kept by the caller and updated on every bit. So, the modelling
+ *   (which probability goes with which bit) is up to the caller, e.g.
+ *   a direction is coded as 2 bits, whose probabilities depend on the
+ *   previous direction. Small integers are coded bit by bit, from the
+ *   most significant one, each bit with a probability depending on the
+ *   bits above it (a "bit-tree", see rcenc_tree()).
+ *
+ * - integers uniformly distributed in a range [0, n) for small n
+ *   (e.g. the index of an empty tile, among all empty tiles).
+ *
+ * The encoder produces its output into a growing buffer, while the
+ * decoder consumes its input in place, one byte at a time, as symbols
+ * get decoded. The decoder consumes exactly the bytes produced by the
+ * encoder, so anything may follow the encoded data.
+ ****************************************************************
+ */
+
+#define RCODER_C
+
+#include <stdlib.h>        /* realloc(), free() */
+#include <string.h>        /* memset() */
+
+#include "common.h"
+#include "rcoder.h"
+
+enum {
+	_NBITS_PROB   = 11,          /* precision of probabilities */
+	_NBITS_ADAPT  = 5,           /* adaptation speed (lower is faster) */
+	_SZMIN_BUF    = 256          /* initial size of the output buffer */
+};
+
+/* Bit-models are scaled to (1 << _NBITS_PROB), the range is normalized
+ * whenever it drops below _RANGE_TOP.
+ */
+#define _PROB_ONE     (1U << _NBITS_PROB)
+#define _RANGE_TOP    (1UL << 24)
+
+/* --------------------------------------------------------------
+ * void rc_init_probs():
+ *
+ * Initialize the specified array of (n) adaptive probabilities (probs)
+ * to RC_PROB_INIT.
+ * --------------------------------------------------------------
+ */
+void rc_init_probs( RcProb *probs, size_t n )
+{
+	size_t i;
+
+	if ( NULL == probs ) {
+		DBGF( "%s", "NULL pointer argument (probs)!" );
+		return;
+	}
+
+	for (i=0; i < n; i++) {
+		probs[i] = RC_PROB_INIT;
+	}
+}
+
+/* --------------------------------------------------------------
+ * void _enc_putbyte():
+ *
+ * Append the specified byte (b) to the output of the specified
+ * encoder (enc), growing its buffer as needed.
+ * --------------------------------------------------------------
+ */
+static inline void _enc_putbyte( RcEncoder *enc, unsigned char b )
+{
+	unsigned char *try = NULL;
+	size_t capacity;
+
+	if ( enc->size == enc->capacity ) {
+		capacity = enc->capacity ? 2 * enc->capacity : _SZMIN_BUF;
+		try = realloc( enc->buf, capacity );
+		if ( NULL == try ) {
+			enc->failed = 1;  /* true */
+			return;
+		}
+		enc->buf      = try;
+		enc->capacity = capacity;
+	}
+	enc->buf[ enc->size++ ] = b;
+}
+
+/* --------------------------------------------------------------
+ * void _enc_shift_low():
+ *
+ * Move the top byte of the low end of the range of the specified
+ * encoder (enc) to its output, propagating any pending carry.
+ * --------------------------------------------------------------
+ */
+static inline void _enc_shift_low( RcEncoder *enc )
+{
+	const unsigned char carry = (unsigned char)(enc->low >> 32);
+
+	if ( (uint32_t)enc->low < 0xFF000000UL || carry ) {
+		unsigned char b = enc->cache;
+		do {
+			_enc_putbyte( enc, (unsigned char)(b + carry) );
+			b = 0xFF;
+		} while ( --enc->ncache != 0 );
+		enc->cache = (unsigned char)(enc->low >> 24);
+	}
+	enc->ncache++;
+	enc->low = (enc->low & 0x00FFFFFFUL) << 8;
+}
+
+/* --------------------------------------------------------------
+ * void _enc_normalize():
+ *
+ * Keep the range of the specified encoder (enc) wide enough.
+ * --------------------------------------------------------------
+ */
+static inline void _enc_normalize( RcEncoder *enc )
+{
+	while ( enc->range < _RANGE_TOP ) {
+		enc->range <<= 8;
+		_enc_shift_low( enc );
+	}
+}
+
+/* --------------------------------------------------------------
+ * void rcenc_init():
+ *
+ * Initialize the specified encoder (enc) with an empty output.
+ * --------------------------------------------------------------
+ */
+void rcenc_init( RcEncoder *enc )
+{
+	if ( NULL == enc ) {
+		DBGF( "%s", "NULL pointer argument (enc)!" );
+		return;
+	}
+
+	memset( enc, 0, sizeof(*enc) );
+	enc->range  = 0xFFFFFFFFUL;
+	enc->ncache = 1;
+}
+
+/* --------------------------------------------------------------
+ * void rcenc_bit():
+ *
+ * Encode with the specified encoder (enc) the specified bit (bit),
+ * given the probability (prob) of it being 0, and then adapt that
+ * probability to the bit. The probability should be initialized to
+ * RC_PROB_INIT before its 1st use.
+ * --------------------------------------------------------------
+ */
+void rcenc_bit( RcEncoder *enc, RcProb *prob, int bit )
+{
+	const uint32_t bound = (enc->range >> _NBITS_PROB) * *prob;
+
+	if ( !bit ) {
+		enc->range = bound;
+		*prob += (_PROB_ONE - *prob) >> _NBITS_ADAPT;
+	}
+	else {
+		enc->low   += bound;
+		enc->range -= bound;
+		*prob -= *prob >> _NBITS_ADAPT;
+	}
+	_enc_normalize( enc );
+}
+
+/* --------------------------------------------------------------
+ * void rcenc_tree():
+ *
+ * Encode with the specified encoder (enc) the (nbits) least significant
+ * bits of the specified integer (v), as a bit-tree over the specified
+ * array of adaptive probabilities (probs), which MUST have (1 << nbits)
+ * elements (the 1st one is not used).
+ * --------------------------------------------------------------
+ */
+void rcenc_tree( RcEncoder *enc, RcProb *probs, int nbits, unsigned int v )
+{
+	int bit;
+	unsigned int node = 1;
+
+	while ( nbits-- > 0 ) {
+		bit = (v >> nbits) & 1;
+		rcenc_bit( enc, &probs[node], bit );
+		node = (node << 1) | bit;
+	}
+}
+
+/* --------------------------------------------------------------
+ * void rcenc_uniform():
+ *
+ * Encode with the specified encoder (enc) the specified integer (v)
+ * which is uniformly distributed in the range [0, n). The range MUST
+ * NOT exceed 256 values.
+ * --------------------------------------------------------------
+ */
+void rcenc_uniform( RcEncoder *enc, unsigned int v, unsigned int n )
+{
+	if ( n < 2 ) {
+		return;     /* a single value needs no bits at all */
+	}
+	enc->range /= n;
+	enc->low   += (uint64_t)v * enc->range;
+	_enc_normalize( enc );
+}
+
+/* --------------------------------------------------------------
+ * int rcenc_flush():
+ *
+ * Complete the output of the specified encoder (enc). Return 0
+ * (false) if any memory reservation failed along the way, 1 (true)
+ * otherwise.
+ * --------------------------------------------------------------
+ */
+int rcenc_flush( RcEncoder *enc )
+{
+	int i;
+
+	if ( NULL == enc ) {
+		DBGF( "%s", "NULL pointer argument (enc)!" );
+		return 0;  /* false */
+	}
+
+	for (i=0; i < 5; i++) {
+		_enc_shift_low( enc );
+	}
+	return !enc->failed;
+}
+
+/* --------------------------------------------------------------
+ * void rcenc_free():
+ *
+ * Release the output of the specified encoder (enc), and empty it.
+ * --------------------------------------------------------------
+ */
+void rcenc_free( RcEncoder *enc )
+{
+	if ( enc ) {
+		free( enc->buf );
+		memset( enc, 0, sizeof(*enc) );
+	}
+}
+
+/* --------------------------------------------------------------
+ * unsigned int _dec_getbyte():
+ *
+ * Consume the next input byte of the specified decoder (dec). Past
+ * the end of the input, 0 is returned and the decoder is marked as
+ * overrun.
+ * --------------------------------------------------------------
+ */
+static inline unsigned int _dec_getbyte( RcDecoder *dec )
+{
+	if ( dec->cp >= dec->end ) {
+		dec->overrun = 1;  /* true */
+		return 0;
+	}
+	return *dec->cp++;
+}
+
+/* --------------------------------------------------------------
+ * void _dec_normalize():
+ *
+ * Keep the range of the specified decoder (dec) wide enough.
+ * --------------------------------------------------------------
+ */
+static inline void _dec_normalize( RcDecoder *dec )
+{
+	while ( dec->range < _RANGE_TOP ) {
+		dec->range <<= 8;
+		dec->code = (dec->code << 8) | _dec_getbyte( dec );
+	}
+}
+
+/* --------------------------------------------------------------
+ * int rcdec_init():
+ *
+ * Initialize the specified decoder (dec) for consuming the input
+ * starting at (buf) and ending right before (end). Return 0 (false)
+ * if the input does not start like an encoded one, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+int rcdec_init(
+	RcDecoder           *dec,
+	const unsigned char *buf,
+	const unsigned char *end
+	)
+{
+	int i;
+
+	if ( NULL == dec || NULL == buf || NULL == end ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+
+	memset( dec, 0, sizeof(*dec) );
+	dec->cp    = buf;
+	dec->end   = end;
+	dec->range = 0xFFFFFFFFUL;
+
+	/* the 1st byte produced by the encoder is always 0 */
+	if ( 0 != _dec_getbyte(dec) ) {
+		return 0;  /* false */
+	}
+	for (i=0; i < 4; i++) {
+		dec->code = (dec->code << 8) | _dec_getbyte( dec );
+	}
+
+	return !dec->overrun;
+}
+
+/* --------------------------------------------------------------
+ * int rcdec_bit():
+ *
+ * Decode with the specified decoder (dec) a bit encoded by rcenc_bit()
+ * along with the specified probability (prob), and adapt it the same
+ * way the encoder did. Return the decoded bit.
+ * --------------------------------------------------------------
+ */
+int rcdec_bit( RcDecoder *dec, RcProb *prob )
+{
+	int bit;
+	const uint32_t bound = (dec->range >> _NBITS_PROB) * *prob;
+
+	if ( dec->code < bound ) {
+		dec->range = bound;
+		*prob += (_PROB_ONE - *prob) >> _NBITS_ADAPT;
+		bit = 0;
+	}
+	else {
+		dec->code  -= bound;
+		dec->range -= bound;
+		*prob -= *prob >> _NBITS_ADAPT;
+		bit = 1;
+	}
+	_dec_normalize( dec );
+
+	return bit;
+}
+
+/* --------------------------------------------------------------
+ * unsigned int rcdec_tree():
+ *
+ * Decode with the specified decoder (dec) an integer of (nbits) bits
+ * encoded by rcenc_tree() over the specified array of probabilities
+ * (probs), and return it.
+ * --------------------------------------------------------------
+ */
+unsigned int rcdec_tree( RcDecoder *dec, RcProb *probs, int nbits )
+{
+	unsigned int node = 1;
+	const unsigned int top = 1U << nbits;
+
+	while ( node < top ) {
+		node = (node << 1) | rcdec_bit( dec, &probs[node] );
+	}
+	return node - top;
+}
+
+/* --------------------------------------------------------------
+ * int rcdec_uniform():
+ *
+ * Decode with the specified decoder (dec) an integer encoded by the
+ * function rcenc_uniform() in the range [0, n). Return the decoded
+ * integer, or -1 if the input is corrupted.
+ * --------------------------------------------------------------
+ */
+int rcdec_uniform( RcDecoder *dec, unsigned int n )
+{
+	uint32_t v;
+
+	if ( n < 2 ) {
+		return 0;
+	}
+	dec->range /= n;
+	v = dec->code / dec->range;
+	if ( v >= n ) {
+		return -1;
+	}
+	dec->code -= v * dec->range;
+	_dec_normalize( dec );
+
+	return (int)v;
+}
+
+/* --------------------------------------------------------------
+ * const unsigned char *rcdec_finish():
+ *
+ * Return a pointer to the input byte right after the data consumed
+ * by the specified decoder (dec), or NULL if it ran out of input.
+ * --------------------------------------------------------------
+ */
+const unsigned char *rcdec_finish( RcDecoder *dec )
+{
+	if ( NULL == dec ) {
+		DBGF( "%s", "NULL pointer argument (dec)!" );
+		return NULL;
+	}
+
+	return dec->overrun ? NULL : dec->cp;
+}
@@ -0,0 +1,75 @@
+/****************************************************************
+ * This file is part of the "2048cc" game.
+ *
+ * Author:       migf1 <mig_f1@hotmail.com>
+ * Version:      0.3a3
+ * Date:         July 21, 2014
+ * License:      Free Software (see comments in main.c for limitations)
+ * --------------------------------------------------------------
+ *
+ * The public interface of the adaptive binary range coder, used for
+ * compressing the moves of replay-files.
+ * For details, see the file: "rcoder.c"
+ ****************************************************************
+ */
+
+#ifndef RCODER_H
+#define RCODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Initial value of adaptive probabilities (that is, 50%) */
+#define RC_PROB_INIT    1024
+
+/* The adaptive probability of a bit being 0 (see rcenc_bit()) */
+typedef uint16_t RcProb;
+
+/* A range encoder, producing its output into a growing buffer.
+ * Its fields should be treated as read-only (buf & size are its
+ * output, which is complete only after rcenc_flush()).
+ */
+typedef struct _rcencoder {
+	unsigned char *buf;       /* encoded bytes */
+	size_t        size;       /* # of encoded bytes */
+	size_t        capacity;   /* # of bytes reserved for buf */
+	uint64_t      low;
+	uint32_t      range;
+	unsigned char cache;      /* byte pending a possible carry */
+	size_t        ncache;     /* # of pending bytes (cache + 0xFFs) */
+	int           failed;     /* did any reservation of memory fail? */
+} RcEncoder;
+
+/* A range decoder, consuming its input in place.
+ * Its fields should be treated as private.
+ */
+typedef struct _rcdecoder {
+	const unsigned char *cp;  /* next byte to be consumed */
+	const unsigned char *end; /* end of the input */
+	uint32_t            range;
+	uint32_t            code;
+	int                 overrun; /* was the input exhausted? */
+} RcDecoder;
+
+#ifndef RCODER_C
+extern void  rc_init_probs( RcProb *probs, size_t n );
+
+extern void  rcenc_init( RcEncoder *enc );
+extern void  rcenc_bit( RcEncoder *enc, RcProb *prob, int bit );
+extern void  rcenc_tree( RcEncoder *enc, RcProb *probs, int nbits, unsigned int v );
+extern void  rcenc_uniform( RcEncoder *enc, unsigned int v, unsigned int n );
+extern int   rcenc_flush( RcEncoder *enc );
+extern void  rcenc_free( RcEncoder *enc );
+
+extern int   rcdec_init(
+                    RcDecoder           *dec,
+                    const unsigned char *buf,
+                    const unsigned char *end
+                    );
+extern int   rcdec_bit( RcDecoder *dec, RcProb *prob );
+extern unsigned int rcdec_tree( RcDecoder *dec, RcProb *probs, int nbits );
+extern int   rcdec_uniform( RcDecoder *dec, unsigned int n );
+extern const unsigned char *rcdec_finish( RcDecoder *dec );
+#endif
+
+#endif
@@ -0,0 +1,634 @@
+/****************************************************************
+ * This file is part of the "2048cc" game.
+ *
+ * Author:       migf1 <mig_f1@hotmail.com>
+ * Version:      0.3a3
+ * Date:         July 21, 2014
+ * License:      Free Software (see comments in main.c for limitations)
+ * Dependencies: common.h, my.h, con_color.h, screen.h
+ * --------------------------------------------------------------
+ *
+ * Private implementation of the Screen "class". The accompanying
+ * header file "screen.h" exposes publicly the "class" as an opaque
+ * data-type.
+ *
+ * Functions with a "_" prefix in their names are meant to be private
+ * in this source-module. They are usually inlined, without performing
+ * any sanity check on their arguments.
+ *
+ * A Screen object is a shadow of the console screen, as a grid of
+ * cells (glyph, fg & bg colors). The text-user-interface draws into
+ * its cells (see screen_printf() & screen_paint()) instead of drawing
+ * directly on the console. When a frame ends (see screen_end_frame())
+ * the cells are compared against the ones currently displayed, and
+ * only the runs of cells that differ are written to the console (as a
+ * single frame, see my_begin_frame() in the file "my.c"). Thus, after
+ * a move only the tiles that changed get written, plus the scores.
+ *
+ * Drawing outside any frame is written at once, as if it was a frame
+ * on its own. Anything written on the console by other means makes
+ * the screen object stale, so it should be invalidated afterwards
+ * (see screen_invalidate()) so the next frame repaints everything.
+ *
+ * Colors are kept in the cells as indices of a small table of the
+ * distinct colors used so far. Blank cells do not keep their fg color
+ * (it does not show), so they compare equal regardless of it.
+ *
+ * Looking up a color in the table costs a string comparison per entry
+ * with ANSI colors, so a pair of colors drawn over and over (say, the
+ * colors of a tile) may get resolved just once into a pen (see
+ * screen_pen()). Drawing with a pen copies ready-made cells.
+ ****************************************************************
+ */
+
+#define SCREEN_C
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "common.h"
+#include "my.h"
+#include "con_color.h"
+#include "screen.h"
+
+#define _MAXCOLORS   64  /* max distinct colors (0 is BG_DEFAULT) */
+#define _MAXGAP      4   /* max unchanged cells re-written to join runs */
+
+#define _DEFAULT_W   80  /* dimensions if the console cannot tell */
+#define _DEFAULT_H   24
+
+/* A single cell of the screen */
+struct _cell {
+	unsigned char ch;    /* glyph */
+	unsigned char fg;    /* index of fg color (0 for blanks) */
+	unsigned char bg;    /* index of bg color */
+};
+
+/* The shadow of the console screen */
+struct _Screen {
+	int            w, h;       /* dimensions (in cells) */
+	struct _cell   *cells;     /* the screen being composed */
+	struct _cell   *shown;     /* the screen displayed on the console */
+	int            isshown;    /* does shown match the console? */
+	char           *line;      /* work-area for writing runs of cells */
+	int            x, y;       /* cursor position */
+	int            ymin, ymax; /* rows changed since the last update */
+	int            nframes;    /* depth of frames (see screen_begin_frame())*/
+	ConSingleColor colors[ _MAXCOLORS ];
+	int            ncolors;    /* # of colors in the table */
+};
+
+/* --------------------------------------------------------------
+ * int _screen_resize():
+ *
+ * Resize the specified screen object (scr) to the dimensions of the
+ * console, blanking all its cells if they changed. Return 0 (false)
+ * on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _screen_resize( Screen *scr )
+{
+	int i, w, h;
+	struct _cell *cells = NULL, *shown = NULL;
+	char *line = NULL;
+
+	w = my_console_width();
+	h = my_console_height();
+	if ( w < 1 || h < 1 ) {
+		w = _DEFAULT_W;
+		h = _DEFAULT_H;
+	}
+	if ( w == scr->w && h == scr->h ) {
+		return 1;  /* true */
+	}
+
+	cells = malloc( w * h * sizeof(*cells) );
+	shown = malloc( w * h * sizeof(*shown) );
+	line  = malloc( w + 1 );
+	if ( !cells || !shown || !line ) {
+		free( cells );
+		free( shown );
+		free( line );
+		return 0;  /* false */
+	}
+	for (i=0; i < w * h; i++) {
+		cells[i].ch = ' ';
+		cells[i].fg = cells[i].bg = 0;
+	}
+	memcpy( shown, cells, w * h * sizeof(*shown) );
+
+	free( scr->cells );
+	free( scr->shown );
+	free( scr->line );
+	scr->cells   = cells;
+	scr->shown   = shown;
+	scr->line    = line;
+	scr->w       = w;
+	scr->h       = h;
+	scr->isshown = 0;  /* false */
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _color_index():
+ *
+ * Return the index of the specified color in the table of colors of
+ * the specified screen object (scr), adding it there if needed (if
+ * the table is full, the index of BG_DEFAULT is returned instead).
+ * --------------------------------------------------------------
+ */
+static inline int _color_index( Screen *scr, const ConSingleColor color )
+{
+#if CON_COLORMODE_NOCOLORS == CON_COLORMODE
+	(void)scr;
+	(void)color;
+	return 0;
+#else
+	int i;
+
+	for (i=0; i < scr->ncolors; i++) {
+		if ( CONOUT_SAMECLR(scr->colors[i], color) ) {
+			return i;
+		}
+	}
+	if ( _MAXCOLORS == scr->ncolors ) {
+		return 0;
+	}
+	CONOUT_CPYCLR( scr->colors[i], color );
+	return scr->ncolors++;
+#endif
+}
+
+/* --------------------------------------------------------------
+ * void _put_cell():
+ *
+ * Put the specified glyph (ch) with the specified color indices
+ * (fg, bg) at the cursor of the specified screen object (scr),
+ * and advance the cursor. Nothing is put outside the screen.
+ * --------------------------------------------------------------
+ */
+static inline void _put_cell( Screen *scr, int ch, int fg, int bg )
+{
+	struct _cell *cell = NULL;
+
+	if ( scr->x >= 0 && scr->x < scr->w && scr->y >= 0 && scr->y < scr->h )
+	{
+		cell = &scr->cells[ scr->y * scr->w + scr->x ];
+		cell->ch = (unsigned char)ch;
+		cell->fg = (unsigned char)(' ' == ch ? 0 : fg);
+		cell->bg = (unsigned char)bg;
+		if ( scr->y < scr->ymin ) {
+			scr->ymin = scr->y;
+		}
+		if ( scr->y > scr->ymax ) {
+			scr->ymax = scr->y;
+		}
+	}
+	scr->x++;
+}
+
+/* --------------------------------------------------------------
+ * void _put_ncells():
+ *
+ * Put the specified count (n) of copies of the specified cell at the
+ * cursor of the specified screen object (scr), and advance the cursor.
+ * Nothing is put outside the screen.
+ * --------------------------------------------------------------
+ */
+static inline void _put_ncells( Screen *scr, const struct _cell *cell, int n )
+{
+	int x0 = scr->x, x1 = scr->x + n;
+	struct _cell *row = NULL;
+
+	scr->x = x1;
+	if ( scr->y < 0 || scr->y >= scr->h ) {
+		return;
+	}
+	if ( x0 < 0 ) {
+		x0 = 0;
+	}
+	if ( x1 > scr->w ) {
+		x1 = scr->w;
+	}
+	if ( x0 >= x1 ) {
+		return;
+	}
+
+	row = &scr->cells[ scr->y * scr->w ];
+	while ( x0 < x1 ) {
+		row[ x0++ ] = *cell;
+	}
+	if ( scr->y < scr->ymin ) {
+		scr->ymin = scr->y;
+	}
+	if ( scr->y > scr->ymax ) {
+		scr->ymax = scr->y;
+	}
+}
+
+/* --------------------------------------------------------------
+ * int _issame_cell():
+ *
+ * Return 1 (true) if the specified cells (a, b) look the same
+ * on the console, 0 (false) otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _issame_cell( const struct _cell *a, const struct _cell *b )
+{
+	return a->ch == b->ch && a->fg == b->fg && a->bg == b->bg;
+}
+
+/* --------------------------------------------------------------
+ * void _write_run():
+ *
+ * Write on the console the specified run of cells (cells) of the
+ * specified screen object (scr), having the specified length (n),
+ * starting at the current position of the console cursor. Adjacent
+ * cells of the same colors are written together.
+ * --------------------------------------------------------------
+ */
+static void _write_run( Screen *scr, const struct _cell *cells, int n )
+{
+	int i, k, fg, bg;
+
+	for (i=0; i < n; i += k)
+	{
+		fg = cells[i].fg;
+		bg = cells[i].bg;
+		for (k=0; i+k < n && cells[i+k].bg == bg; k++) {
+			if ( 0 == cells[i+k].fg ) {
+				;  /* blanks go along with any fg */
+			}
+			else if ( 0 == fg ) {
+				fg = cells[i+k].fg;
+			}
+			else if ( cells[i+k].fg != fg ) {
+				break;
+			}
+			scr->line[k] = (char)cells[i+k].ch;
+		}
+		scr->line[k] = '\0';
+
+		if ( 0 == fg ) {
+			CONOUT_PAINT_NTIMES( scr->colors[bg], k );
+		}
+		else {
+			CONOUT_PRINTF(
+				scr->colors[fg],
+				scr->colors[bg],
+				"%s",
+				scr->line
+				);
+		}
+	}
+}
+
+/* --------------------------------------------------------------
+ * void _screen_update():
+ *
+ * Write on the console (as a single frame) all the runs of cells of
+ * the specified screen object (scr) which differ from the displayed
+ * ones, and then move the console cursor to the cursor of scr.
+ * --------------------------------------------------------------
+ */
+static void _screen_update( Screen *scr )
+{
+	int x, y, end, i;
+	int xcon = -1, ycon = -1;             /* position of console cursor */
+	const struct _cell *row = NULL, *srow = NULL;
+
+	if ( !scr->isshown ) {
+		scr->ymin = 0;
+		scr->ymax = scr->h - 1;
+	}
+
+	my_begin_frame();
+	CONOUT_BEGIN_FRAME();
+
+	for (y = scr->ymin; y <= scr->ymax; y++)
+	{
+		row  = &scr->cells[ y * scr->w ];
+		srow = &scr->shown[ y * scr->w ];
+		for (x=0; x < scr->w; x = end)
+		{
+			if ( scr->isshown && _issame_cell(&row[x], &srow[x]) ) {
+				end = x + 1;
+				continue;
+			}
+
+			/* a run of changed cells (joining close ones) */
+			end = x + 1;
+			for (i = end; i < scr->w && i - end < _MAXGAP; i++) {
+				if ( !scr->isshown || !_issame_cell(&row[i], &srow[i]) ) {
+					end = i + 1;
+				}
+			}
+
+			if ( x != xcon || y != ycon ) {
+				my_gotoxy( x, y );
+			}
+			_write_run( scr, &row[x], end - x );
+			xcon = end;
+			ycon = y;
+		}
+		memcpy( (void *)srow, row, scr->w * sizeof(*row) );
+	}
+
+	if ( scr->x != xcon || scr->y != ycon ) {
+		my_gotoxy( scr->x, scr->y );
+	}
+
+	CONOUT_END_FRAME();
+	my_end_frame();
+
+	scr->isshown = 1;  /* true */
+	scr->ymin    = scr->h;
+	scr->ymax    = -1;
+}
+
+/* --------------------------------------------------------------
+ * void _screen_autoupdate():
+ *
+ * Update the console from the specified screen object (scr) if no
+ * frame is being composed (see screen_end_frame()).
+ * --------------------------------------------------------------
+ */
+static inline void _screen_autoupdate( Screen *scr )
+{
+	if ( 0 == scr->nframes ) {
+		_screen_update( scr );
+	}
+}
+
+/* --------------------------------------------------------------
+ * (Destructor) Screen *screen_free():
+ *
+ * Release all resources occupied by the specified screen object,
+ * and return NULL (so the caller may assign it back to the object
+ * pointer).
+ * --------------------------------------------------------------
+ */
+Screen *screen_free( Screen *scr )
+{
+	if ( scr ) {
+		free( scr->cells );
+		free( scr->shown );
+		free( scr->line );
+		free( scr );
+	}
+	return NULL;
+}
+
+/* --------------------------------------------------------------
+ * (Constructor) Screen *new_screen():
+ *
+ * Create a new screen object, having the dimensions of the console,
+ * all blank in BG_DEFAULT, and return a pointer to it, or NULL on
+ * error. Its 1st update repaints the whole console.
+ *
+ * NOTE: The console colors MUST have been initialized already
+ *       (see CONOUT_INIT() in the file "con_color.h").
+ * --------------------------------------------------------------
+ */
+Screen *new_screen( void )
+{
+	Screen *scr = calloc( 1, sizeof(*scr) );
+
+	if ( NULL == scr ) {
+		DBGF( "%s", "calloc() failed!" );
+		return NULL;
+	}
+	if ( !_screen_resize(scr) ) {
+		DBGF( "%s", "_screen_resize() failed!" );
+		return screen_free( scr );
+	}
+
+	CONOUT_CPYCLR( scr->colors[0], BG_DEFAULT );
+	scr->ncolors = 1;
+	scr->ymin    = scr->h;
+	scr->ymax    = -1;
+
+	return scr;
+}
+
+/* --------------------------------------------------------------
+ * int screen_invalidate():
+ *
+ * Forget what the console displays, so the next update of the
+ * specified screen object (scr) repaints all of it (e.g. after the
+ * console got written by other means). The dimensions of scr are
+ * re-read from the console too. Return 0 (false) on error, 1 (true)
+ * otherwise.
+ * --------------------------------------------------------------
+ */
+int screen_invalidate( Screen *scr )
+{
+	if ( NULL == scr ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;  /* false */
+	}
+	if ( !_screen_resize(scr) ) {
+		DBGF( "%s", "_screen_resize() failed!" );
+		return 0;  /* false */
+	}
+	scr->isshown = 0;  /* false */
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * void screen_begin_frame():
+ *
+ * Start composing a frame on the specified screen object (scr):
+ * nothing gets written on the console until the matching call of
+ * screen_end_frame(). Frames may be nested, in which case only the
+ * outermost one counts.
+ * --------------------------------------------------------------
+ */
+void screen_begin_frame( Screen *scr )
+{
+	if ( NULL == scr ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return;
+	}
+	scr->nframes++;
+}
+
+/* --------------------------------------------------------------
+ * void screen_end_frame():
+ *
+ * End composing a frame on the specified screen object (scr). If it
+ * is the outermost one, write on the console whatever changed since
+ * the last update (see screen_begin_frame()).
+ * --------------------------------------------------------------
+ */
+void screen_end_frame( Screen *scr )
+{
+	if ( NULL == scr ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return;
+	}
+	if ( scr->nframes > 0 && 0 == --scr->nframes ) {
+		_screen_update( scr );
+	}
+}
+
+/* --------------------------------------------------------------
+ * void screen_gotoxy():
+ *
+ * Move the cursor of the specified screen object (scr) to the
+ * specified position (x,y).
+ * --------------------------------------------------------------
+ */
+void screen_gotoxy( Screen *scr, int x, int y )
+{
+	if ( NULL == scr ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return;
+	}
+	scr->x = x;
+	scr->y = y;
+	_screen_autoupdate( scr );
+}
+
+/* --------------------------------------------------------------
+ * int screen_printf():
+ *
+ * This function is a colored printf() into the specified screen
+ * object (scr), starting at its cursor, using the specified
+ * foreground & background colors (fg, bg). Return the count of
+ * the printed characters, or -1 on error.
+ *
+ * NOTE: The output should fit in a single line of the screen
+ *       (anything beyond its right edge is lost).
+ * --------------------------------------------------------------
+ */
+int screen_printf(
+	Screen               *scr,
+	const ConSingleColor fg,
+	const ConSingleColor bg,
+	const char           *fmt,
+	...
+	)
+{
+	int  ifg, ibg, n = 0;
+	char *txtout = NULL;
+	va_list vargs;
+
+	if ( NULL == scr || NULL == fmt ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return -1;
+	}
+
+	va_start( vargs, fmt );
+	txtout = vprintf_to_text( fmt, vargs );
+	va_end( vargs );
+	if ( NULL == txtout ) {
+		return -1;
+	}
+
+	ifg = _color_index( scr, fg );
+	ibg = _color_index( scr, bg );
+	for (n=0; '\0' != txtout[n]; n++) {
+		_put_cell( scr, txtout[n], ifg, ibg );
+	}
+	free( txtout );
+	_screen_autoupdate( scr );
+
+	return n;
+}
+
+/* --------------------------------------------------------------
+ * void screen_paint():
+ *
+ * Paint the specified count (n) of blank cells in the specified
+ * background color (bg), starting at the cursor of the specified
+ * screen object (scr).
+ * --------------------------------------------------------------
+ */
+void screen_paint( Screen *scr, const ConSingleColor bg, int n )
+{
+	struct _cell cell;
+
+	if ( NULL == scr ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return;
+	}
+
+	cell.ch = ' ';
+	cell.fg = 0;
+	cell.bg = (unsigned char)_color_index( scr, bg );
+	_put_ncells( scr, &cell, n );
+	_screen_autoupdate( scr );
+}
+
+/* --------------------------------------------------------------
+ * int screen_pen():
+ *
+ * Resolve the specified foreground & background colors (fg, bg) in
+ * the table of colors of the specified screen object (scr), and
+ * return them as a pen for screen_paint_pen() & screen_puts_pen(),
+ * or -1 on error. A pen stays valid for the lifetime of scr.
+ * --------------------------------------------------------------
+ */
+int screen_pen( Screen *scr, const ConSingleColor fg, const ConSingleColor bg )
+{
+	if ( NULL == scr ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return -1;
+	}
+	return _color_index(scr, bg) << 8 | _color_index(scr, fg);
+}
+
+/* --------------------------------------------------------------
+ * void screen_paint_pen():
+ *
+ * Like screen_paint(), but in the background color of the specified
+ * pen (see screen_pen()).
+ * --------------------------------------------------------------
+ */
+void screen_paint_pen( Screen *scr, int pen, int n )
+{
+	struct _cell cell;
+
+	if ( NULL == scr || pen < 0 ) {
+		DBGF( "%s", "Invalid argument!" );
+		return;
+	}
+
+	cell.ch = ' ';
+	cell.fg = 0;
+	cell.bg = (unsigned char)(pen >> 8);
+	_put_ncells( scr, &cell, n );
+	_screen_autoupdate( scr );
+}
+
+/* --------------------------------------------------------------
+ * int screen_puts_pen():
+ *
+ * Put the specified text (s) into the specified screen object (scr),
+ * starting at its cursor, in the colors of the specified pen (see
+ * screen_pen()). Return the count of the put characters, or -1 on
+ * error. The text should fit in a single line of the screen (see
+ * screen_printf()).
+ * --------------------------------------------------------------
+ */
+int screen_puts_pen( Screen *scr, int pen, const char *s )
+{
+	int n;
+
+	if ( NULL == scr || NULL == s || pen < 0 ) {
+		DBGF( "%s", "Invalid argument!" );
+		return -1;
+	}
+
+	for (n=0; '\0' != s[n]; n++) {
+		_put_cell( scr, s[n], pen & 0xFF, pen >> 8 );
+	}
+	_screen_autoupdate( scr );
+
+	return n;
+}
@@ -0,0 +1,51 @@
+/****************************************************************
+ * This file is part of the "2048cc" game.
+ *
+ * Author:       migf1 <mig_f1@hotmail.com>
+ * Version:      0.3a3
+ * Date:         July 21, 2014
+ * License:      Free Software (see comments in main.c for limitations)
+ * Dependencies: con_color.h
+ * --------------------------------------------------------------
+ *
+ * The public interface of the Screen "class".
+ * For details, see the file: "screen.c"
+ ****************************************************************
+ */
+
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include "con_color.h"
+
+/* The "class" is forward-declared as an opaque data-type */
+typedef struct _Screen Screen;
+
+#ifndef SCREEN_C
+extern Screen *new_screen( void );
+extern Screen *screen_free( Screen *scr );
+
+extern int    screen_invalidate( Screen *scr );
+extern void   screen_begin_frame( Screen *scr );
+extern void   screen_end_frame( Screen *scr );
+
+extern void   screen_gotoxy( Screen *scr, int x, int y );
+extern int    screen_printf(
+                      Screen               *scr,
+                      const ConSingleColor fg,
+                      const ConSingleColor bg,
+                      const char           *fmt,
+                      ...
+                      );
+extern void   screen_paint( Screen *scr, const ConSingleColor bg, int n );
+
+extern int    screen_pen(
+                      Screen               *scr,
+                      const ConSingleColor fg,
+                      const ConSingleColor bg
+                      );
+extern void   screen_paint_pen( Screen *scr, int pen, int n );
+extern int    screen_puts_pen( Screen *scr, int pen, const char *s );
+#endif
+
+#endif
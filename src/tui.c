@@ -6,7 +6,7 @@
  * Date:         July 20, 2014
  * License:      Free Software (see comments in main.c for limitations)
  * Dependencies: con_color.h, my.h, common.h, board.h,
- *               gs.h, mvhist.h, tui_skin.h
+ *               gs.h, mvhist.h, tui_skin.h, screen.h
  * --------------------------------------------------------------
  *
  * Private implementation of the Tui "class".
@@ -34,7 +34,8 @@
  * - title-bar
  * - board of tiles
  * - scores-bar   (shows the current & best score)
- * - info-bar     (shows messages like the winning message)
+ * - info-bar     (shows messages like the winning message, or the
+ *                 memory used by the moves-history when toggled on)
  *
  * The right-half consists of the following entities (top to bottom):
  * - help-box     (shows the game instructions & commands)
@@ -59,6 +60,16 @@
  * of type TuiSkin: (TuiSkin *)tui->skin;
  *
  * It is implemented in a different source module (tui_skin.c)
+ *
+ * Screen
+ * ------
+ *
+ * The layout entities are not drawn directly on the console, but on
+ * a shadow of it: (Screen *)tui->scr; which writes on the console
+ * only the cells that actually changed (see the file "screen.c").
+ * The only exception is the prompt for loading a replay-file, which
+ * lists the replay-files as plain text, so the screen object gets
+ * invalidated afterwards.
  * 
  *****************************************************************
  */
@@ -68,6 +79,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
 
 #include "tui.h"
 #include "tui_skin.h"
@@ -77,6 +91,24 @@
 #include "board.h"
 #include "gs.h"
 #include "mvhist.h"
+#include "catalog.h"
+#include "screen.h"
+
+/* Size of the buffer of the standard output, enough for a whole
+ * frame (see tui_begin_frame())
+ */
+#define _SZ_FRAMEBUF    (64 * 1024)
+
+/* Size of the buffers of _nbytes_to_text(), enough for the 20 digits
+ * of the largest unsigned long, ".9M" and the '\0'
+ */
+#define _SZ_NBYTES_TEXT  24
+
+/* Animation of the moves (see tui_animate_board()) */
+#define _ANIM_FPS           60  /* target frame rate */
+#define _MSECS_ANIM_SLIDE   90  /* duration of the slides */
+#define _MSECS_ANIM_PULSE   60  /* duration of the merge pulses */
+#define _MSECS_ANIM_BUDGET  12  /* max time to render a single frame */
 
 /* single screen-box (screen area) */
 struct _scrbox {
@@ -100,12 +132,25 @@ struct _scrlayout {
 	struct _scrbox iobar;
 };
 
+/* changes of the board since it got drawn */
+struct _tuievents {
+	int         queued;         /* any changes since it got drawn? */
+	BoardEvents set;            /* set.n < 0 if unknown */
+};
+
 /* text user interface */
 struct _tui {
 	GameState         *state;
 	MovesHistory      *mvhist;
 	struct _scrlayout layout;
 	TuiSkin           *skin;
+	Screen            *scr;     /* shadow of the console screen */
+	struct _tuievents *events;  /* changes of the board since it got
+	                             * drawn (see tui_set_board_events()) */
+	int               tilepens[ TUI_SKIN_NTILES ];
+	                            /* screen pens of the tile colors of the
+	                             * skin, by log2(value) (see _set_tilepens())*/
+	int               showmem;  /* info-bar shows memory info? */
 };
 
 int tui_cls( const Tui *tui );
@@ -146,6 +191,17 @@ int tui_sys_getkey( unsigned int *outKeyMask )
 	return my_getch( outKeyMask );
 }
 
+/* --------------------------------------------------------------
+ * Wait up to the specified milliseconds (negative for ever) for a
+ * key to be pressed. Return 1 (true) if one is pending, 0 (false)
+ * otherwise. The key itself is then got with tui_sys_getkey().
+ * --------------------------------------------------------------
+ */
+int tui_sys_wait_key( long int msecs )
+{
+	return my_wait_key( msecs );
+}
+
 /* --------------------------------------------------------------
  * Pause until the user presses a key.
  * --------------------------------------------------------------
@@ -181,6 +237,45 @@ int tui_sys_sleep( unsigned long int msecs )
 	return my_sleep_msecs( msecs );
 }
 
+/* --------------------------------------------------------------
+ * void tui_begin_frame():
+ *
+ * Start composing a frame on the screen of the specified tui object:
+ * everything drawn until the matching call of tui_end_frame() gets
+ * compared against what the terminal displays, and only the changed
+ * cells get written, at once, with a single system call (rather than
+ * one per cursor move, color change or text). Frames may be nested,
+ * in which case only the outermost one counts.
+ *
+ * NOTE: No input should be read while a frame is being composed,
+ *       since the frame has not been displayed yet.
+ * --------------------------------------------------------------
+ */
+void tui_begin_frame( const Tui *tui )
+{
+	if ( NULL == tui ) {
+		DBGF( "%s", "NULL pointer argument (tui)!" );
+		return;
+	}
+	screen_begin_frame( tui->scr );
+}
+
+/* --------------------------------------------------------------
+ * void tui_end_frame():
+ *
+ * End composing a frame on the screen of the specified tui object,
+ * displaying it if it is the outermost one (see tui_begin_frame()).
+ * --------------------------------------------------------------
+ */
+void tui_end_frame( const Tui *tui )
+{
+	if ( NULL == tui ) {
+		DBGF( "%s", "NULL pointer argument (tui)!" );
+		return;
+	}
+	screen_end_frame( tui->scr );
+}
+
 /* --------------------------------------------------------------
  * char *_get_replay_fname_from_user():
  *
@@ -200,8 +295,11 @@ char *_get_replay_fname_from_user( char *fname )
 	strncpy( fname, REPLAYS_FOLDER "/", SZMAX_FNAME-1 );
 	fname[ SZMAX_FNAME-1 ] = '\0';
 
+	/* line input needs the original settings of the terminal */
 	cp = &fname[idxbeg];
+	my_raw_end();
 	s_getflushed( cp, szfname );
+	my_raw_begin();
 
 	return fname;
 }
@@ -209,13 +307,14 @@ char *_get_replay_fname_from_user( char *fname )
 /* --------------------------------------------------------------
  * int _printfxy():
  *
- * This function is an enhanced printf(). It expects 4 additional
- * leading arguments, specifying the foreground (fg) & background
- * (bg) colors for the output, along with its starting position on
- * the console screen (x,y).
+ * This function is an enhanced printf() into the specified screen
+ * object (scr). It expects 4 additional leading arguments, specifying
+ * the foreground (fg) & background (bg) colors for the output, along
+ * with its starting position on the screen (x,y).
  * --------------------------------------------------------------
  */
 int _printfxy(
+	Screen *scr,
 	const ConSingleColor fg,
 	const ConSingleColor bg,
 	int x,
@@ -235,13 +334,10 @@ int _printfxy(
 		return -1;
 	}
 
-	my_gotoxy(x,y);
-	CONOUT_NPRINTF(
-		ret,        /* gets updated to the return value of printf() */
-		fg, bg,
-		"%s",
-		txtout
-		);
+	screen_begin_frame( scr );
+	screen_gotoxy( scr, x,y );
+	ret = screen_printf( scr, fg, bg, "%s", txtout );
+	screen_end_frame( scr );
 	free( txtout );
 
 	return ret;
@@ -291,12 +387,14 @@ static int _put_hspan_centered(
  * int _putxy_hspan_centered():
  *
  * Using the given foreground & background colors (fg, bg), and
- * starting at the specified cursor position (x,y), center and
- * display the specified cstring (text) across the specified
- * number of columns (ncols). Return 0 on error, 1 otherwise.
+ * starting at the specified position (x,y) of the specified screen
+ * object (scr), center and display the specified cstring (text)
+ * across the specified number of columns (ncols). Return 0 on error,
+ * 1 otherwise.
  * --------------------------------------------------------------
  */
 int _putxy_hspan_centered(
+	Screen *scr,
 	const ConSingleColor fg,
 	const ConSingleColor bg,
 	int x,
@@ -311,138 +409,134 @@ int _putxy_hspan_centered(
 		return 0;
 	}
 
-	my_gotoxy( x,y );
+	screen_begin_frame( scr );
+	screen_gotoxy( scr, x,y );
 
 	len = strlen( text );
-	if ( len >= ncols ) {
-		CONOUT_PRINTF( fg, bg, "%s", text );
-		return 1;
+	if ( len < ncols ) {
+		screen_paint( scr, bg, ncols );
+		x += (ncols - len) / 2;
+		screen_gotoxy( scr, x, y );
 	}
-
-	CONOUT_PAINT_NTIMES( bg, ncols );
-
-	x += (ncols - len) / 2;
-	my_gotoxy( x, y );
-	CONOUT_PRINTF( fg, bg, "%s", text );
+	screen_printf( scr, fg, bg, "%s", text );
+	screen_end_frame( scr );
 
 	return 1;
 }
 
 /* --------------------------------------------------------------
- * int _int_count_digits():
+ * void _set_tilepens():
  *
- * Return the digits count of the given integer (0 counts as 1 digit,
- * for negative numbers the minus sign in not counted).
- *
- * NOTE: Used only in this module, in the function: _draw_tileval_at_xy().
+ * Resolve the tile colors of the skin of the specified tui object
+ * into screen pens (see screen_pen() in the file "screen.c"), so the
+ * tiles get drawn without looking up their colors every time. It is
+ * called whenever the skin changes.
  * --------------------------------------------------------------
  */
-static int _int_count_digits( int num )
+static void _set_tilepens( Tui *tui )
 {
-	int i = 0;
+	int i;
+	const ConColors *tc = tui_skin_get_colors_tiles( tui->skin );
 
-	if ( 0 == num ) {
-		return 1;
+	for (i=0; i < TUI_SKIN_NTILES; i++) {
+		tui->tilepens[i] = screen_pen( tui->scr, tc[i].fg, tc[i].bg );
 	}
-	while ( num ) {
-		num /= 10;
-		i++;
-	}
-	return i;
 }
 
 /* --------------------------------------------------------------
- * const ConColors *_tileval_to_colors():
- *
- * Depending on the specified tile-value (val), query the skin of
- * the specified tui for the corresponding foreground & background
- * colors, and return them.
+ * int _tileval_to_pen():
  *
- * These colors are returned in the form of pointer to a ConColors
- * structure, which is available through the con_color.h preprocessor
- * interface.
+ * Return the screen pen of the specified tile-value (val) in the
+ * specified tui object, that is its tile-pen indexed by log2(val),
+ * or the last one if val is too big to have a pen of its own.
  *
- * NOTE: Used exclusively in the function _draw_tileval_at_xy(),
- *       so it depends heavily on assumptions made in that context.
+ * NOTE: The tile-values are powers of 2 (or 0), so their log2 is
+ *       the position of their single set bit. A de Bruijn sequence
+ *       multiplied by the value moves a distinct 5-bit pattern to
+ *       the top bits for every position, so a small table maps it
+ *       back to the position, without looping over the bits.
  * --------------------------------------------------------------
  */
-static inline const ConColors *_tileval_to_colors( int val, const Tui *tui )
+static inline int _tileval_to_pen( int val, const Tui *tui )
 {
-	switch ( val )
-	{
-		case 0:
-			return tui_skin_get_colors_tile0( tui->skin );
-		case 2:
-			return tui_skin_get_colors_tile2( tui->skin );
-		case 4:
-			return tui_skin_get_colors_tile4( tui->skin );
-		case 8:
-			return tui_skin_get_colors_tile8( tui->skin );
-		case 16:
-			return tui_skin_get_colors_tile16( tui->skin );
-		case 32:
-			return tui_skin_get_colors_tile32( tui->skin );
-		case 64:
-			return tui_skin_get_colors_tile64( tui->skin );
-		case 128:
-			return tui_skin_get_colors_tile128( tui->skin );
-		case 256:
-			return tui_skin_get_colors_tile256( tui->skin );
-		case 512:
-			return tui_skin_get_colors_tile512( tui->skin );
-		case 1024:
-			return tui_skin_get_colors_tile1024( tui->skin );
-		case 2048:
-			return tui_skin_get_colors_tile2048( tui->skin );
-		default:
-			return tui_skin_get_colors_tilebig( tui->skin );
-	}
+	static const unsigned char log2s[32] = {
+		 0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+		31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9
+	};
+	int e = log2s[ ((unsigned long)val * 0x077CB531UL & 0xFFFFFFFFUL) >> 27 ];
 
-	return NULL;
+	return tui->tilepens[ e < TUI_SKIN_NTILES ? e : TUI_SKIN_NTILES-1 ];
 }
 
 /* --------------------------------------------------------------
- * int _draw_tileval_at_xy():
+ * int _draw_tileval_colored_at_xy():
  *
  * Draw the specified tile-value at the specified position (x,y)
- * on the console screen. Return 0 (false) on error, 1 (true)
- * otherwise.
+ * on the console screen, using the specified screen pen (pen).
+ * Return 0 (false) on error, 1 (true) otherwise.
  *
- * NOTE: Used exclusively in the function tui_draw_board(),
- *       so it depends heavily on assumptions made in that
- *       context.
+ * NOTE: Used exclusively in the function _draw_tileval_at_xy()
+ *       and in the animation of the moves (see tui_animate_board())
+ *       so it depends heavily on assumptions made in that context.
  * --------------------------------------------------------------
  */
-static inline int _draw_tileval_at_xy(
+static inline int _draw_tileval_colored_at_xy(
 	const Tui *tui,
 	int       tileval,
+	int       pen,
 	int       x,
 	int       y
 	)
 {
 	int i;
-	const ConColors *tc;                  /* tile colors */
+	char txt[16] = {'\0'};
 	const int wtile = tui->layout.tile.w; /* drawing width of any tile */
 	const int htile = tui->layout.tile.h; /* drawing height of any tile*/
 
-	tc  = _tileval_to_colors( tileval, tui );
-
 	/* first draw the tile box */
 	for (i=0; i < htile; i++) {
-		my_gotoxy( x, y+i );
-		CONOUT_PAINT_NTIMES( tc->bg, wtile );
+		screen_gotoxy( tui->scr, x, y+i );
+		screen_paint_pen( tui->scr, pen, wtile );
 	}
 
 	/* then print tile value at the center */
-	int vw = _int_count_digits( tileval ); /* val width */
+	int vw = snprintf( txt, sizeof(txt), "%d", tileval ); /* val width */
 	int cx = x + (wtile - vw) / 2;         /* centered x of val */
 	int cy = y + htile/2;                  /* centered y of val */
-	my_gotoxy( cx, cy );
-	CONOUT_PRINTF( tc->fg, tc->bg, "%d", tileval );
+	screen_gotoxy( tui->scr, cx, cy );
+	screen_puts_pen( tui->scr, pen, txt );
 
 	return 1;
 }
 
+/* --------------------------------------------------------------
+ * int _draw_tileval_at_xy():
+ *
+ * Draw the specified tile-value at the specified position (x,y)
+ * on the console screen. Return 0 (false) on error, 1 (true)
+ * otherwise.
+ *
+ * NOTE: Used exclusively in the function tui_draw_board(),
+ *       so it depends heavily on assumptions made in that
+ *       context.
+ * --------------------------------------------------------------
+ */
+static inline int _draw_tileval_at_xy(
+	const Tui *tui,
+	int       tileval,
+	int       x,
+	int       y
+	)
+{
+	return _draw_tileval_colored_at_xy(
+			tui,
+			tileval,
+			_tileval_to_pen( tileval, tui ),
+			x,
+			y
+			);
+}
+
 /* --------------------------------------------------------------
  * void _clear_iobar():
  *
@@ -452,11 +546,13 @@ static inline int _draw_tileval_at_xy(
 static void _clear_iobar( const Tui *tui )
 {
 	const ConColors *cc = tui_skin_get_colors_iobar( tui->skin );
-	my_gotoxy(
+	screen_gotoxy(
+		tui->scr,
 		tui->layout.iobar.x,
 		tui->layout.iobar.y
 		);
-	CONOUT_PAINT_NTIMES(
+	screen_paint(
+		tui->scr,
 		cc->bg,
 		tui->layout.iobar.w
 		);
@@ -471,11 +567,13 @@ static void _clear_iobar( const Tui *tui )
 static void _clear_iobar2( const Tui *tui )
 {
 	const ConColors *cc = tui_skin_get_colors_iobar2( tui->skin );
-	my_gotoxy(
+	screen_gotoxy(
+		tui->scr,
 		tui->layout.iobar2.x,
 		tui->layout.iobar2.y
 		);
-	CONOUT_PAINT_NTIMES(
+	screen_paint(
+		tui->scr,
 		cc->bg,
 		tui->layout.iobar2.w
 		);
@@ -674,19 +772,22 @@ static int _init_layout( Tui *tui, const Board *board )
  *
  * The tui destructor releases all resources occupied by the
  * specified object, restores the console colors, enables the
- * cursor, and finally returns NULL (so the caller may assign
- * it back to the object pointer).
+ * cursor, takes the terminal out of raw mode, and finally returns
+ * NULL (so the caller may assign it back to the object pointer).
  * --------------------------------------------------------------
  */
 Tui *tui_free( Tui *tui )
 {
 	if ( tui ) {
 		tui_skin_free( tui->skin );
+		screen_free( tui->scr );
+		free( tui->events );
 		free( tui );
 	}
 
 	CONOUT_RESTORE();    /* restore console colors */
 	tui_sys_cursor_on(); /* ensure the cursor is enabled */
+	my_raw_end();        /* restore the terminal settings */
 	tui_sys_cls();       /* clear screen to system's default colors */
 
 	return NULL;
@@ -696,9 +797,10 @@ Tui *tui_free( Tui *tui )
  * (Constructor) Tui *new_tui():
  *
  * The tui constructor instantiates a new object in memory, initializes
- * it to default values, saves the console colors, hides the cursor,
- * clears the screen (using the default skin's bg color), and finally
- * returns a pointer to the new object, or NULL on error.
+ * it to default values, saves the console colors, puts the terminal
+ * in raw mode (see my_raw_begin()), hides the cursor, clears the
+ * screen (using the default skin's bg color), and finally returns
+ * a pointer to the new object, or NULL on error.
  * --------------------------------------------------------------
  */
 Tui *new_tui( GameState *state, MovesHistory *mvhist )
@@ -727,7 +829,10 @@ Tui *new_tui( GameState *state, MovesHistory *mvhist )
 		return NULL;
 	}
 
+	/* this is the 1st output of the game */
+	my_buffer_output( _SZ_FRAMEBUF );
 	CONOUT_INIT();
+	my_raw_begin();     /* for the whole session (see tui_free()) */
 
 	tui->skin = new_tui_skin();
 	if ( NULL == tui->skin ) {
@@ -741,6 +846,23 @@ Tui *new_tui( GameState *state, MovesHistory *mvhist )
 		return NULL;
 	}
 
+	tui->scr = new_screen();
+	if ( NULL == tui->scr ) {
+		DBGF( "%s", "screen allocation failed!" );
+		tui_free( tui );    /* this also calls CONOUT_RESTORE() */
+		return NULL;
+	}
+	_set_tilepens( tui );
+
+	tui->events = malloc( sizeof(*tui->events) );
+	if ( NULL == tui->events ) {
+		DBGF( "%s", "malloc() failed (events)!" );
+		tui_free( tui );    /* this also calls CONOUT_RESTORE() */
+		return NULL;
+	}
+	tui->events->set.n  = -1;   /* the board has not been drawn yet */
+	tui->events->queued = 1;    /* true */
+
 	tui->state  = state;
 	tui->mvhist = mvhist;
 
@@ -753,25 +875,20 @@ Tui *new_tui( GameState *state, MovesHistory *mvhist )
 /* --------------------------------------------------------------
  * int tui_update_board_reference():
  *
- * Update the board referencing pointer of the specified tui object,
- * so it points to the board object specified by the second argument.
+ * Re-initialize the screen layout of the specified tui object,
+ * according to the board object specified by the second argument,
+ * which MUST be the board of the game-state referenced by the tui.
  * 
  * NOTES: This function should be called after the board of the
  *        game has been resized. A pointer to the resized board
  *        object is passed as the second argument.
  *
- *        Besides updating the internal board reference of the
- *        tui object, the function also re-initializes the screen
- *        layout of the tui object, according to the resized board.
- *
- *        The board reference is initially assigned during the creation
- *        of a tui object (via new_tui() ), but if later-on the original
- *        board gets externally resized via realloc(), it may have been
- *        moved to a different location in memory, because that's how
- *        realloc() works.
- *
- *        So it is essential to call this function every time the
- *        original board gets resized.
+ *        The board is embedded into the game-state, with an inline
+ *        grid, so resizing it never moves it in memory. Thus, the
+ *        tui does not need to update any board reference any more.
+ *        However, its screen layout still depends on the dimension
+ *        of the board, so it is essential to call this function
+ *        every time the board gets resized.
  * --------------------------------------------------------------
  */
 int tui_update_board_reference( Tui *tui, Board *board )
@@ -784,8 +901,8 @@ int tui_update_board_reference( Tui *tui, Board *board )
 		DBGF( "%s", "Layout initialization failed!" );
 		return 0;  /* false */
 	}
-	gamestate_set_board_reference( tui->state, board );
-//	tui->board = board;
+	tui->events->set.n  = -1;   /* redraw the whole board */
+	tui->events->queued = 1;    /* true */
 
 	return 1;  /* true */
 }
@@ -814,7 +931,8 @@ int tui_update_mvhist_reference( Tui *tui, MovesHistory *mvhist )
  * int tui_cls():
  *
  * Clear the console screen using the screen background color of
- * the specified tui object.
+ * the specified tui object. The whole console gets repainted (and
+ * its dimensions re-read), regardless of what it is displaying.
  *
  * NOTE: This is different from the function: tui_sys_cls() which
  *       clears the console screen using the background color of
@@ -823,7 +941,7 @@ int tui_update_mvhist_reference( Tui *tui, MovesHistory *mvhist )
  */
 int tui_cls( const Tui *tui )
 {
-	int w,h;
+	int y, w,h;
 	const ConColors *cc = NULL;
 
 	if ( NULL == tui ) {
@@ -831,15 +949,20 @@ int tui_cls( const Tui *tui )
 		return 0;  /* false */
 	}
 
+	screen_invalidate( tui->scr );
+	tui->events->set.n  = -1;   /* redraw the whole board */
+	tui->events->queued = 1;    /* true */
 	w  = my_console_width();
 	h  = my_console_height();
 	cc = tui_skin_get_colors_screen( tui->skin );
 
-	my_gotoxy(0,0);
-	while ( h-- > -1 ) {
-		CONOUT_PAINT_NTIMES( cc->bg, w );
+	tui_begin_frame( tui );
+	for (y=0; y < h; y++) {
+		screen_gotoxy( tui->scr, 0,y );
+		screen_paint( tui->scr, cc->bg, w );
 	}
-	my_gotoxy(0,0);
+	screen_gotoxy( tui->scr, 0,0 );
+	tui_end_frame( tui );
 
 	return 1;  /* true */
 }
@@ -873,6 +996,7 @@ void tui_draw_titlebar( const Tui *tui )
 
 	cc = tui_skin_get_colors_titlebar( tui->skin );
 	_putxy_hspan_centered(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.titlebar.x,
@@ -908,6 +1032,7 @@ void tui_draw_scoresbar( const Tui *tui )
 	sb = tui_skin_get_colors_scoresbar( tui->skin );
 
 	nchars =  _printfxy(
+			tui->scr,
 			sb->fg, sb->bg,
 			x, y,
 			"Score: %-6ld",
@@ -916,6 +1041,7 @@ void tui_draw_scoresbar( const Tui *tui )
 
 	x += (nchars + 3);
 	_printfxy(
+		tui->scr,
 		sb->fg, sb->bg,
 		x, y,
 		"Best: %-6ld",
@@ -960,6 +1086,7 @@ void tui_draw_help( const Tui *tui, int isenabledcommands )
 
 	/* header */
 	_putxy_hspan_centered(
+		tui->scr,
 		hh->fg, hh->bg,
 		x,y,
 		"HOW TO PLAY",
@@ -970,12 +1097,14 @@ void tui_draw_help( const Tui *tui, int isenabledcommands )
 
 	y += 2;
 	_printfxy(
+		tui->scr,
 		hb->fg, hb->bg,
 		x, y,
 		"%s", "Use your arrow keys to move the tiles."
 		);
 	y++;
 	_printfxy(
+		tui->scr,
 		hb->fg, hb->bg,
 		x, y,
 		"%s", "If 2 tiles with the same number touch,"
@@ -983,24 +1112,28 @@ void tui_draw_help( const Tui *tui, int isenabledcommands )
 
 	y++;
 	_printfxy(
+		tui->scr,
 		hb->fg, hb->bg,
 		x, y,
 		"%s", "they are summed up & merged into one!"
 		);
 	y += 2;
 	_printfxy(
+		tui->scr,
 		hb->fg, hb->bg,
 		x, y,
 		"%s", "If the tiles're already stacked-up to"
 		);
 	y++;
 	_printfxy(
+		tui->scr,
 		hb->fg, hb->bg,
 		x, y,
 		"%s", "the given direction, with no adjacent"
 		);
 	y++;
 	_printfxy(
+		tui->scr,
 		hb->fg, hb->bg,
 		x, y,
 		"%s", "equal tiles, then nothing happens."
@@ -1008,12 +1141,14 @@ void tui_draw_help( const Tui *tui, int isenabledcommands )
 
 	y += 2;
 	_printfxy(
+		tui->scr,
 		hb->fg, hb->bg,
 		x, y,
 		"%s", "After a move, a new tile is generated"
 		);
 	y++;
 	_printfxy(
+		tui->scr,
 		hb->fg, hb->bg,
 		x, y,
 		"%s", "randomly, having either 2 or 4."
@@ -1021,11 +1156,13 @@ void tui_draw_help( const Tui *tui, int isenabledcommands )
 
 	y += 2;
 	_printfxy(
+		tui->scr,
 		hb->fg, hb->bg,
 		x, y,
 		"%s", "The game ends if a tile reaches "
 		);
-	CONOUT_PRINTF(
+	screen_printf(
+		tui->scr,
 		hc->fg, hc->bg,
 		"%d",
 		board_get_sentinel( gamestate_get_board(tui->state) )
@@ -1033,6 +1170,7 @@ void tui_draw_help( const Tui *tui, int isenabledcommands )
 
 	y++;
 	_printfxy(
+		tui->scr,
 		hb->fg, hb->bg,
 		x, y,
 		"%s", "or when there are no moves available"
@@ -1040,6 +1178,7 @@ void tui_draw_help( const Tui *tui, int isenabledcommands )
 
 	y++;
 	_printfxy(
+		tui->scr,
 		hb->fg, hb->bg,
 		x, y,
 		"%s", "at any direction."
@@ -1048,20 +1187,23 @@ void tui_draw_help( const Tui *tui, int isenabledcommands )
 	/* commands */
 	y += 2;
 	_printfxy(
+		tui->scr,
 		hc->fg, hc->bg,
 		x, y,
 		"%s", "S)kin  U)ndo  Re)do  Rep)lay  R)eset"
 		);
 	y++;
 	_printfxy(
+		tui->scr,
 		hc->fg, hc->bg,
 		x, y,
-		"%s", "4)x4   5)x5   6)x6   8)x8     Q)uit"
+		"%s", "4)x4 5)x5 6)x6 8)x8 F)ork M)em Q)uit"
 		);
 
 	/* footer */
 	y += 2;
 	_putxy_hspan_centered(
+		tui->scr,
 		hf->fg, hf->bg,
 		x,y,
 		"free software (c) 2014 migf1",
@@ -1083,12 +1225,14 @@ void tui_clear_infobar( const Tui *tui )
 		return;
 	}
 
-	my_gotoxy(
+	screen_gotoxy(
+		tui->scr,
 		tui->layout.infobar.x,
 		tui->layout.infobar.y
 		);
 	cc = tui_skin_get_colors_infobar( tui->skin );
-	CONOUT_PAINT_NTIMES(
+	screen_paint(
+		tui->scr,
 		cc->bg,
 		tui->layout.infobar.w
 		);
@@ -1137,6 +1281,110 @@ void tui_draw_infobar_boardinfo( const Tui *tui )
 	cc = tui_skin_get_colors_infobar( tui->skin );
 
 	_putxy_hspan_centered(
+		tui->scr,
+		cc->fg,
+		cc->bg,
+		tui->layout.infobar.x,
+		tui->layout.infobar.y,
+		txtout,
+		tui->layout.infobar.w    /* # of spanning columns */
+		);
+}
+
+/* --------------------------------------------------------------
+ * char *_nbytes_to_text():
+ *
+ * Write into the specified buffer (buf) of the specified size (bufsz)
+ * a short human readable text for the specified count of bytes, and
+ * return the buffer (e.g. 900 -> "900B", 12345 -> "12K", 1200000 ->
+ * "1.1M"). A buffer of _SZ_NBYTES_TEXT chars fits any count.
+ * --------------------------------------------------------------
+ */
+static char *_nbytes_to_text( char *buf, size_t bufsz, size_t nbytes )
+{
+	const size_t K = 1024, M = 1024 * 1024;
+
+	if ( nbytes < K ) {
+		snprintf( buf, bufsz, "%luB", (unsigned long)nbytes );
+	}
+	else if ( nbytes < M ) {
+		snprintf( buf, bufsz, "%luK", (unsigned long)(nbytes / K) );
+	}
+	else {
+		snprintf(
+			buf, bufsz,
+			"%lu.%luM",
+			(unsigned long)(nbytes / M),
+			(unsigned long)((nbytes % M) * 10 / M)
+			);
+	}
+	return buf;
+}
+
+/* --------------------------------------------------------------
+ * void tui_draw_infobar_meminfo():
+ *
+ * Draw on the console screen the info-bar of the specified tui
+ * object, containing the memory currently used by the undo (U),
+ * redo (R) & replay (P) stacks and by the branches (B) of the
+ * moves-history, along with the peak of their total.
+ *
+ * NOTE: The replay stack is shown only when it is not empty.
+ * --------------------------------------------------------------
+ */
+void tui_draw_infobar_meminfo( const Tui *tui )
+{
+	const ConColors *cc = NULL;
+	char txtout[BUFSIZ] = {'\0'};
+	char u[_SZ_NBYTES_TEXT], r[_SZ_NBYTES_TEXT], p[_SZ_NBYTES_TEXT];
+	char b[_SZ_NBYTES_TEXT], pk[_SZ_NBYTES_TEXT];
+	size_t nbreplay;
+
+	if ( NULL == tui ) {
+		DBGF( "%s", "NULL pointer argument (tui)" );
+		return;
+	}
+	if ( NULL == tui->mvhist ) {
+		DBGF( "%s", "tui->mvhist is NULL!" );
+		return;
+	}
+
+	tui_clear_infobar( tui );
+
+	nbreplay = mvhist_get_nbytes( tui->mvhist, MVHIST_MEM_REPLAY );
+	_nbytes_to_text(
+		u, sizeof(u),
+		mvhist_get_nbytes(tui->mvhist, MVHIST_MEM_UNDO)
+		);
+	_nbytes_to_text(
+		r, sizeof(r),
+		mvhist_get_nbytes(tui->mvhist, MVHIST_MEM_REDO)
+		);
+	_nbytes_to_text( p, sizeof(p), nbreplay );
+	_nbytes_to_text(
+		b, sizeof(b),
+		mvhist_get_nbytes(tui->mvhist, MVHIST_MEM_BRANCHES)
+		);
+	_nbytes_to_text(
+		pk, sizeof(pk),
+		mvhist_get_nbpeak(tui->mvhist, MVHIST_MEM_TOTAL)
+		);
+
+	if ( 0 == nbreplay ) {
+		snprintf( txtout, BUFSIZ, "U:%s R:%s B:%s pk:%s", u,r,b,pk );
+	}
+	else {
+		snprintf(
+			txtout, BUFSIZ,
+			"U:%s R:%s P:%s B:%s pk:%s",
+			u,r,p,b,pk
+			);
+	}
+
+	cc = tui_skin_get_colors_infobar( tui->skin );
+
+	_putxy_hspan_centered(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.infobar.x,
@@ -1169,6 +1417,7 @@ void tui_draw_infobar_winmsg( const Tui *tui )
 
 	cc = tui_skin_get_colors_infobar( tui->skin );
 	_putxy_hspan_centered(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.infobar.x,
@@ -1206,6 +1455,7 @@ int tui_draw_iobar_prompt_undo( const Tui *tui )
 
 	tui_sys_cursor_on();
 	_printfxy(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.iobar.x,
@@ -1248,6 +1498,7 @@ int tui_draw_iobar_prompt_newgame( const Tui *tui )
 
 	tui_sys_cursor_on();
 	_printfxy(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.iobar.x,
@@ -1290,6 +1541,7 @@ int tui_draw_iobar_prompt_watchreplay( const Tui *tui )
 
 	tui_sys_cursor_on();
 	_printfxy(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.iobar.x,
@@ -1333,6 +1585,7 @@ int tui_draw_iobar_prompt_notyet( const Tui *tui )
 
 	tui_sys_cursor_on();
 	_printfxy(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.iobar.x,
@@ -1382,6 +1635,7 @@ int tui_draw_iobar_prompt_replaycommand(
 	_clear_iobar( tui );
 
 	_printfxy(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.iobar.x,
@@ -1426,6 +1680,7 @@ int tui_draw_iobar_prompt_savereplay( const Tui *tui )
 	tui_sys_cursor_on();
 
 	_printfxy(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.iobar.x,
@@ -1469,6 +1724,7 @@ int tui_draw_iobar_prompt_loadreplay( const Tui *tui )
 
 	tui_sys_beep(1);
 	_printfxy(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.iobar.x,
@@ -1513,6 +1769,7 @@ int tui_draw_iobar_prompt_loadreplay_nofile( const Tui *tui )
 
 	tui_sys_beep(1);
 	_printfxy(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.iobar.x,
@@ -1562,6 +1819,7 @@ void tui_draw_iobar2_replaynavigation( const Tui *tui )
 
 	_clear_iobar2( tui );
 	nchars = _printfxy(
+			tui->scr,
 			cc->fg,
 			cc->bg,
 			tui->layout.iobar2.x,
@@ -1573,11 +1831,13 @@ void tui_draw_iobar2_replaynavigation( const Tui *tui )
 	/* if redo-stack, show its count */
 	if ( 0 != nredo )
 	{
-		my_gotoxy(
+		screen_gotoxy(
+			tui->scr,
 			tui->layout.iobar2.x + nchars,
 			tui->layout.iobar2.y
 			);
-		CONOUT_PRINTF(
+		screen_printf(
+			tui->scr,
 			hc->fg,
 			hc->bg,
 			"+%ld",
@@ -1611,6 +1871,7 @@ void tui_draw_iobar2_savereplayname( const Tui *tui, const char *fname )
 
 	_clear_iobar2( tui );
 	_printfxy(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.iobar2.x,
@@ -1647,6 +1908,7 @@ void tui_draw_iobar2_movescounter( const Tui *tui )
 
 	_clear_iobar2( tui );
 	_printfxy(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.iobar2.x,
@@ -1679,6 +1941,7 @@ void tui_draw_iobar2_mainmenu( const Tui *tui )
 
 	_clear_iobar2( tui );
 	_printfxy(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.iobar2.x,
@@ -1692,15 +1955,18 @@ void tui_draw_iobar2_mainmenu( const Tui *tui )
  * void tui_draw_iobar_autoreplayinfo():
  *
  * Draw on the console screen the io-bar of the specified tui object,
- * containing replay information.
+ * containing replay information: the specified speed of auto-play
+ * (as a multiple of the replay delay, 0 for the top one), and
+ * whether it is paused or not, along with the relevant commands.
  *
  * NOTE: Read the comments of the function: tui_draw_titlebar()
  *       for details about the primitiveness of the implementation.
  * --------------------------------------------------------------
  */
-void tui_draw_iobar_autoreplayinfo( const Tui *tui )
+void tui_draw_iobar_autoreplayinfo( const Tui *tui, double speed, int paused )
 {
 	const ConColors *cc = NULL;
+	char label[16] = {'\0'};
 
 	if ( NULL == tui ) {
 		DBGF( "%s", "NULL pointer argument (tui)" );
@@ -1709,14 +1975,23 @@ void tui_draw_iobar_autoreplayinfo( const Tui *tui )
 
 	cc = tui_skin_get_colors_iobar( tui->skin );
 
+	if ( speed > 0 ) {
+		snprintf( label, sizeof(label), "x%g", speed );
+	}
+	else {
+		strcpy( label, "xMAX" );
+	}
+
 	_clear_iobar( tui );
 	_printfxy(
+		tui->scr,
 		cc->fg,
 		cc->bg,
 		tui->layout.iobar.x,
 		tui->layout.iobar.y,
-		"Moves delay: %.2f secs    :%s|%s",
-		mvhist_get_replay_delay( tui->mvhist ) / 1000.f,
+		"Speed %-5s +/-  %s   :%s|%s",
+		label,
+		paused ? "p)lay " : "p)ause",
 		gamestate_get_prevmove_label( tui->state ),
 		gamestate_get_nextmove_label( tui->state )
 		);
@@ -1737,6 +2012,7 @@ void tui_draw_iobar_movescounter( const Tui *tui )
 	const ConColors *cc = NULL;    /* iobar colors */
 	const ConColors *hc = NULL;    /* help-box colors */
 	long int nredo = 0, nchars = 0;
+	int nforks = 0;
 
 	if ( NULL == tui ) {
 		DBGF( "%s", "NULL pointer argument (tui)" );
@@ -1746,9 +2022,11 @@ void tui_draw_iobar_movescounter( const Tui *tui )
 	cc = tui_skin_get_colors_iobar( tui->skin );
 	hc = tui_skin_get_colors_help_box( tui->skin );
 	nredo  = mvhist_peek_redo_stack_count( tui->mvhist );
+	nforks = mvhist_count_branches( tui->mvhist );
 
 	_clear_iobar( tui );
 	nchars = _printfxy(
+			tui->scr,
 			cc->fg,
 			cc->bg,
 			tui->layout.iobar.x,
@@ -1760,56 +2038,169 @@ void tui_draw_iobar_movescounter( const Tui *tui )
 	/* if redo-stack, show its count */
 	if ( 0 != nredo )
 	{
-		my_gotoxy(
+		screen_gotoxy(
+			tui->scr,
 			tui->layout.iobar.x + nchars,
 			tui->layout.iobar.y
 			);
-		CONOUT_PRINTF(
+		screen_printf(
+			tui->scr,
 			hc->fg,
 			hc->bg,
 			"+%ld",
 			nredo
 			);
 	}
+
+	/* if branches fork off the current line, show their count */
+	if ( 0 != nforks )
+	{
+		screen_printf(
+			tui->scr,
+			hc->fg,
+			hc->bg,
+			" (forks: %d)",
+			nforks
+			);
+	}
 }
 
 /* --------------------------------------------------------------
- * void tui_draw_iobar_savingreplay():
+ * void tui_draw_iobar2_asyncsave():
  *
- * Draw on the console screen the io-bar of the specified tui object,
- * containing a msg while saving a replay-file.
+ * Draw on the console screen the io-bar2 of the specified tui object,
+ * containing a msg about the specified outcome (one of the constants
+ * MVHIST_ASYNC_XXX, defined in "mvhist.h") of saving a replay-file in
+ * the background. Nothing is drawn for MVHIST_ASYNC_NONE.
  *
  * NOTE: Read the comments of the function: tui_draw_titlebar()
  *       for details about the primitiveness of the implementation.
  * --------------------------------------------------------------
  */
-void tui_draw_iobar_savingreplay( const Tui *tui )
+void tui_draw_iobar2_asyncsave( const Tui *tui, int outcome )
 {
-	const ConColors *sc = NULL;    /* screen colors */
+	const ConColors *cc = NULL;
+	const char *msg = NULL;
 
 	if ( NULL == tui ) {
 		DBGF( "%s", "NULL pointer argument (tui)" );
 		return;
 	}
 
-	sc = tui_skin_get_colors_screen( tui->skin );
+	switch ( outcome )
+	{
+		case MVHIST_ASYNC_PENDING:
+			msg = "Saving in the background...";
+			break;
+		case MVHIST_ASYNC_SAVED:
+			msg = "Replay saved.";
+			break;
+		case MVHIST_ASYNC_FAILED:
+			msg = "Could not save the replay!";
+			break;
+		default:
+			return;
+	}
 
-	_clear_iobar( tui );
+	cc = tui_skin_get_colors_iobar2( tui->skin );
+
+	_clear_iobar2( tui );
 	_printfxy(
-		sc->fg,
-		sc->bg,
-		tui->layout.iobar.x,
-		tui->layout.iobar.y,
-		"Saving, please wait..."
+		tui->scr,
+		cc->fg,
+		cc->bg,
+		tui->layout.iobar2.x,
+		tui->layout.iobar2.y,
+		"%s",
+		msg
+		);
+}
+
+/* --------------------------------------------------------------
+ * void _print_catalog():
+ *
+ * Print the items of the specified catalog of replay-files, one
+ * per line in their current order, followed by a line explaining
+ * how to sort them (see _sort_command_to_key()).
+ * --------------------------------------------------------------
+ */
+static void _print_catalog( const ReplayCatalog *catalog )
+{
+	long int  i, n = catalog_get_count( catalog );
+	char      date[32];
+	time_t    mtime;
+	struct tm *tm = NULL;
+	const ReplayInfo *info = NULL;
+
+	printf(
+		"%-32s %7s %9s %7s %8s  %s\n",
+		"REPLAY-FILE", "VARIANT", "SCORE", "MOVES", "MAXTILE", "DATE"
+		);
+	for (i=0; i < n; i++)
+	{
+		info  = catalog_get_info( catalog, i );
+		mtime = (time_t) info->mtime;
+		tm    = localtime( &mtime );
+		if ( NULL == tm
+		|| 0 == strftime( date, sizeof(date), "%Y-%m-%d %H:%M", tm )
+		){
+			strcpy( date, "?" );
+		}
+
+		if ( 0 == info->dim ) {
+			printf( "%-32s %34s  %s\n", info->fname, "(unreadable)", date );
+			continue;
+		}
+		printf(
+			"%-32s %5dx%d %9ld %7ld %7d%c  %s\n",
+			info->fname,
+			info->dim, info->dim,
+			info->score,
+			info->nmoves,
+			info->maxtile, info->iswin ? '*' : ' ',
+			date
+			);
+	}
+	printf(
+		"%ld replay-file(s). Type /d, /n, /s, /m or /t to sort them by "
+		"date, name, score, moves or max tile.\n",
+		n
 		);
 }
 
+/* --------------------------------------------------------------
+ * int _sort_command_to_key():
+ *
+ * Return the CATALOG_SORT_XXX key (defined in "catalog.h") of the
+ * specified c-string (s) if it is a sorting command typed-in at the
+ * prompt for a replay-file, or -1 otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _sort_command_to_key( const char *s )
+{
+	if ( '/' != s[0] || '\0' == s[1] || '\0' != s[2] ) {
+		return -1;
+	}
+
+	switch ( tolower( (unsigned char)s[1] ) )
+	{
+		case 'd': return CATALOG_SORT_TIME;
+		case 'n': return CATALOG_SORT_NAME;
+		case 's': return CATALOG_SORT_SCORE;
+		case 'm': return CATALOG_SORT_NMOVES;
+		case 't': return CATALOG_SORT_MAXTILE;
+		default:  break;
+	}
+	return -1;
+}
+
 /* --------------------------------------------------------------
  * void tui_prompt_replay_fname_to_load():
  *
  * Ask user for a replay-file to load, using the colors of the iobar
- * if the specified tui object. The typed-in filename, is stored in
- * the fname argument. 
+ * if the specified tui object. The replay-files of the specified
+ * catalog (which may be NULL) are listed before the prompt. The
+ * typed-in filename, is stored in the fname argument.
  *
  * NOTES: Read the comments of the function: tui_draw_titlebar()
  *        for details about the primitiveness of the implementation.
@@ -1817,12 +2208,21 @@ void tui_draw_iobar_savingreplay( const Tui *tui )
  *        Contrary to similar functions, this one is NOT using a
  *        screen-layout entity. Instead, it performs the required
  *        i/o right below the main screen of the game.
+ *
+ *        When a sorting command is typed-in instead of a filename
+ *        (see _print_catalog()) the catalog gets sorted, and it is
+ *        listed again before prompting once more.
  * --------------------------------------------------------------
  */
-void tui_prompt_replay_fname_to_load( const Tui *tui, char *fname )
+void tui_prompt_replay_fname_to_load(
+	const Tui     *tui,
+	ReplayCatalog *catalog,
+	char          *fname
+	)
 {
 	const char *prompt = "Type the name of the replay-file to load: ";
 	int y;                          /* current cursor y position */
+	int by;                         /* sorting key typed-in, if any */
 
 	if ( NULL == tui || NULL == fname ) {
 		DBGF( "%s", "NULL pointer argument" );
@@ -1831,45 +2231,133 @@ void tui_prompt_replay_fname_to_load( const Tui *tui, char *fname )
 
 	tui_sys_cursor_on();
 
-	puts( "\n" );
-	system( LS_REPLAYS );
-	putchar( '\n' );
+	for (;;)
+	{
+		puts( "\n" );
+		if ( catalog ) {
+			_print_catalog( catalog );
+		}
+		putchar( '\n' );
 
-	/* remember cursor's y-position */
-	y = my_gety();
+		/* remember cursor's y-position */
+		y = my_gety();
 
-	/* clear the line a cursor's y-position */
-	CONOUT_PAINT_NTIMES( BG_DEFAULT, my_console_width() );
+		/* clear the line a cursor's y-position */
+		CONOUT_PAINT_NTIMES( BG_DEFAULT, my_console_width() );
 
-	/* display the actual prompt */
-	my_gotoxy( 0,y );
-	_put_hspan_centered(
-		FG_DEFAULT,
-		BG_DEFAULT,
-		prompt,
-		strlen( prompt )
-		);
+		/* display the actual prompt */
+		my_gotoxy( 0,y );
+		_put_hspan_centered(
+			FG_DEFAULT,
+			BG_DEFAULT,
+			prompt,
+			strlen( prompt )
+			);
+
+		_get_replay_fname_from_user( fname );
+
+		by = _sort_command_to_key( &fname[strlen(REPLAYS_FOLDER "/")] );
+		if ( NULL == catalog || by < 0 ) {
+			break;
+		}
+		catalog_sort( catalog, by );
+	}
 
-	_get_replay_fname_from_user( fname );
 	tui_sys_cursor_off();
+	screen_invalidate( tui->scr );  /* the console got written directly */
 
 	return;
 }
 
+/* --------------------------------------------------------------
+ * void tui_set_board_events():
+ *
+ * Let the specified tui object know which tiles of its board got
+ * changed since it was last drawn, via the specified move-events
+ * (see the type BoardEvents in the file "board.h"). Then the next
+ * call of tui_draw_board() repaints just those tiles, rather than
+ * the whole board.
+ *
+ * Events set by several moves before the board gets drawn (say, a
+ * batch of queued moves) are accumulated. If they do not all fit,
+ * the whole board gets repainted instead.
+ *
+ * NOTE: The tui forgets the events when it gets cleared (see the
+ *       function tui_cls()) or when its board gets resized, since
+ *       then the whole board has to be repainted anyway.
+ * --------------------------------------------------------------
+ */
+void tui_set_board_events( const Tui *tui, const BoardEvents *events )
+{
+	int n = 0;  /* # of events kept from previous moves */
+
+	if ( NULL == tui || NULL == events ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return;
+	}
+
+	if ( tui->events->queued ) {
+		if ( tui->events->set.n < 0
+		|| tui->events->set.n + events->n > BOARD_MAXEVENTS
+		){
+			tui->events->set.n = -1;
+			return;
+		}
+		n = tui->events->set.n;
+	}
+	tui->events->queued = 1;  /* true */
+
+	tui->events->set.n = n + events->n;
+	memcpy(
+		&tui->events->set.ev[n],
+		events->ev,
+		events->n * sizeof(*events->ev)
+		);
+}
+
+/* --------------------------------------------------------------
+ * void _draw_tile():
+ *
+ * Draw the tile at the specified cell (i,j) of the specified board,
+ * on the console screen of the specified tui object.
+ *
+ * NOTE: Used exclusively in the function tui_draw_board(),
+ *       so it depends heavily on assumptions made in that
+ *       context.
+ * --------------------------------------------------------------
+ */
+static inline void _draw_tile(
+	const Tui   *tui,
+	const Board *board,
+	int         i,
+	int         j
+	)
+{
+	_draw_tileval_at_xy(
+		tui,
+		board_get_tile_value( board, i,j ),
+		tui->layout.board.x + j * tui->layout.tile.w,
+		tui->layout.board.y + i * tui->layout.tile.h
+		);
+}
+
 /* --------------------------------------------------------------
  * int tui_draw_board():
  *
  * Draw on the console screen the board which is referenced
  * internally by the specified tui object. Return 0 (false)
  * on error, 1 (true) otherwise.
+ *
+ * If the changes of the board since it was last drawn are known
+ * (see tui_set_board_events()) only the tiles involved in them
+ * get repainted, otherwise all of them.
  * --------------------------------------------------------------
  */
 int tui_draw_board( const Tui *tui )
 {
 	const Board *board = NULL;/* tui's internal board reference */ 
-	int i,j;                  /* for indexing the board tiles */
-	int y,x;                  /* top-left tile pos for looping over tiles*/
-	int wtile, htile;         /* single-tile drawing width & height */
+	const BoardEvent *ev = NULL;
+	int i,j,k;
 	int dim;
 
 	if ( NULL == tui ) {
@@ -1878,30 +2366,206 @@ int tui_draw_board( const Tui *tui )
 	}
 
 	board = gamestate_get_board( tui->state );
-	wtile = tui->layout.tile.w;
-	htile = tui->layout.tile.h;
 	dim = board_get_dim( board );
 
-	y = tui->layout.board.y;
-	for (i=0; i < dim; i++, y += htile )
-	{
-		x = tui->layout.board.x;
-		for (j=0; j < dim; j++, x += wtile)
-		{
+	tui_begin_frame( tui );
+	if ( tui->events->set.n < 0 ) {
+		for (i=0; i < dim; i++) {
+			for (j=0; j < dim; j++) {
+				_draw_tile( tui, board, i,j );
+			}
+		}
+	}
+	else {
+		/* both ends of slides & merges (spawns have i0,j0 == i,j) */
+		for (k=0; k < tui->events->set.n; k++) {
+			ev = &tui->events->set.ev[k];
+			if ( ev->i0 != ev->i || ev->j0 != ev->j ) {
+				_draw_tile( tui, board, ev->i0, ev->j0 );
+			}
+			_draw_tile( tui, board, ev->i, ev->j );
+		}
+	}
+	tui_end_frame( tui );
+
+	/* any further changes are unknown, until told otherwise */
+	tui->events->set.n  = -1;
+	tui->events->queued = 0;  /* false */
+
+	return 1;
+}
+
+/* --------------------------------------------------------------
+ * void _draw_anim_frame():
+ *
+ * Draw on the console screen a frame of the animation of the move
+ * whose events (evs) are known to the specified tui object, at the
+ * specified progress (0.0 to 1.0) of the slides. The tiles that do
+ * not move are taken from the specified values (under). If pulse is
+ * 1 (true) the merged tiles are drawn with the colors of their next
+ * value, instead of their own.
+ *
+ * NOTE: Used exclusively in the function tui_animate_board(), so
+ *       it depends heavily on assumptions made in that context.
+ * --------------------------------------------------------------
+ */
+static void _draw_anim_frame(
+	const Tui         *tui,
+	const BoardEvents *evs,
+	const int         *under,
+	int               dim,
+	double            progress,
+	int               pulse
+	)
+{
+	int i,j,k, val, x,y;
+	const BoardEvent *ev = NULL;
+	const int bx = tui->layout.board.x, by = tui->layout.board.y;
+	const int tw = tui->layout.tile.w,  th = tui->layout.tile.h;
+
+	/* the still tiles */
+	for (i=0; i < dim; i++) {
+		for (j=0; j < dim; j++) {
 			_draw_tileval_at_xy(
-				tui,
-				board_get_tile_value( board, i,j ),
-				x, y
+				tui, under[i*dim + j], bx + j*tw, by + i*th
+				);
+		}
+	}
+
+	/* the moving tiles (a merged one had half its value) */
+	for (k=0; k < evs->n; k++)
+	{
+		ev = &evs->ev[k];
+		if ( BOARD_EVENT_SPAWN == ev->kind ) {
+			continue;
+		}
+		x = bx + (int)( (ev->j0 + (ev->j - ev->j0) * progress) * tw + .5 );
+		y = by + (int)( (ev->i0 + (ev->i - ev->i0) * progress) * th + .5 );
+
+		if ( BOARD_EVENT_SLIDE == ev->kind ) {
+			_draw_tileval_at_xy( tui, ev->val, x,y );
+		}
+		else if ( !pulse ) {
+			_draw_tileval_at_xy( tui, ev->val / 2, x,y );
+		}
+		else {
+			val = ev->val;
+			_draw_tileval_colored_at_xy(
+				tui, val, _tileval_to_pen(2 * val, tui), x,y
 				);
 		}
 	}
-	return 1;
+}
+
+/* --------------------------------------------------------------
+ * int tui_animate_board():
+ *
+ * Animate on the console screen the move whose events are known to
+ * the specified tui object (see tui_set_board_events()): the tiles
+ * slide to their new cells within _MSECS_ANIM_SLIDE, and then the
+ * merged ones pulse for _MSECS_ANIM_PULSE. The spawned tiles appear
+ * when the board gets drawn afterwards (see tui_draw_board()).
+ *
+ * The frames are timed at _ANIM_FPS, but each one shows the progress
+ * due by the clock when it gets drawn, so frames are dropped if the
+ * terminal cannot keep up. If a frame takes more than _MSECS_ANIM_BUDGET
+ * to render, or if a key gets pressed, the animation is cancelled right
+ * away, so playing is never slowed down.
+ *
+ * Return 0 (false) if it got cancelled, 1 (true) otherwise. Either way
+ * the whole board gets repainted the next time it is drawn (which only
+ * writes the cells the last frame left different, see "screen.c").
+ *
+ * NOTE: The events of a single move are expected, since those of a
+ *       batch of moves would lead from different boards.
+ * --------------------------------------------------------------
+ */
+int tui_animate_board( const Tui *tui )
+{
+	const Board *board = NULL;
+	const BoardEvents *evs = NULL;
+	const BoardEvent *ev = NULL;
+	int under[ BOARD_DIM_8 * BOARD_DIM_8 ];  /* still tiles */
+	int dim, i,j,k, nmoving = 0, ret = 1;
+	double tbeg, tframe, t, msecs;
+	const double secsslide = _MSECS_ANIM_SLIDE / 1000.0;
+	const double secstotal = secsslide + _MSECS_ANIM_PULSE / 1000.0;
+
+	if ( NULL == tui ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;
+	}
+
+	evs   = &tui->events->set;
+	board = gamestate_get_board( tui->state );
+	dim   = board_get_dim( board );
+
+	/* the still tiles are those of the new board, without the spawned
+	 * ones and the moving ones (but a tile that another merged into
+	 * without moving itself, stays there with half the new value)
+	 */
+	for (i=0; i < dim; i++) {
+		for (j=0; j < dim; j++) {
+			under[i*dim + j] = board_get_tile_value( board, i,j );
+		}
+	}
+	for (k=0; k < evs->n; k++) {
+		ev = &evs->ev[k];
+		if ( BOARD_EVENT_MERGE != ev->kind ) {
+			under[ev->i * dim + ev->j] = 0;
+		}
+		nmoving += BOARD_EVENT_SPAWN != ev->kind;
+	}
+	for (k=0; k < evs->n; k++) {
+		ev = &evs->ev[k];
+		if ( BOARD_EVENT_MERGE == ev->kind && 0 != under[ev->i*dim + ev->j] ) {
+			under[ev->i * dim + ev->j] = ev->val / 2;
+		}
+	}
+	if ( 0 == nmoving ) {
+		return 1;
+	}
+
+	tbeg = th_wall_secs();
+	for (;;)
+	{
+		tframe = th_wall_secs();
+		t = tframe - tbeg;
+		if ( t >= secstotal ) {
+			break;
+		}
+
+		tui_begin_frame( tui );
+		_draw_anim_frame(
+			tui, evs, under, dim,
+			t < secsslide ? t / secsslide : 1.0,
+			t >= secsslide
+			);
+		tui_end_frame( tui );
+
+		/* the terminal cannot keep up */
+		if ( th_wall_secs() - tframe > _MSECS_ANIM_BUDGET / 1000.0 ) {
+			ret = 0;
+			break;
+		}
+
+		/* wait for the next frame, unless a key gets pressed */
+		msecs = (tframe + 1.0 / _ANIM_FPS - th_wall_secs()) * 1000;
+		if ( my_wait_key(msecs > 0 ? (long int)msecs + 1 : 0) ) {
+			ret = 0;
+			break;
+		}
+	}
+
+	tui->events->set.n = -1;  /* redraw the whole board */
+	return ret;
 }
 
 /* --------------------------------------------------------------
  * void tui_redraw():
  *
- * Redraw all the screen entities of the specified tui object.
+ * Redraw all the screen entities of the specified tui object,
+ * as a single frame (see tui_begin_frame()).
  * --------------------------------------------------------------
  */
 void tui_redraw( const Tui *tui, int isenabledcommands )
@@ -1911,31 +2575,70 @@ void tui_redraw( const Tui *tui, int isenabledcommands )
 		return;
 	}
 
+	tui_begin_frame( tui );
 	tui_draw_titlebar( tui );
 	tui_draw_help( tui, isenabledcommands );
 	tui_draw_board( tui );
 	tui_draw_scoresbar( tui );
-	tui_draw_infobar_boardinfo( tui );
+	if ( tui->showmem ) {
+		tui_draw_infobar_meminfo( tui );
+	}
+	else {
+		tui_draw_infobar_boardinfo( tui );
+	}
 	tui_draw_iobar2_mainmenu( tui );
 	tui_draw_iobar_movescounter( tui );
 //	_clear_iobar2( tui );
 //	_clear_iobar( tui );
+	tui_end_frame( tui );
 }
 
 /* --------------------------------------------------------------
  * int tui_cycle_skin():
  *
  * Apply to the specified tui object, the next available skin.
+ * Return the id of the applied skin (a positive number, so the
+ * skins repeat when an id comes up again), or 0 (false) on error.
  * --------------------------------------------------------------
  */
 int tui_cycle_skin( Tui *tui )
+{
+	int id;
+
+	if ( NULL == tui ) {
+		DBGF( "%s", "NULL pointer argument!" );
+		return 0;
+	}
+
+	id = tui_skin_cycle( tui->skin );
+	_set_tilepens( tui );
+
+	return id;
+}
+
+/* --------------------------------------------------------------
+ * int tui_toggle_meminfo():
+ *
+ * Toggle the contents of the info-bar of the specified tui object,
+ * between board information and memory information (see the func:
+ * tui_draw_infobar_meminfo()). The info-bar is redrawn accordingly.
+ * Return 0 (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+int tui_toggle_meminfo( Tui *tui )
 {
 	if ( NULL == tui ) {
 		DBGF( "%s", "NULL pointer argument!" );
 		return 0;
 	}
 
-	tui_skin_cycle( tui->skin );
+	tui->showmem = !tui->showmem;
+	if ( tui->showmem ) {
+		tui_draw_infobar_meminfo( tui );
+	}
+	else {
+		tui_draw_infobar_boardinfo( tui );
+	}
 
 	return 1;
 }
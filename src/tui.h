@@ -23,6 +23,7 @@
 #include "board.h"
 #include "gs.h"
 #include "mvhist.h"
+#include "catalog.h"
 
 /* The "class" is forward-declared as an opaque data-type */
 typedef struct _tui Tui;
@@ -44,10 +45,15 @@ enum {
 	TUI_KEY_SKIN          = 'S',
 	TUI_KEY_UNDO          = 'U',
 	TUI_KEY_REDO          = 'E',
+	TUI_KEY_BRANCH        = 'F',
+	TUI_KEY_MEMINFO       = 'M',
 	TUI_KEY_REPLAY        = 'P',
 	TUI_KEY_REPLAY_BEG    = MY_KEY_HOME,
 	TUI_KEY_REPLAY_END    = MY_KEY_END,
 	TUI_KEY_REPLAY_PLAY   = 'P',
+	TUI_KEY_REPLAY_PAUSE  = 'P',    /* during auto-play */
+	TUI_KEY_REPLAY_FASTER = '+',    /* during auto-play */
+	TUI_KEY_REPLAY_SLOWER = '-',    /* during auto-play */
 	TUI_KEY_REPLAY_SAVE   = 'S',
 	TUI_KEY_REPLAY_LOAD   = 'L',
 	TUI_KEY_REPLAY_BACK   = 'B',
@@ -65,12 +71,16 @@ extern int  tui_update_mvhist_reference( Tui *tui, MovesHistory *mvhist );
 
 extern int  tui_cls( const Tui *tui );
 
+extern void tui_begin_frame( const Tui *tui );
+extern void tui_end_frame( const Tui *tui );
+
 extern void tui_draw_titlebar( const Tui *tui );
 extern void tui_draw_scoresbar( const Tui *tui );
 extern void tui_draw_help( const Tui *tui, int isenabledcommands );
 
 extern void tui_clear_infobar( const Tui *tui );
 extern void tui_draw_infobar_boardinfo( const Tui *tui );
+extern void tui_draw_infobar_meminfo( const Tui *tui );
 extern void tui_draw_infobar_winmsg( const Tui *tui );
 
 extern int  tui_draw_iobar_prompt_undo( const Tui *tui );
@@ -93,15 +103,29 @@ extern void tui_draw_iobar2_savereplayname(
 extern void tui_draw_iobar2_movescounter( const Tui *tui );
 extern void tui_draw_iobar2_mainmenu( const Tui *tui );
 extern void tui_draw_iobar_movescounter( const Tui *tui );
-extern void tui_draw_iobar_savingreplay( const Tui *tui );
-extern void tui_draw_iobar_autoreplayinfo( const Tui *tui );
+extern void tui_draw_iobar2_asyncsave( const Tui *tui, int outcome );
+extern void tui_draw_iobar_autoreplayinfo(
+                    const Tui *tui,
+                    double    speed,
+                    int       paused
+                    );
 
-extern void tui_prompt_replay_fname_to_load( const Tui *tui, char *fname );
+extern void tui_prompt_replay_fname_to_load(
+                    const Tui     *tui,
+                    ReplayCatalog *catalog,
+                    char          *fname
+                    );
 
+extern void tui_set_board_events(
+                    const Tui         *tui,
+                    const BoardEvents *events
+                    );
 extern int  tui_draw_board( const Tui *tui );
+extern int  tui_animate_board( const Tui *tui );
 extern void tui_redraw( const Tui *tui, int isenabledcommands );
 
 extern int  tui_cycle_skin( Tui *tui );
+extern int  tui_toggle_meminfo( Tui *tui );
 
 /* tui_sys_ functions do NOT require an allocated Tui object */
 extern int  tui_sys_cls( void );
@@ -109,6 +133,7 @@ extern int  tui_sys_cursor_off( void );
 extern int  tui_sys_cursor_on( void );
 extern void tui_sys_press_a_key( void );
 extern int  tui_sys_getkey( unsigned int *outKeyMask );
+extern int  tui_sys_wait_key( long int msecs );
 extern void tui_sys_beep( size_t ntimes );
 extern int  tui_sys_sleep( unsigned long int msecs );
 
@@ -31,6 +31,10 @@
  * direct interconnection among them (i.e. some layout-entities
  * may not be skinnable, and vice versa).
  *
+ * The colors of the tiles are kept in an array, indexed by the log2
+ * of the tile values (see TUI_SKIN_NTILES in the file "tui_skin.h"),
+ * so the tiles of any value find their colors in a single step.
+ *
  * All the entities (along with the skin-id) are bundled in the
  * _tuiskin struct, which is exposed publicly as an opaque type,
  * called: TuiSkin. This is the "class".
@@ -104,10 +108,7 @@ struct _tuiskin {
 
 	/* left half of the screen*/
 	ConColors titlebar;
-	ConColors tile0,    tile2,    tile4,    tile8,
-	          tile16,   tile32,   tile64,
-	          tile128,  tile256,  tile512,
-	          tile1024, tile2048, tilebig;
+	ConColors tiles[ TUI_SKIN_NTILES ];  /* indexed by log2(value) */
 	ConColors scoresbar;
 	ConColors infobar;
 
@@ -158,56 +159,76 @@ static void _set_dark( TuiSkin *skin )
 	CONOUT_CPYCLR( skin->titlebar.bg, BG_WHITE );
 
 	/* empty-tile */
-	CONOUT_CPYCLR( skin->tile0.fg, FG_DARKGRAY );
-	CONOUT_CPYCLR( skin->tile0.bg, s->bg );
+	CONOUT_CPYCLR( skin->tiles[0].fg, FG_DARKGRAY );
+	CONOUT_CPYCLR( skin->tiles[0].bg, s->bg );
 
 	/* tile-2 */
-	CONOUT_CPYCLR( skin->tile2.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile2.bg, BG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[1].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[1].bg, BG_WHITE );
 
 	/* tile-4 */
-	CONOUT_CPYCLR( skin->tile4.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile4.bg, BG_GRAY );
+	CONOUT_CPYCLR( skin->tiles[2].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[2].bg, BG_GRAY );
 
 	/* tile-8 */
-	CONOUT_CPYCLR( skin->tile8.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile8.bg, BG_DARKMAGENTA );
+	CONOUT_CPYCLR( skin->tiles[3].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[3].bg, BG_DARKMAGENTA );
 
 	/* tile-16 */
-	CONOUT_CPYCLR( skin->tile16.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile16.bg, BG_MAGENTA );
+	CONOUT_CPYCLR( skin->tiles[4].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[4].bg, BG_MAGENTA );
 
 	/* tile-32 */
-	CONOUT_CPYCLR( skin->tile32.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile32.bg, BG_DARKRED );
+	CONOUT_CPYCLR( skin->tiles[5].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[5].bg, BG_DARKRED );
 
 	/* tile-64 */
-	CONOUT_CPYCLR( skin->tile64.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile64.bg, BG_RED );
+	CONOUT_CPYCLR( skin->tiles[6].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[6].bg, BG_RED );
 
 	/* tile-128 */
-	CONOUT_CPYCLR( skin->tile128.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile128.bg, BG_DARKGREEN );
+	CONOUT_CPYCLR( skin->tiles[7].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[7].bg, BG_DARKGREEN );
 
 	/* tile-256 */
-	CONOUT_CPYCLR( skin->tile256.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile256.bg, BG_GREEN );
+	CONOUT_CPYCLR( skin->tiles[8].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[8].bg, BG_GREEN );
 
 	/* tile-512 */
-	CONOUT_CPYCLR( skin->tile512.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile512.bg, BG_DARKCYAN );
+	CONOUT_CPYCLR( skin->tiles[9].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[9].bg, BG_DARKCYAN );
 
 	/* tile-1024 */
-	CONOUT_CPYCLR( skin->tile1024.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile1024.bg, BG_CYAN );
+	CONOUT_CPYCLR( skin->tiles[10].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[10].bg, BG_CYAN );
 
 	/* tile-2048 */
-	CONOUT_CPYCLR( skin->tile2048.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile2048.bg, BG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[11].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[11].bg, BG_YELLOW );
+
+	/* tile-4096 */
+	CONOUT_CPYCLR( skin->tiles[12].fg, FG_RED );
+	CONOUT_CPYCLR( skin->tiles[12].bg, BG_YELLOW );
+
+	/* tile-8192 */
+	CONOUT_CPYCLR( skin->tiles[13].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[13].bg, BG_DARKRED );
+
+	/* tile-16384 */
+	CONOUT_CPYCLR( skin->tiles[14].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[14].bg, BG_DARKBLUE );
 
-	/* tile-big */
-	CONOUT_CPYCLR( skin->tilebig.fg, FG_RED );
-	CONOUT_CPYCLR( skin->tilebig.bg, BG_YELLOW );
+	/* tile-32768 */
+	CONOUT_CPYCLR( skin->tiles[15].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[15].bg, BG_BLUE );
+
+	/* tile-65536 */
+	CONOUT_CPYCLR( skin->tiles[16].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[16].bg, BG_DARKGREEN );
+
+	/* tile-131072 (and any bigger one) */
+	CONOUT_CPYCLR( skin->tiles[17].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[17].bg, BG_DARKYELLOW );
 
 	/* scores-bar */
 	CONOUT_CPYCLR( skin->scoresbar.fg, s->fg );
@@ -283,56 +304,76 @@ static void _set_light( TuiSkin *skin )
 	CONOUT_CPYCLR( skin->titlebar.bg, BG_BLACK );
 
 	/* empty-tile */
-	CONOUT_CPYCLR( skin->tile0.fg, FG_DARKGRAY );
-	CONOUT_CPYCLR( skin->tile0.bg, s->bg );
+	CONOUT_CPYCLR( skin->tiles[0].fg, FG_DARKGRAY );
+	CONOUT_CPYCLR( skin->tiles[0].bg, s->bg );
 
 	/* tile-2 */
-	CONOUT_CPYCLR( skin->tile2.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile2.bg, BG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[1].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[1].bg, BG_WHITE );
 
 	/* tile-4 */
-	CONOUT_CPYCLR( skin->tile4.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile4.bg, BG_DARKGRAY );
+	CONOUT_CPYCLR( skin->tiles[2].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[2].bg, BG_DARKGRAY );
 
 	/* tile-8 */
-	CONOUT_CPYCLR( skin->tile8.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile8.bg, BG_DARKMAGENTA );
+	CONOUT_CPYCLR( skin->tiles[3].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[3].bg, BG_DARKMAGENTA );
 
 	/* tile-16 */
-	CONOUT_CPYCLR( skin->tile16.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile16.bg, BG_MAGENTA );
+	CONOUT_CPYCLR( skin->tiles[4].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[4].bg, BG_MAGENTA );
 
 	/* tile-32 */
-	CONOUT_CPYCLR( skin->tile32.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile32.bg, BG_DARKRED );
+	CONOUT_CPYCLR( skin->tiles[5].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[5].bg, BG_DARKRED );
 
 	/* tile-64 */
-	CONOUT_CPYCLR( skin->tile64.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile64.bg, BG_RED );
+	CONOUT_CPYCLR( skin->tiles[6].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[6].bg, BG_RED );
 
 	/* tile-128 */
-	CONOUT_CPYCLR( skin->tile128.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile128.bg, BG_DARKGREEN );
+	CONOUT_CPYCLR( skin->tiles[7].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[7].bg, BG_DARKGREEN );
 
 	/* tile-256 */
-	CONOUT_CPYCLR( skin->tile256.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile256.bg, BG_GREEN );
+	CONOUT_CPYCLR( skin->tiles[8].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[8].bg, BG_GREEN );
 
 	/* tile-512 */
-	CONOUT_CPYCLR( skin->tile512.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile512.bg, BG_DARKCYAN );
+	CONOUT_CPYCLR( skin->tiles[9].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[9].bg, BG_DARKCYAN );
 
 	/* tile-1024 */
-	CONOUT_CPYCLR( skin->tile1024.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile1024.bg, BG_CYAN );
+	CONOUT_CPYCLR( skin->tiles[10].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[10].bg, BG_CYAN );
 
 	/* tile-2048 */
-	CONOUT_CPYCLR( skin->tile2048.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile2048.bg, BG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[11].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[11].bg, BG_YELLOW );
+
+	/* tile-4096 */
+	CONOUT_CPYCLR( skin->tiles[12].fg, FG_RED );
+	CONOUT_CPYCLR( skin->tiles[12].bg, BG_YELLOW );
 
-	/* tile-big */
-	CONOUT_CPYCLR( skin->tilebig.fg, FG_RED );
-	CONOUT_CPYCLR( skin->tilebig.bg, BG_YELLOW );
+	/* tile-8192 */
+	CONOUT_CPYCLR( skin->tiles[13].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[13].bg, BG_DARKRED );
+
+	/* tile-16384 */
+	CONOUT_CPYCLR( skin->tiles[14].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[14].bg, BG_DARKBLUE );
+
+	/* tile-32768 */
+	CONOUT_CPYCLR( skin->tiles[15].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[15].bg, BG_BLUE );
+
+	/* tile-65536 */
+	CONOUT_CPYCLR( skin->tiles[16].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[16].bg, BG_DARKGREEN );
+
+	/* tile-131072 (and any bigger one) */
+	CONOUT_CPYCLR( skin->tiles[17].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[17].bg, BG_DARKYELLOW );
 
 	/* scores-bar */
 	CONOUT_CPYCLR( skin->scoresbar.fg, s->fg );
@@ -410,56 +451,76 @@ static void _set_dark( TuiSkin *skin )
 	CONOUT_CPYCLR( skin->titlebar.bg, BG_DARKBLUE );
 
 	/* empty-tile */
-	CONOUT_CPYCLR( skin->tile0.fg, FG_GRAY );
-	CONOUT_CPYCLR( skin->tile0.bg, s->bg );
+	CONOUT_CPYCLR( skin->tiles[0].fg, FG_GRAY );
+	CONOUT_CPYCLR( skin->tiles[0].bg, s->bg );
 
 	/* tile-2 */
-	CONOUT_CPYCLR( skin->tile2.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile2.bg, BG_GRAY );
+	CONOUT_CPYCLR( skin->tiles[1].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[1].bg, BG_GRAY );
 
 	/* tile-4 */
-	CONOUT_CPYCLR( skin->tile4.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile4.bg, BG_DARKCYAN );
+	CONOUT_CPYCLR( skin->tiles[2].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[2].bg, BG_DARKCYAN );
 
 	/* tile-8 */
-	CONOUT_CPYCLR( skin->tile8.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile8.bg, BG_DARKGREEN );
+	CONOUT_CPYCLR( skin->tiles[3].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[3].bg, BG_DARKGREEN );
 
 	/* tile-16 */
-	CONOUT_CPYCLR( skin->tile16.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile16.bg, BG_DARKMAGENTA );
+	CONOUT_CPYCLR( skin->tiles[4].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[4].bg, BG_DARKMAGENTA );
 
 	/* tile-32 */
-	CONOUT_CPYCLR( skin->tile32.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile32.bg, BG_DARKRED );
+	CONOUT_CPYCLR( skin->tiles[5].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[5].bg, BG_DARKRED );
 
 	/* tile-64 */
-	CONOUT_CPYCLR( skin->tile64.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile64.bg, BG_DARKRED );
+	CONOUT_CPYCLR( skin->tiles[6].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[6].bg, BG_DARKRED );
 
 	/* tile-128 */
-	CONOUT_CPYCLR( skin->tile128.fg, FG_CYAN );
-	CONOUT_CPYCLR( skin->tile128.bg, BG_DARKBLUE );
+	CONOUT_CPYCLR( skin->tiles[7].fg, FG_CYAN );
+	CONOUT_CPYCLR( skin->tiles[7].bg, BG_DARKBLUE );
 
 	/* tile-256 */
-	CONOUT_CPYCLR( skin->tile256.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile256.bg, BG_DARKBLUE );
+	CONOUT_CPYCLR( skin->tiles[8].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[8].bg, BG_DARKBLUE );
 
 	/* tile-512 */
-	CONOUT_CPYCLR( skin->tile512.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile512.bg, BG_DARKCYAN );
+	CONOUT_CPYCLR( skin->tiles[9].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[9].bg, BG_DARKCYAN );
 
 	/* tile-1024 */
-	CONOUT_CPYCLR( skin->tile1024.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile1024.bg, BG_DARKYELLOW );
+	CONOUT_CPYCLR( skin->tiles[10].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[10].bg, BG_DARKYELLOW );
 
 	/* tile-2048 */
-	CONOUT_CPYCLR( skin->tile2048.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile2048.bg, BG_DARKYELLOW );
+	CONOUT_CPYCLR( skin->tiles[11].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[11].bg, BG_DARKYELLOW );
+
+	/* tile-4096 */
+	CONOUT_CPYCLR( skin->tiles[12].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[12].bg, BG_DARKMAGENTA );
+
+	/* tile-8192 */
+	CONOUT_CPYCLR( skin->tiles[13].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[13].bg, BG_DARKMAGENTA );
+
+	/* tile-16384 */
+	CONOUT_CPYCLR( skin->tiles[14].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[14].bg, BG_DARKRED );
 
-	/* tile-big */
-	CONOUT_CPYCLR( skin->tilebig.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tilebig.bg, BG_DARKMAGENTA );
+	/* tile-32768 */
+	CONOUT_CPYCLR( skin->tiles[15].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[15].bg, BG_DARKBLUE );
+
+	/* tile-65536 */
+	CONOUT_CPYCLR( skin->tiles[16].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[16].bg, BG_DARKGREEN );
+
+	/* tile-131072 (and any bigger one) */
+	CONOUT_CPYCLR( skin->tiles[17].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[17].bg, BG_DARKCYAN );
 
 	/* scores-bar */
 	CONOUT_CPYCLR( skin->scoresbar.fg, s->fg );
@@ -535,56 +596,76 @@ static void _set_light( TuiSkin *skin )
 	CONOUT_CPYCLR( skin->titlebar.bg, BG_DARKBLUE );
 
 	/* empty-tile */
-	CONOUT_CPYCLR( skin->tile0.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile0.bg, s->bg );
+	CONOUT_CPYCLR( skin->tiles[0].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[0].bg, s->bg );
 
 	/* tile-2 */
-	CONOUT_CPYCLR( skin->tile2.fg, FG_CYAN );
-	CONOUT_CPYCLR( skin->tile2.bg, BG_DARKCYAN );
+	CONOUT_CPYCLR( skin->tiles[1].fg, FG_CYAN );
+	CONOUT_CPYCLR( skin->tiles[1].bg, BG_DARKCYAN );
 
 	/* tile-4 */
-	CONOUT_CPYCLR( skin->tile4.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile4.bg, BG_DARKCYAN );
+	CONOUT_CPYCLR( skin->tiles[2].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[2].bg, BG_DARKCYAN );
 
 	/* tile-8 */
-	CONOUT_CPYCLR( skin->tile8.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile8.bg, BG_DARKGREEN );
+	CONOUT_CPYCLR( skin->tiles[3].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[3].bg, BG_DARKGREEN );
 
 	/* tile-16 */
-	CONOUT_CPYCLR( skin->tile16.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile16.bg, BG_DARKMAGENTA );
+	CONOUT_CPYCLR( skin->tiles[4].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[4].bg, BG_DARKMAGENTA );
 
 	/* tile-32 */
-	CONOUT_CPYCLR( skin->tile32.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile32.bg, BG_DARKRED );
+	CONOUT_CPYCLR( skin->tiles[5].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[5].bg, BG_DARKRED );
 
 	/* tile-64 */
-	CONOUT_CPYCLR( skin->tile64.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile64.bg, BG_DARKRED );
+	CONOUT_CPYCLR( skin->tiles[6].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[6].bg, BG_DARKRED );
 
 	/* tile-128 */
-	CONOUT_CPYCLR( skin->tile128.fg, FG_CYAN );
-	CONOUT_CPYCLR( skin->tile128.bg, BG_DARKBLUE );
+	CONOUT_CPYCLR( skin->tiles[7].fg, FG_CYAN );
+	CONOUT_CPYCLR( skin->tiles[7].bg, BG_DARKBLUE );
 
 	/* tile-256 */
-	CONOUT_CPYCLR( skin->tile256.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile256.bg, BG_DARKBLUE );
+	CONOUT_CPYCLR( skin->tiles[8].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[8].bg, BG_DARKBLUE );
 
 	/* tile-512 */
-	CONOUT_CPYCLR( skin->tile512.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile512.bg, BG_DARKCYAN );
+	CONOUT_CPYCLR( skin->tiles[9].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[9].bg, BG_DARKCYAN );
 
 	/* tile-1024 */
-	CONOUT_CPYCLR( skin->tile1024.fg, FG_BLACK );
-	CONOUT_CPYCLR( skin->tile1024.bg, BG_DARKYELLOW );
+	CONOUT_CPYCLR( skin->tiles[10].fg, FG_BLACK );
+	CONOUT_CPYCLR( skin->tiles[10].bg, BG_DARKYELLOW );
 
 	/* tile-2048 */
-	CONOUT_CPYCLR( skin->tile2048.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tile2048.bg, BG_DARKYELLOW );
+	CONOUT_CPYCLR( skin->tiles[11].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[11].bg, BG_DARKYELLOW );
+
+	/* tile-4096 */
+	CONOUT_CPYCLR( skin->tiles[12].fg, FG_WHITE );
+	CONOUT_CPYCLR( skin->tiles[12].bg, BG_DARKMAGENTA );
+
+	/* tile-8192 */
+	CONOUT_CPYCLR( skin->tiles[13].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[13].bg, BG_DARKMAGENTA );
+
+	/* tile-16384 */
+	CONOUT_CPYCLR( skin->tiles[14].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[14].bg, BG_DARKRED );
+
+	/* tile-32768 */
+	CONOUT_CPYCLR( skin->tiles[15].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[15].bg, BG_DARKBLUE );
+
+	/* tile-65536 */
+	CONOUT_CPYCLR( skin->tiles[16].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[16].bg, BG_DARKGREEN );
 
-	/* tile-big */
-	CONOUT_CPYCLR( skin->tilebig.fg, FG_WHITE );
-	CONOUT_CPYCLR( skin->tilebig.bg, BG_DARKMAGENTA );
+	/* tile-131072 (and any bigger one) */
+	CONOUT_CPYCLR( skin->tiles[17].fg, FG_YELLOW );
+	CONOUT_CPYCLR( skin->tiles[17].bg, BG_DARKCYAN );
 
 	/* scores-bar */
 	CONOUT_CPYCLR( skin->scoresbar.fg, s->fg );
@@ -769,146 +850,24 @@ const const ConColors *tui_skin_get_colors_titlebar( const TuiSkin *skin )
 }
 
 /* --------------------------------------------------------------
- * (Getters)
- *
- * Given a specified tui-skin object (skin), each of the following
- * functions returns a pointer to the colors of the object's tile
- * implied by the numeric suffix of the function name, or NULL on
- * error.
- *
- * For example, the function tui_skin_get_colors_tile16() returns
- * a pointer to the colors of tiles having 16 as their value.
+ * (Getter)
+ * const ConColors *tui_skin_get_colors_tiles():
+ *
+ * Return a pointer to the tile colors of the specified tui-skin
+ * object (skin), or NULL on error. They are an array of
+ * TUI_SKIN_NTILES colors indexed by the log2 of the tile values
+ * (the 1st one is for empty tiles, the last one for any tile too
+ * big to have colors of its own). For example, the tiles having
+ * 16 as their value use the colors at index 4.
  * --------------------------------------------------------------
  */
-
-/* tile0 */
-const const ConColors *tui_skin_get_colors_tile0( const TuiSkin *skin )
-{
-	if ( NULL == skin ) {
-		DBGF( "%s", "NULL pointer argument (skin)!" );
-		return NULL;
-	}
-	return &skin->tile0;
-}
-
-/* tile2 */
-const const ConColors *tui_skin_get_colors_tile2( const TuiSkin *skin )
-{
-	if ( NULL == skin ) {
-		DBGF( "%s", "NULL pointer argument (skin)!" );
-		return NULL;
-	}
-	return &skin->tile2;
-}
-
-/* tile4 */
-const const ConColors *tui_skin_get_colors_tile4( const TuiSkin *skin )
-{
-	if ( NULL == skin ) {
-		DBGF( "%s", "NULL pointer argument (skin)!" );
-		return NULL;
-	}
-	return &skin->tile4;
-}
-
-/* tile8 */
-const const ConColors *tui_skin_get_colors_tile8( const TuiSkin *skin )
-{
-	if ( NULL == skin ) {
-		DBGF( "%s", "NULL pointer argument (skin)!" );
-		return NULL;
-	}
-	return &skin->tile8;
-}
-
-/* tile16 */
-const const ConColors *tui_skin_get_colors_tile16( const TuiSkin *skin )
-{
-	if ( NULL == skin ) {
-		DBGF( "%s", "NULL pointer argument (skin)!" );
-		return NULL;
-	}
-	return &skin->tile16;
-}
-
-/* tile32 */
-const const ConColors *tui_skin_get_colors_tile32( const TuiSkin *skin )
-{
-	if ( NULL == skin ) {
-		DBGF( "%s", "NULL pointer argument (skin)!" );
-		return NULL;
-	}
-	return &skin->tile32;
-}
-
-/* tile64 */
-const const ConColors *tui_skin_get_colors_tile64( const TuiSkin *skin )
-{
-	if ( NULL == skin ) {
-		DBGF( "%s", "NULL pointer argument (skin)!" );
-		return NULL;
-	}
-	return &skin->tile64;
-}
-
-/* tile128 */
-const const ConColors *tui_skin_get_colors_tile128( const TuiSkin *skin )
-{
-	if ( NULL == skin ) {
-		DBGF( "%s", "NULL pointer argument (skin)!" );
-		return NULL;
-	}
-	return &skin->tile128;
-}
-
-/* tile256 */
-const const ConColors *tui_skin_get_colors_tile256( const TuiSkin *skin )
-{
-	if ( NULL == skin ) {
-		DBGF( "%s", "NULL pointer argument (skin)!" );
-		return NULL;
-	}
-	return &skin->tile256;
-}
-
-/* tile512 */
-const const ConColors *tui_skin_get_colors_tile512( const TuiSkin *skin )
-{
-	if ( NULL == skin ) {
-		DBGF( "%s", "NULL pointer argument (skin)!" );
-		return NULL;
-	}
-	return &skin->tile512;
-}
-
-/* tile1024 */
-const ConColors *tui_skin_get_colors_tile1024( const TuiSkin *skin )
-{
-	if ( NULL == skin ) {
-		DBGF( "%s", "NULL pointer argument (skin)!" );
-		return NULL;
-	}
-	return &skin->tile1024;
-}
-
-/* tile2048 */
-const ConColors *tui_skin_get_colors_tile2048( const TuiSkin *skin )
-{
-	if ( NULL == skin ) {
-		DBGF( "%s", "NULL pointer argument (skin)!" );
-		return NULL;
-	}
-	return &skin->tile2048;
-}
-
-/* tilebig */
-const ConColors *tui_skin_get_colors_tilebig( const TuiSkin *skin )
+const ConColors *tui_skin_get_colors_tiles( const TuiSkin *skin )
 {
 	if ( NULL == skin ) {
 		DBGF( "%s", "NULL pointer argument (skin)!" );
 		return NULL;
 	}
-	return &skin->tilebig;
+	return skin->tiles;
 }
 
 /* --------------------------------------------------------------
@@ -20,6 +20,9 @@
 
 #include "con_color.h"
 
+/* # of tile colors of a skin: empty tile, then tiles 2 up to 131072 */
+#define TUI_SKIN_NTILES  18
+
 /* The "class" is forward-declared as an opaque data-type */
 typedef struct _tuiskin TuiSkin;
 
@@ -34,19 +37,7 @@ extern const ConColors *tui_skin_get_colors_screen( const TuiSkin *skin );
 
 extern const ConColors *tui_skin_get_colors_titlebar( const TuiSkin *skin );
 
-extern const ConColors *tui_skin_get_colors_tile0( const TuiSkin *skin );
-extern const ConColors *tui_skin_get_colors_tile2( const TuiSkin *skin );
-extern const ConColors *tui_skin_get_colors_tile4( const TuiSkin *skin );
-extern const ConColors *tui_skin_get_colors_tile8( const TuiSkin *skin );
-extern const ConColors *tui_skin_get_colors_tile16( const TuiSkin *skin );
-extern const ConColors *tui_skin_get_colors_tile32( const TuiSkin *skin );
-extern const ConColors *tui_skin_get_colors_tile64( const TuiSkin *skin );
-extern const ConColors *tui_skin_get_colors_tile128( const TuiSkin *skin );
-extern const ConColors *tui_skin_get_colors_tile256( const TuiSkin *skin );
-extern const ConColors *tui_skin_get_colors_tile512( const TuiSkin *skin );
-extern const ConColors *tui_skin_get_colors_tile1024( const TuiSkin *skin );
-extern const ConColors *tui_skin_get_colors_tile2048( const TuiSkin *skin );
-extern const ConColors *tui_skin_get_colors_tilebig( const TuiSkin *skin );
+extern const ConColors *tui_skin_get_colors_tiles( const TuiSkin *skin );
 
 extern const ConColors *tui_skin_get_colors_scoresbar( const TuiSkin *skin );
 extern const ConColors *tui_skin_get_colors_infobar( const TuiSkin *skin );
@@ -0,0 +1,310 @@
+/****************************************************************
+ * This file is part of the "2048cc" game.
+ *
+ * Author:       migf1 <mig_f1@hotmail.com>
+ * Version:      0.3a3
+ * Date:         July 21, 2014
+ * License:      Free Software (see comments in main.c for limitations)
+ * Dependencies: common.h, my.h, gs.h, mvhist.h, tui.h
+ * --------------------------------------------------------------
+ *
+ * A headless benchmark (it is NOT part of the game) of the text user
+ * interface. It sends the standard output to a headless sink (see
+ * my_output_sink() in the file "my.c") and then, for every skin, it
+ * replays every move of the replay-files (both .sav2 & .sav) of a
+ * folder through tui_redraw(), just like the replay-mode of the game
+ * does. It reports the frames per second, and the bytes & the writes
+ * per frame, for every skin & board size.
+ *
+ * Usage: bench [-m] [folder]   (folder defaults to "replays")
+ *
+ * By default the output goes nowhere. With -m it is kept in memory
+ * instead, which costs a bit more. The exit status is 0 on success,
+ * 1 otherwise. To compile it, from the tools/ folder type:
+ *
+ *   gcc -std=c99 -s -O3 -D_BSD_SOURCE -pthread -I../src bench.c \
+ *       ../src/board.c ../src/gs.c ../src/mvhist.c ../src/common.c \
+ *       ../src/pool.c ../src/rcoder.c ../src/catalog.c ../src/my.c \
+ *       ../src/screen.c ../src/tui.c ../src/tui_skin.c -o bench.out
+ ****************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "my.h"
+#include "gs.h"
+#include "mvhist.h"
+#include "tui.h"
+#include "pool.h"
+
+#if defined( CC2048_OS_WINDOWS )
+	#define _NULL_DEVICE  "NUL"
+#else
+	#define _NULL_DEVICE  "/dev/null"
+#endif
+
+/* The measurements of a skin on a board size */
+struct _result {
+	int               dim;      /* board size */
+	int               skin;     /* skin id (see tui_cycle_skin()) */
+	long int          nframes;  /* # of frames drawn */
+	double            secs;     /* time taken to draw them */
+	unsigned long int nbytes;   /* # of bytes they were written in */
+	unsigned long int nwrites;  /* # of writes they were written with */
+};
+
+/* The measurements of all the skins & board sizes met */
+struct _results {
+	struct _result *results;
+	int            n;           /* # of results */
+	int            capacity;    /* # of results reserved */
+};
+
+/* --------------------------------------------------------------
+ * int _is_replay_fname():
+ *
+ * Return 1 (true) if the specified filename (name) has the extension
+ * of replay-files (binary or text), 0 (false) otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _is_replay_fname( const char *name )
+{
+	const char *ext = strrchr( name, '.' );
+
+	return NULL != ext
+		&& ( 0 == strcmp(ext, REPLAY_FNAME_EXT)
+		  || 0 == strcmp(ext, REPLAY_FNAME_EXT_TEXT) );
+}
+
+/* --------------------------------------------------------------
+ * struct _result *_get_result():
+ *
+ * Return the result of the specified board size (dim) & skin id
+ * (skin) out of the specified results, adding it if it is not there
+ * yet. Return NULL on error.
+ * --------------------------------------------------------------
+ */
+static struct _result *_get_result( struct _results *res, int dim, int skin )
+{
+	int i, capacity;
+	struct _result *try = NULL;
+
+	for (i=0; i < res->n; i++) {
+		if ( dim == res->results[i].dim && skin == res->results[i].skin ) {
+			return &res->results[i];
+		}
+	}
+
+	if ( res->n == res->capacity ) {
+		capacity = res->capacity ? 2 * res->capacity : 16;
+		try = realloc( res->results, capacity * sizeof(*try) );
+		if ( NULL == try ) {
+			return NULL;
+		}
+		res->results  = try;
+		res->capacity = capacity;
+	}
+
+	try = &res->results[ res->n++ ];
+	memset( try, 0, sizeof(*try) );
+	try->dim  = dim;
+	try->skin = skin;
+	return try;
+}
+
+/* The state shared by the benchmarks of the replay-files */
+struct _scan {
+	const char      *folder;
+	struct _results *res;
+	GameState       *gs;
+	Tui             *tui;       /* created by the 1st replay-file */
+	long int        nfiles;     /* # of files benchmarked */
+	long int        nfailed;    /* # of files failed */
+};
+
+/* --------------------------------------------------------------
+ * int _bench_file():
+ *
+ * Replay every move of the specified replay-file (fname) through the
+ * text user interface of the specified scan, once for every skin,
+ * adding the measurements to its results. Like the game does, there
+ * is just one tui for the whole session, that gets pointed to every
+ * replay-file in turn. Return 0 (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _bench_file( const char *fname, struct _scan *scan )
+{
+	int ret = 0, skin, firstskin;
+	double secs;
+	MovesHistory   *mvhist = NULL;
+	const GSNode   *it     = NULL;
+	struct _result *r      = NULL;
+
+	mvhist = new_mvhist_from_file( fname );
+	if ( NULL == mvhist ) {
+		return 0;
+	}
+	/* a loaded replay-file comes with its replay-stack ready */
+	it = mvhist_iter_top_replay_stack( mvhist );
+	if ( NULL == it ) {
+		goto ret_cleanup;
+	}
+	gamestate_copy( scan->gs, gsstack_peek_state(it) );
+
+	if ( NULL == scan->tui ) {
+		scan->tui = new_tui( scan->gs, mvhist );
+		if ( NULL == scan->tui ) {
+			goto ret_cleanup;
+		}
+	}
+	tui_update_mvhist_reference( scan->tui, mvhist );
+	tui_update_board_reference(
+		scan->tui,
+		gamestate_get_board( scan->gs )
+		);
+
+	firstskin = skin = tui_cycle_skin( scan->tui );
+	do {
+		tui_cls( scan->tui );
+		r = _get_result(
+			scan->res,
+			board_get_dim( gamestate_get_board(scan->gs) ),
+			skin
+			);
+		if ( NULL == r ) {
+			goto ret_cleanup;
+		}
+
+		my_output_stats( NULL, NULL, 1 );
+		secs = th_wall_secs();
+		for (it = mvhist_iter_top_replay_stack(mvhist);
+		     NULL != it;
+		     it = mvhist_iter_down_replay_stack(mvhist, it)
+		){
+			gamestate_copy( scan->gs, gsstack_peek_state(it) );
+			tui_redraw( scan->tui, 0 );
+			r->nframes++;
+		}
+		r->secs += th_wall_secs() - secs;
+		my_output_stats( &r->nbytes, &r->nwrites, 0 );
+
+		skin = tui_cycle_skin( scan->tui );
+	} while ( skin != firstskin );
+	ret = 1;
+
+ret_cleanup:
+	mvhist = mvhist_free( mvhist );
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int _scan_entry():
+ *
+ * Callback of f_scan_folder(), benchmarking the specified entry
+ * (name) of the folder of the specified scan (arg) if it is a
+ * replay-file. Return 1 (true) even if it fails, so the rest of
+ * the folder still gets benchmarked.
+ * --------------------------------------------------------------
+ */
+static int _scan_entry( const char *name, void *arg )
+{
+	struct _scan *scan = arg;
+	char *fname = NULL;
+
+	if ( !_is_replay_fname(name) ) {
+		return 1;  /* true */
+	}
+	fname = printf_to_text( "%s/%s", scan->folder, name );
+	if ( NULL == fname ) {
+		return 0;  /* false */
+	}
+
+	scan->nfiles++;
+	if ( !_bench_file(fname, scan) ) {
+		fprintf( stderr, "%s: cannot be benchmarked\n", fname );
+		scan->nfailed++;
+	}
+	free( fname );
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ *
+ * --------------------------------------------------------------
+ */
+int main( int argc, char *argv[] )
+{
+	int             i, ret = 1, sink = MY_SINK_NULL;
+	struct _results res  = {NULL, 0, 0};
+	struct _scan    scan = {REPLAYS_FOLDER, NULL, NULL, NULL, 0, 0};
+	struct _result  *r   = NULL;
+
+	for (i=1; i < argc; i++) {
+		if ( 0 == strcmp(argv[i], "-m") ) {
+			sink = MY_SINK_MEMORY;
+		}
+		else if ( '-' != argv[i][0] ) {
+			scan.folder = argv[i];
+		}
+		else {
+			fprintf( stderr, "usage: %s [-m] [folder]\n", argv[0] );
+			return 1;
+		}
+	}
+
+	/* DBGF() waits for ENTER, so just let it report any error */
+	if ( NULL == freopen(_NULL_DEVICE, "r", stdin) ) {
+		fprintf( stderr, "%s\n", "cannot redirect stdin!" );
+		return 1;
+	}
+	scan.res = &res;
+	scan.gs  = new_gamestate( BOARD_DIM_4 );
+	if ( NULL == scan.gs ) {
+		fprintf( stderr, "%s\n", "out of memory!" );
+		return 1;
+	}
+	if ( !my_output_sink(sink) ) {
+		fprintf( stderr, "%s\n", "headless output is not supported!" );
+		goto ret_cleanup;
+	}
+
+	i = f_scan_folder( scan.folder, _scan_entry, &scan );
+	if ( scan.tui ) {
+		scan.tui = tui_free( scan.tui );
+	}
+	my_output_sink( MY_SINK_TERMINAL );
+	if ( !i ) {
+		fprintf( stderr, "cannot read the folder: %s\n", scan.folder );
+		goto ret_cleanup;
+	}
+
+	printf(
+		"%ld files (%ld failed), %s sink\n",
+		scan.nfiles, scan.nfailed,
+		MY_SINK_MEMORY == sink ? "memory" : "null"
+		);
+	printf( "%-6s %-5s %8s %10s %12s %12s\n",
+		"board", "skin", "frames", "frames/s", "bytes/frame",
+		"writes/frame" );
+	for (i=0; i < res.n; i++) {
+		r = &res.results[i];
+		printf(
+			"%dx%-4d %-5d %8ld %10.0f %12.1f %12.2f\n",
+			r->dim, r->dim, r->skin, r->nframes,
+			r->secs > 0 ? r->nframes / r->secs : 0.0,
+			r->nframes ? (double)r->nbytes / r->nframes : 0.0,
+			r->nframes ? (double)r->nwrites / r->nframes : 0.0
+			);
+	}
+	ret = scan.nfailed > 0;
+
+ret_cleanup:
+	scan.gs = gamestate_free( scan.gs );
+	free( res.results );
+	pool_release();
+	return ret;
+}
@@ -0,0 +1,857 @@
+/****************************************************************
+ * This file is part of the "2048cc" game.
+ *
+ * Author:       migf1 <mig_f1@hotmail.com>
+ * Version:      0.3a3
+ * Date:         July 21, 2014
+ * License:      Free Software (see comments in main.c for limitations)
+ * Dependencies: common.h, board.h, gs.h, mvhist.h
+ * --------------------------------------------------------------
+ *
+ * A headless tool (it is NOT part of the game) that runs a few checks
+ * of the moves-history code against sequences that once went wrong,
+ * and reports every check as "ok" or "FAILED".
+ *
+ * Usage: selftest
+ *
+ * The exit status is 0 if all the checks passed, 1 otherwise. To
+ * compile it, from the tools/ folder type:
+ *
+ *   gcc -std=c99 -s -O3 -D_BSD_SOURCE -DCC2048_QUIET -pthread -I../src \
+ *       selftest.c ../src/board.c ../src/gs.c ../src/mvhist.c ../src/common.c \
+ *       ../src/pool.c ../src/rcoder.c -o selftest.out
+ ****************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "board.h"
+#include "gs.h"
+#include "mvhist.h"
+#include "pool.h"
+
+#if defined( CC2048_OS_WINDOWS )
+	#define _NULL_DEVICE  "NUL"
+#else
+	#define _NULL_DEVICE  "/dev/null"
+#endif
+
+/* --------------------------------------------------------------
+ * GameState *_new_state():
+ *
+ * Create a 4x4 game-state whose tiles are the specified 16 values
+ * (tiles, row by row), having the specified prevmv. Return NULL on
+ * error.
+ * --------------------------------------------------------------
+ */
+static GameState *_new_state( const int tiles[16], int prevmv )
+{
+	int i;
+	GameState *gs = new_gamestate( BOARD_DIM_4 );
+
+	if ( NULL == gs ) {
+		return NULL;
+	}
+	for (i=0; i < 16; i++) {
+		board_set_tile_value( gamestate_get_board(gs), i/4, i%4, tiles[i] );
+	}
+	gamestate_set_prevmove( gs, prevmv );
+	return gs;
+}
+
+/* --------------------------------------------------------------
+ * int _test_fork_after_nomove():
+ *
+ * A key that moves nothing, then an undo, then a new move: the
+ * undone move must still be kept as a branch, even if the game-state
+ * it led to has recorded the direction of the key that moved nothing
+ * (older versions did so). Return 1 (true) if it passes.
+ * --------------------------------------------------------------
+ */
+static int _test_fork_after_nomove( void )
+{
+	static const int a[16] = { 0,2,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0 };
+	static const int b[16] = { 2,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,2 };
+	int ret = 0;
+	MovesHistory *mvhist = new_mvhist();
+	GameState    *sa = _new_state( a, GS_MVDIR_NONE );
+	GameState    *sb = _new_state( b, GS_MVDIR_UP ); /* really LEFT */
+
+	if ( !mvhist || !sa || !sb ) {
+		goto ret_cleanup;
+	}
+
+	mvhist_push_undo_stack( mvhist, sa );
+	mvhist_push_undo_stack( mvhist, sb );
+
+	/* undo (see _do_undo() in the file "main.c") */
+	mvhist_set_didundo( mvhist, 1 );
+	mvhist_push_redo_stack( mvhist, sb );
+	mvhist_pop_undo_stack( mvhist );
+
+	/* a new move forks off the undone one */
+	ret = mvhist_fork_redo_stack( mvhist )
+		&& mvhist_isempty_redo_stack( mvhist )
+		&& 1 == mvhist_count_branches( mvhist );
+
+ret_cleanup:
+	mvhist = mvhist_free( mvhist );
+	sa = gamestate_free( sa );
+	sb = gamestate_free( sb );
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int _play_game():
+ *
+ * Play a game of up to the specified count (max) of game-states on
+ * an 8x8 board, cycling over the move directions, and put copies of
+ * its game-states in the specified array (states), with their prevmv
+ * & nextmv fields set like the game sets them. Return the count of
+ * the game-states put, or 0 on error.
+ * --------------------------------------------------------------
+ */
+static int _play_game( GameState **states, int max )
+{
+	int n = 0, k, mvdir, moved, iswin;
+	long int score = 0;
+	GameState *gs = new_gamestate( BOARD_DIM_8 );
+	Board     *board = NULL;
+
+	if ( NULL == gs ) {
+		return 0;
+	}
+	board = gamestate_get_board( gs );
+	board_generate_ntiles( board, 2, NULL );
+
+	for (n=0; n < max; n++)
+	{
+		states[n] = new_gamestate( BOARD_DIM_8 );
+		if ( NULL == states[n] ) {
+			break;
+		}
+		gamestate_copy( states[n], gs );
+
+		/* the 1st direction that moves, starting from n */
+		moved = 0;
+		for (k=0; k < 4 && !moved; k++) {
+			mvdir = GS_MVDIR_UP + (n + k) % 4;
+			switch ( mvdir ) {
+				case GS_MVDIR_UP:
+					moved = board_move_up(board, &score, &iswin, NULL);
+					break;
+				case GS_MVDIR_DOWN:
+					moved = board_move_down(board, &score, &iswin, NULL);
+					break;
+				case GS_MVDIR_LEFT:
+					moved = board_move_left(board, &score, &iswin, NULL);
+					break;
+				default:
+					moved = board_move_right(board, &score, &iswin, NULL);
+					break;
+			}
+		}
+		if ( !moved || !board_has_room(board) ) {
+			n++;
+			break;
+		}
+		gamestate_set_nextmove( states[n], mvdir );
+		gamestate_set_prevmove( gs, mvdir );
+		gamestate_set_score( gs, score );
+		board_generate_ntiles( board, board_get_nrandom(board), NULL );
+	}
+
+	gamestate_free( gs );
+	return n;
+}
+
+/* --------------------------------------------------------------
+ * int _files_equal():
+ *
+ * Return 1 (true) if the specified files (fa, fb) can be read and
+ * have the same contents, 0 (false) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _files_equal( const char *fa, const char *fb )
+{
+	int ca, cb;
+	FILE *a = fopen( fa, "rb" );
+	FILE *b = fopen( fb, "rb" );
+
+	if ( !a || !b ) {
+		ca = 0, cb = 1;
+	}
+	else {
+		do {
+			ca = fgetc( a );
+			cb = fgetc( b );
+		} while ( ca == cb && EOF != ca );
+	}
+	if ( a ) {
+		fclose( a );
+	}
+	if ( b ) {
+		fclose( b );
+	}
+	return ca == cb;
+}
+
+/* --------------------------------------------------------------
+ * int _test_archive():
+ *
+ * Under the smallest memory budget, the archived moves must keep
+ * their nextmv fields (even the ones that differ from the direction
+ * of the following move) and at least 64 undo nodes must stay
+ * resident. Replaying must walk them both ways, without decoding
+ * the whole line. Saving must write the same text file as a history
+ * without any budget. Return 1 (true) if it passes.
+ * --------------------------------------------------------------
+ */
+static int _test_archive( void )
+{
+	enum { MAXSTATES = 400 };
+	int i, n, ret = 0;
+	GameState    *states[ MAXSTATES ] = {NULL};
+	MovesHistory *mvhist = new_mvhist();
+	MovesHistory *full   = new_mvhist();
+	const GSNode *it = NULL;
+
+	n = _play_game( states, MAXSTATES );
+	if ( NULL == mvhist || NULL == full || n < 200
+	|| !mvhist_set_budget(mvhist, 1) || !mvhist_set_budget(full, 0)
+	){
+		goto ret_cleanup;
+	}
+
+	/* nextmv fields that do not follow the next moves */
+	gamestate_set_nextmove( states[50], GS_MVDIR_NONE );
+	gamestate_set_nextmove( states[51], GS_MVDIR_UP );
+	gamestate_set_nextmove( states[52], GS_MVDIR_UP );
+
+	for (i=0; i < n; i++) {
+		if ( !mvhist_push_undo_stack(mvhist, states[i])
+		|| !mvhist_push_undo_stack(full, states[i])
+		){
+			goto ret_cleanup;
+		}
+	}
+	if ( 0 == mvhist_get_narchived(mvhist)
+	|| mvhist_peek_undo_stack_count(mvhist)
+	   - mvhist_get_narchived(mvhist) < 64
+	){
+		goto ret_cleanup;
+	}
+
+	/* the replay-stack decodes the archive */
+	if ( NULL == mvhist_init_replay(mvhist, 0) ) {
+		goto ret_cleanup;
+	}
+	it = mvhist_iter_top_replay_stack( mvhist );
+	for (i=0; i < n && it; i++, it = mvhist_iter_down_replay_stack(mvhist, it))
+	{
+		if ( gamestate_get_nextmove(gsstack_peek_state(it))
+		!= gamestate_get_nextmove(states[i])
+		){
+			break;
+		}
+	}
+	ret = (n == i && NULL == it);
+
+	/* ... upwards too, holding a single segment at a time */
+	it = mvhist_iter_bottom_replay_stack( mvhist );
+	for (i = n-1; i > -1 && it; i--, it = mvhist_iter_up_replay_stack(mvhist, it))
+	{
+		if ( gsstack_peek_count(it) != n - i
+		|| gamestate_get_nextmove(gsstack_peek_state(it))
+		   != gamestate_get_nextmove(states[i])
+		){
+			break;
+		}
+	}
+	ret = ret && -1 == i && NULL == it
+		&& mvhist_get_nbytes(mvhist, MVHIST_MEM_REPLAY)
+		   < (size_t) n * gsstack_sizeof_node();
+	mvhist_cleanup_replay( mvhist );
+
+	/* saved files do not depend on the budget */
+	ret = ret
+		&& mvhist_save_to_file( mvhist, "selftest_a.sav" )
+		&& mvhist_save_to_file( full, "selftest_b.sav" )
+		&& _files_equal( "selftest_a.sav", "selftest_b.sav" );
+	remove( "selftest_a.sav" );
+	remove( "selftest_b.sav" );
+
+ret_cleanup:
+	mvhist = mvhist_free( mvhist );
+	full   = mvhist_free( full );
+	for (i=0; i < MAXSTATES; i++) {
+		gamestate_free( states[i] );
+	}
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int _test_journal():
+ *
+ * A journal opened on a history whose nextmv fields do not all follow
+ * the directions of the next moves, must load back with the very same
+ * nextmv fields. Return 1 (true) if it passes.
+ * --------------------------------------------------------------
+ */
+static int _test_journal( void )
+{
+	enum { MAXSTATES = 100 };
+	int i, n, ret = 0;
+	GameState    *states[ MAXSTATES ] = {NULL};
+	MovesHistory *mvhist = new_mvhist();
+	MovesHistory *loaded = NULL;
+	const GSNode *it = NULL;
+
+	n = _play_game( states, MAXSTATES );
+	if ( NULL == mvhist || n < 50 ) {
+		goto ret_cleanup;
+	}
+
+	/* nextmv fields that do not follow the next moves */
+	gamestate_set_nextmove( states[10], GS_MVDIR_NONE );
+	gamestate_set_nextmove( states[11], GS_MVDIR_UP );
+	gamestate_set_nextmove( states[12], GS_MVDIR_UP );
+
+	for (i=0; i < n; i++) {
+		if ( !mvhist_push_undo_stack(mvhist, states[i]) ) {
+			goto ret_cleanup;
+		}
+	}
+	if ( !mvhist_journal_open(mvhist, "selftest_j.jnl")
+	|| !mvhist_journal_close(mvhist, "selftest_j.sav2")
+	|| NULL == (loaded = new_mvhist_from_file("selftest_j.sav2"))
+	){
+		goto ret_cleanup;
+	}
+
+	it = mvhist_iter_top_replay_stack( loaded );
+	for (i=0; i < n && it; i++, it = mvhist_iter_down_replay_stack(loaded, it))
+	{
+		if ( gamestate_get_nextmove(gsstack_peek_state(it))
+		!= gamestate_get_nextmove(states[i])
+		){
+			break;
+		}
+	}
+	ret = (n == i && NULL == it);
+
+ret_cleanup:
+	remove( "selftest_j.jnl" );
+	remove( "selftest_j.sav2" );
+	mvhist = mvhist_free( mvhist );
+	loaded = mvhist_free( loaded );
+	for (i=0; i < MAXSTATES; i++) {
+		gamestate_free( states[i] );
+	}
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int _corrupt_file():
+ *
+ * Overwrite in the specified text file (fname) the character that
+ * follows the 1st (after) character found after the specified count
+ * of lines (nlines), with the specified one (to). Return 0 (false) on
+ * error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _corrupt_file( const char *fname, int nlines, int after, int to )
+{
+	int c, ret = 0;
+	FILE *fp = fopen( fname, "r+b" );
+
+	if ( NULL == fp ) {
+		return 0;  /* false */
+	}
+	while ( nlines > 0 && EOF != (c = fgetc(fp)) ) {
+		nlines -= ('\n' == c);
+	}
+	while ( EOF != (c = fgetc(fp)) && after != c ) {
+		;
+	}
+	/* switching from reading to writing needs a positioning call */
+	if ( after == c && 0 == fseek(fp, 0L, SEEK_CUR) ) {
+		ret = (EOF != fputc(to, fp));
+	}
+	fclose( fp );
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int _corrupt_nempty():
+ *
+ * Change by one the count of empty tiles stored in the game-state
+ * found after the specified count of lines (nlines) of the specified
+ * text file (fname), leaving its tiles intact. The count is the last
+ * field before the '#' but one (see board_to_text() in "board.c").
+ * Return 0 (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _corrupt_nempty( const char *fname, int nlines )
+{
+	int c, ret = 0;
+	long int pos;
+	char line[ BUFSIZ ] = {'\0'}, *cp = NULL;
+	FILE *fp = fopen( fname, "r+b" );
+
+	if ( NULL == fp ) {
+		return 0;  /* false */
+	}
+	while ( nlines > 0 && EOF != (c = fgetc(fp)) ) {
+		nlines -= ('\n' == c);
+	}
+	pos = ftell( fp );
+	if ( pos < 0 || NULL == fgets(line, BUFSIZ, fp)
+	|| NULL == (cp = strchr(line, '#')) || cp - line < 3
+	){
+		goto ret_cleanup;
+	}
+	/* e.g. "... 3 1#..." becomes "... 2 1#..." */
+	cp -= 3;
+	if ( *cp < '0' || *cp > '9' ) {
+		goto ret_cleanup;
+	}
+	c = ('0' == *cp) ? '1' : *cp - 1;
+	if ( 0 == fseek(fp, pos + (cp - line), SEEK_SET) ) {
+		ret = (EOF != fputc(c, fp));
+	}
+
+ret_cleanup:
+	fclose( fp );
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int _save_game():
+ *
+ * Play a game and save it as the specified text replay-file (fname).
+ * Return 0 (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _save_game( const char *fname )
+{
+	enum { MAXSTATES = 200 };
+	int i, n, ret = 0;
+	GameState    *states[ MAXSTATES ] = {NULL};
+	MovesHistory *mvhist = new_mvhist();
+
+	n = _play_game( states, MAXSTATES );
+	if ( NULL == mvhist || n < 100 ) {
+		goto ret_cleanup;
+	}
+	for (i=0; i < n; i++) {
+		if ( !mvhist_push_undo_stack(mvhist, states[i]) ) {
+			goto ret_cleanup;
+		}
+	}
+	ret = mvhist_save_to_file( mvhist, fname );
+
+ret_cleanup:
+	mvhist = mvhist_free( mvhist );
+	for (i=0; i < MAXSTATES; i++) {
+		gamestate_free( states[i] );
+	}
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int _save_corrupt_game():
+ *
+ * Play a game and save it as the specified text replay-file (fname),
+ * then corrupt the file with _corrupt_file() and the specified (after)
+ * & (to) characters, 50 lines into its undo-stack. Return 0 (false)
+ * on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _save_corrupt_game( const char *fname, int after, int to )
+{
+	return _save_game( fname ) && _corrupt_file( fname, 50, after, to );
+}
+
+/* --------------------------------------------------------------
+ * int _test_corrupt_text():
+ *
+ * A text replay-file whose undo-stack is broken in the middle (a line
+ * without a count) must fail to load. One having a malformed game-state
+ * there must load, since its game-states are decoded lazily, but then
+ * fail verification at that game-state. Return 1 (true) if it passes.
+ * --------------------------------------------------------------
+ */
+static int _test_corrupt_text( void )
+{
+	int ret = 0;
+	long int bad, nchecked = 0;
+	const char   *reason = NULL;
+	MovesHistory *loaded = NULL;
+
+	/* a line starting with no count */
+	if ( !_save_corrupt_game("selftest_c.sav", '\n', 'x')
+	|| NULL != (loaded = new_mvhist_from_file("selftest_c.sav"))
+	){
+		goto ret_cleanup;
+	}
+
+	/* a board dimension that cannot be parsed */
+	if ( _save_corrupt_game("selftest_c.sav", '@', 'x')
+	&& NULL != (loaded = new_mvhist_from_file("selftest_c.sav"))
+	){
+		bad = mvhist_verify( loaded, &nchecked, &reason );
+		ret = (bad > 1 && nchecked + 1 == bad && NULL != reason);
+	}
+
+ret_cleanup:
+	remove( "selftest_c.sav" );
+	loaded = mvhist_free( loaded );
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int _test_verify_tampered():
+ *
+ * Verifying a text replay-file having a well-formed game-state that
+ * does not follow from the previous one (see tools/verify.c) must
+ * report that game-state, along with a reason. So must verifying one
+ * having a game-state whose stored count of empty tiles is off by one.
+ * Return 1 (true) if it passes.
+ * --------------------------------------------------------------
+ */
+static int _test_verify_tampered( void )
+{
+	int ret = 0;
+	long int bad, nchecked = 0;
+	const char   *reason = NULL;
+	MovesHistory *loaded = NULL;
+
+	/* no tile value starts with a 7 */
+	if ( _save_corrupt_game("selftest_v.sav", '#', '7')
+	&& NULL != (loaded = new_mvhist_from_file("selftest_v.sav"))
+	){
+		bad = mvhist_verify( loaded, &nchecked, &reason );
+		ret = (bad > 1 && nchecked + 1 == bad && NULL != reason);
+	}
+	remove( "selftest_v.sav" );
+	loaded = mvhist_free( loaded );
+	if ( !ret ) {
+		return 0;  /* false */
+	}
+
+	/* the stored count of empty tiles, not a recount, gets checked */
+	ret = 0;
+	if ( _save_game("selftest_v.sav")
+	&& _corrupt_nempty( "selftest_v.sav", 50 )
+	&& NULL != (loaded = new_mvhist_from_file("selftest_v.sav"))
+	){
+		bad = mvhist_verify( loaded, &nchecked, &reason );
+		ret = (bad > 1 && nchecked + 1 == bad && NULL != reason
+			&& 0 == strcmp(reason, "the count of its empty tiles is wrong"));
+	}
+	remove( "selftest_v.sav" );
+	loaded = mvhist_free( loaded );
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int _states_equal():
+ *
+ * Return 1 (true) if the specified game-states (a, b) have the same
+ * tiles, score, best-score, prevmv & nextmv fields, 0 (false) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _states_equal( const GameState *a, const GameState *b )
+{
+	int i;
+	const Board *ba = gamestate_get_board( a );
+	const Board *bb = gamestate_get_board( b );
+	const int   dim = board_get_dim( ba );
+
+	if ( dim != board_get_dim(bb)
+	|| gamestate_get_score(a) != gamestate_get_score(b)
+	|| gamestate_get_bestscore(a) != gamestate_get_bestscore(b)
+	|| gamestate_get_prevmove(a) != gamestate_get_prevmove(b)
+	|| gamestate_get_nextmove(a) != gamestate_get_nextmove(b)
+	){
+		return 0;  /* false */
+	}
+	for (i=0; i < dim * dim; i++) {
+		if ( board_get_tile_value(ba, i/dim, i%dim)
+		!= board_get_tile_value(bb, i/dim, i%dim)
+		){
+			return 0;  /* false */
+		}
+	}
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _test_switch_branch():
+ *
+ * After switching to a branch, the redo count must cover all of its
+ * moves, saving must write the same text file as a history having
+ * those moves undone, and redoing must walk the very same game-states
+ * that were played (see _do_undo() & _do_redo() in "main.c"). Return
+ * 1 (true) if it passes.
+ * --------------------------------------------------------------
+ */
+static int _test_switch_branch( void )
+{
+	enum { MAXSTATES = 80, NUNDO = 40 };
+	int i, n, ret = 0;
+	GameState    *states[ MAXSTATES ] = {NULL};
+	GameState    *gs = new_gamestate( BOARD_DIM_8 );
+	MovesHistory *mvhist = new_mvhist();
+	MovesHistory *undone = new_mvhist();
+
+	n = _play_game( states, MAXSTATES );
+	if ( NULL == gs || NULL == mvhist || NULL == undone || n < 2 * NUNDO ) {
+		goto ret_cleanup;
+	}
+
+	/* the last game-state has no next move, like in the game */
+	gamestate_set_nextmove( states[n-1], GS_MVDIR_NONE );
+
+	for (i=0; i < n; i++) {
+		if ( !mvhist_push_undo_stack(mvhist, states[i])
+		|| !mvhist_push_undo_stack(undone, states[i])
+		){
+			goto ret_cleanup;
+		}
+	}
+	mvhist_set_didundo( mvhist, 1 );
+	mvhist_set_didundo( undone, 1 );
+	for (i = n - 1; i >= n - NUNDO; i--) {
+		mvhist_push_redo_stack( mvhist, states[i] );
+		mvhist_pop_undo_stack( mvhist );
+		mvhist_push_redo_stack( undone, states[i] );
+		mvhist_pop_undo_stack( undone );
+	}
+
+	/* archive the undone moves, then switch back to them */
+	if ( !mvhist_fork_redo_stack(mvhist)
+	|| !mvhist_switch_branch(mvhist, 0, gs)
+	|| 0 != mvhist_count_branches(mvhist)
+	|| NUNDO != mvhist_peek_redo_stack_count(mvhist)
+	|| !_states_equal(gs, states[n - NUNDO - 1])
+	){
+		goto ret_cleanup;
+	}
+	if ( !mvhist_save_to_file(mvhist, "selftest_s.sav")
+	|| !mvhist_save_to_file(undone, "selftest_u.sav")
+	|| !_files_equal("selftest_s.sav", "selftest_u.sav")
+	){
+		goto ret_cleanup;
+	}
+
+	/* redo all the moves of the branch */
+	for (i = n - NUNDO; i < n; i++) {
+		if ( mvhist_isempty_redo_stack(mvhist)
+		|| !_states_equal(mvhist_peek_redo_stack_state(mvhist), states[i])
+		){
+			goto ret_cleanup;
+		}
+		gamestate_copy( gs, mvhist_peek_redo_stack_state(mvhist) );
+		mvhist_pop_redo_stack( mvhist );
+		mvhist_push_undo_stack( mvhist, gs );
+	}
+	ret = mvhist_isempty_redo_stack( mvhist )
+		&& 0 == mvhist_peek_redo_stack_count( mvhist )
+		&& n == mvhist_peek_undo_stack_count( mvhist );
+
+ret_cleanup:
+	remove( "selftest_s.sav" );
+	remove( "selftest_u.sav" );
+	gs = gamestate_free( gs );
+	mvhist = mvhist_free( mvhist );
+	undone = mvhist_free( undone );
+	for (i=0; i < MAXSTATES; i++) {
+		gamestate_free( states[i] );
+	}
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int _test_branches_nbytes():
+ *
+ * The running count of the bytes of the branches must match the count
+ * of a history loaded from a file with the same branches, after nested
+ * forks and a switch, and it must drop to 0 when they get pruned.
+ * Return 1 (true) if it passes.
+ * --------------------------------------------------------------
+ */
+static int _test_branches_nbytes( void )
+{
+	enum { MAXSTATES = 60 };
+	int i, n, ret = 0;
+	GameState    *states[ MAXSTATES ] = {NULL};
+	GameState    *gs = new_gamestate( BOARD_DIM_8 );
+	MovesHistory *mvhist = new_mvhist();
+	MovesHistory *loaded = NULL;
+
+	n = _play_game( states, MAXSTATES );
+	if ( NULL == gs || NULL == mvhist || n < 40 ) {
+		goto ret_cleanup;
+	}
+	for (i=0; i < n; i++) {
+		if ( !mvhist_push_undo_stack(mvhist, states[i]) ) {
+			goto ret_cleanup;
+		}
+	}
+
+	/* a branch forking off another one, then switch to the latter */
+	mvhist_set_didundo( mvhist, 1 );
+	for (i = n - 1; i >= 20; i--) {
+		mvhist_push_redo_stack( mvhist, states[i] );
+		mvhist_pop_undo_stack( mvhist );
+		if ( 30 == i && !mvhist_fork_redo_stack(mvhist) ) {
+			goto ret_cleanup;
+		}
+	}
+	if ( !mvhist_fork_redo_stack(mvhist)
+	|| !mvhist_switch_branch(mvhist, 0, gs)
+	|| 0 == mvhist_get_nbytes(mvhist, MVHIST_MEM_BRANCHES)
+	|| !mvhist_save_to_file(mvhist, "selftest_n.sav2")
+	|| NULL == (loaded = new_mvhist_from_file("selftest_n.sav2"))
+	){
+		goto ret_cleanup;
+	}
+
+	ret = mvhist_get_nbytes(mvhist, MVHIST_MEM_BRANCHES)
+		== mvhist_get_nbytes(loaded, MVHIST_MEM_BRANCHES)
+		&& mvhist_free_redo_stack( mvhist )
+		&& 0 == mvhist_count_branches( mvhist )
+		&& 0 == mvhist_get_nbytes( mvhist, MVHIST_MEM_BRANCHES );
+
+ret_cleanup:
+	remove( "selftest_n.sav2" );
+	gs = gamestate_free( gs );
+	mvhist = mvhist_free( mvhist );
+	loaded = mvhist_free( loaded );
+	for (i=0; i < MAXSTATES; i++) {
+		gamestate_free( states[i] );
+	}
+	return ret;
+}
+
+/* --------------------------------------------------------------
+ * int _test_async_save():
+ *
+ * Saving in the background must write the same files as saving in
+ * the foreground, even though the object gets changed or freed right
+ * after the save has started, in either format, and for an object
+ * loaded from a text file (whose game-states are decoded lazily).
+ * Return 1 (true) if it passes.
+ * --------------------------------------------------------------
+ */
+static int _test_async_save( void )
+{
+	enum { MAXSTATES = 300 };
+	int i, n, ret = 0;
+	GameState    *states[ MAXSTATES ] = {NULL};
+	MovesHistory *mvhist = new_mvhist();
+	MovesHistory *loaded = NULL;
+
+	n = _play_game( states, MAXSTATES );
+	if ( NULL == mvhist || n < 200 || !mvhist_set_budget(mvhist, 1) ) {
+		goto ret_cleanup;
+	}
+	for (i=0; i < n; i++) {
+		if ( !mvhist_push_undo_stack(mvhist, states[i]) ) {
+			goto ret_cleanup;
+		}
+	}
+	mvhist_set_didundo( mvhist, 1 );
+	for (i = n - 1; i >= n - 20; i--) {
+		mvhist_push_redo_stack( mvhist, states[i] );
+		mvhist_pop_undo_stack( mvhist );
+	}
+	if ( !mvhist_save_to_file(mvhist, "selftest_s.sav2")
+	|| !mvhist_save_to_file(mvhist, "selftest_s.sav")
+	){
+		goto ret_cleanup;
+	}
+
+	/* archived & resident moves, the object changes meanwhile */
+	ret = mvhist_save_to_file_async( mvhist, "selftest_t.sav2" )
+		&& mvhist_reset( mvhist )
+		&& MVHIST_ASYNC_SAVED == mvhist_wait_async_save()
+		&& _files_equal( "selftest_s.sav2", "selftest_t.sav2" );
+
+	/* lazy nodes, in either format, the object is freed meanwhile */
+	for (i=0; ret && i < 2; i++) {
+		loaded = new_mvhist_from_file( "selftest_s.sav" );
+		ret = NULL != loaded
+			&& mvhist_save_to_file_async(
+				loaded,
+				i ? "selftest_t.sav" : "selftest_u.sav2"
+				);
+		loaded = mvhist_free( loaded );
+		ret = ret && MVHIST_ASYNC_SAVED == mvhist_wait_async_save();
+	}
+	ret = ret
+		&& _files_equal( "selftest_s.sav2", "selftest_u.sav2" )
+		&& _files_equal( "selftest_s.sav", "selftest_t.sav" );
+
+ret_cleanup:
+	remove( "selftest_s.sav2" );
+	remove( "selftest_s.sav" );
+	remove( "selftest_t.sav2" );
+	remove( "selftest_t.sav" );
+	remove( "selftest_u.sav2" );
+	mvhist = mvhist_free( mvhist );
+	for (i=0; i < MAXSTATES; i++) {
+		gamestate_free( states[i] );
+	}
+	return ret;
+}
+
+/* The checks, in the order they are run */
+static const struct {
+	const char *name;
+	int        (*run)( void );
+} _tests[] = {
+	{ "fork after a key that moved nothing", _test_fork_after_nomove },
+	{ "archive under the smallest budget", _test_archive },
+	{ "corrupt text replay-file", _test_corrupt_text },
+	{ "journal of an arbitrary history", _test_journal },
+	{ "verify a tampered replay-file", _test_verify_tampered },
+	{ "switch to a branch and redo it", _test_switch_branch },
+	{ "running count of the bytes of branches", _test_branches_nbytes },
+	{ "save in the background", _test_async_save },
+	{ NULL, NULL }
+};
+
+/* --------------------------------------------------------------
+ *
+ * --------------------------------------------------------------
+ */
+int main( void )
+{
+	int i, nfailed = 0;
+
+	/* unless compiled with CC2048_QUIET, DBGF() waits for ENTER */
+	if ( NULL == freopen(_NULL_DEVICE, "r", stdin) ) {
+		fprintf( stderr, "%s\n", "cannot redirect stdin!" );
+		return 1;
+	}
+
+	for (i=0; NULL != _tests[i].name; i++) {
+		if ( _tests[i].run() ) {
+			printf( "%s: ok\n", _tests[i].name );
+		}
+		else {
+			printf( "%s: FAILED\n", _tests[i].name );
+			nfailed++;
+		}
+	}
+	printf( "%d checks (%d failed)\n", i, nfailed );
+
+	pool_release();
+	return nfailed > 0;
+}
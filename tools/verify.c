@@ -0,0 +1,304 @@
+/****************************************************************
+ * This file is part of the "2048cc" game.
+ *
+ * Author:       migf1 <mig_f1@hotmail.com>
+ * Version:      0.3a3
+ * Date:         July 21, 2014
+ * License:      Free Software (see comments in main.c for limitations)
+ * Dependencies: common.h, mvhist.h
+ * --------------------------------------------------------------
+ *
+ * A headless tool (it is NOT part of the game) that verifies all the
+ * replay-files (both .sav2 & .sav) of a folder, by re-simulating every
+ * move of their current lines (see mvhist_verify() in the file
+ * "mvhist.c"). It is meant for checking the save & load code against
+ * a large corpus of replays, and for measuring its throughput.
+ *
+ * The files are spread over a number of threads (by default, one per
+ * processor): thread t verifies the files t, t+N, t+2N, ... of the
+ * folder, so no locking is needed. Every file is loaded, verified and
+ * freed by the same thread (the memory pool is per-thread anyway).
+ *
+ * Usage: verify [-j nthreads] [folder]   (folder defaults to "replays")
+ *
+ * The game-states of .sav files are checked as stored. The .sav2 files
+ * store only their 1st game-state, the moves and the generated tiles,
+ * so the later game-states (with their scores, best-scores, winning
+ * status & counts of empty tiles) are derived from the moves when the
+ * file gets loaded. For them, only the 1st game-state and the moves &
+ * tiles can be checked: there are no stored keyframes or final scores
+ * to compare against.
+ *
+ * The exit status is 0 if all the files got verified successfully,
+ * 1 otherwise. To compile it, from the tools/ folder type:
+ *
+ *   gcc -std=c99 -s -O3 -D_BSD_SOURCE -DCC2048_QUIET -pthread -I../src \
+ *       verify.c ../src/board.c ../src/gs.c ../src/mvhist.c ../src/common.c \
+ *       ../src/pool.c ../src/rcoder.c -o verify.out
+ ****************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "mvhist.h"
+#include "pool.h"
+
+#if defined( CC2048_OS_WINDOWS )
+	#define _NULL_DEVICE  "NUL"
+#else
+	#define _NULL_DEVICE  "/dev/null"
+#endif
+
+/* The verification of a replay-file */
+struct _item {
+	char        *fname;     /* path of the file */
+	int         loaded;     /* could the file be loaded? */
+	long int    nchecked;   /* # of game-states found consistent */
+	long int    bad;        /* count of the 1st inconsistent one (or 0) */
+	const char  *reason;    /* why it is inconsistent (or NULL) */
+};
+
+/* The replay-files of the folder */
+struct _items {
+	const char   *folder;
+	struct _item *items;
+	long int     n;         /* # of items */
+	long int     capacity;  /* # of items reserved */
+};
+
+/* The share of a worker thread (see _worker()) */
+struct _share {
+	struct _items *items;
+	long int      first;    /* 1st item of the share */
+	long int      step;     /* distance between the items of the share */
+};
+
+/* --------------------------------------------------------------
+ * int _is_replay_fname():
+ *
+ * Return 1 (true) if the specified filename (name) has the extension
+ * of replay-files (binary or text), 0 (false) otherwise.
+ * --------------------------------------------------------------
+ */
+static inline int _is_replay_fname( const char *name )
+{
+	const char *ext = strrchr( name, '.' );
+
+	return NULL != ext
+		&& ( 0 == strcmp(ext, REPLAY_FNAME_EXT)
+		  || 0 == strcmp(ext, REPLAY_FNAME_EXT_TEXT) );
+}
+
+/* --------------------------------------------------------------
+ * int _scan_entry():
+ *
+ * Callback of f_scan_folder(), appending the specified entry (name)
+ * to the specified items (arg) if it is a replay-file. Return 0
+ * (false) on error, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _scan_entry( const char *name, void *arg )
+{
+	struct _items *items = arg;
+	struct _item  *try = NULL;
+
+	if ( !_is_replay_fname(name) ) {
+		return 1;  /* true */
+	}
+	if ( items->n == items->capacity ) {
+		long int capacity = items->capacity ? 2 * items->capacity : 256;
+		try = realloc( items->items, capacity * sizeof(*try) );
+		if ( NULL == try ) {
+			return 0;  /* false */
+		}
+		items->items    = try;
+		items->capacity = capacity;
+	}
+
+	try = &items->items[ items->n ];
+	memset( try, 0, sizeof(*try) );
+	try->fname = printf_to_text( "%s/%s", items->folder, name );
+	if ( NULL == try->fname ) {
+		return 0;  /* false */
+	}
+	items->n++;
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * (thread entry-point) int _worker():
+ *
+ * Load & verify every item of the specified share (arg).
+ * Return 1 (true).
+ * --------------------------------------------------------------
+ */
+static int _worker( void *arg )
+{
+	long int       i;
+	MovesHistory   *mvhist = NULL;
+	struct _share  *share  = arg;
+	struct _item   *it     = NULL;
+
+	for (i = share->first; i < share->items->n; i += share->step)
+	{
+		it = &share->items->items[i];
+		mvhist = new_mvhist_from_file( it->fname );
+		if ( NULL == mvhist ) {
+			continue;
+		}
+		it->loaded = 1;  /* true */
+		it->bad = mvhist_verify( mvhist, &it->nchecked, &it->reason );
+		mvhist = mvhist_free( mvhist );
+	}
+	pool_release();
+
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ * int _parse_args():
+ *
+ * Parse the command-line arguments into the specified folder and
+ * nthreads. Return 0 (false) if they are invalid, 1 (true) otherwise.
+ * --------------------------------------------------------------
+ */
+static int _parse_args(
+	int        argc,
+	char       *argv[],
+	const char **folder,
+	int        *nthreads
+	)
+{
+	int i;
+	const char *cp = NULL;
+
+	for (i=1; i < argc; i++) {
+		if ( 0 == strcmp(argv[i], "-j") && i+1 < argc ) {
+			cp = s_parse_int( argv[++i], nthreads );
+			if ( NULL == cp || '\0' != *cp || *nthreads < 1 ) {
+				return 0;  /* false */
+			}
+		}
+		else if ( '-' != argv[i][0] ) {
+			*folder = argv[i];
+		}
+		else {
+			return 0;  /* false */
+		}
+	}
+	return 1;  /* true */
+}
+
+/* --------------------------------------------------------------
+ *
+ * --------------------------------------------------------------
+ */
+int main( int argc, char *argv[] )
+{
+	int            t, ret = 1, nthreads = th_count_cpus();
+	long int       i, nfailed = 0, nstates = 0;
+	double         secs;
+	struct _items  items = {REPLAYS_FOLDER, NULL, 0, 0};
+	struct _share  *shares  = NULL;
+	void           **ths    = NULL;
+	struct _item   *it      = NULL;
+
+	if ( !_parse_args(argc, argv, &items.folder, &nthreads) ) {
+		fprintf( stderr, "usage: %s [-j nthreads] [folder]\n", argv[0] );
+		fprintf(
+			stderr,
+			"%s\n%s\n",
+			"(for .sav2 files, only the 1st game-state and the moves are"
+			" checked;",
+			" their later game-states & scores are derived from the moves)"
+			);
+		return 1;
+	}
+
+	/* Unless compiled with CC2048_QUIET (see "common.h") DBGF() waits
+	 * for ENTER, which would stall the threads on every corrupted file,
+	 * so just let it report the error.
+	 */
+	if ( NULL == freopen(_NULL_DEVICE, "r", stdin) ) {
+		fprintf( stderr, "%s\n", "cannot redirect stdin!" );
+		return 1;
+	}
+
+	if ( !f_scan_folder(items.folder, _scan_entry, &items) ) {
+		fprintf( stderr, "cannot read the folder: %s\n", items.folder );
+		goto ret_cleanup;
+	}
+	if ( nthreads > items.n ) {
+		nthreads = items.n > 0 ? (int)items.n : 1;
+	}
+	shares = calloc( nthreads, sizeof(*shares) );
+	ths    = calloc( nthreads, sizeof(*ths) );
+	if ( NULL == shares || NULL == ths ) {
+		fprintf( stderr, "%s\n", "out of memory!" );
+		goto ret_cleanup;
+	}
+
+	secs = th_wall_secs();
+	for (t=0; t < nthreads; t++) {
+		shares[t].items = &items;
+		shares[t].first = t;
+		shares[t].step  = nthreads;
+		ths[t] = th_start( _worker, &shares[t] );
+		if ( NULL == ths[t] ) {
+			_worker( &shares[t] );
+		}
+	}
+	for (t=0; t < nthreads; t++) {
+		if ( ths[t] ) {
+			th_join( ths[t] );
+		}
+	}
+	secs = th_wall_secs() - secs;
+
+	for (i=0; i < items.n; i++) {
+		it = &items.items[i];
+		nstates += it->nchecked;
+		if ( !it->loaded ) {
+			printf( "%s: cannot be loaded\n", it->fname );
+		}
+		else if ( it->bad < 0 ) {
+			printf( "%s: cannot be verified\n", it->fname );
+		}
+		else if ( it->bad > 0 ) {
+			printf(
+				"%s: game-state %ld: %s\n",
+				it->fname, it->bad, it->reason
+				);
+		}
+		else {
+			continue;
+		}
+		nfailed++;
+	}
+
+	printf(
+		"%ld files (%ld failed), %ld game-states, %d threads, %.3f secs",
+		items.n, nfailed, nstates, nthreads, secs
+		);
+	if ( secs > 0 ) {
+		printf(
+			" (%.1f files/sec, %.0f game-states/sec)",
+			items.n / secs, nstates / secs
+			);
+	}
+	putchar( '\n' );
+	ret = nfailed > 0;
+
+ret_cleanup:
+	for (i=0; i < items.n; i++) {
+		free( items.items[i].fname );
+	}
+	free( items.items );
+	free( shares );
+	free( ths );
+	return ret;
+}